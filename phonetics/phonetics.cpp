@@ -0,0 +1,10155 @@
+/*
+Filename: phonetics.cpp
+
+Implementation of the phonetics portion of the lang library.
+*/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <type_traits>
+#include <new>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <istream>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <limits>
+#include <fstream>
+#include <chrono>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LANG_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define LANG_HAVE_MMAP 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define LANG_HAVE_SSE2 1
+#include <emmintrin.h>
+#else
+#define LANG_HAVE_SSE2 0
+#endif
+
+#if defined(__AVX__)
+#define LANG_HAVE_AVX 1
+#include <immintrin.h>
+#else
+#define LANG_HAVE_AVX 0
+#endif
+
+#if defined(__GNUC__)
+#define LANG_HAVE_BUILTINS 1
+#else
+#define LANG_HAVE_BUILTINS 0
+#endif
+
+#include "expt.h"
+#include "phonetics.h"
+
+using namespace lang;
+
+// Constants
+
+namespace {
+  
+  // PhoneCode layout
+  
+  const uint64_t kind_mask            = 0x1;
+  
+  const int phonation_shift           = 1;
+  const uint64_t phonation_mask       = 0xF;
+  
+  const int nasalization_shift        = 5;
+  const uint64_t nasalization_mask    = 0x3;
+  
+  const int roundedness_shift         = 7;
+  const uint64_t roundedness_mask     = 0x3;
+  
+  const int r_colored_shift           = 9;
+  
+  const int height_shift              = 10;
+  const uint64_t height_mask          = 0x7FF;
+  
+  const int backness_shift            = 21;
+  const uint64_t backness_mask        = 0x7FF;
+  
+  const int manner_shift              = 7;
+  const uint64_t manner_mask          = 0xF;
+  
+  const int place_shift               = 11;
+  const uint64_t place_mask           = 0x1F;
+  
+  const int secondary_shift           = 16;
+  const uint64_t secondary_mask       = 0x1F;
+  
+  const int vot_shift                 = 21;
+  const uint64_t vot_mask             = 0x7;
+  
+  const int mechanism_shift           = 24;
+  const uint64_t mechanism_mask       = 0x3;
+  
+  const int length_shift              = 32;
+  
+  const float quantization_steps      = 256.0;
+  
+  uint64_t length_bits(float length) {
+    
+    uint32_t bits;
+    std::memcpy(&bits, &length, sizeof(bits));
+    return (uint64_t) bits << length_shift;
+    
+  }
+  
+  uint64_t quantize(float value) {
+    
+    return (uint64_t) std::lround(value * quantization_steps);
+    
+  }
+  
+  // Stepping
+  
+  template <typename Enum>
+  Enum wrap(int value, int count) {
+    
+    // Steps go around the horn in both directions
+    int result = value % count;
+    if(result < 0) {
+      result += count;
+    }
+    
+    return (Enum) result;
+    
+  }
+  
+  // Exceptions
+  
+  // what() of a DecodingFailed with a known position, whose message() 
+  // formats the full text
+  const char decoding_failed[] = "transcription could not be decoded";
+  
+  // Bounds checks
+  
+  int checked_index(int index, int size) {
+    
+    // Negative indices count from the end
+    int result = index;
+    if(result < 0) {
+      result += size;
+    }
+    
+    // The exception keeps the index as given
+    if(result < 0 || result >= size) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(index, size);
+    }
+    
+    return result;
+    
+  }
+  
+  int checked_position(int position, int size) {
+    
+    // Like checked_index, but one past the end is also allowed
+    int result = position;
+    if(result < 0) {
+      result += size + 1;
+    }
+    
+    if(result < 0 || result > size) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(position, size);
+    }
+    
+    return result;
+    
+  }
+  
+  int checked_step(int position, int size) {
+    
+    // Like checked_position, but for an iterator that has been moved, so a
+    // negative position is out of bounds rather than counted from the end
+    if(position < 0 || position > size) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(position, size);
+    }
+    
+    return position;
+    
+  }
+  
+  int checked_value(int value, int count) {
+    
+    // For enumerated features passed to a query, which index a table
+    if(value < 0 || value >= count) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "A feature value is outside its enumeration.");
+    }
+    
+    return value;
+    
+  }
+  
+  // Iterators
+  
+  template <class Kind>
+  Kind* arrow(Kind& phone) {
+    
+    // For an iterator that yields references
+    return &phone;
+    
+  }
+  
+  template <class Value>
+  Syllable::Arrow<Value> arrow(const Value& value) {
+    
+    // For an iterator that yields values, which need somewhere to live
+    return Syllable::Arrow<Value>(value);
+    
+  }
+  
+  // Hashing
+  
+  uint64_t mix(uint64_t value) {
+    
+    // The finalizer of MurmurHash3, so that every bit affects every other
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+    
+  }
+  
+  uint64_t combine(uint64_t seed, uint64_t value) {
+    
+    // Folds value into a running hash, so that order matters
+    return mix(seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + 
+                       (seed >> 2)));
+    
+  }
+  
+  // Stamps
+  
+  const uint64_t stamp_block = 1 << 16;
+  
+  uint64_t new_stamp() {
+    
+    // Each thread takes stamps from the shared counter a block at a time, so 
+    // that threads changing syllables do not contend for it.  Zero is never 
+    // handed out and can mean no stamp.
+    static std::atomic<uint64_t> next_block(1);
+    thread_local uint64_t next = 0;
+    thread_local uint64_t end = 0;
+    if(next == end) {
+      next = next_block.fetch_add(stamp_block, std::memory_order_relaxed);
+      end = next + stamp_block;
+    }
+    
+    return next++;
+    
+  }
+  
+  // Articulation
+  
+  const char* const violation_messages[] = {
+    "", 
+    "Vowel height must be between 0.0 and 6.0.", 
+    "Vowel backness must be between 0.0 and 4.0.", 
+    "Length must be > 0.", 
+    "A vowel cannot have glottal closure.", 
+    "Voiceless phonation paired with voiced vot.", 
+    "Voiced glottal stop", 
+    "Impossible manner-place combination", 
+    "Voiced ejective", 
+    "A nasal consonant must be nasalized.", 
+    "A phone field is outside its enumeration."
+  };
+  
+  void enforce(Phone::Violation violation) {
+    
+    // The throwing counterpart of the try_ functions
+    if(violation != Phone::no_violation) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::impossible_articulation);
+      throw ImpossibleArticulation(expt::literal, 
+                                   violation_messages[violation]);
+    }
+    
+  }
+  
+  template <typename Field>
+  Phone::Violation try_assign(const Phone& phone, Field& field, Field value) {
+    
+    // Changes one field of phone, and changes it back if the result is not 
+    // articulable.
+    Field original = field;
+    field = value;
+    
+    Phone::Violation result = phone.violation();
+    if(result != Phone::no_violation) {
+      field = original;
+    }
+    
+    return result;
+    
+  }
+  
+};
+
+// Symbol tables
+
+namespace {
+  
+  // Building blocks for constant PhoneCodes
+  
+  const uint64_t unit_length = (uint64_t) 0x3F800000 << length_shift;
+  
+  constexpr uint64_t consonant_code(Consonant::Manner manner, 
+                                    Consonant::Place place, 
+                                    Phone::Phonation phonation, 
+                                    Consonant::VOT vot, 
+                                    Phone::Nasalization nasalization, 
+                                    Consonant::Mechanism mechanism, 
+                                    Consonant::Place secondary) {
+    
+    return 1
+         | (uint64_t) phonation << phonation_shift
+         | (uint64_t) nasalization << nasalization_shift
+         | (uint64_t) manner << manner_shift
+         | (uint64_t) place << place_shift
+         | (uint64_t) secondary << secondary_shift
+         | (uint64_t) vot << vot_shift
+         | (uint64_t) mechanism << mechanism_shift
+         | unit_length;
+    
+  }
+  
+  constexpr uint64_t voiceless(Consonant::Manner manner, 
+                               Consonant::Place place) {
+    
+    return consonant_code(manner, place, Phone::voiceless, 
+                          Consonant::not_aspirated, Phone::oral, 
+                          Consonant::pul_eg, place);
+    
+  }
+  
+  constexpr uint64_t voiced(Consonant::Manner manner, 
+                            Consonant::Place place) {
+    
+    return consonant_code(manner, place, Phone::modal, 
+                          Consonant::completely_voiced, Phone::oral, 
+                          Consonant::pul_eg, place);
+    
+  }
+  
+  constexpr uint64_t nasal(Consonant::Place place) {
+    
+    return consonant_code(Consonant::nasal, place, Phone::modal, 
+                          Consonant::completely_voiced, Phone::nasal, 
+                          Consonant::pul_eg, place);
+    
+  }
+  
+  constexpr uint64_t coarticulated(uint64_t code, Consonant::Place secondary) {
+    
+    return (code & ~(secondary_mask << secondary_shift))
+         | (uint64_t) secondary << secondary_shift;
+    
+  }
+  
+  constexpr uint64_t click(Consonant::Place place) {
+    
+    return consonant_code(Consonant::stop, place, Phone::voiceless, 
+                          Consonant::not_aspirated, Phone::oral, 
+                          Consonant::click, place);
+    
+  }
+  
+  constexpr uint64_t implosive(Consonant::Place place) {
+    
+    return consonant_code(Consonant::stop, place, Phone::modal, 
+                          Consonant::completely_voiced, Phone::oral, 
+                          Consonant::implosive, place);
+    
+  }
+  
+  constexpr uint64_t vowel_code(Vowel::Height height, Vowel::Backness backness,
+                                Vowel::Roundedness roundedness) {
+    
+    return (uint64_t) Phone::modal << phonation_shift
+         | (uint64_t) roundedness << roundedness_shift
+         | (uint64_t) height * 256 << height_shift
+         | (uint64_t) backness * 256 << backness_shift
+         | unit_length;
+    
+  }
+  
+  constexpr uint64_t tone_levels(int count, int level1, int level2 = 0) {
+    
+    // Levels are stored offset by 2 so that they are never negative
+    return count | (uint64_t) (level1 + 2) << 2 | (uint64_t) (level2 + 2) << 5;
+    
+  }
+  
+  // Symbols
+  
+  enum SymbolKind {phone_symbol    = 0, 
+                   modifier_symbol = 1, 
+                   tone_symbol     = 2, 
+                   stress_symbol   = 3};
+  
+  enum Modifier {long_modifier           = 0, 
+                 half_long_modifier      = 1, 
+                 extra_short_modifier    = 2, 
+                 nasalized_modifier      = 3, 
+                 aspirated_modifier      = 4, 
+                 voiceless_modifier      = 5, 
+                 breathy_modifier        = 6, 
+                 creaky_modifier         = 7, 
+                 labialized_modifier     = 8, 
+                 palatalized_modifier    = 9, 
+                 velarized_modifier      = 10, 
+                 pharyngealized_modifier = 11, 
+                 r_colored_modifier      = 12, 
+                 ejective_modifier       = 13, 
+                 syllabic_modifier       = 14};
+  
+  struct Symbol {
+    
+    const char* spellings[3];
+      
+      /*
+      The spelling of the symbol in each PhoneticEncoding, indexed by the 
+      encoding.  An empty spelling means the symbol has no equivalent in that 
+      encoding.
+      */
+    
+    SymbolKind kind;
+    
+    uint64_t value;
+      
+      /*
+      A raw PhoneCode for phones, a Modifier for modifiers, a packed list of 
+      levels (see tone_levels()) for tones, and 0 for primary or 1 for 
+      secondary stress
+      */
+    
+  };
+  
+  // Where several symbols share a value, the first one listed is the one 
+  // used when encoding.
+  
+  constexpr Symbol symbols[] = {
+    
+    // Stops
+    {{"p",    "p",      "p"}, phone_symbol, voiceless(Consonant::stop, Consonant::bilabial)},
+    {{"b",    "b",      "b"}, phone_symbol, voiced(Consonant::stop, Consonant::bilabial)},
+    {{"t",    "t",      "t"}, phone_symbol, voiceless(Consonant::stop, Consonant::apical_alveolar)},
+    {{"d",    "d",      "d"}, phone_symbol, voiced(Consonant::stop, Consonant::apical_alveolar)},
+    {{"t`",   "t.",     "ʈ"}, phone_symbol, voiceless(Consonant::stop, Consonant::apical_retroflex)},
+    {{"d`",   "d.",     "ɖ"}, phone_symbol, voiced(Consonant::stop, Consonant::apical_retroflex)},
+    {{"c",    "c",      "c"}, phone_symbol, voiceless(Consonant::stop, Consonant::palatal)},
+    {{"J\\",  "J",      "ɟ"}, phone_symbol, voiced(Consonant::stop, Consonant::palatal)},
+    {{"k",    "k",      "k"}, phone_symbol, voiceless(Consonant::stop, Consonant::velar)},
+    {{"g",    "g",      "ɡ"}, phone_symbol, voiced(Consonant::stop, Consonant::velar)},
+    {{"",     "",       "g"}, phone_symbol, voiced(Consonant::stop, Consonant::velar)},
+    {{"q",    "q",      "q"}, phone_symbol, voiceless(Consonant::stop, Consonant::uvular)},
+    {{"G\\",  "G",      "ɢ"}, phone_symbol, voiced(Consonant::stop, Consonant::uvular)},
+    {{">\\",  "",       "ʡ"}, phone_symbol, voiceless(Consonant::stop, Consonant::epiglottal)},
+    {{"?",    "?",      "ʔ"}, phone_symbol, voiceless(Consonant::stop, Consonant::glottal)},
+    
+    // Nasals
+    {{"m",    "m",      "m"}, phone_symbol, nasal(Consonant::bilabial)},
+    {{"F",    "M",      "ɱ"}, phone_symbol, nasal(Consonant::labiodental)},
+    {{"n",    "n",      "n"}, phone_symbol, nasal(Consonant::apical_alveolar)},
+    {{"n`",   "n.",     "ɳ"}, phone_symbol, nasal(Consonant::apical_retroflex)},
+    {{"J",    "n^",     "ɲ"}, phone_symbol, nasal(Consonant::palatal)},
+    {{"N",    "N",      "ŋ"}, phone_symbol, nasal(Consonant::velar)},
+    {{"N\\",  "n\"",    "ɴ"}, phone_symbol, nasal(Consonant::uvular)},
+    
+    // Trills, flaps, and lateral flaps
+    {{"B\\",  "b<trl>", "ʙ"}, phone_symbol, voiced(Consonant::trill, Consonant::bilabial)},
+    {{"r",    "r<trl>", "r"}, phone_symbol, voiced(Consonant::trill, Consonant::apical_alveolar)},
+    {{"R\\",  "r\"",    "ʀ"}, phone_symbol, voiced(Consonant::trill, Consonant::uvular)},
+    {{"4",    "*",      "ɾ"}, phone_symbol, voiced(Consonant::flap, Consonant::apical_alveolar)},
+    {{"r`",   "*.",     "ɽ"}, phone_symbol, voiced(Consonant::flap, Consonant::apical_retroflex)},
+    {{"l\\",  "*<lat>", "ɺ"}, phone_symbol, voiced(Consonant::lateral_flap, Consonant::apical_alveolar)},
+    
+    // Non-sibilant fricatives
+    {{"p\\",  "P",      "ɸ"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::bilabial)},
+    {{"B",    "B",      "β"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::bilabial)},
+    {{"f",    "f",      "f"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::labiodental)},
+    {{"v",    "v",      "v"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::labiodental)},
+    {{"T",    "T",      "θ"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::apical_dental)},
+    {{"D",    "D",      "ð"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::apical_dental)},
+    {{"C",    "C",      "ç"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::palatal)},
+    {{"j\\",  "C<vcd>", "ʝ"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::palatal)},
+    {{"x",    "x",      "x"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::velar)},
+    {{"G",    "Q",      "ɣ"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::velar)},
+    {{"X",    "X",      "χ"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::uvular)},
+    {{"R",    "g\"",    "ʁ"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::uvular)},
+    {{"X\\",  "H",      "ħ"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::pharyngeal)},
+    {{"?\\",  "H<vcd>", "ʕ"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::pharyngeal)},
+    {{"H\\",  "",       "ʜ"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::epiglottal)},
+    {{"<\\",  "",       "ʢ"}, phone_symbol, voiced(Consonant::nsib_fricative, Consonant::epiglottal)},
+    {{"h",    "h",      "h"}, phone_symbol, voiceless(Consonant::nsib_fricative, Consonant::glottal)},
+    {{"h\\",  "h<?>",   "ɦ"}, phone_symbol, consonant_code(Consonant::nsib_fricative, Consonant::glottal, Phone::breathy, Consonant::completely_voiced, Phone::oral, Consonant::pul_eg, Consonant::glottal)},
+    
+    // Sibilant fricatives
+    {{"s",    "s",      "s"}, phone_symbol, voiceless(Consonant::sib_fricative, Consonant::apical_alveolar)},
+    {{"z",    "z",      "z"}, phone_symbol, voiced(Consonant::sib_fricative, Consonant::apical_alveolar)},
+    {{"S",    "S",      "ʃ"}, phone_symbol, voiceless(Consonant::sib_fricative, Consonant::laminal_palato_alveolar)},
+    {{"Z",    "Z",      "ʒ"}, phone_symbol, voiced(Consonant::sib_fricative, Consonant::laminal_palato_alveolar)},
+    {{"s`",   "s.",     "ʂ"}, phone_symbol, voiceless(Consonant::sib_fricative, Consonant::apical_retroflex)},
+    {{"z`",   "z.",     "ʐ"}, phone_symbol, voiced(Consonant::sib_fricative, Consonant::apical_retroflex)},
+    {{"s\\",  "s;",     "ɕ"}, phone_symbol, voiceless(Consonant::sib_fricative, Consonant::alveolo_palatal)},
+    {{"z\\",  "z;",     "ʑ"}, phone_symbol, voiced(Consonant::sib_fricative, Consonant::alveolo_palatal)},
+    
+    // Lateral fricatives
+    {{"K",    "s<lat>", "ɬ"}, phone_symbol, voiceless(Consonant::lateral_fricative, Consonant::apical_alveolar)},
+    {{"K\\",  "z<lat>", "ɮ"}, phone_symbol, voiced(Consonant::lateral_fricative, Consonant::apical_alveolar)},
+    
+    // Approximants
+    {{"v\\",  "r<lbd>", "ʋ"}, phone_symbol, voiced(Consonant::approximant, Consonant::labiodental)},
+    {{"r\\",  "r",      "ɹ"}, phone_symbol, voiced(Consonant::approximant, Consonant::apical_alveolar)},
+    {{"r\\`", "r.",     "ɻ"}, phone_symbol, voiced(Consonant::approximant, Consonant::apical_retroflex)},
+    {{"j",    "j",      "j"}, phone_symbol, voiced(Consonant::approximant, Consonant::palatal)},
+    {{"M\\",  "j<vel>", "ɰ"}, phone_symbol, voiced(Consonant::approximant, Consonant::velar)},
+    {{"w",    "w",      "w"}, phone_symbol, coarticulated(voiced(Consonant::approximant, Consonant::bilabial), Consonant::velar)},
+    {{"H",    "j<rnd>", "ɥ"}, phone_symbol, coarticulated(voiced(Consonant::approximant, Consonant::palatal), Consonant::bilabial)},
+    {{"W",    "w<vls>", "ʍ"}, phone_symbol, coarticulated(voiceless(Consonant::approximant, Consonant::bilabial), Consonant::velar)},
+    
+    // Lateral approximants
+    {{"l",    "l",      "l"}, phone_symbol, voiced(Consonant::lateral_approximant, Consonant::apical_alveolar)},
+    {{"l`",   "l.",     "ɭ"}, phone_symbol, voiced(Consonant::lateral_approximant, Consonant::apical_retroflex)},
+    {{"L",    "l^",     "ʎ"}, phone_symbol, voiced(Consonant::lateral_approximant, Consonant::palatal)},
+    {{"L\\",  "L",      "ʟ"}, phone_symbol, voiced(Consonant::lateral_approximant, Consonant::velar)},
+    {{"5",    "l<vel>", "ɫ"}, phone_symbol, coarticulated(voiced(Consonant::lateral_approximant, Consonant::apical_alveolar), Consonant::velar)},
+    
+    // Clicks and implosives
+    {{"O\\",  "p!",     "ʘ"}, phone_symbol, click(Consonant::bilabial)},
+    {{"|\\",  "t[!",    "ǀ"}, phone_symbol, click(Consonant::apical_dental)},
+    {{"!\\",  "t!",     "ǃ"}, phone_symbol, click(Consonant::apical_alveolar)},
+    {{"=\\",  "c!",     "ǂ"}, phone_symbol, click(Consonant::palatal)},
+    {{"b_<",  "b`",     "ɓ"}, phone_symbol, implosive(Consonant::bilabial)},
+    {{"d_<",  "d`",     "ɗ"}, phone_symbol, implosive(Consonant::apical_alveolar)},
+    {{"J\\_<", "J`",    "ʄ"}, phone_symbol, implosive(Consonant::palatal)},
+    {{"g_<",  "g`",     "ɠ"}, phone_symbol, implosive(Consonant::velar)},
+    {{"G\\_<", "G`",    "ʛ"}, phone_symbol, implosive(Consonant::uvular)},
+    
+    // Vowels
+    {{"i",    "i",      "i"}, phone_symbol, vowel_code(Vowel::close, Vowel::front, Vowel::unrounded)},
+    {{"y",    "y",      "y"}, phone_symbol, vowel_code(Vowel::close, Vowel::front, Vowel::exolabial)},
+    {{"1",    "i\"",    "ɨ"}, phone_symbol, vowel_code(Vowel::close, Vowel::central, Vowel::unrounded)},
+    {{"}",    "u\"",    "ʉ"}, phone_symbol, vowel_code(Vowel::close, Vowel::central, Vowel::exolabial)},
+    {{"M",    "u-",     "ɯ"}, phone_symbol, vowel_code(Vowel::close, Vowel::back, Vowel::unrounded)},
+    {{"u",    "u",      "u"}, phone_symbol, vowel_code(Vowel::close, Vowel::back, Vowel::exolabial)},
+    {{"I",    "I",      "ɪ"}, phone_symbol, vowel_code(Vowel::near_close, Vowel::near_front, Vowel::unrounded)},
+    {{"Y",    "I.",     "ʏ"}, phone_symbol, vowel_code(Vowel::near_close, Vowel::near_front, Vowel::exolabial)},
+    {{"U",    "U",      "ʊ"}, phone_symbol, vowel_code(Vowel::near_close, Vowel::near_back, Vowel::exolabial)},
+    {{"e",    "e",      "e"}, phone_symbol, vowel_code(Vowel::close_mid, Vowel::front, Vowel::unrounded)},
+    {{"2",    "Y",      "ø"}, phone_symbol, vowel_code(Vowel::close_mid, Vowel::front, Vowel::exolabial)},
+    {{"@\\",  "e\"",    "ɘ"}, phone_symbol, vowel_code(Vowel::close_mid, Vowel::central, Vowel::unrounded)},
+    {{"8",    "o\"",    "ɵ"}, phone_symbol, vowel_code(Vowel::close_mid, Vowel::central, Vowel::exolabial)},
+    {{"7",    "o-",     "ɤ"}, phone_symbol, vowel_code(Vowel::close_mid, Vowel::back, Vowel::unrounded)},
+    {{"o",    "o",      "o"}, phone_symbol, vowel_code(Vowel::close_mid, Vowel::back, Vowel::exolabial)},
+    {{"@",    "@",      "ə"}, phone_symbol, vowel_code(Vowel::mid, Vowel::central, Vowel::unrounded)},
+    {{"E",    "E",      "ɛ"}, phone_symbol, vowel_code(Vowel::open_mid, Vowel::front, Vowel::unrounded)},
+    {{"9",    "W",      "œ"}, phone_symbol, vowel_code(Vowel::open_mid, Vowel::front, Vowel::exolabial)},
+    {{"3",    "V\"",    "ɜ"}, phone_symbol, vowel_code(Vowel::open_mid, Vowel::central, Vowel::unrounded)},
+    {{"3\\",  "O\"",    "ɞ"}, phone_symbol, vowel_code(Vowel::open_mid, Vowel::central, Vowel::exolabial)},
+    {{"V",    "V",      "ʌ"}, phone_symbol, vowel_code(Vowel::open_mid, Vowel::back, Vowel::unrounded)},
+    {{"O",    "O",      "ɔ"}, phone_symbol, vowel_code(Vowel::open_mid, Vowel::back, Vowel::exolabial)},
+    {{"{",    "&",      "æ"}, phone_symbol, vowel_code(Vowel::near_open, Vowel::front, Vowel::unrounded)},
+    {{"6",    "&\"",    "ɐ"}, phone_symbol, vowel_code(Vowel::near_open, Vowel::central, Vowel::unrounded)},
+    {{"a",    "a",      "a"}, phone_symbol, vowel_code(Vowel::open, Vowel::front, Vowel::unrounded)},
+    {{"&",    "&.",     "ɶ"}, phone_symbol, vowel_code(Vowel::open, Vowel::front, Vowel::exolabial)},
+    {{"A",    "A",      "ɑ"}, phone_symbol, vowel_code(Vowel::open, Vowel::back, Vowel::unrounded)},
+    {{"Q",    "A.",     "ɒ"}, phone_symbol, vowel_code(Vowel::open, Vowel::back, Vowel::exolabial)},
+    
+    // Diacritics
+    {{":",    ":",      "ː"},      modifier_symbol, long_modifier},
+    {{":\\",  "",       "ˑ"},      modifier_symbol, half_long_modifier},
+    {{"_X",   "",       "̆"}, modifier_symbol, extra_short_modifier},
+    {{"~",    "~",      "̃"}, modifier_symbol, nasalized_modifier},
+    {{"_h",   "<h>",    "ʰ"},      modifier_symbol, aspirated_modifier},
+    {{"_0",   "<o>",    "̥"}, modifier_symbol, voiceless_modifier},
+    {{"",     "",       "̊"}, modifier_symbol, voiceless_modifier},
+    {{"_t",   "<?>",    "̤"}, modifier_symbol, breathy_modifier},
+    {{"_k",   "",       "̰"}, modifier_symbol, creaky_modifier},
+    {{"_w",   "<w>",    "ʷ"},      modifier_symbol, labialized_modifier},
+    {{"_j",   ";",      "ʲ"},      modifier_symbol, palatalized_modifier},
+    {{"_G",   "<vel>",  "ˠ"},      modifier_symbol, velarized_modifier},
+    {{"_?\\", "<H>",    "ˤ"},      modifier_symbol, pharyngealized_modifier},
+    {{"`",    "<r>",    "˞"},      modifier_symbol, r_colored_modifier},
+    {{"_>",   "`",      "ʼ"},      modifier_symbol, ejective_modifier},
+    {{"=",    "-",      "̩"}, modifier_symbol, syllabic_modifier},
+    
+    // Tones
+    {{"_T",   "",       "˥"},      tone_symbol, tone_levels(1, 2)},
+    {{"_H",   "",       "˦"},      tone_symbol, tone_levels(1, 1)},
+    {{"_M",   "",       "˧"},      tone_symbol, tone_levels(1, 0)},
+    {{"_L",   "",       "˨"},      tone_symbol, tone_levels(1, -1)},
+    {{"_B",   "",       "˩"},      tone_symbol, tone_levels(1, -2)},
+    {{"_R",   "",       "̌"}, tone_symbol, tone_levels(2, -1, 1)},
+    {{"_F",   "",       "̂"}, tone_symbol, tone_levels(2, 1, -1)},
+    {{"",     "",       "̋"}, tone_symbol, tone_levels(1, 2)},
+    {{"",     "",       "́"}, tone_symbol, tone_levels(1, 1)},
+    {{"",     "",       "̄"}, tone_symbol, tone_levels(1, 0)},
+    {{"",     "",       "̀"}, tone_symbol, tone_levels(1, -1)},
+    {{"",     "",       "̏"}, tone_symbol, tone_levels(1, -2)},
+    
+    // Stress
+    {{"\"",   "'",      "ˈ"},      stress_symbol, 0},
+    {{"%",    ",",      "ˌ"},      stress_symbol, 1}
+    
+  };
+  
+  const int symbol_count = sizeof(symbols) / sizeof(Symbol);
+  
+  constexpr bool articulable_code(uint64_t code) {
+    
+    // Every phone in the table has length 1.0 and, for vowels, a named 
+    // height and backness, so only the articulation needs checking.
+    return (code & kind_mask) == 0
+             ? Vowel::articulable((Phone::Phonation) 
+                                  (code >> phonation_shift & phonation_mask))
+         : Consonant::articulable(
+             (Consonant::Manner) (code >> manner_shift & manner_mask), 
+             (Consonant::Place) (code >> place_shift & place_mask), 
+             (Phone::Phonation) (code >> phonation_shift & phonation_mask), 
+             (Consonant::VOT) (code >> vot_shift & vot_mask), 
+             (Phone::Nasalization) 
+               (code >> nasalization_shift & nasalization_mask), 
+             (Consonant::Mechanism) 
+               (code >> mechanism_shift & mechanism_mask));
+    
+  }
+  
+  constexpr bool articulable_symbols(int row = 0) {
+    
+    return row == symbol_count 
+        || ((symbols[row].kind != phone_symbol 
+             || articulable_code(symbols[row].value)) 
+            && articulable_symbols(row + 1));
+    
+  }
+  
+  static_assert(articulable_symbols(), 
+                "Every phone in the symbol table must be articulable.");
+  
+  // UTF-8
+  
+  int code_point(const char* text, int length, int& result) {
+    
+    // Returns the number of bytes in the code point at the start of text, or 
+    // 0 if text does not start with a valid UTF-8 sequence.
+    const unsigned char* bytes = (const unsigned char*) text;
+    if(length < 1) {
+      return 0;
+    }
+    
+    int size;
+    if(bytes[0] < 0x80) {
+      result = bytes[0];
+      return 1;
+    }
+    else if((bytes[0] & 0xE0) == 0xC0) {
+      result = bytes[0] & 0x1F;
+      size = 2;
+    }
+    else if((bytes[0] & 0xF0) == 0xE0) {
+      result = bytes[0] & 0x0F;
+      size = 3;
+    }
+    else if((bytes[0] & 0xF8) == 0xF0) {
+      result = bytes[0] & 0x07;
+      size = 4;
+    }
+    else {
+      return 0;
+    }
+    
+    if(length < size) {
+      return 0;
+    }
+    
+    for(int i = 1; i < size; i++) {
+      if((bytes[i] & 0xC0) != 0x80) {
+        return 0;
+      }
+      result = result << 6 | (bytes[i] & 0x3F);
+    }
+    
+    return size;
+    
+  }
+  
+  // Compile-time tables
+  
+  template <int... I>
+  struct Indices {};
+  
+  template <class First, class Second>
+  struct JoinIndices;
+  
+  template <int... I, int... J>
+  struct JoinIndices<Indices<I...>, Indices<J...> > {
+    
+    typedef Indices<I..., (int) sizeof...(I) + J...> type;
+    
+  };
+  
+  template <int N>
+  struct MakeIndices {
+    
+    // Halves N at each step, so that tables of a thousand entries stay well 
+    // within the template nesting limit
+    typedef typename JoinIndices<
+      typename MakeIndices<N / 2>::type, 
+      typename MakeIndices<N - N / 2>::type>::type type;
+    
+  };
+  
+  template <>
+  struct MakeIndices<0> {
+    
+    typedef Indices<> type;
+    
+  };
+  
+  template <>
+  struct MakeIndices<1> {
+    
+    typedef Indices<0> type;
+    
+  };
+  
+  // Lookup
+  
+  const int indexed_code_points = 0x400;
+  
+  constexpr int spelling_length(const char* spelling, int length = 0) {
+    
+    return spelling[length] == '\0' ? length 
+         : spelling_length(spelling, length + 1);
+    
+  }
+  
+  constexpr int continuation(const char* text, int result, int count) {
+    
+    // Folds the next count continuation bytes of a UTF-8 sequence into result
+    return count == 0 ? result 
+         : continuation(text + 1, 
+                        result << 6 | ((unsigned char) *text & 0x3F), 
+                        count - 1);
+    
+  }
+  
+  constexpr int leading_code_point(const char* text) {
+    
+    // The code point at the start of a valid UTF-8 text, like code_point()
+    return (unsigned char) text[0] < 0x80 ? (unsigned char) text[0] 
+         : (text[0] & 0xE0) == 0xC0 ? continuation(text + 1, text[0] & 0x1F, 1)
+         : (text[0] & 0xF0) == 0xE0 ? continuation(text + 1, text[0] & 0x0F, 2)
+         : (text[0] & 0xF8) == 0xF0 ? continuation(text + 1, text[0] & 0x07, 3)
+         : indexed_code_points;
+    
+  }
+  
+  constexpr short symbol_bucket(const char* spelling) {
+    
+    // The first code point of a spelling, or indexed_code_points if it is 
+    // empty or cannot be indexed
+    return spelling[0] == '\0' ? indexed_code_points 
+         : leading_code_point(spelling) < indexed_code_points 
+             ? leading_code_point(spelling) 
+         : indexed_code_points;
+    
+  }
+  
+  template <int Encoding, class Rows = MakeIndices<symbol_count>::type>
+  struct SymbolRows;
+  
+  template <int Encoding, int... R>
+  struct SymbolRows<Encoding, Indices<R...> > {
+    
+    // The bucket and the length of each row's spelling
+    static constexpr short buckets[symbol_count] = {
+      symbol_bucket(symbols[R].spellings[Encoding])...
+    };
+    
+    static constexpr unsigned char lengths[symbol_count] = {
+      (unsigned char) spelling_length(symbols[R].spellings[Encoding])...
+    };
+    
+  };
+  
+  template <int Encoding, int... R>
+  constexpr short SymbolRows<Encoding, Indices<R...> >::buckets[];
+  
+  template <int Encoding, int... R>
+  constexpr unsigned char SymbolRows<Encoding, Indices<R...> >::lengths[];
+  
+  constexpr bool symbol_precedes(const unsigned char* lengths, int row, 
+                                 int other) {
+    
+    // Within a bucket, longer spellings come first, and then earlier rows
+    return other < 0 || lengths[row] > lengths[other] || 
+           (lengths[row] == lengths[other] && row < other);
+    
+  }
+  
+  constexpr short first_symbol(const short* buckets, 
+                               const unsigned char* lengths, int point, 
+                               int row = 0, int best = -1) {
+    
+    // The row that comes first in the bucket of point, or -1 if it is empty
+    return row == symbol_count ? best 
+         : first_symbol(buckets, lengths, point, row + 1, 
+                        buckets[row] == point && 
+                        symbol_precedes(lengths, row, best) ? row : best);
+    
+  }
+  
+  constexpr short next_symbol(const short* buckets, 
+                              const unsigned char* lengths, int row, 
+                              int other = 0, int best = -1) {
+    
+    // The row that follows row in its bucket, or -1 if it is the last
+    return other == symbol_count ? best 
+         : next_symbol(buckets, lengths, row, other + 1, 
+                       buckets[row] < indexed_code_points && 
+                       buckets[other] == buckets[row] && 
+                       symbol_precedes(lengths, row, other) && 
+                       symbol_precedes(lengths, other, best) ? other : best);
+    
+  }
+  
+  template <int Encoding, 
+            class Points = MakeIndices<indexed_code_points>::type, 
+            class Rows = MakeIndices<symbol_count>::type>
+  struct SymbolTable;
+  
+  template <int Encoding, int... P, int... R>
+  struct SymbolTable<Encoding, Indices<P...>, Indices<R...> > {
+    
+    // The first row in each bucket and the row after each row in its 
+    // bucket, both built by the compiler
+    typedef SymbolRows<Encoding> rows;
+    
+    static constexpr short first[indexed_code_points] = {
+      first_symbol(rows::buckets, rows::lengths, P)...
+    };
+    
+    static constexpr short next[symbol_count] = {
+      next_symbol(rows::buckets, rows::lengths, R)...
+    };
+    
+  };
+  
+  template <int Encoding, int... P, int... R>
+  constexpr short 
+    SymbolTable<Encoding, Indices<P...>, Indices<R...> >::first[];
+  
+  template <int Encoding, int... P, int... R>
+  constexpr short 
+    SymbolTable<Encoding, Indices<P...>, Indices<R...> >::next[];
+  
+  class SymbolIndex {
+    
+    /*
+    Finds the longest symbol at a position in a transcription.  Symbols are 
+    bucketed by their first code point, and each bucket is chained from the 
+    longest spelling to the shortest, so the first full match in a bucket is 
+    the longest one.  All of the symbols in the tables start with a code point 
+    below indexed_code_points.  The buckets are built at compile time by 
+    SymbolTable.
+    */
+    
+    protected:
+      
+      PhoneticEncoding _encoding;
+      
+      const short* _first;
+      
+      const short* _next;
+      
+      const unsigned char* _lengths;
+    
+    public:
+      
+      constexpr SymbolIndex(PhoneticEncoding encoding, const short* first, 
+                            const short* next, const unsigned char* lengths) 
+        : _encoding(encoding), _first(first), _next(next), 
+          _lengths(lengths) {}
+      
+      int match(const char* text, int length, int& symbol_length) const {
+        
+        // Returns the row of the longest symbol at the start of text, or -1 
+        // if there is none.
+        int first;
+        if(!code_point(text, length, first) || first >= indexed_code_points) {
+          return -1;
+        }
+        
+        for(int row = _first[first]; row >= 0; row = _next[row]) {
+          if(_lengths[row] <= length && 
+             std::memcmp(text, symbols[row].spellings[_encoding], 
+                         _lengths[row]) == 0) {
+            symbol_length = _lengths[row];
+            return row;
+          }
+        }
+        
+        return -1;
+        
+      }
+    
+  };
+  
+  template <int Encoding>
+  constexpr SymbolIndex make_symbol_index() {
+    
+    return SymbolIndex((PhoneticEncoding) Encoding, 
+                       SymbolTable<Encoding>::first, 
+                       SymbolTable<Encoding>::next, 
+                       SymbolRows<Encoding>::lengths);
+    
+  }
+  
+  constexpr SymbolIndex symbol_indices[3] = {make_symbol_index<x_sampa>(), 
+                                             make_symbol_index<kirschenbaum>(),
+                                             make_symbol_index<unicode>()};
+  
+  const SymbolIndex& symbol_index(PhoneticEncoding encoding) {
+    
+    return symbol_indices[encoding];
+    
+  }
+  
+  // Diacritics
+  
+  uint64_t with_field(uint64_t code, int shift, uint64_t mask, 
+                      uint64_t value) {
+    
+    return (code & ~(mask << shift)) | (value & mask) << shift;
+    
+  }
+  
+  float code_length(uint64_t code) {
+    
+    uint32_t bits = (uint32_t) (code >> length_shift);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+    
+  }
+  
+  uint64_t with_length(uint64_t code, float length) {
+    
+    return (code & 0xFFFFFFFF) | length_bits(length);
+    
+  }
+  
+  bool apply_modifier(uint64_t modifier, uint64_t& code, bool& syllabic) {
+    
+    // Returns false if the modifier cannot be applied to the phone.
+    bool is_vowel = (code & kind_mask) == 0;
+    uint64_t nasalization = (code >> nasalization_shift) & nasalization_mask;
+    
+    switch(modifier) {
+      
+      case long_modifier:
+        code = with_length(code, code_length(code) + 1.0);
+        return true;
+      
+      case half_long_modifier:
+        code = with_length(code, code_length(code) + 0.5);
+        return true;
+      
+      case extra_short_modifier:
+        code = with_length(code, 0.5);
+        return true;
+      
+      case nasalized_modifier:
+        if(nasalization == Phone::strongly_nasal) {
+          return false;
+        }
+        code = with_field(code, nasalization_shift, nasalization_mask, 
+                          nasalization + 1);
+        return true;
+      
+      case voiceless_modifier:
+        code = with_field(code, phonation_shift, phonation_mask, 
+                          Phone::voiceless);
+        if(!is_vowel && 
+           ((code >> vot_shift) & vot_mask) < Consonant::not_aspirated) {
+          code = with_field(code, vot_shift, vot_mask, 
+                            Consonant::not_aspirated);
+        }
+        return true;
+      
+      case breathy_modifier:
+      case creaky_modifier:
+        // Both are voiced, so they undo the VOT a voiceless mark sets
+        code = with_field(code, phonation_shift, phonation_mask, 
+                          modifier == breathy_modifier ? Phone::breathy : 
+                                                         Phone::creaky);
+        if(!is_vowel && 
+           ((code >> vot_shift) & vot_mask) == Consonant::not_aspirated) {
+          code = with_field(code, vot_shift, vot_mask, 
+                            Consonant::completely_voiced);
+        }
+        return true;
+      
+      case r_colored_modifier:
+        if(!is_vowel) {
+          return false;
+        }
+        code |= (uint64_t) 1 << r_colored_shift;
+        return true;
+      
+      case syllabic_modifier:
+        syllabic = true;
+        return true;
+      
+    }
+    
+    // The remaining modifiers only apply to consonants
+    if(is_vowel) {
+      return false;
+    }
+    
+    switch(modifier) {
+      
+      case aspirated_modifier:
+        code = with_field(code, vot_shift, vot_mask, 
+                          Consonant::moderately_aspirated);
+        return true;
+      
+      case labialized_modifier:
+        code = with_field(code, secondary_shift, secondary_mask, 
+                          Consonant::bilabial);
+        return true;
+      
+      case palatalized_modifier:
+        code = with_field(code, secondary_shift, secondary_mask, 
+                          Consonant::palatal);
+        return true;
+      
+      case velarized_modifier:
+        code = with_field(code, secondary_shift, secondary_mask, 
+                          Consonant::velar);
+        return true;
+      
+      case pharyngealized_modifier:
+        code = with_field(code, secondary_shift, secondary_mask, 
+                          Consonant::pharyngeal);
+        return true;
+      
+      case ejective_modifier:
+        // Clicks and implosives cannot also be ejective
+        if(((code >> mechanism_shift) & mechanism_mask) != 
+           Consonant::pul_eg) {
+          return false;
+        }
+        code = with_field(code, mechanism_shift, mechanism_mask, 
+                          Consonant::ejective);
+        return true;
+      
+    }
+    
+    return false;
+    
+  }
+  
+  // Tones
+  
+  bool add_tone_levels(uint64_t value, int levels[3], int& level_count) {
+    
+    // Returns false if there would be more than three levels.
+    int count = value & 0x3;
+    for(int i = 0; i < count; i++) {
+      if(level_count == 3) {
+        return false;
+      }
+      levels[level_count] = ((value >> (2 + 3 * i)) & 0x7) - 2;
+      level_count++;
+    }
+    
+    return true;
+    
+  }
+  
+  Tone tone_from_levels(const int levels[3], int level_count) {
+    
+    // One level is a level tone, two levels are a contour through the 
+    // midpoint, and three levels are used as they are.
+    switch(level_count) {
+      case 1:
+        return Tone(levels[0], levels[0], levels[0]);
+      case 2:
+        return Tone(levels[0], (levels[0] + levels[1]) / 2, levels[1]);
+      case 3:
+        return Tone(levels[0], levels[1], levels[2]);
+    }
+    
+    return Tone(0, 0, 0);
+    
+  }
+  
+  // Tone codes
+  
+  struct ToneTables {
+    
+    int8_t levels[ToneCode::count][3];
+    uint8_t contours[ToneCode::count];
+    uint8_t order[ToneCode::count];
+    uint8_t ranks[ToneCode::count];
+      // order[rank] is a code and ranks[code] is its rank
+    
+    ToneTables() {
+      
+      for(int code = 0; code < ToneCode::count; code++) {
+        int8_t* tone = levels[code];
+        tone[0] = code / 25 - 2;
+        tone[1] = code / 5 % 5 - 2;
+        tone[2] = code % 5 - 2;
+        
+        int first = tone[1] - tone[0];
+        int second = tone[2] - tone[1];
+        if(first == 0 && second == 0) {
+          contours[code] = ToneCode::level_tone;
+        }
+        else if(first >= 0 && second >= 0) {
+          contours[code] = ToneCode::rising_tone;
+        }
+        else if(first <= 0 && second <= 0) {
+          contours[code] = ToneCode::falling_tone;
+        }
+        else if(first > 0) {
+          contours[code] = ToneCode::peaking_tone;
+        }
+        else {
+          contours[code] = ToneCode::dipping_tone;
+        }
+      }
+      
+      // By contour, then by code
+      int rank = 0;
+      for(int contour = ToneCode::level_tone; 
+          contour <= ToneCode::dipping_tone; contour++) {
+        for(int code = 0; code < ToneCode::count; code++) {
+          if(contours[code] == contour) {
+            order[rank] = code;
+            ranks[code] = rank;
+            rank++;
+          }
+        }
+      }
+      
+    }
+    
+  };
+  
+  const ToneTables& tone_tables() {
+    
+    // Built once, on first use
+    static const ToneTables tables;
+    
+    return tables;
+    
+  }
+  
+  template <class Sequence>
+  void count_tones(const Sequence& sequence, 
+                   long long counts[ToneCode::count]) {
+    
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      counts[sequence[i].tone_code().code()]++;
+    }
+    
+  }
+  
+  // Encoding
+  
+  const int places = Consonant::glottal + 1;
+  
+  const int backnesses = Vowel::back + 1;
+  
+  const int consonant_buckets = (Consonant::nasal + 1) * places;
+  
+  const int phone_buckets = consonant_buckets + (Vowel::close + 1) * backnesses;
+  
+  const int max_long_marks = 3;
+  
+  uint64_t field(uint64_t code, int shift, uint64_t mask) {
+    
+    return (code >> shift) & mask;
+    
+  }
+  
+  int phone_bucket(uint64_t code) {
+    
+    // Consonants are bucketed by manner and place, and vowels by height and 
+    // backness when these are whole steps.  Returns -1 for anything else.
+    if(code & kind_mask) {
+      uint64_t manner = field(code, manner_shift, manner_mask);
+      uint64_t place = field(code, place_shift, place_mask);
+      if(manner > Consonant::nasal || place > Consonant::glottal) {
+        return -1;
+      }
+      return manner * places + place;
+    }
+    
+    uint64_t height = field(code, height_shift, height_mask);
+    uint64_t backness = field(code, backness_shift, backness_mask);
+    if(height % 256 || backness % 256 || height > Vowel::close * 256 || 
+       backness > Vowel::back * 256) {
+      return -1;
+    }
+    
+    return consonant_buckets + height / 256 * backnesses + backness / 256;
+    
+  }
+  
+  int mismatch(uint64_t code, uint64_t target) {
+    
+    // A rough distance between two phones, used to pick the closest symbol 
+    // when a phone cannot be transcribed exactly
+    if((code & kind_mask) != (target & kind_mask)) {
+      return 1000000;
+    }
+    
+    int result = 0;
+    if(target & kind_mask) {
+      int manner = field(code, manner_shift, manner_mask);
+      int place = field(code, place_shift, place_mask);
+      int target_manner = field(target, manner_shift, manner_mask);
+      int target_place = field(target, place_shift, place_mask);
+      result += 10000 * (manner != target_manner);
+      result += 1000 * std::abs(place - target_place);
+    }
+    else {
+      int height = field(code, height_shift, height_mask);
+      int backness = field(code, backness_shift, backness_mask);
+      int target_height = field(target, height_shift, height_mask);
+      int target_backness = field(target, backness_shift, backness_mask);
+      result += 4 * (std::abs(height - target_height) + 
+                     std::abs(backness - target_backness));
+    }
+    
+    if(code != target) {
+      result += 100;
+    }
+    
+    return result;
+    
+  }
+  
+  class EncodingIndex {
+    
+    /*
+    Finds the symbols with which to write a phone.  Phone symbols are bucketed 
+    by phone_bucket(), so that a phone is usually matched against only one or 
+    two symbols, and the diacritics needed to turn each candidate into the 
+    phone are worked out with the same apply_modifier() that decoding uses, so 
+    that whatever is encoded decodes to the same phone.
+    */
+    
+    protected:
+      
+      PhoneticEncoding _encoding;
+      
+      std::vector<int> _buckets[phone_buckets];
+      
+      std::vector<int> _phones;
+      
+      int _modifiers[syllabic_modifier + 1];
+      
+      int _levels[5];
+      
+      int write(int row, char* buffer) const {
+        
+        const char* spelling = symbols[row].spellings[_encoding];
+        int length = std::strlen(spelling);
+        std::memcpy(buffer, spelling, length);
+        return length;
+        
+      }
+      
+      bool modify(int modifier, uint64_t& code, int* modifiers, 
+                  int& count) const {
+        
+        // Applies a modifier if it can be written in this encoding
+        bool syllabic = false;
+        if(_modifiers[modifier] < 0 || 
+           !apply_modifier(modifier, code, syllabic)) {
+          return false;
+        }
+        
+        modifiers[count] = modifier;
+        count++;
+        return true;
+        
+      }
+      
+      int modifiers_for(uint64_t code, uint64_t target, 
+                        int* modifiers, uint64_t& result) const {
+        
+        // Finds the diacritics that take code as close to target as this 
+        // encoding allows.  Returns the number of diacritics.
+        int count = 0;
+        bool is_consonant = target & kind_mask;
+        
+        uint64_t phonation = field(target, phonation_shift, phonation_mask);
+        if(field(code, phonation_shift, phonation_mask) != phonation) {
+          if(phonation == Phone::voiceless) {
+            modify(voiceless_modifier, code, modifiers, count);
+          }
+          else if(phonation == Phone::breathy) {
+            modify(breathy_modifier, code, modifiers, count);
+          }
+          else if(phonation == Phone::creaky) {
+            modify(creaky_modifier, code, modifiers, count);
+          }
+        }
+        
+        while(field(code, nasalization_shift, nasalization_mask) < 
+              field(target, nasalization_shift, nasalization_mask)) {
+          if(!modify(nasalized_modifier, code, modifiers, count)) {
+            break;
+          }
+        }
+        
+        if(is_consonant) {
+          uint64_t vot = field(target, vot_shift, vot_mask);
+          if(vot >= Consonant::weakly_aspirated && 
+             field(code, vot_shift, vot_mask) != vot) {
+            modify(aspirated_modifier, code, modifiers, count);
+          }
+          
+          uint64_t secondary = field(target, secondary_shift, secondary_mask);
+          if(field(code, secondary_shift, secondary_mask) != secondary) {
+            if(secondary == Consonant::bilabial) {
+              modify(labialized_modifier, code, modifiers, count);
+            }
+            else if(secondary == Consonant::palatal) {
+              modify(palatalized_modifier, code, modifiers, count);
+            }
+            else if(secondary == Consonant::velar) {
+              modify(velarized_modifier, code, modifiers, count);
+            }
+            else if(secondary == Consonant::pharyngeal) {
+              modify(pharyngealized_modifier, code, modifiers, count);
+            }
+          }
+          
+          if(field(target, mechanism_shift, mechanism_mask) == 
+             Consonant::ejective && 
+             field(code, mechanism_shift, mechanism_mask) == 
+             Consonant::pul_eg) {
+            modify(ejective_modifier, code, modifiers, count);
+          }
+        }
+        else if(field(target, r_colored_shift, 1) && 
+                !field(code, r_colored_shift, 1)) {
+          modify(r_colored_modifier, code, modifiers, count);
+        }
+        
+        // Length marks go last
+        float length = code_length(target);
+        if(length == 0.5) {
+          modify(extra_short_modifier, code, modifiers, count);
+        }
+        else if(length > 1.0) {
+          int marks = 0;
+          while(code_length(code) + 1.0 <= length && marks < max_long_marks && 
+                modify(long_modifier, code, modifiers, count)) {
+            marks++;
+          }
+          if(code_length(code) + 0.5 <= length) {
+            modify(half_long_modifier, code, modifiers, count);
+          }
+        }
+        
+        result = code;
+        return count;
+        
+      }
+      
+      int closest(const std::vector<int>& rows, uint64_t target, 
+                  int* modifiers, int& modifier_count, int& score) const {
+        
+        // Returns the row in rows that can be made closest to target with the
+        // fewest diacritics, or -1 if rows is empty.
+        int best = -1;
+        int row_modifiers[12];
+        for(int i = 0; i < (int) rows.size(); i++) {
+          uint64_t result;
+          int count = modifiers_for(symbols[rows[i]].value, target, 
+                                    row_modifiers, result);
+          int row_score = mismatch(result, target) + count;
+          if(best < 0 || row_score < score) {
+            best = rows[i];
+            score = row_score;
+            modifier_count = count;
+            std::memcpy(modifiers, row_modifiers, count * sizeof(int));
+          }
+        }
+        
+        return best;
+        
+      }
+    
+    public:
+      
+      EncodingIndex(PhoneticEncoding encoding) {
+        
+        _encoding = encoding;
+        for(int i = 0; i <= syllabic_modifier; i++) {
+          _modifiers[i] = -1;
+        }
+        for(int i = 0; i < 5; i++) {
+          _levels[i] = -1;
+        }
+        
+        // The first usable symbol for each value wins
+        for(int row = 0; row < symbol_count; row++) {
+          const Symbol& symbol = symbols[row];
+          if(symbol.spellings[encoding][0] == '\0') {
+            continue;
+          }
+          
+          if(symbol.kind == phone_symbol) {
+            _phones.push_back(row);
+            int bucket = phone_bucket(symbol.value);
+            if(bucket >= 0) {
+              _buckets[bucket].push_back(row);
+            }
+          }
+          else if(symbol.kind == modifier_symbol && 
+                  _modifiers[symbol.value] < 0) {
+            _modifiers[symbol.value] = row;
+          }
+          else if(symbol.kind == tone_symbol && (symbol.value & 0x3) == 1) {
+            int level = field(symbol.value, 2, 0x7);
+            if(_levels[level] < 0) {
+              _levels[level] = row;
+            }
+          }
+        }
+        
+      }
+      
+      int encode_phone(uint64_t code, bool syllabic, char* buffer) const {
+        
+        int modifiers[12];
+        int modifier_count = 0;
+        int score = 0;
+        int row = -1;
+        int bucket = phone_bucket(code);
+        if(bucket >= 0) {
+          row = closest(_buckets[bucket], code, modifiers, modifier_count, 
+                        score);
+        }
+        
+        // Fall back on searching every symbol when nothing matches exactly
+        if(row < 0 || score >= 100) {
+          row = closest(_phones, code, modifiers, modifier_count, score);
+        }
+        
+        int length = write(row, buffer);
+        for(int i = 0; i < modifier_count; i++) {
+          length += write(_modifiers[modifiers[i]], buffer + length);
+        }
+        if(syllabic && (code & kind_mask) && 
+           _modifiers[syllabic_modifier] >= 0) {
+          length += write(_modifiers[syllabic_modifier], buffer + length);
+        }
+        
+        return length;
+        
+      }
+      
+      int encode_tone(const Tone& tone, char* buffer) const {
+        
+        int levels[3] = {tone[0], tone[1], tone[2]};
+        int count = 3;
+        if(levels[0] == 0 && levels[1] == 0 && levels[2] == 0) {
+          return 0;
+        }
+        else if(levels[0] == levels[1] && levels[1] == levels[2]) {
+          count = 1;
+        }
+        else if(levels[1] == (levels[0] + levels[2]) / 2) {
+          levels[1] = levels[2];
+          count = 2;
+        }
+        
+        int length = 0;
+        for(int i = 0; i < count; i++) {
+          int level = std::min(std::max(levels[i], -2), 2) + 2;
+          if(_levels[level] >= 0) {
+            length += write(_levels[level], buffer + length);
+          }
+        }
+        
+        return length;
+        
+      }
+    
+  };
+  
+  const EncodingIndex& encoding_index(PhoneticEncoding encoding) {
+    
+    // Built once, on first use
+    static const EncodingIndex indices[3] = {EncodingIndex(x_sampa), 
+                                             EncodingIndex(kirschenbaum), 
+                                             EncodingIndex(unicode)};
+    
+    return indices[encoding];
+    
+  }
+  
+  template <class Sequence>
+  void encode_sequence(const Sequence& sequence, std::string& output, 
+                       PhoneticEncoding encoding, char separator) {
+    
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      if(i > 0) {
+        output += separator;
+      }
+      sequence[i].encode(output, encoding);
+    }
+    
+  }
+  
+  // Descriptions
+  
+  const char* const phonation_words[] = {"voiceless", "breathy", "slack", 
+                                         "voiced", "stiff", "creaky", 
+                                         "glottal-closure", "faucalized", 
+                                         "harsh", "strident"};
+  
+  const char* const nasalization_words[] = {"", "nasal", "strongly-nasal"};
+  
+  const char* const height_words[] = {"open", "near-open", "open-mid", "mid", 
+                                      "close-mid", "near-close", "close"};
+  
+  const char* const backness_words[] = {"front", "near-front", "central", 
+                                        "near-back", "back"};
+  
+  const char* const roundedness_words[] = {"unrounded", "rounded", 
+                                           "endolabial rounded"};
+  
+  const char* const manner_words[] = {"lateral flap", "lateral approximant", 
+                                      "lateral fricative", "trill", "flap", 
+                                      "approximant", "non-sibilant fricative",
+                                      "sibilant fricative", "stop", "nasal"};
+  
+  const char* const place_words[] = {"bilabial", "labiodental", "dentolabial", 
+                                     "bidental", "apical-linguolabial", 
+                                     "laminal-linguolabial", 
+                                     "apical-lower-lip", "laminal-lower-lip", 
+                                     "interdental", "apical-dental", 
+                                     "laminal-dental", "apical-alveolar", 
+                                     "laminal-alveolar", 
+                                     "apical-palato-alveolar", 
+                                     "laminal-palato-alveolar", 
+                                     "apical-retroflex", "laminal-retroflex", 
+                                     "subapical-retroflex", "alveolo-palatal", 
+                                     "palatal", "velar", "uvular", 
+                                     "pharyngeal", "epiglottal", "glottal"};
+  
+  const char* const vot_words[] = {"", "moderately-voiced", "weakly-voiced", 
+                                   "", "weakly-aspirated", "aspirated", 
+                                   "strongly-aspirated"};
+  
+  void add_word(std::string& description, const char* word) {
+    
+    if(word[0] == '\0') {
+      return;
+    }
+    if(!description.empty()) {
+      description += ' ';
+    }
+    description += word;
+    
+  }
+  
+  const char* length_word(float length) {
+    
+    if(length < 1.0) {
+      return "short";
+    }
+    else if(length == 1.0) {
+      return "";
+    }
+    else if(length < 2.0) {
+      return "half-long";
+    }
+    else if(length < 3.0) {
+      return "long";
+    }
+    
+    return "extra-long";
+    
+  }
+  
+  void add_position(std::string& description, uint64_t value, 
+                    const char* const* words, int count) {
+    
+    // Heights and backnesses between the named steps are described by the 
+    // steps on either side.
+    uint64_t step = value / 256;
+    if(value % 256 == 0 || (int) step + 1 >= count) {
+      add_word(description, words[std::min((int) step, count - 1)]);
+      return;
+    }
+    
+    add_word(description, words[step]);
+    description += '-';
+    description += words[step + 1];
+    
+  }
+  
+  std::string describe(uint64_t code) {
+    
+    std::string result;
+    add_word(result, length_word(code_length(code)));
+    
+    int phonation = field(code, phonation_shift, phonation_mask);
+    int nasalization = field(code, nasalization_shift, nasalization_mask);
+    
+    if(!(code & kind_mask)) {
+      if(phonation != Phone::modal) {
+        add_word(result, phonation_words[phonation]);
+      }
+      add_word(result, nasalization_words[nasalization]);
+      if(field(code, r_colored_shift, 1)) {
+        add_word(result, "r-colored");
+      }
+      add_position(result, field(code, height_shift, height_mask), 
+                   height_words, 7);
+      add_position(result, field(code, backness_shift, backness_mask), 
+                   backness_words, 5);
+      add_word(result, roundedness_words[field(code, roundedness_shift, 
+                                               roundedness_mask)]);
+      add_word(result, "vowel");
+      return result;
+    }
+    
+    int manner = field(code, manner_shift, manner_mask);
+    int place = field(code, place_shift, place_mask);
+    int secondary = field(code, secondary_shift, secondary_mask);
+    int mechanism = field(code, mechanism_shift, mechanism_mask);
+    
+    add_word(result, phonation_words[phonation]);
+    add_word(result, vot_words[field(code, vot_shift, vot_mask)]);
+    
+    // Nasal stops are nasal by definition
+    if(manner != Consonant::nasal || nasalization != Phone::nasal) {
+      add_word(result, nasalization_words[nasalization]);
+    }
+    
+    if(secondary != place) {
+      switch(secondary) {
+        case Consonant::bilabial:
+          add_word(result, "labialized");
+          break;
+        case Consonant::palatal:
+          add_word(result, "palatalized");
+          break;
+        case Consonant::velar:
+          add_word(result, "velarized");
+          break;
+        case Consonant::pharyngeal:
+          add_word(result, "pharyngealized");
+          break;
+        default:
+          add_word(result, place_words[secondary]);
+          result += "-coarticulated";
+      }
+    }
+    
+    add_word(result, place_words[place]);
+    
+    // Clicks and implosives are kinds of stops
+    if(mechanism == Consonant::ejective) {
+      add_word(result, "ejective");
+    }
+    if(manner == Consonant::stop && mechanism == Consonant::click) {
+      add_word(result, "click");
+    }
+    else if(manner == Consonant::stop && mechanism == Consonant::implosive) {
+      add_word(result, "implosive");
+    }
+    else {
+      if(mechanism == Consonant::click) {
+        add_word(result, "click");
+      }
+      else if(mechanism == Consonant::implosive) {
+        add_word(result, "implosive");
+      }
+      add_word(result, manner_words[manner]);
+    }
+    
+    return result;
+    
+  }
+  
+  struct CachedDescription {
+    
+    uint64_t code;
+    
+    std::string text;
+    
+  };
+  
+  std::string cached_description(uint64_t code) {
+    
+    // Each thread keeps the descriptions it built most recently in a small 
+    // direct-mapped table, so a repeated phone costs one lookup and a copy 
+    // with no lock, and the memory per thread stays bounded.  Descriptions 
+    // are never empty, so an empty text marks an unused entry.
+    const int size = 256;
+    thread_local CachedDescription cache[size];
+    
+    CachedDescription& entry = cache[mix(code) & (size - 1)];
+    if(entry.text.empty() || entry.code != code) {
+      entry.code = code;
+      entry.text = describe(code);
+    }
+    
+    return entry.text;
+    
+  }
+  
+  // Transcoding
+  
+  bool advance_phase(uint64_t code, bool syllabic, int& phase) {
+    
+    // Moves through the onset (0), nucleus (1) and coda (2) the same way the 
+    // Decoder does.  Returns false if the phone cannot come next or, as in 
+    // Decoder::append, cannot be articulated.
+    bool nucleus = (code & kind_mask) == 0 || syllabic;
+    if(nucleus && phase == 2) {
+      return false;
+    }
+    
+    PhoneCode phone_code;
+    phone_code.set_code(code);
+    if(phone_code.violation() != Phone::no_violation) {
+      return false;
+    }
+    
+    if(nucleus) {
+      phase = 1;
+    }
+    else if(phase == 1) {
+      phase = 2;
+    }
+    
+    return true;
+    
+  }
+  
+  const std::vector<int>& translations(PhoneticEncoding source, 
+                                       PhoneticEncoding target) {
+    
+    // For each symbol, the first symbol with the same meaning that can be 
+    // written in the target encoding, or -1.  Built once, on first use.
+    static std::vector<int> tables[3][3];
+    static std::once_flag built;
+    std::call_once(built, [] {
+      for(int from = 0; from < 3; from++) {
+        for(int to = 0; to < 3; to++) {
+          std::vector<int>& table = tables[from][to];
+          table.assign(symbol_count, -1);
+          for(int row = 0; row < symbol_count; row++) {
+            for(int other = 0; other < symbol_count; other++) {
+              if(symbols[other].kind == symbols[row].kind && 
+                 symbols[other].value == symbols[row].value && 
+                 symbols[other].spellings[to][0] != '\0') {
+                table[row] = other;
+                break;
+              }
+            }
+          }
+        }
+      }
+    });
+    
+    return tables[source][target];
+    
+  }
+  
+  const int queue_depth = 4;
+  
+  class ChunkQueue {
+    
+    /*
+    A bounded queue of chunks passed between the stages of a stream 
+    transcoding.  Closing the queue wakes up both ends.
+    */
+    
+    protected:
+      
+      std::deque<std::string> _chunks;
+      
+      bool _closed;
+      
+      std::mutex _mutex;
+      
+      std::condition_variable _changed;
+    
+    public:
+      
+      ChunkQueue() {
+        
+        _closed = false;
+        
+      }
+      
+      bool push(std::string& chunk) {
+        
+        // Takes the contents of chunk.  Returns false if the queue was closed.
+        std::unique_lock<std::mutex> lock(_mutex);
+        while(!_closed && (int) _chunks.size() >= queue_depth) {
+          _changed.wait(lock);
+        }
+        if(_closed) {
+          return false;
+        }
+        
+        _chunks.push_back(std::string());
+        _chunks.back().swap(chunk);
+        _changed.notify_all();
+        return true;
+        
+      }
+      
+      bool pop(std::string& chunk) {
+        
+        // Returns false once the queue is closed and empty.
+        std::unique_lock<std::mutex> lock(_mutex);
+        while(!_closed && _chunks.empty()) {
+          _changed.wait(lock);
+        }
+        if(_chunks.empty()) {
+          return false;
+        }
+        
+        chunk.swap(_chunks.front());
+        _chunks.pop_front();
+        _changed.notify_all();
+        return true;
+        
+      }
+      
+      void close() {
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        _changed.notify_all();
+        
+      }
+    
+  };
+  
+  bool is_separator(char character) {
+    
+    return character == ' ' || character == '\t' || character == '\n' || 
+           character == '\r' || character == '\f' || character == '\v';
+    
+  }
+  
+  // Binary corpora
+  
+  const char corpus_magic[8] = {'L', 'A', 'N', 'G', 'C', 'R', 'P', '\0'};
+  
+  const uint32_t byte_order_mark = 0x01020304;
+  
+  const int header_size = 32;
+  const int header_version = 8;
+  const int header_byte_order = 12;
+  const int header_syllable_count = 16;
+  const int header_phone_count = 24;
+  
+  const int record_size = 16;
+  const int record_offset = 0;
+  const int record_onset = 4;
+  const int record_nucleus = 6;
+  const int record_coda = 8;
+  const int record_tone = 10;
+  
+  template <class Number>
+  Number read_number(const unsigned char* data, int offset) {
+    
+    Number result;
+    std::memcpy(&result, data + offset, sizeof(result));
+    return result;
+    
+  }
+  
+  template <class Number>
+  void write_number(unsigned char* data, int offset, Number value) {
+    
+    std::memcpy(data + offset, &value, sizeof(value));
+    
+  }
+  
+  void write_record(unsigned char* record, const Syllable& syllable, 
+                    uint32_t offset) {
+    
+    // Fills in a zeroed record for a syllable whose first phone is at offset
+    Tone tone = syllable.tone();
+    write_number<uint32_t>(record, record_offset, offset);
+    write_number<uint16_t>(record, record_onset, syllable.onset_size());
+    write_number<uint16_t>(record, record_nucleus, syllable.nucleus_size());
+    write_number<uint16_t>(record, record_coda, syllable.coda_size());
+    for(int i = 0; i < 3; i++) {
+      record[record_tone + i] = (unsigned char) (signed char) tone[i];
+    }
+    
+  }
+  
+  Syllable make_syllable(const PhoneCode* phones, int onset_size, 
+                         int nucleus_size, int coda_size, const Tone& tone) {
+    
+    // Decodes the phones of a syllable stored as PhoneCodes
+    int size = onset_size + nucleus_size + coda_size;
+    std::vector<Vowel> vowels;
+    std::vector<Consonant> consonants;
+    vowels.reserve(size);
+    consonants.reserve(size);
+    for(int i = 0; i < size; i++) {
+      if(phones[i].is_vowel()) {
+        vowels.push_back(phones[i].vowel());
+      }
+      else {
+        consonants.push_back(phones[i].consonant());
+      }
+    }
+    
+    // Point each part of the syllable at the copies in order
+    std::vector<const Phone*> parts[3];
+    int vowel = 0;
+    int consonant = 0;
+    for(int i = 0; i < size; i++) {
+      int part = i < onset_size ? 0 : i < onset_size + nucleus_size ? 1 : 2;
+      if(phones[i].is_vowel()) {
+        parts[part].push_back(&vowels[vowel++]);
+      }
+      else {
+        parts[part].push_back(&consonants[consonant++]);
+      }
+    }
+    
+    return Syllable(parts[0], parts[1], parts[2], tone);
+    
+  }
+  
+  template <class Sequence>
+  void write_sequence(const Sequence& sequence, std::ostream& output) {
+    
+    // Check that everything fits before writing anything
+    uint64_t phones = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      Tone tone = syllable.tone();
+      if(syllable.onset_size() > 0xFFFF || syllable.nucleus_size() > 0xFFFF || 
+         syllable.coda_size() > 0xFFFF) {
+        LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+        throw expt::ValueError(expt::literal, 
+                               "A syllable is too long for a binary corpus.");
+      }
+      for(int j = 0; j < 3; j++) {
+        if(tone[j] < -128 || tone[j] > 127) {
+          LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+          throw expt::ValueError(expt::literal, 
+                                 "A tone is out of range for a binary corpus.");
+        }
+      }
+      phones += syllable.size();
+    }
+    if(phones > std::numeric_limits<uint32_t>::max()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "Too many phones for a binary corpus.");
+    }
+    
+    unsigned char header[header_size] = {0};
+    std::memcpy(header, corpus_magic, sizeof(corpus_magic));
+    write_number<uint32_t>(header, header_version, CorpusView::version);
+    write_number<uint32_t>(header, header_byte_order, byte_order_mark);
+    write_number<uint64_t>(header, header_syllable_count, sequence.size());
+    write_number<uint64_t>(header, header_phone_count, phones);
+    output.write(reinterpret_cast<const char*>(header), header_size);
+    
+    uint32_t offset = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      unsigned char record[record_size] = {0};
+      write_record(record, syllable, offset);
+      output.write(reinterpret_cast<const char*>(record), record_size);
+      offset += syllable.size();
+    }
+    
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      for(Syllable::Slot slot : syllable.span()) {
+        uint64_t code = slot.code().code();
+        output.write(reinterpret_cast<const char*>(&code), sizeof(code));
+      }
+    }
+    
+    if(!output) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception(expt::literal, 
+                            "Could not write the binary corpus.");
+    }
+    
+  }
+  
+  // Columnar scans
+  
+  long long count_matches(const uint8_t* column1, uint8_t value1, 
+                          const uint8_t* column2, uint8_t value2, 
+                          const uint8_t* column3, uint8_t value3, 
+                          long long size) {
+    
+    // Counts the indices where all three columns hold their values.  Callers 
+    // that need fewer columns repeat one.
+    long long result = 0;
+    long long i = 0;
+
+#if LANG_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i match1 = _mm_set1_epi8((char) value1);
+    const __m128i match2 = _mm_set1_epi8((char) value2);
+    const __m128i match3 = _mm_set1_epi8((char) value3);
+    while(size - i >= 16) {
+      
+      // Each byte of counts gains one per match by subtracting the all-ones 
+      // comparison result, so it has to be summed before it can overflow
+      __m128i counts = zero;
+      long long blocks = std::min<long long>((size - i) / 16, 255);
+      for(long long j = 0; j < blocks; j++, i += 16) {
+        __m128i matches = _mm_and_si128(
+          _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (column1 + i)), 
+                         match1), 
+          _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (column2 + i)), 
+                           match2), 
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (column3 + i)), 
+                           match3)));
+        counts = _mm_sub_epi8(counts, matches);
+      }
+      
+      __m128i sums = _mm_sad_epu8(counts, zero);
+      result += _mm_cvtsi128_si32(sums) + 
+                _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+      
+    }
+#endif
+    
+    for(; i < size; i++) {
+      result += column1[i] == value1 && column2[i] == value2 && 
+                column3[i] == value3;
+    }
+    
+    return result;
+    
+  }
+  
+  double sum(const float* column, long long size) {
+    
+    // Accumulates in double precision so that long columns stay accurate
+    double result = 0;
+    long long i = 0;
+
+#if LANG_HAVE_SSE2
+    __m128d low = _mm_setzero_pd();
+    __m128d high = _mm_setzero_pd();
+    for(; size - i >= 4; i += 4) {
+      __m128 values = _mm_loadu_ps(column + i);
+      low = _mm_add_pd(low, _mm_cvtps_pd(values));
+      high = _mm_add_pd(high, _mm_cvtps_pd(_mm_movehl_ps(values, values)));
+    }
+    
+    double totals[2];
+    _mm_storeu_pd(totals, _mm_add_pd(low, high));
+    result = totals[0] + totals[1];
+#endif
+    
+    for(; i < size; i++) {
+      result += column[i];
+    }
+    
+    return result;
+    
+  }
+  
+  void add_tone_counts(const ToneCode* tones, long long size, 
+                       long long* counts) {
+    
+    // A ToneCode is just its one-byte code.  Four sets of counts are kept so 
+    // that runs of the same tone do not wait on each other's increments.
+    const uint8_t* codes = reinterpret_cast<const uint8_t*>(tones);
+    long long partial[4][ToneCode::count] = {};
+    long long i = 0;
+    for(; size - i >= 4; i += 4) {
+      partial[0][codes[i]]++;
+      partial[1][codes[i + 1]]++;
+      partial[2][codes[i + 2]]++;
+      partial[3][codes[i + 3]]++;
+    }
+    for(; i < size; i++) {
+      partial[0][codes[i]]++;
+    }
+    
+    for(int code = 0; code < ToneCode::count; code++) {
+      counts[code] += partial[0][code] + partial[1][code] + 
+                      partial[2][code] + partial[3][code];
+    }
+    
+  }
+  
+  template <class Sequence>
+  void append_sequence(const Sequence& sequence, ColumnarSequence& columns) {
+    
+    long long phones = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      phones += sequence[i].size();
+    }
+    
+    columns.reserve(sequence.size(), phones);
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      columns.append(sequence[i]);
+    }
+    
+  }
+  
+  // Distance kernels
+  
+  float feature_distance(const float* features1, const float* features2) {
+    
+    // The scalar distance between two phones' features
+    float total = 0;
+    for(int k = 0; k < PhoneFeatures::feature_count; k++) {
+      float difference = features2[k] - features1[k];
+      total += difference * difference;
+    }
+    
+    return std::sqrt(total);
+    
+  }
+  
+  void feature_distances(const float* const* columns, int size, 
+                         const float* point, float* output) {
+    
+    // Writes the distance from point to each of the size entries of columns. 
+    // Every path adds up the squared differences in the same order, so they 
+    // all give the same results.
+    const int count = PhoneFeatures::feature_count;
+    int i = 0;
+
+#if LANG_HAVE_AVX
+    __m256 wide_point[count];
+    for(int k = 0; k < count; k++) {
+      wide_point[k] = _mm256_set1_ps(point[k]);
+    }
+    for(; size - i >= 8; i += 8) {
+      __m256 total = _mm256_setzero_ps();
+      for(int k = 0; k < count; k++) {
+        __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(columns[k] + i), 
+                                          wide_point[k]);
+        total = _mm256_add_ps(total, _mm256_mul_ps(difference, difference));
+      }
+      _mm256_storeu_ps(output + i, _mm256_sqrt_ps(total));
+    }
+#endif
+
+#if LANG_HAVE_SSE2
+    __m128 narrow_point[count];
+    for(int k = 0; k < count; k++) {
+      narrow_point[k] = _mm_set1_ps(point[k]);
+    }
+    for(; size - i >= 4; i += 4) {
+      __m128 total = _mm_setzero_ps();
+      for(int k = 0; k < count; k++) {
+        __m128 difference = _mm_sub_ps(_mm_loadu_ps(columns[k] + i), 
+                                       narrow_point[k]);
+        total = _mm_add_ps(total, _mm_mul_ps(difference, difference));
+      }
+      _mm_storeu_ps(output + i, _mm_sqrt_ps(total));
+    }
+#endif
+    
+    for(; i < size; i++) {
+      float total = 0;
+      for(int k = 0; k < count; k++) {
+        float difference = columns[k][i] - point[k];
+        total += difference * difference;
+      }
+      output[i] = std::sqrt(total);
+    }
+    
+  }
+  
+  // Alignment
+  
+  template <class Sequence>
+  std::vector<PhoneCode> flatten(const Sequence& sequence) {
+    
+    // The phones of every syllable in order
+    std::vector<PhoneCode> result;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      for(Syllable::Slot slot : sequence[i].span()) {
+        result.push_back(slot.code());
+      }
+    }
+    
+    return result;
+    
+  }
+  
+  class SubstitutionCosts {
+    
+    // The substitution costs between two strings of phones, with the 
+    // features of every phone worked out once rather than once per pair
+    
+    protected:
+      
+      const PhoneCode* _first;
+      const PhoneCode* _second;
+      std::vector<float> _first_features;
+      std::vector<float> _second_features;
+      float _weight;
+    
+    public:
+      
+      SubstitutionCosts(const PhoneCode* first, int first_size, 
+                        const PhoneCode* second, int second_size, 
+                        float weight) : 
+          _first(first), _second(second), 
+          _first_features(first_size * PhoneFeatures::feature_count), 
+          _second_features(second_size * PhoneFeatures::feature_count), 
+          _weight(weight) {
+        
+        const int count = PhoneFeatures::feature_count;
+        for(int i = 0; i < first_size; i++) {
+          PhoneFeatures::features(first[i], &_first_features[i * count]);
+        }
+        for(int j = 0; j < second_size; j++) {
+          PhoneFeatures::features(second[j], &_second_features[j * count]);
+        }
+        
+      }
+      
+      float operator()(int i, int j) const {
+        
+        // The same value as Aligner::substitution_cost
+        if(_first[i] == _second[j]) {
+          return 0;
+        }
+        
+        const int count = PhoneFeatures::feature_count;
+        return _weight * feature_distance(&_first_features[i * count], 
+                                          &_second_features[j * count]);
+        
+      }
+    
+  };
+  
+  int bit_parallel_distance(const PhoneCode* pattern, int pattern_size, 
+                            const PhoneCode* text, int text_size) {
+    
+    // Myers' algorithm for 1 to 64 pattern phones.  Bit i of each mask 
+    // stands for row i + 1 of the current column of the alignment matrix.
+    const int table_size = 128;
+    uint64_t keys[table_size];
+    uint64_t masks[table_size];
+    bool used[table_size] = {false};
+    
+    // Find the slot for a code in a small open-addressed table of the 
+    // pattern's phones
+    auto slot = [&](const PhoneCode& phone) {
+      int index = phone.hash() & (table_size - 1);
+      while(used[index] && keys[index] != phone.code()) {
+        index = (index + 1) & (table_size - 1);
+      }
+      return index;
+    };
+    
+    for(int i = 0; i < pattern_size; i++) {
+      int index = slot(pattern[i]);
+      if(!used[index]) {
+        used[index] = true;
+        keys[index] = pattern[i].code();
+        masks[index] = 0;
+      }
+      masks[index] |= (uint64_t) 1 << i;
+    }
+    
+    uint64_t positive = ~(uint64_t) 0;
+    uint64_t negative = 0;
+    uint64_t last = (uint64_t) 1 << (pattern_size - 1);
+    int score = pattern_size;
+    for(int j = 0; j < text_size; j++) {
+      int index = slot(text[j]);
+      uint64_t equal = used[index] ? masks[index] : 0;
+      uint64_t vertical = equal | negative;
+      uint64_t horizontal = (((equal & positive) + positive) ^ positive) | equal;
+      uint64_t horizontal_positive = negative | ~(horizontal | positive);
+      uint64_t horizontal_negative = positive & horizontal;
+      
+      if(horizontal_positive & last) {
+        score++;
+      }
+      else if(horizontal_negative & last) {
+        score--;
+      }
+      
+      // The top row of the matrix counts up by one along the text
+      horizontal_positive = (horizontal_positive << 1) | 1;
+      horizontal_negative <<= 1;
+      positive = horizontal_negative | ~(vertical | horizontal_positive);
+      negative = horizontal_positive & vertical;
+    }
+    
+    return score;
+    
+  }
+  
+  // Hash tables
+  
+  template <class Matches>
+  std::size_t probe_slots(const std::vector<int>& slots, 
+                          const std::vector<std::size_t>& hashes, 
+                          std::size_t hash, const Matches& matches) {
+    
+    // Linear probing over a power-of-two table of IDs, calling matches only 
+    // when the stored hash is the same.  Returns the slot holding the 
+    // matching ID, or the empty slot where it would go.
+    std::size_t mask = slots.size() - 1;
+    std::size_t slot = hash & mask;
+    while(slots[slot] >= 0) {
+      int id = slots[slot];
+      if(hashes[id] == hash && matches(id)) {
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+    
+    return slot;
+    
+  }
+  
+  void grow_slots(std::vector<int>& slots, 
+                  const std::vector<std::size_t>& hashes) {
+    
+    // Doubles the table and reinserts every ID using the stored hashes
+    std::vector<int> grown(2 * slots.size(), -1);
+    std::size_t mask = grown.size() - 1;
+    for(int id = 0; id < (int) hashes.size(); id++) {
+      std::size_t slot = hashes[id] & mask;
+      while(grown[slot] >= 0) {
+        slot = (slot + 1) & mask;
+      }
+      grown[slot] = id;
+    }
+    
+    slots.swap(grown);
+    
+  }
+  
+  // N-grams
+  
+  const uint64_t ngram_boundary = 0xFFFF;
+  
+  const int ngram_max_id = 0xFFFD;
+    // So that an ID plus 1 is never the boundary
+  
+  template <class Sequence>
+  void count_shards(NgramCounter& counter, const Sequence& sequence, 
+                    int size, ThreadPool& pool) {
+    
+    // Each shard is a contiguous range counted into its own table
+    int shards = pool.size();
+    std::vector<NgramCounter> counters(shards, 
+                                       NgramCounter(counter.order(), 
+                                                    counter.inventory()));
+    pool.run(shards, [&](int begin, int end) {
+      for(int shard = begin; shard < end; shard++) {
+        int first = (long long) size * shard / shards;
+        int last = (long long) size * (shard + 1) / shards;
+        for(int i = first; i < last; i++) {
+          counters[shard].add(sequence[i]);
+        }
+      }
+    }, 1);
+    
+    for(int shard = 0; shard < shards; shard++) {
+      counter.merge(counters[shard]);
+    }
+    
+  }
+  
+  // Bitmaps
+  
+  int popcount(uint64_t word) {
+
+#if LANG_HAVE_BUILTINS
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + 
+           ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (word * 0x0101010101010101ULL) >> 56;
+#endif
+    
+  }
+  
+  int highest_bit(uint64_t word) {
+    
+    // word must not be 0
+
+#if LANG_HAVE_BUILTINS
+    return 63 - __builtin_clzll(word);
+#else
+    int result = 0;
+    while(word >>= 1) {
+      result++;
+    }
+    return result;
+#endif
+    
+  }
+  
+  int lowest_bit(uint64_t word) {
+    
+    // word must not be 0
+
+#if LANG_HAVE_BUILTINS
+    return __builtin_ctzll(word);
+#else
+    int result = 0;
+    while(!(word & 1)) {
+      word >>= 1;
+      result++;
+    }
+    return result;
+#endif
+    
+  }
+  
+  // Sound changes
+  
+  enum RuleFeature {part_feature         = 0, 
+                    phonation_feature    = 1, 
+                    nasalization_feature = 2, 
+                    roundedness_feature  = 3, 
+                    manner_feature       = 4, 
+                    place_feature        = 5, 
+                    vot_feature          = 6, 
+                    mechanism_feature    = 7};
+  
+  const uint32_t vowel_kind     = 0x1;
+  const uint32_t consonant_kind = 0x2;
+  
+  uint32_t value_range(int first, int last) {
+    
+    // The bits from first to last, inclusive
+    if(last < first) {
+      return 0;
+    }
+    
+    return (2u << last) - (1u << first);
+    
+  }
+  
+  void change_phone(const std::vector<SoundChange::Rule>& rules, 
+                    Syllable::Slot& phone, Syllable::Part part, int syllable, 
+                    int position, 
+                    std::vector<SoundChange::Rejection>* rejections) {
+    
+    // Runs every rule over one phone
+    for(int i = 0; i < (int) rules.size(); i++) {
+      if(!rules[i].matches(phone, part)) {
+        continue;
+      }
+      
+      // A rejected change leaves the phone as it was
+      Phone::Violation violation = rules[i].apply(phone);
+      if(violation != Phone::no_violation && rejections) {
+        SoundChange::Rejection rejection = {syllable, position, i, 
+                                            phone.code(), violation};
+        rejections->push_back(rejection);
+      }
+    }
+    
+  }
+  
+  class ChangeCache {
+    
+    /*
+    Remembers what the rules did to each distinct phone in each part of a 
+    syllable.  Only a few hundred distinct phones turn up in practice, so 
+    almost every phone of a sequence is changed with one lookup in this 
+    open-addressed table instead of by running it through every rule.
+    */
+    
+    protected:
+      
+      struct Entry {
+        
+        Syllable::Slot phone;
+        Syllable::Slot result;
+        int part;
+        int first;
+        int count;
+        
+        Entry() : phone(PhoneCode()), result(PhoneCode()) {}
+        
+      };
+      
+      const std::vector<SoundChange::Rule>& _rules;
+      
+      std::vector<Entry> _entries;
+      
+      int _used;
+      
+      std::vector<SoundChange::Rejection> _rejections;
+        
+        /*
+        The rejections of each entry, from first to first + count, with the 
+        syllable and position left as 0
+        */
+      
+      int slot(const Syllable::Slot& phone, int part) const {
+        
+        // Vowels whose exact heights and backnesses round alike hash alike
+        int mask = _entries.size() - 1;
+        int index = mix(phone.code().code() + part) & mask;
+        while(_entries[index].part >= 0 && 
+              (_entries[index].phone != phone || 
+               _entries[index].part != part)) {
+          index = (index + 1) & mask;
+        }
+        
+        return index;
+        
+      }
+      
+      void grow() {
+        
+        std::vector<Entry> entries(_entries.size() * 2);
+        entries.swap(_entries);
+        for(int i = 0; i < (int) _entries.size(); i++) {
+          _entries[i].part = -1;
+        }
+        for(int i = 0; i < (int) entries.size(); i++) {
+          if(entries[i].part >= 0) {
+            _entries[slot(entries[i].phone, entries[i].part)] = entries[i];
+          }
+        }
+        
+      }
+    
+    public:
+      
+      ChangeCache(const std::vector<SoundChange::Rule>& rules) : 
+          _rules(rules), _entries(64) {
+        
+        _used = 0;
+        for(int i = 0; i < (int) _entries.size(); i++) {
+          _entries[i].part = -1;
+        }
+        
+      }
+      
+      bool change(Syllable::Slot& phone, Syllable::Part part, int syllable, 
+                  int position, 
+                  std::vector<SoundChange::Rejection>* rejections) {
+        
+        // Returns whether the phone changed
+        int index = slot(phone, part);
+        if(_entries[index].part < 0) {
+          if(2 * (_used + 1) > (int) _entries.size()) {
+            grow();
+            index = slot(phone, part);
+          }
+          
+          Entry& entry = _entries[index];
+          entry.phone = phone;
+          entry.result = phone;
+          entry.part = part;
+          entry.first = _rejections.size();
+          change_phone(_rules, entry.result, part, 0, 0, &_rejections);
+          entry.count = _rejections.size() - entry.first;
+          _used++;
+        }
+        
+        const Entry& entry = _entries[index];
+        if(rejections) {
+          for(int i = entry.first; i < entry.first + entry.count; i++) {
+            SoundChange::Rejection rejection = _rejections[i];
+            rejection.syllable = syllable;
+            rejection.position = position;
+            rejections->push_back(rejection);
+          }
+        }
+        
+        if(entry.result == phone) {
+          return false;
+        }
+        
+        phone = entry.result;
+        return true;
+        
+      }
+    
+  };
+  
+  struct PhoneChanger {
+    
+    // Applies the rules to each phone of a syllable, in its Slot, through 
+    // Syllable::visit_slots
+    ChangeCache& cache;
+    std::vector<SoundChange::Rejection>* rejections;
+    int syllable;
+    int position;
+    long long changed;
+    
+    bool operator()(Syllable::Slot& slot, Syllable::Part part) {
+      
+      if(cache.change(slot, part, syllable, position++, rejections)) {
+        changed++;
+        return true;
+      }
+      
+      return false;
+      
+    }
+    
+  };
+  
+  // Thread pools
+  
+  struct PoolFrame {
+    
+    // One thread pool loop that the current thread is taking part in, and 
+    // the one it was already taking part in before that
+    const ThreadPool* pool;
+    const PoolFrame* outer;
+    
+  };
+  
+  const PoolFrame*& pool_frames() {
+    
+    thread_local const PoolFrame* frames = 0;
+    return frames;
+    
+  }
+  
+  struct EnteredPool {
+    
+    // Records that the current thread is taking part in a loop of pool for 
+    // as long as it exists
+    PoolFrame frame;
+    
+    EnteredPool(const ThreadPool* pool) {
+      
+      frame.pool = pool;
+      frame.outer = pool_frames();
+      pool_frames() = &frame;
+      
+    }
+    
+    ~EnteredPool() {
+      
+      pool_frames() = frame.outer;
+      
+    }
+    
+  };
+  
+  bool in_pool(const ThreadPool* pool) {
+    
+    for(const PoolFrame* frame = pool_frames(); frame; frame = frame->outer) {
+      if(frame->pool == pool) {
+        return true;
+      }
+    }
+    
+    return false;
+    
+  }
+  
+  // Instrumentation
+  
+  typedef std::atomic<long long> Counter;
+  
+  struct EventCounters {
+    
+    // The counts of one thread.  Only that thread writes them, so relaxed 
+    // loads and stores are enough, and other threads can read them at any 
+    // time.
+    Counter counts[Instrumentation::event_count];
+    Counter nanoseconds[Instrumentation::event_count];
+    
+  };
+  
+  struct EventRegistry {
+    
+    std::mutex mutex;
+    std::vector<EventCounters*> threads;
+    long long retired[2][Instrumentation::event_count];
+    long long baseline[2][Instrumentation::event_count];
+    std::atomic<Instrumentation::TraceHook> hook;
+    std::atomic<void*> data;
+    
+  };
+  
+  EventRegistry& event_registry() {
+    
+    // Built once, on first use, and never destroyed, so that threads that 
+    // finish during static destruction can still retire their counts
+    static EventRegistry* registry = new EventRegistry();
+    return *registry;
+    
+  }
+  
+  void add_counts(const EventCounters& counters, 
+                  long long totals[2][Instrumentation::event_count]) {
+    
+    for(int i = 0; i < Instrumentation::event_count; i++) {
+      totals[0][i] += counters.counts[i].load(std::memory_order_relaxed);
+      totals[1][i] += counters.nanoseconds[i].load(std::memory_order_relaxed);
+    }
+    
+  }
+  
+  void total_counts(EventRegistry& registry, 
+                    long long totals[2][Instrumentation::event_count]) {
+    
+    // registry.mutex must be held
+    std::memcpy(totals, registry.retired, sizeof(registry.retired));
+    for(EventCounters* counters : registry.threads) {
+      add_counts(*counters, totals);
+    }
+    
+  }
+  
+  struct ThreadCounters {
+    
+    // Registers a thread's counters for its lifetime, and folds them into 
+    // the retired totals when the thread finishes
+    EventCounters counters;
+    
+    ThreadCounters() {
+      
+      for(int i = 0; i < Instrumentation::event_count; i++) {
+        counters.counts[i].store(0, std::memory_order_relaxed);
+        counters.nanoseconds[i].store(0, std::memory_order_relaxed);
+      }
+      
+      EventRegistry& registry = event_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.threads.push_back(&counters);
+      
+    }
+    
+    ~ThreadCounters() {
+      
+      EventRegistry& registry = event_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      add_counts(counters, registry.retired);
+      registry.threads.erase(std::find(registry.threads.begin(), 
+                                       registry.threads.end(), &counters));
+      
+    }
+    
+  };
+  
+  EventCounters& thread_counters() {
+    
+    thread_local ThreadCounters counters;
+    return counters.counters;
+    
+  }
+  
+  void increment(Counter& counter, long long value) {
+    
+    counter.store(counter.load(std::memory_order_relaxed) + value, 
+                  std::memory_order_relaxed);
+    
+  }
+  
+  
+  // Enumeration names
+  
+  const uint32_t fnv_offset = 2166136261u;
+  const uint32_t fnv_prime  = 16777619u;
+  
+  constexpr uint32_t name_hash(const char* name, uint32_t hash) {
+    
+    // FNV-1a, starting from hash so that it can be seeded
+    return *name == '\0' ? hash 
+         : name_hash(name + 1, (hash ^ (unsigned char) *name) * fnv_prime);
+    
+  }
+  
+  uint32_t name_hash(const char* name, int length, uint32_t hash) {
+    
+    for(int i = 0; i < length; i++) {
+      hash = (hash ^ (unsigned char) name[i]) * fnv_prime;
+    }
+    
+    return hash;
+    
+  }
+  
+  constexpr int name_table_size(int count, int size = 1) {
+    
+    // The smallest power of two with at least four slots per name, which 
+    // keeps the search for a seed short
+    return size >= 4 * count ? size : name_table_size(count, size * 2);
+    
+  }
+  
+  template <const char* const* Names, int Count, 
+            int Size = name_table_size(Count)>
+  struct NameHash {
+    
+    // Searches at compile time for a seed that gives every name a slot of
+    // its own
+    static constexpr int slot(const char* name, uint32_t seed) {
+      
+      return name_hash(name, seed) % Size;
+      
+    }
+    
+    static constexpr bool unique(uint32_t seed, int i, int j) {
+      
+      return j == Count || 
+             (slot(Names[i], seed) != slot(Names[j], seed) && 
+              unique(seed, i, j + 1));
+      
+    }
+    
+    static constexpr bool perfect(uint32_t seed, int i = 0) {
+      
+      return i == Count || (unique(seed, i, i + 1) && perfect(seed, i + 1));
+      
+    }
+    
+    static constexpr uint32_t seed(uint32_t candidate = fnv_offset) {
+      
+      return perfect(candidate) ? candidate : seed(candidate + 1);
+      
+    }
+    
+    static constexpr int value(int index, uint32_t seed, int i = 0) {
+      
+      // The value whose name has the slot, or -1 if there is none
+      return i == Count ? -1 
+           : slot(Names[i], seed) == index ? i 
+           : value(index, seed, i + 1);
+      
+    }
+    
+  };
+  
+  template <const char* const* Names, int Count, 
+            int Size = name_table_size(Count), 
+            class List = typename MakeIndices<Size>::type>
+  struct NameTable;
+  
+  template <const char* const* Names, int Count, int Size, int... I>
+  struct NameTable<Names, Count, Size, Indices<I...> > {
+    
+    typedef NameHash<Names, Count, Size> hash;
+    
+    static constexpr uint32_t seed = hash::seed();
+    
+    static constexpr signed char values[Size] = {
+      (signed char) hash::value(I, seed)...
+    };
+    
+  };
+  
+  template <const char* const* Names, int Count, int Size, int... I>
+  constexpr uint32_t NameTable<Names, Count, Size, Indices<I...> >::seed;
+  
+  template <const char* const* Names, int Count, int Size, int... I>
+  constexpr signed char 
+    NameTable<Names, Count, Size, Indices<I...> >::values[];
+  
+  template <class Enum>
+  struct ValueCount;
+  
+  template <>
+  struct ValueCount<Phone::Phonation> {
+    
+    static const int value = Phone::strident + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Phone::Nasalization> {
+    
+    static const int value = Phone::strongly_nasal + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Vowel::Height> {
+    
+    static const int value = Vowel::close + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Vowel::Backness> {
+    
+    static const int value = Vowel::back + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Vowel::Roundedness> {
+    
+    static const int value = Vowel::endolabial + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Consonant::Manner> {
+    
+    static const int value = Consonant::nasal + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Consonant::Place> {
+    
+    static const int value = Consonant::glottal + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Consonant::VOT> {
+    
+    static const int value = Consonant::strongly_aspirated + 1;
+    
+  };
+  
+  template <>
+  struct ValueCount<Consonant::Mechanism> {
+    
+    static const int value = Consonant::implosive + 1;
+    
+  };
+  
+  template <const char* const* Names, class Enum>
+  bool find_name(const char* name, int length, Enum& result) {
+    
+    // One hash, one slot, and one comparison with the only name that could 
+    // match
+    typedef NameTable<Names, ValueCount<Enum>::value> table;
+    int size = sizeof(table::values);
+    int value = table::values[name_hash(name, length, table::seed) % size];
+    if(value < 0 || (int) std::strlen(Names[value]) != length || 
+       std::memcmp(Names[value], name, length) != 0) {
+      return false;
+    }
+    
+    result = (Enum) value;
+    return true;
+    
+  }
+  
+  template <class Enum>
+  Enum& step(Enum& value, int val) {
+    
+    // val is reduced first so that neither the sum nor negating it can 
+    // overflow.  The count is a constant, so the remainders compile to 
+    // multiplications.
+    const int count = ValueCount<Enum>::value;
+    value = (Enum) ((value + val % count + count) % count);
+    return value;
+    
+  }
+  
+  template <class Enum>
+  Enum& step_back(Enum& value, int val) {
+    
+    return step(value, -(val % ValueCount<Enum>::value));
+    
+  }
+  
+};
+
+// Classes
+
+// ImpossibleArticulation
+  
+  ImpossibleArticulation::~ImpossibleArticulation() {}
+  
+  ImpossibleArticulation::ImpossibleArticulation() {}
+  
+  ImpossibleArticulation::ImpossibleArticulation(std::string message) 
+    : expt::Exception(std::move(message)) {}
+  
+  ImpossibleArticulation::ImpossibleArticulation(const char* message) 
+    : expt::Exception(message) {}
+  
+  ImpossibleArticulation::ImpossibleArticulation(expt::Literal, 
+                                                 const char* message) 
+    : expt::Exception(expt::literal, message) {}
+  
+  ImpossibleArticulation::ImpossibleArticulation(
+    const ImpossibleArticulation& original) : expt::Exception(original) {}
+  
+  ImpossibleArticulation::operator expt::Exception() {
+    
+    return expt::Exception(*this);
+    
+  }
+  
+  ImpossibleArticulation::operator expt::ValueError() {
+    
+    // Copies the message fields as they are, so a literal stays a pointer
+    expt::ValueError result;
+    result.expt::Exception::operator=(*this);
+    return result;
+    
+  }
+
+// DecodingFailed
+  
+  DecodingFailed::~DecodingFailed() {}
+  
+  DecodingFailed::DecodingFailed() {
+    
+    // Initialize essential fields
+    _position = -1;
+    
+  }
+  
+  DecodingFailed::DecodingFailed(std::string message) 
+    : ValueError(std::move(message)) {
+    
+    // Initialize essential fields
+    _position = -1;
+    
+  }
+  
+  DecodingFailed::DecodingFailed(const char* message) 
+    : ValueError(message) {
+    
+    // Initialize essential fields
+    _position = -1;
+    
+  }
+  
+  DecodingFailed::DecodingFailed(expt::Literal, const char* message) 
+    : ValueError(expt::literal, message) {
+    
+    // Initialize essential fields
+    _position = -1;
+    
+  }
+  
+  DecodingFailed::DecodingFailed(long long position) 
+    : ValueError(expt::literal, decoding_failed) {
+    
+    // Initialize essential fields
+    _position = position;
+    
+  }
+  
+  DecodingFailed::DecodingFailed(const DecodingFailed& original) 
+                               : ValueError(original) {
+    
+    // Initialize essential fields
+    _position = original._position;
+    
+  }
+  
+  DecodingFailed& DecodingFailed::operator=(const DecodingFailed& other) {
+    
+    // Transfer fields
+    ValueError::operator=(other);
+    _position = other._position;
+    
+    return *this;
+    
+  }
+  
+  std::string DecodingFailed::message() const {
+    
+    // set_message replaces the literal, and its message is kept as it is
+    if(_literal != decoding_failed) {
+      return ValueError::message();
+    }
+    
+    return "Transcription could not be decoded at byte " + 
+           std::to_string(_position) + ".";
+    
+  }
+  
+  long long DecodingFailed::position() const {
+    
+    return _position;
+    
+  }
+
+// Phone
+  
+  Phone::~Phone() {}
+  
+  Phone::Nasalization Phone::nasalization() const {
+    
+    return _nasalization;
+    
+  }
+  
+  void Phone::set_nasalization(Nasalization new_nasalization) {
+    
+    enforce(try_set_nasalization(new_nasalization));
+    
+  }
+  
+  Phone::Violation Phone::try_set_nasalization(Nasalization new_nasalization) {
+    
+    return try_assign(*this, _nasalization, new_nasalization);
+    
+  }
+  
+  bool Phone::is_nasal() const {
+    
+    return _nasalization != oral;
+    
+  }
+  
+  Phone::Phonation Phone::phonation() const {
+    
+    return _phonation;
+    
+  }
+  
+  void Phone::set_phonation(Phonation new_phonation) {
+    
+    enforce(try_set_phonation(new_phonation));
+    
+  }
+  
+  Phone::Violation Phone::try_set_phonation(Phonation new_phonation) {
+    
+    return try_assign(*this, _phonation, new_phonation);
+    
+  }
+  
+  void Phone::incr_phonation(int val) {
+    
+    set_phonation(wrap<Phonation>(_phonation + val, strident + 1));
+    
+  }
+  
+  void Phone::decr_phonation(int val) {
+    
+    set_phonation(wrap<Phonation>(_phonation - val, strident + 1));
+    
+  }
+  
+  float Phone::length() const {
+    
+    return _length;
+    
+  }
+  
+  void Phone::set_length(float new_length) {
+    
+    enforce(try_set_length(new_length));
+    
+  }
+  
+  Phone::Violation Phone::try_set_length(float new_length) {
+    
+    return try_assign(*this, _length, new_length);
+    
+  }
+  
+  void Phone::lengthen(float val) {
+    
+    set_length(_length + val);
+    
+  }
+  
+  void Phone::shorten(float val) {
+    
+    enforce(try_shorten(val));
+    
+  }
+  
+  Phone::Violation Phone::try_shorten(float val) {
+    
+    return try_set_length(_length - val);
+    
+  }
+  
+  void Phone::double_length() {
+    
+    _length *= 2;
+    
+  }
+  
+  void Phone::halve_length() {
+    
+    _length /= 2;
+    
+  }
+
+// Vowel
+  
+  Vowel::~Vowel() {}
+  
+  Vowel::Vowel() {
+    
+    // Initialize essential fields
+    _height = mid;
+    _backness = central;
+    _roundedness = unrounded;
+    _r_colored = false;
+    _nasalization = oral;
+    _phonation = modal;
+    _length = 1.0;
+    
+  }
+  
+  Vowel::Vowel(float height, float backness, Roundedness roundedness) {
+    
+    enforce(check(height, backness, roundedness));
+    
+    // Initialize essential fields
+    _height = height;
+    _backness = backness;
+    _roundedness = roundedness;
+    _r_colored = false;
+    _nasalization = oral;
+    _phonation = modal;
+    _length = 1.0;
+    
+  }
+  
+  Vowel::Vowel(float height, float backness, Roundedness roundedness, 
+               Nasalization nasalization, bool r_colored, Phonation phonation,
+               float length) {
+    
+    enforce(check(height, backness, roundedness, nasalization, r_colored, 
+                  phonation, length));
+    
+    // Initialize essential fields
+    _height = height;
+    _backness = backness;
+    _roundedness = roundedness;
+    _r_colored = r_colored;
+    _nasalization = nasalization;
+    _phonation = phonation;
+    _length = length;
+    
+  }
+  
+  Phone::Violation Vowel::try_make(Vowel& result, float height, float backness,
+                                   Roundedness roundedness, 
+                                   Nasalization nasalization, bool r_colored, 
+                                   Phonation phonation, float length) {
+    
+    Violation violation = check(height, backness, roundedness, nasalization, 
+                                r_colored, phonation, length);
+    if(violation != no_violation) {
+      return violation;
+    }
+    
+    result._height = height;
+    result._backness = backness;
+    result._roundedness = roundedness;
+    result._r_colored = r_colored;
+    result._nasalization = nasalization;
+    result._phonation = phonation;
+    result._length = length;
+    
+    return no_violation;
+    
+  }
+  
+  Vowel::Vowel(const Vowel& original) {
+    
+    // Initialize essential fields
+    _height = original._height;
+    _backness = original._backness;
+    _roundedness = original._roundedness;
+    _r_colored = original._r_colored;
+    _nasalization = original._nasalization;
+    _phonation = original._phonation;
+    _length = original._length;
+    
+  }
+  
+  Vowel& Vowel::operator=(const Vowel& other) {
+    
+    // Transfer fields
+    _height = other._height;
+    _backness = other._backness;
+    _roundedness = other._roundedness;
+    _r_colored = other._r_colored;
+    _nasalization = other._nasalization;
+    _phonation = other._phonation;
+    _length = other._length;
+    
+    return *this;
+    
+  }
+  
+  bool Vowel::operator==(const Vowel& other) const {
+    
+    return _height == other._height && _backness == other._backness && 
+           _roundedness == other._roundedness && 
+           _r_colored == other._r_colored && 
+           _nasalization == other._nasalization && 
+           _phonation == other._phonation && _length == other._length;
+    
+  }
+  
+  bool Vowel::operator!=(const Vowel& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  std::string Vowel::description() const {
+    
+    return PhoneCode(*this).description();
+    
+  }
+  
+  Phone::Violation Vowel::violation() const {
+    
+    return check(_height, _backness, _roundedness, _nasalization, _r_colored, 
+                 _phonation, _length);
+    
+  }
+  
+  std::size_t Vowel::hash() const {
+    
+    return PhoneCode(*this).hash();
+    
+  }
+  
+  float Vowel::height() const {
+    
+    return _height;
+    
+  }
+  
+  void Vowel::set_height(float new_height) {
+    
+    enforce(try_set_height(new_height));
+    
+  }
+  
+  Phone::Violation Vowel::try_set_height(float new_height) {
+    
+    return try_assign(*this, _height, new_height);
+    
+  }
+  
+  void Vowel::raise(float val) {
+    
+    enforce(try_raise(val));
+    
+  }
+  
+  Phone::Violation Vowel::try_raise(float val) {
+    
+    return try_set_height(_height + val);
+    
+  }
+  
+  void Vowel::lower(float val) {
+    
+    enforce(try_lower(val));
+    
+  }
+  
+  Phone::Violation Vowel::try_lower(float val) {
+    
+    return try_set_height(_height - val);
+    
+  }
+  
+  float Vowel::backness() const {
+    
+    return _backness;
+    
+  }
+  
+  void Vowel::set_backness(float new_backness) {
+    
+    enforce(try_set_backness(new_backness));
+    
+  }
+  
+  Phone::Violation Vowel::try_set_backness(float new_backness) {
+    
+    return try_assign(*this, _backness, new_backness);
+    
+  }
+  
+  void Vowel::move_back(float val) {
+    
+    enforce(try_move_back(val));
+    
+  }
+  
+  Phone::Violation Vowel::try_move_back(float val) {
+    
+    return try_set_backness(_backness + val);
+    
+  }
+  
+  void Vowel::move_forward(float val) {
+    
+    enforce(try_move_forward(val));
+    
+  }
+  
+  Phone::Violation Vowel::try_move_forward(float val) {
+    
+    return try_set_backness(_backness - val);
+    
+  }
+  
+  Vowel::Roundedness Vowel::roundedness() const {
+    
+    return _roundedness;
+    
+  }
+  
+  void Vowel::set_roundedness(Roundedness new_roundedness) {
+    
+    _roundedness = new_roundedness;
+    
+  }
+  
+  bool Vowel::is_rounded() const {
+    
+    return _roundedness != unrounded;
+    
+  }
+  
+  bool Vowel::is_r_colored() const {
+    
+    return _r_colored;
+    
+  }
+  
+  void Vowel::r_color() {
+    
+    _r_colored = true;
+    
+  }
+  
+  void Vowel::de_r_color() {
+    
+    _r_colored = false;
+    
+  }
+
+// Consonant
+  
+  Consonant::~Consonant() {}
+  
+  Consonant::Consonant() {
+    
+    // Initialize essential fields
+    _manner = stop;
+    _place = apical_alveolar;
+    _secondary_articulation = apical_alveolar;
+    _phonation = voiceless;
+    _vot = moderately_aspirated;
+    _nasalization = oral;
+    _mechanism = pul_eg;
+    _length = 1.0;
+    
+  }
+  
+  Consonant::Consonant(Manner manner, Place place, Phonation phonation, 
+                       VOT vot, Nasalization nasalization, Mechanism mechanism,
+                       float length) {
+    
+    enforce(check(manner, place, phonation, vot, nasalization, mechanism, 
+                  length));
+    
+    // Initialize essential fields
+    _manner = manner;
+    _place = place;
+    _secondary_articulation = place;
+    _phonation = phonation;
+    _vot = vot;
+    _nasalization = nasalization;
+    _mechanism = mechanism;
+    _length = length;
+    
+  }
+  
+  Phone::Violation Consonant::try_make(Consonant& result, Manner manner, 
+                                       Place place, Phonation phonation, 
+                                       VOT vot, Nasalization nasalization, 
+                                       Mechanism mechanism, float length) {
+    
+    Violation violation = check(manner, place, phonation, vot, nasalization, 
+                                mechanism, length);
+    if(violation != no_violation) {
+      return violation;
+    }
+    
+    result._manner = manner;
+    result._place = place;
+    result._secondary_articulation = place;
+    result._phonation = phonation;
+    result._vot = vot;
+    result._nasalization = nasalization;
+    result._mechanism = mechanism;
+    result._length = length;
+    
+    return no_violation;
+    
+  }
+  
+  Consonant::Consonant(const Consonant& original) {
+    
+    // Initialize essential fields
+    _manner = original._manner;
+    _place = original._place;
+    _secondary_articulation = original._secondary_articulation;
+    _phonation = original._phonation;
+    _vot = original._vot;
+    _nasalization = original._nasalization;
+    _mechanism = original._mechanism;
+    _length = original._length;
+    
+  }
+  
+  Consonant& Consonant::operator=(const Consonant& other) {
+    
+    // Transfer fields
+    _manner = other._manner;
+    _place = other._place;
+    _secondary_articulation = other._secondary_articulation;
+    _phonation = other._phonation;
+    _vot = other._vot;
+    _nasalization = other._nasalization;
+    _mechanism = other._mechanism;
+    _length = other._length;
+    
+    return *this;
+    
+  }
+  
+  bool Consonant::operator==(const Consonant& other) const {
+    
+    return _manner == other._manner && _place == other._place && 
+           _secondary_articulation == other._secondary_articulation && 
+           _phonation == other._phonation && _vot == other._vot && 
+           _nasalization == other._nasalization && 
+           _mechanism == other._mechanism && _length == other._length;
+    
+  }
+  
+  bool Consonant::operator!=(const Consonant& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  std::string Consonant::description() const {
+    
+    return PhoneCode(*this).description();
+    
+  }
+  
+  Phone::Violation Consonant::violation() const {
+    
+    return check(_manner, _place, _phonation, _vot, _nasalization, _mechanism,
+                 _length);
+    
+  }
+  
+  std::size_t Consonant::hash() const {
+    
+    return PhoneCode(*this).hash();
+    
+  }
+  
+  Consonant::Manner Consonant::manner() const {
+    
+    return _manner;
+    
+  }
+  
+  void Consonant::set_manner(Manner new_manner) {
+    
+    enforce(try_set_manner(new_manner));
+    
+  }
+  
+  Phone::Violation Consonant::try_set_manner(Manner new_manner) {
+    
+    return try_assign(*this, _manner, new_manner);
+    
+  }
+  
+  void Consonant::incr_manner(int val) {
+    
+    set_manner(wrap<Manner>(_manner + val, nasal + 1));
+    
+  }
+  
+  void Consonant::decr_manner(int val) {
+    
+    set_manner(wrap<Manner>(_manner - val, nasal + 1));
+    
+  }
+  
+  Consonant::Place Consonant::place() const {
+    
+    return _place;
+    
+  }
+  
+  void Consonant::set_place(Place new_place) {
+    
+    enforce(try_set_place(new_place));
+    
+  }
+  
+  Phone::Violation Consonant::try_set_place(Place new_place) {
+    
+    // A consonant without a secondary articulation keeps none
+    bool secondary = _secondary_articulation != _place;
+    Violation result = try_assign(*this, _place, new_place);
+    if(result == no_violation && !secondary) {
+      _secondary_articulation = _place;
+    }
+    
+    return result;
+    
+  }
+  
+  void Consonant::incr_place(int val) {
+    
+    set_place(wrap<Place>(_place + val, glottal + 1));
+    
+  }
+  
+  void Consonant::decr_place(int val) {
+    
+    set_place(wrap<Place>(_place - val, glottal + 1));
+    
+  }
+  
+  bool Consonant::has_secondary_articulation() const {
+    
+    return _secondary_articulation != _place;
+    
+  }
+  
+  Consonant::Place Consonant::secondary_articulation() const {
+    
+    return _secondary_articulation;
+    
+  }
+  
+  void Consonant::set_secondary_articulation(Place new_place) {
+    
+    // The rules do not depend on the secondary articulation, so any place is
+    // allowed.
+    _secondary_articulation = new_place;
+    
+  }
+  
+  void Consonant::remove_secondary_articulation() {
+    
+    _secondary_articulation = _place;
+    
+  }
+  
+  void Consonant::incr_secondary_articulation(int val) {
+    
+    set_secondary_articulation(wrap<Place>(_secondary_articulation + val, 
+                                           glottal + 1));
+    
+  }
+  
+  void Consonant::decr_secondary_articulation(int val) {
+    
+    set_secondary_articulation(wrap<Place>(_secondary_articulation - val, 
+                                           glottal + 1));
+    
+  }
+  
+  Consonant::VOT Consonant::vot() const {
+    
+    return _vot;
+    
+  }
+  
+  void Consonant::set_vot(VOT new_vot) {
+    
+    enforce(try_set_vot(new_vot));
+    
+  }
+  
+  Phone::Violation Consonant::try_set_vot(VOT new_vot) {
+    
+    return try_assign(*this, _vot, new_vot);
+    
+  }
+  
+  void Consonant::later_vot(int val) {
+    
+    set_vot(wrap<VOT>(_vot + val, strongly_aspirated + 1));
+    
+  }
+  
+  void Consonant::earlier_vot(int val) {
+    
+    set_vot(wrap<VOT>(_vot - val, strongly_aspirated + 1));
+    
+  }
+  
+  Consonant::Mechanism Consonant::mechanism() const {
+    
+    return _mechanism;
+    
+  }
+  
+  void Consonant::set_mechanism(Mechanism new_mechanism) {
+    
+    enforce(try_set_mechanism(new_mechanism));
+    
+  }
+  
+  Phone::Violation Consonant::try_set_mechanism(Mechanism new_mechanism) {
+    
+    return try_assign(*this, _mechanism, new_mechanism);
+    
+  }
+  
+  void Consonant::incr_mechanism(int val) {
+    
+    set_mechanism(wrap<Mechanism>(_mechanism + val, implosive + 1));
+    
+  }
+  
+  void Consonant::decr_mechanism(int val) {
+    
+    set_mechanism(wrap<Mechanism>(_mechanism - val, implosive + 1));
+    
+  }
+
+// PhoneCode
+  
+  static_assert(std::is_trivially_copyable<PhoneCode>::value, 
+                "PhoneCode must stay trivially copyable.");
+  
+  static_assert(sizeof(PhoneCode) == sizeof(uint64_t), 
+                "PhoneCode must stay the size of its code.");
+  
+  PhoneCode::PhoneCode() {
+    
+    // Initialize essential fields
+    _code = PhoneCode(Vowel())._code;
+    
+  }
+  
+  PhoneCode::PhoneCode(const Vowel& vowel) {
+    
+    // Initialize essential fields
+    _code = (uint64_t) vowel.phonation() << phonation_shift
+          | (uint64_t) vowel.nasalization() << nasalization_shift
+          | (uint64_t) vowel.roundedness() << roundedness_shift
+          | (uint64_t) vowel.is_r_colored() << r_colored_shift
+          | quantize(vowel.height()) << height_shift
+          | quantize(vowel.backness()) << backness_shift
+          | length_bits(vowel.length());
+    
+  }
+  
+  PhoneCode::PhoneCode(const Consonant& consonant) {
+    
+    // Initialize essential fields
+    _code = 1
+          | (uint64_t) consonant.phonation() << phonation_shift
+          | (uint64_t) consonant.nasalization() << nasalization_shift
+          | (uint64_t) consonant.manner() << manner_shift
+          | (uint64_t) consonant.place() << place_shift
+          | (uint64_t) consonant.secondary_articulation() << secondary_shift
+          | (uint64_t) consonant.vot() << vot_shift
+          | (uint64_t) consonant.mechanism() << mechanism_shift
+          | length_bits(consonant.length());
+    
+  }
+  
+  PhoneCode::PhoneCode(const Phone& phone) {
+    
+    // Dispatch on the dynamic type of the phone
+    const Vowel* vowel = dynamic_cast<const Vowel*>(&phone);
+    if(vowel) {
+      _code = PhoneCode(*vowel)._code;
+      return;
+    }
+    
+    const Consonant* consonant = dynamic_cast<const Consonant*>(&phone);
+    if(consonant) {
+      _code = PhoneCode(*consonant)._code;
+      return;
+    }
+    
+    LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+    throw expt::ValueError(expt::literal, 
+                           "Only vowels and consonants can be encoded.");
+    
+  }
+  
+  bool PhoneCode::operator==(const PhoneCode& other) const {
+    
+    return _code == other._code;
+    
+  }
+  
+  bool PhoneCode::operator!=(const PhoneCode& other) const {
+    
+    return _code != other._code;
+    
+  }
+  
+  bool PhoneCode::operator<(const PhoneCode& other) const {
+    
+    return _code < other._code;
+    
+  }
+  
+  std::size_t PhoneCode::hash() const {
+    
+    return (std::size_t) mix(_code);
+    
+  }
+  
+  std::string PhoneCode::description() const {
+    
+    return cached_description(_code);
+    
+  }
+  
+  uint64_t PhoneCode::code() const {
+    
+    return _code;
+    
+  }
+  
+  void PhoneCode::set_code(uint64_t new_code) {
+    
+    _code = new_code;
+    
+  }
+  
+  bool PhoneCode::is_vowel() const {
+    
+    return (_code & kind_mask) == 0;
+    
+  }
+  
+  bool PhoneCode::is_consonant() const {
+    
+    return (_code & kind_mask) == 1;
+    
+  }
+  
+  Vowel PhoneCode::vowel() const {
+    
+    if(!is_vowel()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "PhoneCode does not encode a vowel.");
+    }
+    
+    return Vowel(height(), backness(), roundedness(), nasalization(),
+                 is_r_colored(), phonation(), length());
+    
+  }
+  
+  Consonant PhoneCode::consonant() const {
+    
+    if(!is_consonant()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "PhoneCode does not encode a consonant.");
+    }
+    
+    Consonant result(manner(), place(), phonation(), vot(), nasalization(),
+                     mechanism(), length());
+    if(secondary_articulation() != place()) {
+      result.set_secondary_articulation(secondary_articulation());
+    }
+    
+    return result;
+    
+  }
+  
+  Phone::Violation PhoneCode::violation() const {
+    
+    if(is_vowel()) {
+      return Vowel::check(height(), backness(), roundedness(), nasalization(), 
+                          is_r_colored(), phonation(), length());
+    }
+    
+    // The secondary articulation is the one field that check does not see
+    if((unsigned) secondary_articulation() > Consonant::glottal) {
+      return Phone::undefined_value;
+    }
+    
+    return Consonant::check(manner(), place(), phonation(), vot(), 
+                            nasalization(), mechanism(), length());
+    
+  }
+  
+  Phone::Phonation PhoneCode::phonation() const {
+    
+    return (Phone::Phonation) ((_code >> phonation_shift) & phonation_mask);
+    
+  }
+  
+  Phone::Nasalization PhoneCode::nasalization() const {
+    
+    return (Phone::Nasalization) ((_code >> nasalization_shift)
+                                  & nasalization_mask);
+    
+  }
+  
+  float PhoneCode::length() const {
+    
+    uint32_t bits = (uint32_t) (_code >> length_shift);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+    
+  }
+  
+  float PhoneCode::height() const {
+    
+    return ((_code >> height_shift) & height_mask) / quantization_steps;
+    
+  }
+  
+  float PhoneCode::backness() const {
+    
+    return ((_code >> backness_shift) & backness_mask) / quantization_steps;
+    
+  }
+  
+  Vowel::Roundedness PhoneCode::roundedness() const {
+    
+    return (Vowel::Roundedness) ((_code >> roundedness_shift)
+                                 & roundedness_mask);
+    
+  }
+  
+  bool PhoneCode::is_r_colored() const {
+    
+    return (_code >> r_colored_shift) & 1;
+    
+  }
+  
+  Consonant::Manner PhoneCode::manner() const {
+    
+    return (Consonant::Manner) ((_code >> manner_shift) & manner_mask);
+    
+  }
+  
+  Consonant::Place PhoneCode::place() const {
+    
+    return (Consonant::Place) ((_code >> place_shift) & place_mask);
+    
+  }
+  
+  Consonant::Place PhoneCode::secondary_articulation() const {
+    
+    return (Consonant::Place) ((_code >> secondary_shift) & secondary_mask);
+    
+  }
+  
+  Consonant::VOT PhoneCode::vot() const {
+    
+    return (Consonant::VOT) ((_code >> vot_shift) & vot_mask);
+    
+  }
+  
+  Consonant::Mechanism PhoneCode::mechanism() const {
+    
+    return (Consonant::Mechanism) ((_code >> mechanism_shift)
+                                   & mechanism_mask);
+    
+  }
+
+// Arena
+  
+  Arena::~Arena() {
+    
+    release();
+    
+  }
+  
+  Arena::Arena(std::size_t block_size) {
+    
+    if(block_size == 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "An arena's block size must be positive.");
+    }
+    
+    // Initialize essential fields
+    _block_size = block_size;
+    _used = 0;
+    _next = 0;
+    _end = 0;
+    _allocated = 0;
+    _reserved = 0;
+    
+  }
+  
+  void* Arena::allocate(std::size_t size, std::size_t alignment) {
+    
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "An alignment must be a power of two.");
+    }
+    
+    // Round the next free byte up to the alignment
+    std::uintptr_t next = reinterpret_cast<std::uintptr_t>(_next);
+    std::uintptr_t padding = (alignment - next % alignment) % alignment;
+    
+    if(!_next || padding + size > (std::size_t) (_end - _next)) {
+      
+      // Blocks from the heap are only aligned for std::max_align_t, so an 
+      // over-aligned allocation may need padding even at the start of one
+      std::size_t slack = 0;
+      if(alignment > alignof(std::max_align_t)) {
+        slack = alignment - 1;
+      }
+      if(size > std::numeric_limits<std::size_t>::max() - slack) {
+        throw std::bad_alloc();
+      }
+      
+      // Large allocations get a block of their own, so that they do not waste
+      // the rest of the current one
+      if(size + slack > _block_size / 2) {
+        _large.reserve(_large.size() + 1);
+        void* block = ::operator new(size + slack);
+        _large.push_back(block);
+        _allocated += size;
+        _reserved += size + slack;
+        next = reinterpret_cast<std::uintptr_t>(block);
+        return static_cast<char*>(block) + 
+               (alignment - next % alignment) % alignment;
+      }
+      
+      // Move on to the next block, reusing one kept by reset if there is one
+      if(_used == _blocks.size()) {
+        _blocks.reserve(_blocks.size() + 1);
+        _blocks.push_back(::operator new(_block_size));
+        _reserved += _block_size;
+      }
+      _next = static_cast<char*>(_blocks[_used]);
+      _used++;
+      _end = _next + _block_size;
+      next = reinterpret_cast<std::uintptr_t>(_next);
+      padding = (alignment - next % alignment) % alignment;
+      
+    }
+    
+    void* result = _next + padding;
+    _next += padding + size;
+    _allocated += size;
+    
+    return result;
+    
+  }
+  
+  void Arena::release() {
+    
+    reset();
+    for(int i = 0; i < (int) _blocks.size(); i++) {
+      ::operator delete(_blocks[i]);
+    }
+    
+    _blocks.clear();
+    _reserved = 0;
+    
+  }
+  
+  void Arena::reset() {
+    
+    for(int i = 0; i < (int) _large.size(); i++) {
+      ::operator delete(_large[i]);
+    }
+    
+    _large.clear();
+    _used = 0;
+    _next = 0;
+    _end = 0;
+    _allocated = 0;
+    _reserved = _blocks.size() * _block_size;
+    
+  }
+  
+  std::size_t Arena::allocated() const {
+    
+    return _allocated;
+    
+  }
+  
+  std::size_t Arena::reserved() const {
+    
+    return _reserved;
+    
+  }
+
+// Tone::iterator
+  
+  Tone::iterator::~iterator() {}
+  
+  Tone::iterator::iterator(Tone& tone, int position) {
+    
+    // Initialize essential fields
+    _tone = &tone;
+    _position = checked_position(position, 3);
+    
+  }
+  
+  Tone::iterator::iterator(const iterator& original) {
+    
+    // Initialize essential fields
+    _tone = original._tone;
+    _position = original._position;
+    
+  }
+  
+  Tone::iterator& Tone::iterator::operator=(const iterator& other) {
+    
+    // Transfer fields
+    _tone = other._tone;
+    _position = other._position;
+    
+    return *this;
+    
+  }
+  
+  Tone::iterator& Tone::iterator::operator++() {
+    
+    _position = checked_step(_position + 1, 3);
+    return *this;
+    
+  }
+  
+  Tone::iterator Tone::iterator::operator++(int) {
+    
+    iterator result(*this);
+    ++*this;
+    return result;
+    
+  }
+  
+  Tone::iterator& Tone::iterator::operator--() {
+    
+    _position = checked_step(_position - 1, 3);
+    return *this;
+    
+  }
+  
+  Tone::iterator Tone::iterator::operator--(int) {
+    
+    iterator result(*this);
+    --*this;
+    return result;
+    
+  }
+  
+  bool Tone::iterator::operator==(const iterator& other) const {
+    
+    return _tone == other._tone && _position == other._position;
+    
+  }
+  
+  bool Tone::iterator::operator!=(const iterator& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  bool Tone::iterator::operator>(const iterator& other) const {
+    
+    return _position > other._position;
+    
+  }
+  
+  bool Tone::iterator::operator>(int position) const {
+    
+    return _position > position;
+    
+  }
+  
+  bool Tone::iterator::operator<(const iterator& other) const {
+    
+    return _position < other._position;
+    
+  }
+  
+  bool Tone::iterator::operator<(int position) const {
+    
+    return _position < position;
+    
+  }
+  
+  bool Tone::iterator::operator>=(const iterator& other) const {
+    
+    return _position >= other._position;
+    
+  }
+  
+  bool Tone::iterator::operator>=(int position) const {
+    
+    return _position >= position;
+    
+  }
+  
+  bool Tone::iterator::operator<=(const iterator& other) const {
+    
+    return _position <= other._position;
+    
+  }
+  
+  bool Tone::iterator::operator<=(int position) const {
+    
+    return _position <= position;
+    
+  }
+  
+  Tone::iterator& Tone::iterator::operator+=(int val) {
+    
+    _position = checked_step(_position + val, 3);
+    return *this;
+    
+  }
+  
+  Tone::iterator& Tone::iterator::operator-=(int val) {
+    
+    _position = checked_step(_position - val, 3);
+    return *this;
+    
+  }
+  
+  int Tone::iterator::operator[](int index) {
+    
+    return _tone->_array[checked_index(_position + index, 3)];
+    
+  }
+  
+  int Tone::iterator::operator*() {
+    
+    return _tone->_array[checked_index(_position, 3)];
+    
+  }
+  
+  Tone& Tone::iterator::tone() const {
+    
+    return *_tone;
+    
+  }
+  
+  void Tone::iterator::set_tone(Tone& new_tone) {
+    
+    _tone = &new_tone;
+    
+  }
+  
+  int Tone::iterator::position() const {
+    
+    return _position;
+    
+  }
+  
+  int Tone::iterator::inverse_position() const {
+    
+    return _position - 3;
+    
+  }
+  
+  void Tone::iterator::set_position(int position) {
+    
+    _position = checked_position(position, 3);
+    
+  }
+
+// Tone::const_iterator
+  
+  Tone::const_iterator::~const_iterator() {}
+  
+  Tone::const_iterator::const_iterator(const Tone& tone, int position) {
+    
+    // Initialize essential fields
+    _tone = &tone;
+    _position = checked_position(position, 3);
+    
+  }
+  
+  Tone::const_iterator::const_iterator(const const_iterator& original) {
+    
+    // Initialize essential fields
+    _tone = original._tone;
+    _position = original._position;
+    
+  }
+  
+  Tone::const_iterator& Tone::const_iterator::operator=(
+    const const_iterator& other) {
+    
+    // Transfer fields
+    _tone = other._tone;
+    _position = other._position;
+    
+    return *this;
+    
+  }
+  
+  Tone::const_iterator& Tone::const_iterator::operator++() {
+    
+    _position = checked_step(_position + 1, 3);
+    return *this;
+    
+  }
+  
+  Tone::const_iterator Tone::const_iterator::operator++(int) {
+    
+    const_iterator result(*this);
+    ++*this;
+    return result;
+    
+  }
+  
+  Tone::const_iterator& Tone::const_iterator::operator--() {
+    
+    _position = checked_step(_position - 1, 3);
+    return *this;
+    
+  }
+  
+  Tone::const_iterator Tone::const_iterator::operator--(int) {
+    
+    const_iterator result(*this);
+    --*this;
+    return result;
+    
+  }
+  
+  bool Tone::const_iterator::operator==(const const_iterator& other) const {
+    
+    return _tone == other._tone && _position == other._position;
+    
+  }
+  
+  bool Tone::const_iterator::operator!=(const const_iterator& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  bool Tone::const_iterator::operator>(const const_iterator& other) const {
+    
+    return _position > other._position;
+    
+  }
+  
+  bool Tone::const_iterator::operator>(int position) const {
+    
+    return _position > position;
+    
+  }
+  
+  bool Tone::const_iterator::operator<(const const_iterator& other) const {
+    
+    return _position < other._position;
+    
+  }
+  
+  bool Tone::const_iterator::operator<(int position) const {
+    
+    return _position < position;
+    
+  }
+  
+  bool Tone::const_iterator::operator>=(const const_iterator& other) const {
+    
+    return _position >= other._position;
+    
+  }
+  
+  bool Tone::const_iterator::operator>=(int position) const {
+    
+    return _position >= position;
+    
+  }
+  
+  bool Tone::const_iterator::operator<=(const const_iterator& other) const {
+    
+    return _position <= other._position;
+    
+  }
+  
+  bool Tone::const_iterator::operator<=(int position) const {
+    
+    return _position <= position;
+    
+  }
+  
+  Tone::const_iterator& Tone::const_iterator::operator+=(int val) {
+    
+    _position = checked_step(_position + val, 3);
+    return *this;
+    
+  }
+  
+  Tone::const_iterator& Tone::const_iterator::operator-=(int val) {
+    
+    _position = checked_step(_position - val, 3);
+    return *this;
+    
+  }
+  
+  int Tone::const_iterator::operator[](int index) const {
+    
+    return _tone->_array[checked_index(_position + index, 3)];
+    
+  }
+  
+  int Tone::const_iterator::operator*() const {
+    
+    return _tone->_array[checked_index(_position, 3)];
+    
+  }
+  
+  const Tone& Tone::const_iterator::tone() const {
+    
+    return *_tone;
+    
+  }
+  
+  void Tone::const_iterator::set_tone(const Tone& new_tone) {
+    
+    _tone = &new_tone;
+    
+  }
+  
+  int Tone::const_iterator::position() const {
+    
+    return _position;
+    
+  }
+  
+  int Tone::const_iterator::inverse_position() const {
+    
+    return _position - 3;
+    
+  }
+  
+  void Tone::const_iterator::set_position(int position) {
+    
+    _position = checked_position(position, 3);
+    
+  }
+
+// Tone
+  
+  Tone::~Tone() {}
+  
+  Tone::Tone() {
+    
+    // Initialize essential fields
+    _array[0] = 0;
+    _array[1] = 0;
+    _array[2] = 0;
+    
+  }
+  
+  Tone::Tone(int tone1, int tone2, int tone3) {
+    
+    if(tone1 < -2 || tone1 > 2 || tone2 < -2 || tone2 > 2 || 
+       tone3 < -2 || tone3 > 2) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::impossible_articulation);
+      throw ImpossibleArticulation(expt::literal, 
+                                   "Tone levels must be between -2 and 2.");
+    }
+    
+    // Initialize essential fields
+    _array[0] = tone1;
+    _array[1] = tone2;
+    _array[2] = tone3;
+    
+  }
+  
+  Tone::Tone(std::initializer_list<int> list) {
+    
+    *this = list;
+    
+  }
+  
+  Tone::Tone(const Tone& original) {
+    
+    // Initialize essential fields
+    _array[0] = original._array[0];
+    _array[1] = original._array[1];
+    _array[2] = original._array[2];
+    
+  }
+  
+  Tone& Tone::operator=(const Tone& other) {
+    
+    // Transfer fields
+    _array[0] = other._array[0];
+    _array[1] = other._array[1];
+    _array[2] = other._array[2];
+    
+    return *this;
+    
+  }
+  
+  Tone& Tone::operator=(std::initializer_list<int> list) {
+    
+    if(list.size() != 3) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "A tone must have exactly three levels.");
+    }
+    
+    const int* levels = list.begin();
+    *this = Tone(levels[0], levels[1], levels[2]);
+    
+    return *this;
+    
+  }
+  
+  bool Tone::operator==(const Tone& other) const {
+    
+    return _array[0] == other._array[0] && _array[1] == other._array[1] && 
+           _array[2] == other._array[2];
+    
+  }
+  
+  bool Tone::operator!=(const Tone& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  int& Tone::operator[](int index) {
+    
+    return _array[checked_index(index, 3)];
+    
+  }
+  
+  const int& Tone::operator[](int index) const {
+    
+    return _array[checked_index(index, 3)];
+    
+  }
+  
+  int& Tone::unchecked(int index) {
+    
+    return _array[index];
+    
+  }
+  
+  const int& Tone::unchecked(int index) const {
+    
+    return _array[index];
+    
+  }
+  
+  Tone::iterator Tone::begin() {
+    
+    return iterator(*this, 0);
+    
+  }
+  
+  Tone::const_iterator Tone::begin() const {
+    
+    return const_iterator(*this, 0);
+    
+  }
+  
+  Tone::iterator Tone::end() {
+    
+    return iterator(*this, 3);
+    
+  }
+  
+  Tone::const_iterator Tone::end() const {
+    
+    return const_iterator(*this, 3);
+    
+  }
+  
+  std::array<int, 3> Tone::array() const {
+    
+    std::array<int, 3> result = {{_array[0], _array[1], _array[2]}};
+    return result;
+    
+  }
+  
+  std::size_t Tone::hash() const {
+    
+    // The levels are between -2 and 2, so they fit in one byte each
+    uint64_t levels = 0;
+    for(int i = 0; i < 3; i++) {
+      levels = (levels << 8) | (uint8_t) _array[i];
+    }
+    
+    return (std::size_t) mix(levels);
+    
+  }
+  
+  Tone& Tone::operator++() {
+    
+    ToneCode code(*this);
+    *this = (++code).tone();
+    
+    return *this;
+    
+  }
+  
+  Tone Tone::operator++(int) {
+    
+    Tone original = *this;
+    ++*this;
+    
+    return original;
+    
+  }
+  
+  Tone& Tone::operator--() {
+    
+    ToneCode code(*this);
+    *this = (--code).tone();
+    
+    return *this;
+    
+  }
+  
+  Tone Tone::operator--(int) {
+    
+    Tone original = *this;
+    --*this;
+    
+    return original;
+    
+  }
+
+// ToneCode
+  
+  static_assert(std::is_trivially_copyable<ToneCode>::value, 
+                "ToneCode must stay trivially copyable.");
+  
+  static_assert(sizeof(ToneCode) == sizeof(uint8_t), 
+                "ToneCode must stay the size of its code.");
+  
+  const int ToneCode::count;
+  
+  ToneCode::ToneCode() {
+    
+    // Initialize essential fields
+    _code = 62;
+    
+  }
+  
+  ToneCode::ToneCode(const Tone& tone) {
+    
+    *this = ToneCode(tone[0], tone[1], tone[2]);
+    
+  }
+  
+  ToneCode::ToneCode(int tone1, int tone2, int tone3) {
+    
+    if(tone1 < -2 || tone1 > 2 || tone2 < -2 || tone2 > 2 || 
+       tone3 < -2 || tone3 > 2) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::impossible_articulation);
+      throw ImpossibleArticulation(expt::literal, 
+                                   "Tone levels must be between -2 and 2.");
+    }
+    
+    // Initialize essential fields
+    _code = 25 * (tone1 + 2) + 5 * (tone2 + 2) + (tone3 + 2);
+    
+  }
+  
+  ToneCode& ToneCode::operator++() {
+    
+    const ToneTables& tables = tone_tables();
+    _code = tables.order[(tables.ranks[_code] + 1) % count];
+    
+    return *this;
+    
+  }
+  
+  ToneCode ToneCode::operator++(int) {
+    
+    ToneCode original = *this;
+    ++*this;
+    
+    return original;
+    
+  }
+  
+  ToneCode& ToneCode::operator--() {
+    
+    const ToneTables& tables = tone_tables();
+    _code = tables.order[(tables.ranks[_code] + count - 1) % count];
+    
+    return *this;
+    
+  }
+  
+  ToneCode ToneCode::operator--(int) {
+    
+    ToneCode original = *this;
+    --*this;
+    
+    return original;
+    
+  }
+  
+  bool ToneCode::operator==(const ToneCode& other) const {
+    
+    return _code == other._code;
+    
+  }
+  
+  bool ToneCode::operator!=(const ToneCode& other) const {
+    
+    return _code != other._code;
+    
+  }
+  
+  bool ToneCode::operator<(const ToneCode& other) const {
+    
+    return _code < other._code;
+    
+  }
+  
+  std::size_t ToneCode::hash() const {
+    
+    return (std::size_t) mix(_code);
+    
+  }
+  
+  uint8_t ToneCode::code() const {
+    
+    return _code;
+    
+  }
+  
+  void ToneCode::set_code(uint8_t new_code) {
+    
+    _code = new_code;
+    
+  }
+  
+  Tone ToneCode::tone() const {
+    
+    const int8_t* levels = tone_tables().levels[_code];
+    return Tone(levels[0], levels[1], levels[2]);
+    
+  }
+  
+  int ToneCode::level(int index) const {
+    
+    return tone_tables().levels[_code][index];
+    
+  }
+  
+  const int8_t* ToneCode::begin() const {
+    
+    return tone_tables().levels[_code];
+    
+  }
+  
+  const int8_t* ToneCode::end() const {
+    
+    return tone_tables().levels[_code] + 3;
+    
+  }
+  
+  ToneCode::Contour ToneCode::contour() const {
+    
+    return (Contour) tone_tables().contours[_code];
+    
+  }
+  
+  int ToneCode::rank() const {
+    
+    return tone_tables().ranks[_code];
+    
+  }
+
+// Syllable::Slot
+  
+  static_assert(std::is_trivially_copyable<Syllable::Slot>::value, 
+                "Syllable::Slot must stay trivially copyable.");
+  
+  Syllable::Slot::Slot(const Vowel& vowel) {
+    
+    // Initialize essential fields
+    _code = PhoneCode(vowel);
+    _height = vowel.height();
+    _backness = vowel.backness();
+    
+  }
+  
+  Syllable::Slot::Slot(const Consonant& consonant) {
+    
+    // Initialize essential fields
+    _code = PhoneCode(consonant);
+    _height = 0;
+    _backness = 0;
+    
+  }
+  
+  Syllable::Slot::Slot(const Phone& phone) {
+    
+    // Dispatch on the dynamic type of the phone
+    const Vowel* vowel = dynamic_cast<const Vowel*>(&phone);
+    if(vowel) {
+      *this = Slot(*vowel);
+      return;
+    }
+    
+    const Consonant* consonant = dynamic_cast<const Consonant*>(&phone);
+    if(consonant) {
+      *this = Slot(*consonant);
+      return;
+    }
+    
+    LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+    throw expt::ValueError(expt::literal, 
+                           "Only vowels and consonants can be stored.");
+    
+  }
+  
+  Vowel Syllable::Slot::vowel() const {
+    
+    if(!is_vowel()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, "Slot does not hold a vowel.");
+    }
+    
+    return Vowel(_height, _backness, _code.roundedness(), 
+                 _code.nasalization(), _code.is_r_colored(), 
+                 _code.phonation(), _code.length());
+    
+  }
+  
+  Consonant Syllable::Slot::consonant() const {
+    
+    return _code.consonant();
+    
+  }
+
+// Syllable::Cell
+  
+  Syllable::Cell::~Cell() {
+    
+    if(_is_vowel) {
+      _vowel.~Vowel();
+    }
+    else {
+      _consonant.~Consonant();
+    }
+    
+  }
+  
+  Syllable::Cell::Cell(const Slot& slot) {
+    
+    // Initialize essential fields
+    _is_vowel = slot.is_vowel();
+    if(_is_vowel) {
+      new (&_vowel) Vowel(slot.vowel());
+    }
+    else {
+      new (&_consonant) Consonant(slot.consonant());
+    }
+    
+  }
+  
+  Syllable::Slot Syllable::Cell::slot() const {
+    
+    if(_is_vowel) {
+      return Slot(_vowel);
+    }
+    
+    return Slot(_consonant);
+    
+  }
+
+// Syllable::Span
+  
+  Syllable::Span::~Span() {}
+  
+  Syllable::Span::Span(const Slot* begin, int size) {
+    
+    // Initialize essential fields
+    _begin = begin;
+    _cells = 0;
+    _size = size;
+    
+  }
+  
+  Syllable::Slot Syllable::Span::operator[](int index) const {
+    
+    return unchecked(checked_index(index, _size));
+    
+  }
+
+
+// Syllable::View::iterator
+  
+  template <class Kind>
+  Syllable::View<Kind>::iterator::~iterator() {}
+  
+  template <class Kind>
+  Syllable::View<Kind>::iterator::iterator(SyllableType* syllable, 
+                                           int position, int end) {
+    
+    // Initialize essential fields
+    _syllable = syllable;
+    _position = position;
+    _end = end;
+    
+    while(_position != _end && !holds(_syllable->slots()[_position])) {
+      _position++;
+    }
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::iterator& 
+  Syllable::View<Kind>::iterator::operator++() {
+    
+    do {
+      _position++;
+    } while(_position != _end && !holds(_syllable->slots()[_position]));
+    
+    return *this;
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::iterator 
+  Syllable::View<Kind>::iterator::operator++(int) {
+    
+    iterator result(*this);
+    ++*this;
+    return result;
+    
+  }
+  
+  template <class Kind>
+  bool Syllable::View<Kind>::iterator::operator==(const iterator& other) 
+      const {
+    
+    return _syllable == other._syllable && _position == other._position;
+    
+  }
+  
+  template <class Kind>
+  bool Syllable::View<Kind>::iterator::operator!=(const iterator& other) 
+      const {
+    
+    return !(*this == other);
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::reference 
+  Syllable::View<Kind>::iterator::operator*() const {
+    
+    // The position was checked to hold a Kind when the iterator reached it, 
+    // and only now, and only for a non-const Kind, are the phones 
+    // materialized
+    return phone_at(_syllable, _position, static_cast<Kind*>(0));
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::iterator::pointer 
+  Syllable::View<Kind>::iterator::operator->() const {
+    
+    return arrow(**this);
+    
+  }
+
+// Syllable::View
+  
+  template <class Kind>
+  bool Syllable::View<Kind>::holds(const Slot& slot) {
+    
+    // A view of Phones holds every phone
+    typedef typename std::remove_const<Kind>::type Base;
+    return std::is_same<Base, Phone>::value || 
+           slot.is_vowel() == std::is_same<Base, Vowel>::value;
+    
+  }
+  
+  template <class Kind>
+  Syllable::View<Kind>::~View() {}
+  
+  template <class Kind>
+  Syllable::View<Kind>::View(SyllableType* syllable, int begin, int end) {
+    
+    // Initialize essential fields
+    _syllable = syllable;
+    _begin = begin;
+    _end = end;
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::reference 
+  Syllable::View<Kind>::operator[](int index) const {
+    
+    int position = checked_index(index, size());
+    iterator result = begin();
+    for(int i = 0; i < position; i++) {
+      ++result;
+    }
+    
+    return *result;
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::iterator Syllable::View<Kind>::begin() 
+      const {
+    
+    return iterator(_syllable, _begin, _end);
+    
+  }
+  
+  template <class Kind>
+  typename Syllable::View<Kind>::iterator Syllable::View<Kind>::end() const {
+    
+    return iterator(_syllable, _end, _end);
+    
+  }
+  
+  template <class Kind>
+  int Syllable::View<Kind>::size() const {
+    
+    int result = 0;
+    const Slot* phones = _syllable->slots();
+    for(int i = _begin; i < _end; i++) {
+      result += holds(phones[i]);
+    }
+    
+    return result;
+    
+  }
+  
+  template <class Kind>
+  bool Syllable::View<Kind>::empty() const {
+    
+    return begin() == end();
+    
+  }
+  
+  // The only kinds of view that Syllable hands out
+  template class Syllable::View<Phone>;
+  template class Syllable::View<const Phone>;
+  template class Syllable::View<Vowel>;
+  template class Syllable::View<const Vowel>;
+  template class Syllable::View<Consonant>;
+  template class Syllable::View<const Consonant>;
+
+// Syllable::iterator
+  
+  Syllable::iterator::iterator(Syllable& syllable, int position) {
+    
+    // Initialize essential fields
+    _syllable = &syllable;
+    _position = checked_position(position, syllable._size);
+    
+    // The iterator can change the phones
+    syllable.touch();
+    
+  }
+  
+  void Syllable::iterator::set_position(int position) {
+    
+    _position = checked_position(position, _syllable->_size);
+    
+  }
+
+// Syllable::const_iterator
+  
+  Syllable::const_iterator::const_iterator(const Syllable& syllable, 
+                                           int position) {
+    
+    // Initialize essential fields
+    _syllable = &syllable;
+    _position = checked_position(position, syllable._size);
+    
+  }
+  
+  void Syllable::const_iterator::set_position(int position) {
+    
+    _position = checked_position(position, _syllable->_size);
+    
+  }
+
+// Syllable
+  
+  Syllable::~Syllable() {
+    
+    clear();
+    
+  }
+  
+  Syllable::Syllable() {
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = 0;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = 0;
+    _nucleus_size = 0;
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    
+    _stamp = new_stamp();
+    
+    // The default syllable is just a Schwa
+    insert_slot(Slot(Vowel()), 0);
+    _nucleus_size = 1;
+    
+  }
+  
+  Syllable::Syllable(Arena* arena) {
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = arena;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = 0;
+    _nucleus_size = 0;
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    _stamp = new_stamp();
+    
+    insert_slot(Slot(Vowel()), 0);
+    _nucleus_size = 1;
+    
+  }
+  
+  Syllable::Syllable(const std::vector<const Phone*>& onset, 
+                     const std::vector<const Phone*>& nucleus, 
+                     const std::vector<const Phone*>& coda, 
+                     const Tone& tone) : _tone(tone) {
+    
+    if(nucleus.empty()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::impossible_articulation);
+      throw ImpossibleArticulation(expt::literal, 
+                                   "A syllable nucleus cannot be empty.");
+    }
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = 0;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = onset.size();
+    _nucleus_size = nucleus.size();
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    _stamp = new_stamp();
+    
+    try {
+      reserve(onset.size() + nucleus.size() + coda.size());
+      for(int i = 0; i < (int) onset.size(); i++) {
+        insert_slot(Slot(*onset[i]), _size);
+      }
+      for(int i = 0; i < (int) nucleus.size(); i++) {
+        insert_slot(Slot(*nucleus[i]), _size);
+      }
+      for(int i = 0; i < (int) coda.size(); i++) {
+        insert_slot(Slot(*coda[i]), _size);
+      }
+    }
+    catch(...) {
+      clear();
+      throw;
+    }
+    
+  }
+  
+  Syllable::Syllable(const std::string& transcription, 
+                     PhoneticEncoding encoding) {
+    
+    transcribe(transcription.data(), transcription.size(), encoding);
+    
+  }
+  
+  Syllable::Syllable(const char* transcription, PhoneticEncoding encoding) {
+    
+    transcribe(transcription, std::strlen(transcription), encoding);
+    
+  }
+  
+  Syllable::Syllable(const Syllable& original) : _tone(original._tone) {
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = 0;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = original._onset_size;
+    _nucleus_size = original._nucleus_size;
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    _stamp = original._stamp;
+    
+    LANG_INSTRUMENT_COUNT(Instrumentation::syllable_copy);
+    
+    // Copy the phones straight into this syllable's storage
+    reserve(original._size);
+    copy_slots(original);
+    
+  }
+  
+  Syllable::Syllable(const Syllable& original, Arena* arena) : 
+      _tone(original._tone) {
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = arena;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = original._onset_size;
+    _nucleus_size = original._nucleus_size;
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    _stamp = original._stamp;
+    
+    LANG_INSTRUMENT_COUNT(Instrumentation::syllable_copy);
+    
+    reserve(original._size);
+    copy_slots(original);
+    
+  }
+  
+  Syllable::Syllable(Syllable&& original) noexcept : _tone(original._tone) {
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = original._arena;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = original._onset_size;
+    _nucleus_size = original._nucleus_size;
+    _stamp = original._stamp;
+    
+    // The materialized phones are taken over wherever the Slots are, so 
+    // references to them stay valid
+    _cells.store(original._cells.load(std::memory_order_relaxed), 
+                 std::memory_order_relaxed);
+    _changed.store(original._changed.load(std::memory_order_relaxed), 
+                   std::memory_order_relaxed);
+    original._cells.store(0, std::memory_order_relaxed);
+    original._changed.store(false, std::memory_order_relaxed);
+    
+    if(original._heap) {
+      
+      // Take over the heap storage
+      _heap = original._heap;
+      _capacity = original._capacity;
+      _size = original._size;
+      original._heap = 0;
+      original._size = 0;
+      
+    }
+    else {
+      
+      // Inline phones have to be copied across
+      std::memcpy(_inline, original._inline, original._size * sizeof(Slot));
+      _size = original._size;
+      
+    }
+    
+    original.clear();
+    original.touch();
+    
+  }
+  
+  Syllable& Syllable::operator=(const Syllable& other) {
+    
+    if(this == &other) {
+      return *this;
+    }
+    
+    LANG_INSTRUMENT_COUNT(Instrumentation::syllable_copy);
+    
+    // Reuse the existing storage where possible
+    settle();
+    _size = 0;
+    reserve(other._size);
+    copy_slots(other);
+    
+    // Transfer fields
+    _onset_size = other._onset_size;
+    _nucleus_size = other._nucleus_size;
+    _tone = other._tone;
+    _stamp = other._stamp;
+    
+    return *this;
+    
+  }
+  
+  Syllable& Syllable::operator=(Syllable&& other) noexcept {
+    
+    if(this == &other) {
+      return *this;
+    }
+    
+    // Inline phones have to be copied, which fits in the existing storage, 
+    // and storage in another arena cannot be taken over
+    if(!other._heap || _arena != other._arena) {
+      *this = other;
+      other.clear();
+      other.touch();
+      return *this;
+    }
+    
+    // Take over the heap storage and the materialized phones
+    clear();
+    _heap = other._heap;
+    _capacity = other._capacity;
+    _size = other._size;
+    _onset_size = other._onset_size;
+    _nucleus_size = other._nucleus_size;
+    _tone = other._tone;
+    _stamp = other._stamp;
+    _cells.store(other._cells.load(std::memory_order_relaxed), 
+                 std::memory_order_relaxed);
+    _changed.store(other._changed.load(std::memory_order_relaxed), 
+                   std::memory_order_relaxed);
+    other._cells.store(0, std::memory_order_relaxed);
+    other._changed.store(false, std::memory_order_relaxed);
+    
+    other._heap = 0;
+    other._size = 0;
+    other.clear();
+    other.touch();
+    
+    return *this;
+    
+  }
+  
+  bool Syllable::operator==(const Syllable& other) const {
+    
+    if(_size != other._size || _onset_size != other._onset_size || 
+       _nucleus_size != other._nucleus_size || _tone != other._tone) {
+      return false;
+    }
+    
+    // Syllables whose phones have not been changed in place compare directly
+    if(!changed_cells() && !other.changed_cells()) {
+      const Slot* these = slots();
+      const Slot* those = other.slots();
+      for(int i = 0; i < _size; i++) {
+        if(these[i] != those[i]) {
+          return false;
+        }
+      }
+      return true;
+    }
+    
+    for(int i = 0; i < _size; i++) {
+      if(slot(i) != other.slot(i)) {
+        return false;
+      }
+    }
+    
+    return true;
+    
+  }
+  
+  bool Syllable::operator!=(const Syllable& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  std::size_t Syllable::hash() const {
+    
+    uint64_t result = combine(_onset_size, _nucleus_size);
+    result = combine(result, _size);
+    result = combine(result, _tone.hash());
+    
+    for(int i = 0; i < _size; i++) {
+      result = combine(result, slot(i).code().code());
+    }
+    
+    return (std::size_t) result;
+    
+  }
+  
+  Phone& Syllable::operator[](int index) {
+    
+    touch();
+    return cells()[checked_index(index, _size)].phone();
+    
+  }
+  
+  const Phone& Syllable::operator[](int index) const {
+    
+    return cells()[checked_index(index, _size)].phone();
+    
+  }
+  
+  Syllable::iterator Syllable::begin() {
+    
+    return iterator(*this, 0);
+    
+  }
+  
+  Syllable::iterator Syllable::end() {
+    
+    return iterator(*this, _size);
+    
+  }
+  
+  Syllable::iterator Syllable::onset_begin() {
+    
+    return iterator(*this, 0);
+    
+  }
+  
+  Syllable::iterator Syllable::onset_end() {
+    
+    return iterator(*this, _onset_size);
+    
+  }
+  
+  Syllable::iterator Syllable::nucleus_begin() {
+    
+    return iterator(*this, _onset_size);
+    
+  }
+  
+  Syllable::iterator Syllable::nucleus_end() {
+    
+    return iterator(*this, _onset_size + _nucleus_size);
+    
+  }
+  
+  Syllable::iterator Syllable::coda_begin() {
+    
+    return iterator(*this, _onset_size + _nucleus_size);
+    
+  }
+  
+  Syllable::iterator Syllable::coda_end() {
+    
+    return iterator(*this, _size);
+    
+  }
+  
+  Syllable::const_iterator Syllable::begin() const {
+    
+    return const_iterator(*this, 0);
+    
+  }
+  
+  Syllable::const_iterator Syllable::end() const {
+    
+    return const_iterator(*this, _size);
+    
+  }
+  
+  Syllable::const_iterator Syllable::onset_begin() const {
+    
+    return const_iterator(*this, 0);
+    
+  }
+  
+  Syllable::const_iterator Syllable::onset_end() const {
+    
+    return const_iterator(*this, _onset_size);
+    
+  }
+  
+  Syllable::const_iterator Syllable::nucleus_begin() const {
+    
+    return const_iterator(*this, _onset_size);
+    
+  }
+  
+  Syllable::const_iterator Syllable::nucleus_end() const {
+    
+    return const_iterator(*this, _onset_size + _nucleus_size);
+    
+  }
+  
+  Syllable::const_iterator Syllable::coda_begin() const {
+    
+    return const_iterator(*this, _onset_size + _nucleus_size);
+    
+  }
+  
+  Syllable::const_iterator Syllable::coda_end() const {
+    
+    return const_iterator(*this, _size);
+    
+  }
+  
+  int Syllable::size() const {
+    
+    return _size;
+    
+  }
+  
+  int Syllable::onset_size() const {
+    
+    return _onset_size;
+    
+  }
+  
+  int Syllable::nucleus_size() const {
+    
+    return _nucleus_size;
+    
+  }
+  
+  int Syllable::coda_size() const {
+    
+    return _size - _onset_size - _nucleus_size;
+    
+  }
+  
+  Syllable::View<Phone> Syllable::onset() {
+    
+    touch();
+    return View<Phone>(this, 0, _onset_size);
+    
+  }
+  
+  Syllable::View<const Phone> Syllable::onset() const {
+    
+    return View<const Phone>(this, 0, _onset_size);
+    
+  }
+  
+  Syllable::View<Phone> Syllable::nucleus() {
+    
+    touch();
+    return View<Phone>(this, _onset_size, _onset_size + _nucleus_size);
+    
+  }
+  
+  Syllable::View<const Phone> Syllable::nucleus() const {
+    
+    return View<const Phone>(this, _onset_size, _onset_size + _nucleus_size);
+    
+  }
+  
+  Syllable::View<Phone> Syllable::coda() {
+    
+    touch();
+    return View<Phone>(this, _onset_size + _nucleus_size, _size);
+    
+  }
+  
+  Syllable::View<const Phone> Syllable::coda() const {
+    
+    return View<const Phone>(this, _onset_size + _nucleus_size, _size);
+    
+  }
+  
+  std::vector<Phone*> Syllable::phones() {
+    
+    // The pointers can be used to change the phones
+    touch();
+    std::vector<Phone*> result;
+    Cell* phones = cells();
+    for(int i = 0; i < _size; i++) {
+      result.push_back(&phones[i].phone());
+    }
+    
+    return result;
+    
+  }
+  
+  std::vector<const Phone*> Syllable::phones() const {
+    
+    std::vector<const Phone*> result;
+    const Cell* phones = cells();
+    for(int i = 0; i < _size; i++) {
+      result.push_back(&phones[i].phone());
+    }
+    
+    return result;
+    
+  }
+  
+  Syllable::Span Syllable::span() const {
+    
+    Span result(slots(), _size);
+    result._cells = changed_cells();
+    return result;
+    
+  }
+  
+  Syllable::Span Syllable::onset_span() const {
+    
+    Span result(slots(), _onset_size);
+    result._cells = changed_cells();
+    return result;
+    
+  }
+  
+  Syllable::Span Syllable::nucleus_span() const {
+    
+    Span result(slots() + _onset_size, _nucleus_size);
+    const Cell* cells = changed_cells();
+    result._cells = cells ? cells + _onset_size : 0;
+    return result;
+    
+  }
+  
+  Syllable::Span Syllable::coda_span() const {
+    
+    int start = _onset_size + _nucleus_size;
+    Span result(slots() + start, _size - start);
+    const Cell* cells = changed_cells();
+    result._cells = cells ? cells + start : 0;
+    return result;
+    
+  }
+  
+  Syllable::View<Vowel> Syllable::vowels() {
+    
+    touch();
+    return View<Vowel>(this, 0, _size);
+    
+  }
+  
+  Syllable::View<const Vowel> Syllable::vowels() const {
+    
+    return View<const Vowel>(this, 0, _size);
+    
+  }
+  
+  Syllable::View<Consonant> Syllable::consonants() {
+    
+    touch();
+    return View<Consonant>(this, 0, _size);
+    
+  }
+  
+  Syllable::View<const Consonant> Syllable::consonants() const {
+    
+    return View<const Consonant>(this, 0, _size);
+    
+  }
+  
+  Arena* Syllable::arena() const {
+    
+    return _arena;
+    
+  }
+  
+  Tone Syllable::tone() const {
+    
+    return _tone.tone();
+    
+  }
+  
+  uint64_t Syllable::stamp() const {
+    
+    return _stamp;
+    
+  }
+  
+  void Syllable::touch() {
+    
+    _stamp = new_stamp();
+    
+  }
+  
+  ToneCode Syllable::tone_code() const {
+    
+    return _tone;
+    
+  }
+  
+  void Syllable::insert_onset(const Phone& new_phone, int position) {
+    
+    position = checked_position(position, _onset_size);
+    insert_slot(Slot(new_phone), position);
+    _onset_size++;
+    
+  }
+  
+  void Syllable::insert_nucleus(const Phone& new_phone, int position) {
+    
+    position = checked_position(position, _nucleus_size);
+    insert_slot(Slot(new_phone), _onset_size + position);
+    _nucleus_size++;
+    
+  }
+  
+  void Syllable::insert_coda(const Phone& new_phone, int position) {
+    
+    position = checked_position(position, coda_size());
+    insert_slot(Slot(new_phone), _onset_size + _nucleus_size + position);
+    
+  }
+  
+  void Syllable::remove_onset(int index) {
+    
+    index = checked_index(index, _onset_size);
+    remove_slot(index);
+    _onset_size--;
+    
+  }
+  
+  void Syllable::remove_nucleus(int index) {
+    
+    index = checked_index(index, _nucleus_size);
+    if(_nucleus_size == 1) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::impossible_articulation);
+      throw ImpossibleArticulation(expt::literal, 
+                                   "A syllable nucleus cannot be empty.");
+    }
+    
+    remove_slot(_onset_size + index);
+    _nucleus_size--;
+    
+  }
+  
+  void Syllable::remove_coda(int index) {
+    
+    index = checked_index(index, coda_size());
+    remove_slot(_onset_size + _nucleus_size + index);
+    
+  }
+  
+  std::string Syllable::unicode() const {
+    
+    std::string result("[");
+    encode(result, lang::unicode);
+    result += ']';
+    return result;
+    
+  }
+  
+  std::string Syllable::kirschenbaum() const {
+    
+    std::string result("[");
+    encode(result, lang::kirschenbaum);
+    result += ']';
+    return result;
+    
+  }
+  
+  std::string Syllable::x_sampa() const {
+    
+    std::string result("[");
+    encode(result, lang::x_sampa);
+    result += ']';
+    return result;
+    
+  }
+  
+  void Syllable::encode(std::string& output, PhoneticEncoding encoding) const {
+    
+    LANG_INSTRUMENT_TIME(Instrumentation::encode_event(encoding));
+    
+    char buffer[phone_encoding_size];
+    for(int i = 0; i < _size; i++) {
+      output.append(buffer, encode_phone(i, encoding, buffer));
+    }
+    output.append(buffer, encode_tone(encoding, buffer));
+    
+  }
+  
+  int Syllable::encode(char* buffer, int capacity, 
+                       PhoneticEncoding encoding) const {
+    
+    LANG_INSTRUMENT_TIME(Instrumentation::encode_event(encoding));
+    
+    // Phones are written straight into buffer while they are sure to fit
+    char overflow[phone_encoding_size];
+    int length = 0;
+    for(int i = 0; i <= _size; i++) {
+      char* destination = buffer + length;
+      if(capacity - length < phone_encoding_size) {
+        destination = overflow;
+      }
+      
+      int written;
+      if(i < _size) {
+        written = encode_phone(i, encoding, destination);
+      }
+      else {
+        written = encode_tone(encoding, destination);
+      }
+      
+      if(destination == overflow && length < capacity) {
+        std::memcpy(buffer + length, overflow, 
+                    std::min(written, capacity - length));
+      }
+      length += written;
+    }
+    
+    return length;
+    
+  }
+  
+  Syllable::Slot* Syllable::slots() {
+    
+    if(_heap) {
+      return _heap;
+    }
+    
+    return reinterpret_cast<Slot*>(_inline);
+    
+  }
+  
+  const Syllable::Slot* Syllable::slots() const {
+    
+    if(_heap) {
+      return _heap;
+    }
+    
+    return reinterpret_cast<const Slot*>(_inline);
+    
+  }
+  
+  const Syllable::Cell* Syllable::materialize() const {
+    
+    // Build the whole array before publishing it, and give way to another 
+    // thread that published one first
+    Cell* result = 0;
+    Cell* fresh = static_cast<Cell*>(::operator new(_size * sizeof(Cell)));
+    const Slot* phones = slots();
+    for(int i = 0; i < _size; i++) {
+      new (&fresh[i]) Cell(phones[i]);
+    }
+    
+    if(_cells.compare_exchange_strong(result, fresh, 
+                                      std::memory_order_acq_rel, 
+                                      std::memory_order_acquire)) {
+      return fresh;
+    }
+    
+    for(int i = 0; i < _size; i++) {
+      fresh[i].~Cell();
+    }
+    ::operator delete(fresh);
+    return result;
+    
+  }
+  
+  const Syllable::Cell* Syllable::changed_cells() const {
+    
+    if(!_changed.load(std::memory_order_relaxed)) {
+      return 0;
+    }
+    
+    return _cells.load(std::memory_order_acquire);
+    
+  }
+  
+  Syllable::Slot Syllable::slot(int index) const {
+    
+    const Cell* cells = changed_cells();
+    if(cells) {
+      return cells[index].slot();
+    }
+    
+    return slots()[index];
+    
+  }
+  
+  Syllable::Slot Syllable::phone_at(const Syllable* syllable, int index, 
+                                    const Phone*) {
+    
+    return syllable->slot(index);
+    
+  }
+  
+  Vowel Syllable::phone_at(const Syllable* syllable, int index, 
+                           const Vowel*) {
+    
+    return syllable->slot(index).vowel();
+    
+  }
+  
+  Consonant Syllable::phone_at(const Syllable* syllable, int index, 
+                               const Consonant*) {
+    
+    return syllable->slot(index).consonant();
+    
+  }
+  
+  void Syllable::settle() {
+    
+    Cell* cells = _cells.load(std::memory_order_relaxed);
+    if(!cells) {
+      return;
+    }
+    
+    Slot* phones = slots();
+    bool changed = _changed.load(std::memory_order_relaxed);
+    for(int i = 0; i < _size; i++) {
+      if(changed) {
+        phones[i] = cells[i].slot();
+      }
+      cells[i].~Cell();
+    }
+    ::operator delete(cells);
+    
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    
+  }
+  
+  void Syllable::copy_slots(const Syllable& original) {
+    
+    const Cell* cells = original.changed_cells();
+    if(cells) {
+      Slot* destination = slots();
+      for(int i = 0; i < original._size; i++) {
+        new (&destination[i]) Slot(cells[i].slot());
+      }
+    }
+    else {
+      std::memcpy(slots(), original.slots(), original._size * sizeof(Slot));
+    }
+    _size = original._size;
+    
+  }
+  
+  void Syllable::reserve(int capacity) {
+    
+    if(capacity <= _capacity) {
+      return;
+    }
+    
+    // Grow geometrically so that repeated insertions stay cheap
+    int new_capacity = _capacity * 2;
+    if(new_capacity < capacity) {
+      new_capacity = capacity;
+    }
+    
+    Slot* new_slots;
+    if(_arena) {
+      new_slots = static_cast<Slot*>(_arena->allocate(new_capacity * 
+                                                      sizeof(Slot), 
+                                                      alignof(Slot)));
+    }
+    else {
+      new_slots = static_cast<Slot*>(::operator new(new_capacity * 
+                                                    sizeof(Slot)));
+    }
+    std::memcpy(new_slots, slots(), _size * sizeof(Slot));
+    
+    if(_heap && !_arena) {
+      ::operator delete(_heap);
+    }
+    
+    _heap = new_slots;
+    _capacity = new_capacity;
+    
+  }
+  
+  void Syllable::transcribe(const char* transcription, int length, 
+                            PhoneticEncoding encoding) {
+    
+    // Initialize essential fields
+    _heap = 0;
+    _arena = 0;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = 0;
+    _nucleus_size = 0;
+    _cells.store(0, std::memory_order_relaxed);
+    _changed.store(false, std::memory_order_relaxed);
+    _stamp = 0;
+    
+    int error = Decoder(encoding).decode(transcription, length, *this);
+    if(error >= 0) {
+      clear();
+      LANG_INSTRUMENT_COUNT(Instrumentation::decoding_failed);
+      throw DecodingFailed(error);
+    }
+    
+  }
+  
+  void Syllable::insert_slot(const Slot& slot, int index) {
+    
+    touch();
+    settle();
+    reserve(_size + 1);
+    
+    // Shift the following phones back by one
+    Slot* phones = slots();
+    std::memmove(phones + index + 1, phones + index, 
+                 (_size - index) * sizeof(Slot));
+    new (&phones[index]) Slot(slot);
+    _size++;
+    
+  }
+  
+  void Syllable::remove_slot(int index) {
+    
+    // Shift the following phones forward by one
+    touch();
+    settle();
+    Slot* phones = slots();
+    std::memmove(phones + index, phones + index + 1, 
+                 (_size - index - 1) * sizeof(Slot));
+    _size--;
+    
+  }
+  
+  void Syllable::clear() {
+    
+    settle();
+    if(_heap && !_arena) {
+      ::operator delete(_heap);
+    }
+    
+    _heap = 0;
+    _capacity = inline_capacity;
+    _size = 0;
+    _onset_size = 0;
+    _nucleus_size = 0;
+    
+  }
+  
+  int Syllable::encode_phone(int index, PhoneticEncoding encoding, 
+                             char* buffer) const {
+    
+    bool syllabic = index >= _onset_size && 
+                    index < _onset_size + _nucleus_size;
+    
+    return encoding_index(encoding).encode_phone(slot(index).code().code(), 
+                                                 syllabic, buffer);
+    
+  }
+  
+  int Syllable::encode_tone(PhoneticEncoding encoding, char* buffer) const {
+    
+    return encoding_index(encoding).encode_tone(_tone.tone(), buffer);
+    
+  }
+
+// ThreadPool
+  
+  ThreadPool::~ThreadPool() {
+    
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _started.notify_all();
+    
+    for(int i = 0; i < (int) _workers.size(); i++) {
+      _workers[i].join();
+    }
+    
+  }
+  
+  ThreadPool::ThreadPool(int threads) {
+    
+    if(threads < 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The number of threads cannot be negative.");
+    }
+    if(threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    // Initialize essential fields
+    _task = 0;
+    _count = 0;
+    _grain = 1;
+    _next = 0;
+    _active = 0;
+    _generation = 0;
+    _stopping = false;
+    
+    // The calling thread makes up the last one
+    for(int i = 1; i < threads; i++) {
+      _workers.push_back(std::thread(&ThreadPool::work, this));
+    }
+    
+  }
+  
+  int ThreadPool::size() const {
+    
+    return _workers.size() + 1;
+    
+  }
+  
+  void ThreadPool::run(int count, const std::function<void(int, int)>& task, 
+                       int grain) {
+    
+    if(count <= 0) {
+      return;
+    }
+    
+    // Several chunks per thread keep the threads busy when items vary in cost
+    if(grain <= 0) {
+      grain = std::max(1, count / (size() * 8));
+    }
+    
+    // A task that runs a loop on its own pool would wait forever for the 
+    // loop it is part of, so the nested loop runs on the calling thread
+    if(in_pool(this)) {
+      task(0, count);
+      return;
+    }
+    
+    std::lock_guard<std::mutex> run_lock(_run_mutex);
+    EnteredPool entered(this);
+    if(_workers.empty() || grain >= count) {
+      task(0, count);
+      return;
+    }
+    
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _task = &task;
+      _count = count;
+      _grain = grain;
+      _next = 0;
+      _active = _workers.size();
+      _error = std::exception_ptr();
+      _generation++;
+    }
+    _started.notify_all();
+    
+    share();
+    
+    std::exception_ptr error;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while(_active > 0) {
+        _finished.wait(lock);
+      }
+      _task = 0;
+      error = _error;
+      _error = std::exception_ptr();
+    }
+    
+    if(error) {
+      std::rethrow_exception(error);
+    }
+    
+  }
+  
+  void ThreadPool::work() {
+    
+    long seen = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true) {
+      while(!_stopping && _generation == seen) {
+        _started.wait(lock);
+      }
+      if(_stopping) {
+        return;
+      }
+      seen = _generation;
+      
+      lock.unlock();
+      {
+        EnteredPool entered(this);
+        share();
+      }
+      lock.lock();
+      
+      _active--;
+      if(_active == 0) {
+        _finished.notify_all();
+      }
+    }
+    
+  }
+  
+  void ThreadPool::share() {
+    
+    while(true) {
+      int begin = _next.fetch_add(_grain);
+      if(begin >= _count) {
+        return;
+      }
+      
+      try {
+        (*_task)(begin, std::min(begin + _grain, _count));
+      }
+      catch(...) {
+        
+        // Stop handing out chunks and keep the first exception
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_error) {
+          _error = std::current_exception();
+        }
+        _next = _count;
+        
+      }
+    }
+    
+  }
+
+// Decoder
+  
+  Decoder::~Decoder() {}
+  
+  Decoder::Decoder(PhoneticEncoding encoding) {
+    
+    // Initialize essential fields
+    _encoding = encoding;
+    
+  }
+  
+  Decoder::Decoder(const Decoder& original) {
+    
+    // Initialize essential fields
+    _encoding = original._encoding;
+    
+  }
+  
+  Decoder& Decoder::operator=(const Decoder& other) {
+    
+    // Transfer fields
+    _encoding = other._encoding;
+    
+    return *this;
+    
+  }
+  
+  PhoneticEncoding Decoder::encoding() const {
+    
+    return _encoding;
+    
+  }
+  
+  void Decoder::set_encoding(PhoneticEncoding new_encoding) {
+    
+    _encoding = new_encoding;
+    
+  }
+  
+  int Decoder::decode(const char* transcription, int length, 
+                      Syllable& syllable) const {
+    
+    LANG_INSTRUMENT_TIME(Instrumentation::decode_event(_encoding));
+    
+    int failure = parse(transcription, length, syllable);
+    if(failure >= 0) {
+      
+      // Leave the default syllable rather than the phones read so far
+      syllable.settle();
+      syllable._size = 0;
+      syllable._onset_size = 0;
+      syllable._tone = ToneCode();
+      syllable.insert_slot(Syllable::Slot(Vowel()), 0);
+      syllable._nucleus_size = 1;
+      
+    }
+    
+    return failure;
+    
+  }
+  
+  int Decoder::parse(const char* transcription, int length, 
+                     Syllable& syllable) const {
+    
+    const SymbolIndex& index = symbol_index(_encoding);
+    
+    // Empty the syllable but keep its storage
+    syllable.settle();
+    syllable._size = 0;
+    syllable._onset_size = 0;
+    syllable._nucleus_size = 0;
+    syllable.touch();
+    
+    int position = 0;
+    int end = length;
+    if(length > 0 && transcription[0] == '[') {
+      if(length < 2 || transcription[length - 1] != ']') {
+        return length;
+      }
+      position = 1;
+      end = length - 1;
+    }
+    
+    int phase = 0;
+    bool have_phone = false;
+    bool seen_content = false;
+    int phone_start = 0;
+    uint64_t code = 0;
+    bool syllabic = false;
+    int levels[3];
+    int level_count = 0;
+    
+    while(position < end) {
+      int symbol_length;
+      int row = index.match(transcription + position, end - position, 
+                            symbol_length);
+      if(row < 0) {
+        return position;
+      }
+      
+      const Symbol& symbol = symbols[row];
+      switch(symbol.kind) {
+        
+        case phone_symbol:
+          if(have_phone && !append(code, syllabic, phase, syllable)) {
+            return phone_start;
+          }
+          have_phone = true;
+          phone_start = position;
+          code = symbol.value;
+          syllabic = false;
+          break;
+        
+        case modifier_symbol:
+          if(!have_phone || !apply_modifier(symbol.value, code, syllabic)) {
+            return position;
+          }
+          break;
+        
+        case tone_symbol:
+          if(!add_tone_levels(symbol.value, levels, level_count)) {
+            return position;
+          }
+          break;
+        
+        case stress_symbol:
+          if(seen_content) {
+            return position;
+          }
+          break;
+        
+      }
+      
+      if(symbol.kind != stress_symbol) {
+        seen_content = true;
+      }
+      position += symbol_length;
+    }
+    
+    if(have_phone && !append(code, syllabic, phase, syllable)) {
+      return phone_start;
+    }
+    
+    if(syllable._nucleus_size == 0) {
+      return end;
+    }
+    
+    syllable._tone = tone_from_levels(levels, level_count);
+    
+    return -1;
+    
+  }
+  
+  Syllable Decoder::decode(const std::string& transcription) const {
+    
+    Syllable result;
+    int error = decode(transcription.data(), transcription.size(), result);
+    if(error >= 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::decoding_failed);
+      throw DecodingFailed(error);
+    }
+    
+    return result;
+    
+  }
+  
+  int Decoder::decode(const char* const* transcriptions, const int* lengths, 
+                      int count, Syllable* syllables, int* failures, 
+                      ThreadPool& pool) const {
+    
+    std::atomic<int> failed(0);
+    pool.run(count, [&](int begin, int end) {
+      int local_failed = 0;
+      for(int i = begin; i < end; i++) {
+        failures[i] = decode(transcriptions[i], lengths[i], syllables[i]);
+        if(failures[i] >= 0) {
+          local_failed++;
+        }
+      }
+      failed += local_failed;
+    });
+    
+    return failed;
+    
+  }
+  
+  int Decoder::decode(const std::vector<std::string>& transcriptions, 
+                      std::vector<Syllable>& syllables, 
+                      std::vector<int>& failures, ThreadPool& pool) const {
+    
+    int count = transcriptions.size();
+    syllables.resize(count);
+    failures.resize(count);
+    
+    std::vector<const char*> pointers(count);
+    std::vector<int> lengths(count);
+    for(int i = 0; i < count; i++) {
+      pointers[i] = transcriptions[i].data();
+      lengths[i] = transcriptions[i].size();
+    }
+    
+    return decode(pointers.data(), lengths.data(), count, syllables.data(), 
+                  failures.data(), pool);
+    
+  }
+  
+  bool Decoder::append(uint64_t code, bool syllabic, int& phase, 
+                       Syllable& syllable) const {
+    
+    PhoneCode phone_code;
+    phone_code.set_code(code);
+    bool nucleus = phone_code.is_vowel() || syllabic;
+    
+    // The nucleus cannot resume once the coda has started
+    if(nucleus && phase == 2) {
+      return false;
+    }
+    
+    // Checked up front so that a rejected phone costs no exception
+    if(phone_code.violation() != Phone::no_violation) {
+      return false;
+    }
+    
+    syllable.insert_slot(Syllable::Slot(phone_code), syllable._size);
+    
+    if(nucleus) {
+      phase = 1;
+      syllable._nucleus_size++;
+    }
+    else if(phase == 0) {
+      syllable._onset_size++;
+    }
+    else {
+      phase = 2;
+    }
+    
+    return true;
+    
+  }
+
+// Transcoder
+  
+  Transcoder::~Transcoder() {}
+  
+  Transcoder::Transcoder(PhoneticEncoding source, PhoneticEncoding target, 
+                         int chunk_size) {
+    
+    if(chunk_size <= 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, "The chunk size must be positive.");
+    }
+    
+    // Initialize essential fields
+    _source = source;
+    _target = target;
+    _chunk_size = chunk_size;
+    
+  }
+  
+  Transcoder::Transcoder(const Transcoder& original) {
+    
+    // Initialize essential fields
+    _source = original._source;
+    _target = original._target;
+    _chunk_size = original._chunk_size;
+    
+  }
+  
+  Transcoder& Transcoder::operator=(const Transcoder& other) {
+    
+    // Transfer fields
+    _source = other._source;
+    _target = other._target;
+    _chunk_size = other._chunk_size;
+    
+    return *this;
+    
+  }
+  
+  PhoneticEncoding Transcoder::source() const {
+    
+    return _source;
+    
+  }
+  
+  PhoneticEncoding Transcoder::target() const {
+    
+    return _target;
+    
+  }
+  
+  int Transcoder::transcode(const char* transcription, int length, 
+                            std::string& output) const {
+    
+    int start = 0;
+    int end = length;
+    bool brackets = length > 0 && transcription[0] == '[';
+    if(brackets) {
+      if(length < 2 || transcription[length - 1] != ']') {
+        return length;
+      }
+      start = 1;
+      end = length - 1;
+    }
+    
+    std::string::size_type original_size = output.size();
+    if(brackets) {
+      output += '[';
+    }
+    
+    int error = translate(transcription + start, end - start, output);
+    if(error == -2) {
+      
+      // Go through a Syllable to find the closest symbols
+      output.resize(original_size + brackets);
+      Syllable syllable;
+      error = Decoder(_source).decode(transcription + start, end - start, 
+                                      syllable);
+      if(error < 0) {
+        syllable.encode(output, _target);
+      }
+      
+    }
+    
+    if(error >= 0) {
+      output.resize(original_size);
+      return error + start;
+    }
+    
+    if(brackets) {
+      output += ']';
+    }
+    
+    return -1;
+    
+  }
+  
+  std::string Transcoder::transcode(const std::string& transcription) const {
+    
+    std::string result;
+    int error = transcode(transcription.data(), transcription.size(), result);
+    if(error >= 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::decoding_failed);
+      throw DecodingFailed(error);
+    }
+    
+    return result;
+    
+  }
+  
+  long long Transcoder::transcode(std::istream& input, 
+                                  std::ostream& output) const {
+    
+    ChunkQueue read_queue;
+    ChunkQueue write_queue;
+    long long total = 0;
+    
+    // Exceptions cannot leave a thread, so the stages hand them back to be 
+    // rethrown here
+    std::exception_ptr read_error;
+    std::exception_ptr write_error;
+    bool read_failed = false;
+    bool write_failed = false;
+    
+    std::thread reader([&] {
+      try {
+        while(true) {
+          std::string chunk(_chunk_size, '\0');
+          input.read(&chunk[0], _chunk_size);
+          chunk.resize(input.gcount());
+          if(input.bad()) {
+            read_failed = true;
+            break;
+          }
+          if(chunk.empty()) {
+            break;
+          }
+          total += chunk.size();
+          if(!read_queue.push(chunk)) {
+            break;
+          }
+        }
+      }
+      catch(...) {
+        read_error = std::current_exception();
+      }
+      read_queue.close();
+    });
+    
+    // Closing the write queue when output fails stops the calling thread at 
+    // its next push
+    std::thread writer([&] {
+      try {
+        std::string chunk;
+        while(write_queue.pop(chunk)) {
+          output.write(chunk.data(), chunk.size());
+          if(!output) {
+            write_failed = true;
+            break;
+          }
+        }
+      }
+      catch(...) {
+        write_error = std::current_exception();
+      }
+      write_queue.close();
+    });
+    
+    // Transcriptions cut off at the end of a chunk are carried over to the 
+    // next one
+    long long failure = -1;
+    try {
+      std::string pending;
+      std::string chunk;
+      long long pending_offset = 0;
+      bool more = true;
+      while(more && failure < 0) {
+        more = read_queue.pop(chunk);
+        pending += chunk;
+        chunk.clear();
+        
+        std::string result;
+        std::size_t position = 0;
+        std::size_t size = pending.size();
+        while(position < size) {
+          std::size_t start = position;
+          while(position < size && is_separator(pending[position])) {
+            position++;
+          }
+          result.append(pending, start, position - start);
+          
+          std::size_t token = position;
+          while(position < size && !is_separator(pending[position])) {
+            position++;
+          }
+          if(position == size && more) {
+            position = token;
+            break;
+          }
+          
+          // No transcription is anywhere near this long, but one would not 
+          // fit in the int length that transcode takes
+          std::size_t length = position - token;
+          if(length > (std::size_t) std::numeric_limits<int>::max()) {
+            failure = pending_offset + token;
+            break;
+          }
+          int error = transcode(pending.data() + token, length, result);
+          if(error >= 0) {
+            failure = pending_offset + token + error;
+            break;
+          }
+        }
+        
+        if(failure < 0) {
+          pending.erase(0, position);
+          pending_offset += position;
+          if(!write_queue.push(result)) {
+            break;
+          }
+        }
+      }
+    }
+    catch(...) {
+      read_queue.close();
+      write_queue.close();
+      reader.join();
+      writer.join();
+      throw;
+    }
+    
+    read_queue.close();
+    write_queue.close();
+    reader.join();
+    writer.join();
+    
+    // A failure to read or write makes any decoding failure meaningless
+    if(read_error) {
+      std::rethrow_exception(read_error);
+    }
+    if(write_error) {
+      std::rethrow_exception(write_error);
+    }
+    if(read_failed) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception(expt::literal, 
+                            "Could not read the transcriptions.");
+    }
+    if(write_failed) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception(expt::literal, 
+                            "Could not write the transcriptions.");
+    }
+    if(failure >= 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::decoding_failed);
+      throw DecodingFailed(failure);
+    }
+    
+    return total;
+    
+  }
+  
+  int Transcoder::translate(const char* transcription, int length, 
+                            std::string& output) const {
+    
+    const SymbolIndex& index = symbol_index(_source);
+    const std::vector<int>& table = translations(_source, _target);
+    
+    int position = 0;
+    int phase = 0;
+    bool have_phone = false;
+    bool seen_content = false;
+    int phone_start = 0;
+    uint64_t code = 0;
+    bool syllabic = false;
+    int level_count = 0;
+    
+    while(position < length) {
+      int symbol_length;
+      int row = index.match(transcription + position, length - position, 
+                            symbol_length);
+      if(row < 0) {
+        return position;
+      }
+      if(table[row] < 0) {
+        return -2;
+      }
+      
+      const Symbol& symbol = symbols[row];
+      switch(symbol.kind) {
+        
+        case phone_symbol:
+          if(have_phone && !advance_phase(code, syllabic, phase)) {
+            return phone_start;
+          }
+          have_phone = true;
+          phone_start = position;
+          code = symbol.value;
+          syllabic = false;
+          break;
+        
+        case modifier_symbol:
+          if(!have_phone || !apply_modifier(symbol.value, code, syllabic)) {
+            return position;
+          }
+          break;
+        
+        case tone_symbol:
+          level_count += symbol.value & 0x3;
+          if(level_count > 3) {
+            return position;
+          }
+          break;
+        
+        case stress_symbol:
+          if(seen_content) {
+            return position;
+          }
+          break;
+        
+      }
+      
+      if(symbol.kind != stress_symbol) {
+        seen_content = true;
+      }
+      output += symbols[table[row]].spellings[_target];
+      position += symbol_length;
+    }
+    
+    if(have_phone && !advance_phase(code, syllabic, phase)) {
+      return phone_start;
+    }
+    
+    if(phase == 0) {
+      return length;
+    }
+    
+    return -1;
+    
+  }
+
+// SyllableView
+  
+  SyllableView::~SyllableView() {}
+  
+  SyllableView::SyllableView(const unsigned char* record, 
+                             const PhoneCode* phones) {
+    
+    // Initialize essential fields
+    _record = record;
+    _phones = phones + read_number<uint32_t>(record, record_offset);
+    _onset_size = read_number<uint16_t>(record, record_onset);
+    _nucleus_size = read_number<uint16_t>(record, record_nucleus);
+    _coda_size = read_number<uint16_t>(record, record_coda);
+    
+  }
+  
+  SyllableView::SyllableView(const SyllableView& original) {
+    
+    // Initialize essential fields
+    _record = original._record;
+    _phones = original._phones;
+    _onset_size = original._onset_size;
+    _nucleus_size = original._nucleus_size;
+    _coda_size = original._coda_size;
+    
+  }
+  
+  SyllableView& SyllableView::operator=(const SyllableView& other) {
+    
+    // Transfer fields
+    _record = other._record;
+    _phones = other._phones;
+    _onset_size = other._onset_size;
+    _nucleus_size = other._nucleus_size;
+    _coda_size = other._coda_size;
+    
+    return *this;
+    
+  }
+  
+  PhoneCode SyllableView::operator[](int index) const {
+    
+    return _phones[checked_index(index, size())];
+    
+  }
+  
+  int SyllableView::size() const {
+    
+    return _onset_size + _nucleus_size + _coda_size;
+    
+  }
+  
+  int SyllableView::onset_size() const {
+    
+    return _onset_size;
+    
+  }
+  
+  int SyllableView::nucleus_size() const {
+    
+    return _nucleus_size;
+    
+  }
+  
+  int SyllableView::coda_size() const {
+    
+    return _coda_size;
+    
+  }
+  
+  PhoneCode SyllableView::onset(int index) const {
+    
+    return _phones[checked_index(index, _onset_size)];
+    
+  }
+  
+  PhoneCode SyllableView::nucleus(int index) const {
+    
+    return _phones[_onset_size + checked_index(index, _nucleus_size)];
+    
+  }
+  
+  PhoneCode SyllableView::coda(int index) const {
+    
+    return _phones[_onset_size + _nucleus_size + 
+                   checked_index(index, _coda_size)];
+    
+  }
+  
+  const PhoneCode* SyllableView::phones() const {
+    
+    return _phones;
+    
+  }
+  
+  Tone SyllableView::tone() const {
+    
+    const signed char* levels = 
+      reinterpret_cast<const signed char*>(_record + record_tone);
+    return Tone(levels[0], levels[1], levels[2]);
+    
+  }
+  
+  Syllable SyllableView::syllable() const {
+    
+    return make_syllable(_phones, _onset_size, _nucleus_size, _coda_size, 
+                         tone());
+    
+  }
+
+// CorpusView
+  
+  CorpusView::~CorpusView() {
+
+#if LANG_HAVE_MMAP
+    if(_mapping) {
+      munmap(_mapping, _length);
+    }
+#endif
+    
+  }
+  
+  CorpusView::CorpusView(const std::string& path, bool check_phones) {
+    
+    load(path, check_phones);
+    
+  }
+  
+  CorpusView::CorpusView(const char* path, bool check_phones) {
+    
+    load(path, check_phones);
+    
+  }
+  
+  CorpusView::CorpusView(const void* data, std::size_t length, 
+                         bool check_phones) {
+    
+    // Initialize essential fields
+    _data = static_cast<const unsigned char*>(data);
+    _length = length;
+    _mapping = 0;
+    _size = 0;
+    
+    validate(check_phones);
+    
+  }
+  
+  void CorpusView::load(const std::string& path, bool check_phones) {
+    
+    // Initialize essential fields
+    _data = 0;
+    _length = 0;
+    _mapping = 0;
+    _size = 0;
+
+#if LANG_HAVE_MMAP
+    int file = open(path.c_str(), O_RDONLY);
+    if(file < 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception("Could not open " + path + ".");
+    }
+    
+    struct stat status;
+    if(fstat(file, &status) != 0) {
+      close(file);
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception("Could not read " + path + ".");
+    }
+    _length = status.st_size;
+    
+    if(_length > 0) {
+      _mapping = mmap(0, _length, PROT_READ, MAP_PRIVATE, file, 0);
+      if(_mapping == MAP_FAILED) {
+        _mapping = 0;
+        close(file);
+        LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+        throw expt::Exception("Could not map " + path + ".");
+      }
+      _data = static_cast<const unsigned char*>(_mapping);
+    }
+    close(file);
+#else
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if(!file) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception("Could not open " + path + ".");
+    }
+    
+    // Read into 8-byte words so that the phones are aligned
+    file.seekg(0, std::ios::end);
+    _length = file.tellg();
+    file.seekg(0, std::ios::beg);
+    _buffer.resize(_length + sizeof(uint64_t));
+    unsigned char* start = _buffer.data();
+    start += (sizeof(uint64_t) - (std::uintptr_t) start % sizeof(uint64_t)) % 
+             sizeof(uint64_t);
+    if(!file.read(reinterpret_cast<char*>(start), _length)) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::other_exception);
+      throw expt::Exception("Could not read " + path + ".");
+    }
+    _data = start;
+#endif
+    
+    try {
+      validate(check_phones);
+    }
+    catch(...) {
+#if LANG_HAVE_MMAP
+      if(_mapping) {
+        munmap(_mapping, _length);
+      }
+#endif
+      throw;
+    }
+    
+  }
+  
+  SyllableView CorpusView::operator[](int index) const {
+    
+    index = checked_index(index, _size);
+    // The offsets are computed in std::size_t, since index * record_size 
+    // overflows an int for corpora of more than 2^27 syllables.
+    const unsigned char* records = _data + header_size;
+    return SyllableView(records + (std::size_t) index * record_size, 
+                        reinterpret_cast<const PhoneCode*>(
+                          records + (std::size_t) _size * record_size));
+    
+  }
+  
+  int CorpusView::size() const {
+    
+    return _size;
+    
+  }
+  
+  long long CorpusView::phone_count() const {
+    
+    return read_number<uint64_t>(_data, header_phone_count);
+    
+  }
+  
+  PhoneticSequence CorpusView::sequence() const {
+    
+    PhoneticSequence result;
+    result.reserve(_size);
+    for(int i = 0; i < _size; i++) {
+      result.push_back((*this)[i].syllable());
+    }
+    
+    return result;
+    
+  }
+  
+  void CorpusView::validate(bool check_phones) {
+    
+    if(_length < (std::size_t) header_size || 
+       std::memcmp(_data, corpus_magic, sizeof(corpus_magic)) != 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, "Not a binary corpus.");
+    }
+    if(read_number<uint32_t>(_data, header_byte_order) != byte_order_mark) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The corpus was written with another byte order.");
+    }
+    if(read_number<uint32_t>(_data, header_version) != (uint32_t) version) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "Unsupported binary corpus version.");
+    }
+    if((std::uintptr_t) _data % sizeof(uint64_t)) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The corpus is not aligned to 8 bytes.");
+    }
+    
+    uint64_t syllables = read_number<uint64_t>(_data, header_syllable_count);
+    uint64_t phones = read_number<uint64_t>(_data, header_phone_count);
+    if(syllables > (uint64_t) std::numeric_limits<int>::max() || 
+       phones > std::numeric_limits<uint32_t>::max() || 
+       _length != header_size + syllables * record_size + 
+                  phones * sizeof(uint64_t)) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The corpus is truncated or corrupt.");
+    }
+    
+    // Every syllable must lie within the phones, with a nucleus
+    for(uint64_t i = 0; i < syllables; i++) {
+      const unsigned char* record = _data + header_size + i * record_size;
+      uint64_t end = (uint64_t) read_number<uint32_t>(record, record_offset) + 
+                     read_number<uint16_t>(record, record_onset) + 
+                     read_number<uint16_t>(record, record_nucleus) + 
+                     read_number<uint16_t>(record, record_coda);
+      if(end > phones || read_number<uint16_t>(record, record_nucleus) == 0) {
+        LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+        throw expt::ValueError(expt::literal, 
+                               "The corpus is truncated or corrupt.");
+      }
+      for(int j = 0; j < 3; j++) {
+        int level = (signed char) record[record_tone + j];
+        if(level < -2 || level > 2) {
+          LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+          throw expt::ValueError(expt::literal, 
+                                 "The corpus contains an invalid tone.");
+        }
+      }
+    }
+    
+    // Views hand phone codes out unchecked, so untrusted ones must be 
+    // articulable
+    if(check_phones) {
+      const unsigned char* codes = _data + header_size + 
+                                   syllables * record_size;
+      for(uint64_t i = 0; i < phones; i++) {
+        PhoneCode code;
+        code.set_code(read_number<uint64_t>(codes + i * sizeof(uint64_t), 0));
+        if(code.violation() != Phone::no_violation) {
+          LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+          throw expt::ValueError(expt::literal, 
+                                 "The corpus contains an invalid phone.");
+        }
+      }
+    }
+    
+    _size = syllables;
+    
+  }
+
+// PhoneInventory
+  
+  const int PhoneInventory::first_chunk;
+  
+  const int PhoneInventory::chunk_count;
+  
+  PhoneInventory::~PhoneInventory() {
+    
+    for(int i = 0; i < chunk_count; i++) {
+      delete[] _chunks[i].load(std::memory_order_relaxed);
+    }
+    
+  }
+  
+  PhoneInventory::PhoneInventory() {
+    
+    // Initialize essential fields
+    for(int i = 0; i < chunk_count; i++) {
+      _chunks[i].store(0, std::memory_order_relaxed);
+    }
+    _size.store(0, std::memory_order_relaxed);
+    
+  }
+  
+  PhoneInventory& PhoneInventory::global() {
+    
+    static PhoneInventory inventory;
+    return inventory;
+    
+  }
+  
+  const PhoneInventory::Entry& PhoneInventory::entry(int id) const {
+    
+    int size = _size.load(std::memory_order_acquire);
+    if(id < 0 || id >= size) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(id, size);
+    }
+    
+    // Chunk k starts at first_chunk * (2^k - 1)
+    int chunk = highest_bit(id / first_chunk + 1);
+    int offset = id - first_chunk * ((1 << chunk) - 1);
+    return _chunks[chunk].load(std::memory_order_relaxed)[offset];
+    
+  }
+  
+  PhoneCode PhoneInventory::operator[](int id) const {
+    
+    return entry(id).code;
+    
+  }
+  
+  int PhoneInventory::size() const {
+    
+    return _size.load(std::memory_order_acquire);
+    
+  }
+  
+  int PhoneInventory::intern(const PhoneCode& phone) {
+    
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_map<uint64_t, int>::const_iterator found = 
+      _ids.find(phone.code());
+    if(found != _ids.end()) {
+      return found->second;
+    }
+    
+    int id = _size.load(std::memory_order_relaxed);
+    int chunk = highest_bit(id / first_chunk + 1);
+    int offset = id - first_chunk * ((1 << chunk) - 1);
+    if(chunk == chunk_count) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, "The inventory is full.");
+    }
+    
+    // Write the entry before publishing the new size
+    Entry* entries = _chunks[chunk].load(std::memory_order_relaxed);
+    if(!entries) {
+      entries = new Entry[first_chunk << chunk];
+      _chunks[chunk].store(entries, std::memory_order_relaxed);
+    }
+    entries[offset].code = phone;
+    entries[offset].description = phone.description();
+    
+    _ids.insert(std::make_pair(phone.code(), id));
+    _size.store(id + 1, std::memory_order_release);
+    return id;
+    
+  }
+  
+  int PhoneInventory::intern(const Phone& phone) {
+    
+    return intern(PhoneCode(phone));
+    
+  }
+  
+  void PhoneInventory::intern(const Syllable& syllable, std::vector<int>& ids) {
+    
+    for(Syllable::Slot slot : syllable.span()) {
+      ids.push_back(intern(slot.code()));
+    }
+    
+  }
+  
+  int PhoneInventory::find(const PhoneCode& phone) const {
+    
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_map<uint64_t, int>::const_iterator found = 
+      _ids.find(phone.code());
+    if(found == _ids.end()) {
+      return -1;
+    }
+    
+    return found->second;
+    
+  }
+  
+  const std::string& PhoneInventory::description(int id) const {
+    
+    return entry(id).description;
+    
+  }
+
+// ColumnarSequence
+  
+  const uint8_t ColumnarSequence::not_applicable;
+  
+  ColumnarSequence::~ColumnarSequence() {}
+  
+  ColumnarSequence::ColumnarSequence() {
+    
+    _offsets.push_back(0);
+    
+  }
+  
+  ColumnarSequence::ColumnarSequence(const PhoneticSequence& sequence) {
+    
+    _offsets.push_back(0);
+    append_sequence(sequence, *this);
+    
+  }
+  
+  ColumnarSequence::ColumnarSequence(const ArenaSequence& sequence) {
+    
+    _offsets.push_back(0);
+    append_sequence(sequence, *this);
+    
+  }
+  
+  void ColumnarSequence::append(const Syllable& syllable) {
+    
+    // Encode every phone first, so that nothing is added if one fails
+    std::vector<PhoneCode> codes;
+    codes.reserve(syllable.size());
+    for(Syllable::Slot slot : syllable.span()) {
+      codes.push_back(slot.code());
+    }
+    
+    for(int i = 0; i < (int) codes.size(); i++) {
+      const PhoneCode& code = codes[i];
+      _codes.push_back(code);
+      _phonations.push_back(code.phonation());
+      _lengths.push_back(code.length());
+      if(code.is_vowel()) {
+        _manners.push_back(not_applicable);
+        _places.push_back(not_applicable);
+        _heights.push_back(code.height());
+        _backnesses.push_back(code.backness());
+      }
+      else {
+        _manners.push_back(code.manner());
+        _places.push_back(code.place());
+        _heights.push_back(0);
+        _backnesses.push_back(0);
+      }
+    }
+    
+    _offsets.push_back(_codes.size());
+    _onset_sizes.push_back(syllable.onset_size());
+    _nucleus_sizes.push_back(syllable.nucleus_size());
+    _tones.push_back(syllable.tone_code());
+    
+  }
+  
+  void ColumnarSequence::reserve(int syllables, long long phones) {
+    
+    _codes.reserve(phones);
+    _phonations.reserve(phones);
+    _manners.reserve(phones);
+    _places.reserve(phones);
+    _heights.reserve(phones);
+    _backnesses.reserve(phones);
+    _lengths.reserve(phones);
+    
+    _offsets.reserve(syllables + 1);
+    _onset_sizes.reserve(syllables);
+    _nucleus_sizes.reserve(syllables);
+    _tones.reserve(syllables);
+    
+  }
+  
+  void ColumnarSequence::clear() {
+    
+    _codes.clear();
+    _phonations.clear();
+    _manners.clear();
+    _places.clear();
+    _heights.clear();
+    _backnesses.clear();
+    _lengths.clear();
+    
+    _offsets.resize(1);
+    _onset_sizes.clear();
+    _nucleus_sizes.clear();
+    _tones.clear();
+    
+  }
+  
+  int ColumnarSequence::size() const {
+    
+    return _onset_sizes.size();
+    
+  }
+  
+  long long ColumnarSequence::phone_count() const {
+    
+    return _codes.size();
+    
+  }
+  
+  void ColumnarSequence::set(long long index, PhoneCode phone) {
+    
+    // Negative indices count from the end
+    long long phones = _codes.size();
+    long long result = index < 0 ? index + phones : index;
+    if(result < 0 || result >= phones) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(index, phones);
+    }
+    
+    _codes[result] = phone;
+    _phonations[result] = phone.phonation();
+    _lengths[result] = phone.length();
+    if(phone.is_vowel()) {
+      _manners[result] = not_applicable;
+      _places[result] = not_applicable;
+      _heights[result] = phone.height();
+      _backnesses[result] = phone.backness();
+    }
+    else {
+      _manners[result] = phone.manner();
+      _places[result] = phone.place();
+      _heights[result] = 0;
+      _backnesses[result] = 0;
+    }
+    
+  }
+  
+  Syllable ColumnarSequence::syllable(int index) const {
+    
+    index = checked_index(index, size());
+    int onset_size = _onset_sizes[index];
+    int nucleus_size = _nucleus_sizes[index];
+    int coda_size = _offsets[index + 1] - _offsets[index] - onset_size - 
+                    nucleus_size;
+    
+    return make_syllable(&_codes[_offsets[index]], onset_size, nucleus_size, 
+                         coda_size, tone(index));
+    
+  }
+  
+  PhoneticSequence ColumnarSequence::sequence() const {
+    
+    PhoneticSequence result;
+    result.reserve(size());
+    for(int i = 0; i < size(); i++) {
+      result.push_back(syllable(i));
+    }
+    
+    return result;
+    
+  }
+  
+  long long ColumnarSequence::count_vowels() const {
+    
+    // Only vowels have no manner
+    return count_matches(_manners.data(), not_applicable, 
+                         _manners.data(), not_applicable, 
+                         _manners.data(), not_applicable, _codes.size());
+    
+  }
+  
+  long long ColumnarSequence::count(Phone::Phonation phonation) const {
+    
+    return count_matches(_phonations.data(), phonation, 
+                         _phonations.data(), phonation, 
+                         _phonations.data(), phonation, _codes.size());
+    
+  }
+  
+  long long ColumnarSequence::count(Consonant::Manner manner, 
+                                    Consonant::Place place) const {
+    
+    return count_matches(_manners.data(), manner, _places.data(), place, 
+                         _places.data(), place, _codes.size());
+    
+  }
+  
+  long long ColumnarSequence::count(Consonant::Manner manner, 
+                                    Consonant::Place place, 
+                                    Phone::Phonation phonation) const {
+    
+    return count_matches(_manners.data(), manner, _places.data(), place, 
+                         _phonations.data(), phonation, _codes.size());
+    
+  }
+  
+  double ColumnarSequence::mean_height() const {
+    
+    // Consonants have a height of 0, so they do not change the sum
+    long long vowels = count_vowels();
+    if(vowels == 0) {
+      return 0;
+    }
+    
+    return sum(_heights.data(), _heights.size()) / vowels;
+    
+  }
+  
+  double ColumnarSequence::mean_backness() const {
+    
+    long long vowels = count_vowels();
+    if(vowels == 0) {
+      return 0;
+    }
+    
+    return sum(_backnesses.data(), _backnesses.size()) / vowels;
+    
+  }
+  
+  double ColumnarSequence::total_length() const {
+    
+    return sum(_lengths.data(), _lengths.size());
+    
+  }
+  
+  const PhoneCode* ColumnarSequence::codes() const {
+    
+    return _codes.data();
+    
+  }
+  
+  const uint8_t* ColumnarSequence::phonations() const {
+    
+    return _phonations.data();
+    
+  }
+  
+  const uint8_t* ColumnarSequence::manners() const {
+    
+    return _manners.data();
+    
+  }
+  
+  const uint8_t* ColumnarSequence::places() const {
+    
+    return _places.data();
+    
+  }
+  
+  const float* ColumnarSequence::heights() const {
+    
+    return _heights.data();
+    
+  }
+  
+  const float* ColumnarSequence::backnesses() const {
+    
+    return _backnesses.data();
+    
+  }
+  
+  const float* ColumnarSequence::lengths() const {
+    
+    return _lengths.data();
+    
+  }
+  
+  const int* ColumnarSequence::offsets() const {
+    
+    return _offsets.data();
+    
+  }
+  
+  const uint16_t* ColumnarSequence::onset_sizes() const {
+    
+    return _onset_sizes.data();
+    
+  }
+  
+  const uint16_t* ColumnarSequence::nucleus_sizes() const {
+    
+    return _nucleus_sizes.data();
+    
+  }
+  
+  const ToneCode* ColumnarSequence::tones() const {
+    
+    return _tones.data();
+    
+  }
+  
+  Tone ColumnarSequence::tone(int index) const {
+    
+    return _tones[checked_index(index, size())].tone();
+    
+  }
+  
+  void ColumnarSequence::tone_histogram(long long counts[ToneCode::count]) 
+    const {
+    
+    add_tone_counts(_tones.data(), size(), counts);
+    
+  }
+
+// PhoneFeatures
+  
+  const int PhoneFeatures::feature_count;
+  
+  PhoneFeatures::~PhoneFeatures() {}
+  
+  PhoneFeatures::PhoneFeatures() {}
+  
+  PhoneFeatures::PhoneFeatures(const std::vector<PhoneCode>& phones) {
+    
+    _phones.reserve(phones.size());
+    for(int k = 0; k < feature_count; k++) {
+      _columns[k].reserve(phones.size());
+    }
+    
+    for(int i = 0; i < (int) phones.size(); i++) {
+      append(phones[i]);
+    }
+    
+  }
+  
+  void PhoneFeatures::features(const PhoneCode& phone, float* output) {
+    
+    for(int k = 0; k < feature_count; k++) {
+      output[k] = 0;
+    }
+    
+    if(phone.is_vowel()) {
+      output[1] = phone.height() / Vowel::close;
+      output[2] = phone.backness() / Vowel::back;
+      output[3] = phone.roundedness() != Vowel::unrounded;
+    }
+    else {
+      output[0] = 1;
+      output[4] = (float) phone.place() / Consonant::glottal;
+      output[5] = (float) phone.manner() / Consonant::nasal;
+    }
+    output[6] = (float) phone.phonation() / Phone::strident;
+    output[7] = (float) phone.nasalization() / Phone::strongly_nasal;
+    
+  }
+  
+  float PhoneFeatures::distance(const PhoneCode& phone1, 
+                                const PhoneCode& phone2) {
+    
+    float features1[feature_count];
+    float features2[feature_count];
+    features(phone1, features1);
+    features(phone2, features2);
+    
+    return feature_distance(features1, features2);
+    
+  }
+  
+  void PhoneFeatures::append(const PhoneCode& phone) {
+    
+    float values[feature_count];
+    features(phone, values);
+    
+    _phones.push_back(phone);
+    for(int k = 0; k < feature_count; k++) {
+      _columns[k].push_back(values[k]);
+    }
+    
+  }
+  
+  int PhoneFeatures::size() const {
+    
+    return _phones.size();
+    
+  }
+  
+  PhoneCode PhoneFeatures::operator[](int index) const {
+    
+    return _phones[checked_index(index, size())];
+    
+  }
+  
+  float PhoneFeatures::distance(int index1, int index2) const {
+    
+    return distance((*this)[index1], (*this)[index2]);
+    
+  }
+  
+  void PhoneFeatures::distances(const PhoneCode& phone, float* output) const {
+    
+    float point[feature_count];
+    features(phone, point);
+    
+    const float* columns[feature_count];
+    for(int k = 0; k < feature_count; k++) {
+      columns[k] = _columns[k].data();
+    }
+    
+    feature_distances(columns, size(), point, output);
+    
+  }
+  
+  void PhoneFeatures::distances(int index, float* output) const {
+    
+    distances((*this)[index], output);
+    
+  }
+  
+  void PhoneFeatures::distance_matrix(float* output) const {
+    
+    for(int i = 0; i < size(); i++) {
+      distances(_phones[i], output + (std::size_t) i * size());
+    }
+    
+  }
+  
+  void PhoneFeatures::distance_matrix(float* output, ThreadPool& pool) const {
+    
+    pool.run(size(), [&](int begin, int end) {
+      for(int i = begin; i < end; i++) {
+        distances(_phones[i], output + (std::size_t) i * size());
+      }
+    });
+    
+  }
+
+// Aligner
+  
+  Aligner::~Aligner() {}
+  
+  Aligner::Aligner(float gap_cost, float substitution_weight) {
+    
+    if(!(gap_cost > 0)) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, "The gap cost must be positive.");
+    }
+    if(!(substitution_weight >= 0)) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The substitution weight cannot be negative.");
+    }
+    
+    // Initialize essential fields
+    _gap_cost = gap_cost;
+    _substitution_weight = substitution_weight;
+    
+  }
+  
+  float Aligner::gap_cost() const {
+    
+    return _gap_cost;
+    
+  }
+  
+  float Aligner::substitution_weight() const {
+    
+    return _substitution_weight;
+    
+  }
+  
+  float Aligner::substitution_cost(const PhoneCode& phone1, 
+                                   const PhoneCode& phone2) const {
+    
+    if(phone1 == phone2) {
+      return 0;
+    }
+    
+    return _substitution_weight * PhoneFeatures::distance(phone1, phone2);
+    
+  }
+  
+  float Aligner::distance(const PhoneCode* first, int first_size, 
+                          const PhoneCode* second, int second_size, 
+                          int band) const {
+    
+    const float infinity = std::numeric_limits<float>::infinity();
+    if(band < 0 || band > first_size + second_size) {
+      band = first_size + second_size;
+    }
+    if(std::abs(first_size - second_size) > band) {
+      return infinity;
+    }
+    
+    SubstitutionCosts substitution_costs(first, first_size, second, 
+                                         second_size, _substitution_weight);
+    
+    // Cells outside the band are left at infinity
+    std::vector<float> previous(second_size + 1, infinity);
+    std::vector<float> current(second_size + 1, infinity);
+    for(int j = 0; j <= std::min(band, second_size); j++) {
+      previous[j] = j * _gap_cost;
+    }
+    
+    for(int i = 1; i <= first_size; i++) {
+      int begin = std::max(0, i - band);
+      int end = std::min(second_size, i + band);
+      if(begin > 0) {
+        current[begin - 1] = infinity;
+      }
+      else {
+        current[0] = i * _gap_cost;
+      }
+      
+      for(int j = std::max(1, begin); j <= end; j++) {
+        float substitution = previous[j - 1] + 
+                             substitution_costs(i - 1, j - 1);
+        float deletion = previous[j] + _gap_cost;
+        float insertion = current[j - 1] + _gap_cost;
+        current[j] = std::min(substitution, std::min(deletion, insertion));
+      }
+      
+      std::swap(previous, current);
+    }
+    
+    return previous[second_size];
+    
+  }
+  
+  float Aligner::distance(const PhoneticSequence& first, 
+                          const PhoneticSequence& second, int band) const {
+    
+    std::vector<PhoneCode> first_phones = flatten(first);
+    std::vector<PhoneCode> second_phones = flatten(second);
+    return distance(first_phones.data(), first_phones.size(), 
+                    second_phones.data(), second_phones.size(), band);
+    
+  }
+  
+  float Aligner::distance(const ArenaSequence& first, 
+                          const ArenaSequence& second, int band) const {
+    
+    std::vector<PhoneCode> first_phones = flatten(first);
+    std::vector<PhoneCode> second_phones = flatten(second);
+    return distance(first_phones.data(), first_phones.size(), 
+                    second_phones.data(), second_phones.size(), band);
+    
+  }
+  
+  float Aligner::align(const PhoneCode* first, int first_size, 
+                       const PhoneCode* second, int second_size, 
+                       std::vector<Step>& steps) const {
+    
+    SubstitutionCosts substitution_costs(first, first_size, second, 
+                                         second_size, _substitution_weight);
+    
+    // The whole matrix is kept so that the alignment can be traced back
+    int width = second_size + 1;
+    std::vector<float> costs((first_size + 1) * width);
+    for(int j = 0; j <= second_size; j++) {
+      costs[j] = j * _gap_cost;
+    }
+    for(int i = 1; i <= first_size; i++) {
+      costs[i * width] = i * _gap_cost;
+      for(int j = 1; j <= second_size; j++) {
+        float substitution = costs[(i - 1) * width + j - 1] + 
+                             substitution_costs(i - 1, j - 1);
+        float deletion = costs[(i - 1) * width + j] + _gap_cost;
+        float insertion = costs[i * width + j - 1] + _gap_cost;
+        costs[i * width + j] = std::min(substitution, 
+                                        std::min(deletion, insertion));
+      }
+    }
+    
+    // Walk back from the end, preferring substitutions to gaps
+    steps.clear();
+    int i = first_size;
+    int j = second_size;
+    while(i > 0 || j > 0) {
+      float cost = costs[i * width + j];
+      if(i > 0 && j > 0 && 
+         cost == costs[(i - 1) * width + j - 1] + 
+                 substitution_costs(i - 1, j - 1)) {
+        i--;
+        j--;
+        steps.push_back(Step{i, j});
+      }
+      else if(i > 0 && cost == costs[(i - 1) * width + j] + _gap_cost) {
+        i--;
+        steps.push_back(Step{i, -1});
+      }
+      else {
+        j--;
+        steps.push_back(Step{-1, j});
+      }
+    }
+    std::reverse(steps.begin(), steps.end());
+    
+    return costs[first_size * width + second_size];
+    
+  }
+  
+  float Aligner::align(const PhoneticSequence& first, 
+                       const PhoneticSequence& second, 
+                       std::vector<Step>& steps) const {
+    
+    std::vector<PhoneCode> first_phones = flatten(first);
+    std::vector<PhoneCode> second_phones = flatten(second);
+    return align(first_phones.data(), first_phones.size(), 
+                 second_phones.data(), second_phones.size(), steps);
+    
+  }
+  
+  float Aligner::align(const ArenaSequence& first, 
+                       const ArenaSequence& second, 
+                       std::vector<Step>& steps) const {
+    
+    std::vector<PhoneCode> first_phones = flatten(first);
+    std::vector<PhoneCode> second_phones = flatten(second);
+    return align(first_phones.data(), first_phones.size(), 
+                 second_phones.data(), second_phones.size(), steps);
+    
+  }
+  
+  int Aligner::edit_distance(const PhoneCode* first, int first_size, 
+                             const PhoneCode* second, int second_size) {
+    
+    // The shorter string is the one packed into bits
+    if(first_size > second_size) {
+      std::swap(first, second);
+      std::swap(first_size, second_size);
+    }
+    if(first_size == 0) {
+      return second_size;
+    }
+    if(first_size <= 64) {
+      return bit_parallel_distance(first, first_size, second, second_size);
+    }
+    
+    std::vector<int> previous(second_size + 1);
+    std::vector<int> current(second_size + 1);
+    for(int j = 0; j <= second_size; j++) {
+      previous[j] = j;
+    }
+    for(int i = 1; i <= first_size; i++) {
+      current[0] = i;
+      for(int j = 1; j <= second_size; j++) {
+        current[j] = std::min(previous[j - 1] + (first[i - 1] != second[j - 1]),
+                              std::min(previous[j], current[j - 1]) + 1);
+      }
+      std::swap(previous, current);
+    }
+    
+    return previous[second_size];
+    
+  }
+  
+  int Aligner::edit_distance(const PhoneticSequence& first, 
+                             const PhoneticSequence& second) {
+    
+    std::vector<PhoneCode> first_phones = flatten(first);
+    std::vector<PhoneCode> second_phones = flatten(second);
+    return edit_distance(first_phones.data(), first_phones.size(), 
+                         second_phones.data(), second_phones.size());
+    
+  }
+  
+  int Aligner::edit_distance(const ArenaSequence& first, 
+                             const ArenaSequence& second) {
+    
+    std::vector<PhoneCode> first_phones = flatten(first);
+    std::vector<PhoneCode> second_phones = flatten(second);
+    return edit_distance(first_phones.data(), first_phones.size(), 
+                         second_phones.data(), second_phones.size());
+    
+  }
+  
+  void Aligner::distances(const std::vector<PhoneticSequence>& first, 
+                          const std::vector<PhoneticSequence>& second, 
+                          float* output, ThreadPool& pool, int band) const {
+    
+    if(first.size() != second.size()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "Both lists of sequences must be the same size.");
+    }
+    
+    pool.run(first.size(), [&](int begin, int end) {
+      for(int i = begin; i < end; i++) {
+        output[i] = distance(first[i], second[i], band);
+      }
+    });
+    
+  }
+
+// SyllableIndex
+  
+  SyllableIndex::~SyllableIndex() {}
+  
+  SyllableIndex::SyllableIndex() {
+    
+    // Initialize essential fields
+    _slots.assign(16, -1);
+    _tokens = 0;
+    
+  }
+  
+  int SyllableIndex::add(const Syllable& syllable, long long count) {
+    
+    if(count < 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "A syllable cannot be added a negative number "
+                             "of times.");
+    }
+    
+    std::size_t hash = syllable.hash();
+    int slot = probe(syllable, hash);
+    int id = _slots[slot];
+    if(id < 0) {
+      
+      // A new type
+      id = _syllables.size();
+      _syllables.push_back(syllable);
+      _hashes.push_back(hash);
+      _counts.push_back(0);
+      _slots[slot] = id;
+      if(2 * _syllables.size() > _slots.size()) {
+        grow();
+      }
+      
+    }
+    
+    _counts[id] += count;
+    _tokens += count;
+    
+    return id;
+    
+  }
+  
+  void SyllableIndex::add(const PhoneticSequence& sequence) {
+    
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      add(sequence[i]);
+    }
+    
+  }
+  
+  int SyllableIndex::find(const Syllable& syllable) const {
+    
+    return _slots[probe(syllable, syllable.hash())];
+    
+  }
+  
+  const Syllable& SyllableIndex::operator[](int id) const {
+    
+    if(id < 0 || id >= size()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(id, size());
+    }
+    
+    return _syllables[id];
+    
+  }
+  
+  long long SyllableIndex::count(int id) const {
+    
+    if(id < 0 || id >= size()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(id, size());
+    }
+    
+    return _counts[id];
+    
+  }
+  
+  int SyllableIndex::size() const {
+    
+    return _syllables.size();
+    
+  }
+  
+  long long SyllableIndex::tokens() const {
+    
+    return _tokens;
+    
+  }
+  
+  void SyllableIndex::clear() {
+    
+    _slots.assign(16, -1);
+    _syllables.clear();
+    _hashes.clear();
+    _counts.clear();
+    _tokens = 0;
+    
+  }
+  
+  int SyllableIndex::probe(const Syllable& syllable, std::size_t hash) const {
+    
+    return probe_slots(_slots, _hashes, hash, [&](int id) {
+      return _syllables[id] == syllable;
+    });
+    
+  }
+  
+  void SyllableIndex::grow() {
+    
+    grow_slots(_slots, _hashes);
+    
+  }
+
+// EncodingCache
+  
+  EncodingCache::~EncodingCache() {}
+  
+  EncodingCache::EncodingCache() {
+    
+    // Initialize essential fields
+    _misses = 0;
+    
+  }
+  
+  const std::string& EncodingCache::encode(int position, 
+                                           const Syllable& syllable, 
+                                           PhoneticEncoding encoding) {
+    
+    if(position < 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(position, _stamps[encoding].size());
+    }
+    
+    std::vector<uint64_t>& stamps = _stamps[encoding];
+    std::vector<std::string>& transcriptions = _transcriptions[encoding];
+    if(position >= (int) stamps.size()) {
+      stamps.resize(position + 1, 0);
+      transcriptions.resize(position + 1);
+    }
+    
+    std::string& transcription = transcriptions[position];
+    if(stamps[position] != syllable.stamp()) {
+      transcription.clear();
+      syllable.encode(transcription, encoding);
+      stamps[position] = syllable.stamp();
+      _misses++;
+    }
+    
+    return transcription;
+    
+  }
+  
+  void EncodingCache::encode(const PhoneticSequence& sequence, 
+                             std::string& output, PhoneticEncoding encoding, 
+                             char separator) {
+    
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      if(i > 0) {
+        output += separator;
+      }
+      output += encode(i, sequence[i], encoding);
+    }
+    
+    // Entries past the end would only be hit by a sequence that grows back
+    if(_stamps[encoding].size() > sequence.size()) {
+      _stamps[encoding].resize(sequence.size());
+      _transcriptions[encoding].resize(sequence.size());
+    }
+    
+  }
+  
+  int EncodingCache::size() const {
+    
+    std::size_t result = 0;
+    for(int i = 0; i < 3; i++) {
+      result = std::max(result, _stamps[i].size());
+    }
+    
+    return result;
+    
+  }
+  
+  long long EncodingCache::misses() const {
+    
+    return _misses;
+    
+  }
+  
+  void EncodingCache::clear() {
+    
+    for(int i = 0; i < 3; i++) {
+      _stamps[i].clear();
+      _transcriptions[i].clear();
+    }
+    _misses = 0;
+    
+  }
+
+// Lexicon::Pronunciation
+  
+  Lexicon::Pronunciation::~Pronunciation() {}
+  
+  Lexicon::Pronunciation::Pronunciation(const unsigned char* records, 
+                                        const PhoneCode* phones, int size) {
+    
+    // Initialize essential fields
+    _records = records;
+    _phones = phones;
+    _size = size;
+    
+  }
+  
+  SyllableView Lexicon::Pronunciation::operator[](int index) const {
+    
+    index = checked_index(index, _size);
+    return SyllableView(_records + (std::size_t) index * record_size, _phones);
+    
+  }
+  
+  int Lexicon::Pronunciation::size() const {
+    
+    return _size;
+    
+  }
+  
+  PhoneticSequence Lexicon::Pronunciation::sequence() const {
+    
+    PhoneticSequence result;
+    result.reserve(_size);
+    for(int i = 0; i < _size; i++) {
+      result.push_back((*this)[i].syllable());
+    }
+    
+    return result;
+    
+  }
+
+// Lexicon
+  
+  Lexicon::~Lexicon() {}
+  
+  Lexicon::Lexicon() {
+    
+    // Initialize essential fields
+    _slots.assign(16, -1);
+    _word_offsets.push_back(0);
+    _syllable_offsets.push_back(0);
+    _frozen = false;
+    
+  }
+  
+  int Lexicon::add(const std::string& word, 
+                   const PhoneticSequence& pronunciation) {
+    
+    if(_frozen) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "A frozen lexicon cannot be changed.");
+    }
+    
+    std::size_t hash = mix(std::hash<std::string>()(word));
+    int slot = probe(word, hash);
+    if(_slots[slot] >= 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The word is already in the lexicon.");
+    }
+    
+    // Check that everything fits before changing anything
+    uint64_t phones = _phones.size();
+    for(int i = 0; i < (int) pronunciation.size(); i++) {
+      const Syllable& syllable = pronunciation[i];
+      if(syllable.onset_size() > 0xFFFF || syllable.nucleus_size() > 0xFFFF || 
+         syllable.coda_size() > 0xFFFF) {
+        LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+        throw expt::ValueError(expt::literal, 
+                               "A syllable is too long for a lexicon.");
+      }
+      phones += syllable.size();
+    }
+    if(phones > std::numeric_limits<uint32_t>::max()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, "Too many phones for a lexicon.");
+    }
+    
+    for(int i = 0; i < (int) pronunciation.size(); i++) {
+      const Syllable& syllable = pronunciation[i];
+      std::size_t record = _records.size();
+      _records.resize(record + record_size, 0);
+      write_record(&_records[record], syllable, _phones.size());
+      for(Syllable::Slot slot : syllable.span()) {
+        _phones.push_back(slot.code());
+      }
+    }
+    
+    int id = size();
+    _words += word;
+    _word_offsets.push_back(_words.size());
+    _hashes.push_back(hash);
+    _syllable_offsets.push_back(_records.size() / record_size);
+    _slots[slot] = id;
+    if(2 * size() > (int) _slots.size()) {
+      grow();
+    }
+    
+    return id;
+    
+  }
+  
+  void Lexicon::freeze() {
+    
+    _frozen = true;
+    
+  }
+  
+  bool Lexicon::frozen() const {
+    
+    return _frozen;
+    
+  }
+  
+  int Lexicon::find(const std::string& word) const {
+    
+    return _slots[probe(word, mix(std::hash<std::string>()(word)))];
+    
+  }
+  
+  Lexicon::Pronunciation Lexicon::operator[](int id) const {
+    
+    if(id < 0 || id >= size()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(id, size());
+    }
+    
+    int first = _syllable_offsets[id];
+    return Pronunciation(_records.data() + (std::size_t) first * record_size, 
+                         _phones.data(), _syllable_offsets[id + 1] - first);
+    
+  }
+  
+  std::string Lexicon::word(int id) const {
+    
+    if(id < 0 || id >= size()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::index_error);
+      throw expt::IndexError(id, size());
+    }
+    
+    return _words.substr(_word_offsets[id], 
+                         _word_offsets[id + 1] - _word_offsets[id]);
+    
+  }
+  
+  int Lexicon::size() const {
+    
+    return _hashes.size();
+    
+  }
+  
+  long long Lexicon::phone_count() const {
+    
+    return _phones.size();
+    
+  }
+  
+  int Lexicon::probe(const std::string& word, std::size_t hash) const {
+    
+    return probe_slots(_slots, _hashes, hash, [&](int id) {
+      std::size_t length = _word_offsets[id + 1] - _word_offsets[id];
+      return length == word.size() && 
+             _words.compare(_word_offsets[id], length, word) == 0;
+    });
+    
+  }
+  
+  void Lexicon::grow() {
+    
+    grow_slots(_slots, _hashes);
+    
+  }
+
+// NgramCounter
+  
+  const int NgramCounter::max_order;
+  
+  const int NgramCounter::boundary;
+  
+  NgramCounter::~NgramCounter() {}
+  
+  NgramCounter::NgramCounter(int order, PhoneInventory& inventory) {
+    
+    if(order < 1 || order > max_order) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "N-grams must have between 1 and 4 phones.");
+    }
+    
+    // Initialize essential fields
+    _order = order;
+    _inventory = &inventory;
+    clear();
+    
+  }
+  
+  void NgramCounter::add(const Syllable& syllable) {
+    
+    _buffer.clear();
+    for(Syllable::Slot slot : syllable.span()) {
+      _buffer.push_back(id(slot.code()));
+    }
+    
+    const int* ids = _buffer.data();
+    count(Syllable::onset_part, ids, syllable.onset_size());
+    ids += syllable.onset_size();
+    count(Syllable::nucleus_part, ids, syllable.nucleus_size());
+    ids += syllable.nucleus_size();
+    count(Syllable::coda_part, ids, syllable.coda_size());
+    _tones[syllable.tone_code().code()]++;
+    _syllables++;
+    
+  }
+  
+  void NgramCounter::add(const SyllableView& syllable) {
+    
+    _buffer.clear();
+    const PhoneCode* phones = syllable.phones();
+    for(int i = 0; i < syllable.size(); i++) {
+      _buffer.push_back(id(phones[i]));
+    }
+    
+    const int* ids = _buffer.data();
+    count(Syllable::onset_part, ids, syllable.onset_size());
+    ids += syllable.onset_size();
+    count(Syllable::nucleus_part, ids, syllable.nucleus_size());
+    ids += syllable.nucleus_size();
+    count(Syllable::coda_part, ids, syllable.coda_size());
+    _tones[ToneCode(syllable.tone()).code()]++;
+    _syllables++;
+    
+  }
+  
+  void NgramCounter::add(const PhoneticSequence& sequence) {
+    
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      add(sequence[i]);
+    }
+    
+  }
+  
+  void NgramCounter::add(const CorpusView& corpus) {
+    
+    for(int i = 0; i < corpus.size(); i++) {
+      add(corpus[i]);
+    }
+    
+  }
+  
+  void NgramCounter::add(const PhoneticSequence& sequence, ThreadPool& pool) {
+    
+    count_shards(*this, sequence, sequence.size(), pool);
+    
+  }
+  
+  void NgramCounter::add(const CorpusView& corpus, ThreadPool& pool) {
+    
+    count_shards(*this, corpus, corpus.size(), pool);
+    
+  }
+  
+  void NgramCounter::merge(const NgramCounter& other) {
+    
+    if(other._order != _order || other._inventory != _inventory) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "Only counters with the same order and inventory "
+                             "can be merged.");
+    }
+    
+    for(int part = 0; part < 3; part++) {
+      for(const std::pair<const uint64_t, long long>& entry : 
+          other._counts[part]) {
+        _counts[part][entry.first] += entry.second;
+      }
+      for(int length = 0; length < max_order; length++) {
+        _totals[part][length] += other._totals[part][length];
+      }
+    }
+    for(int i = 0; i < ToneCode::count; i++) {
+      _tones[i] += other._tones[i];
+    }
+    _syllables += other._syllables;
+    
+  }
+  
+  long long NgramCounter::count(Syllable::Part part, 
+                                const std::vector<int>& ngram) const {
+    
+    uint64_t ngram_key;
+    if(!key(ngram, ngram_key)) {
+      return 0;
+    }
+    
+    std::unordered_map<uint64_t, long long>::const_iterator found = 
+      _counts[part].find(ngram_key);
+    return found == _counts[part].end() ? 0 : found->second;
+    
+  }
+  
+  long long NgramCounter::total(Syllable::Part part, int length) const {
+    
+    if(length < 1 || length > _order) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The length is not one that is counted.");
+    }
+    
+    return _totals[part][length - 1];
+    
+  }
+  
+  double NgramCounter::probability(Syllable::Part part, 
+                                   const std::vector<int>& ngram) const {
+    
+    long long occurrences = count(part, ngram);
+    if(ngram.size() == 1) {
+      long long phones = _totals[part][0];
+      return phones == 0 ? 0 : (double) occurrences / phones;
+    }
+    
+    // Only the boundary at the start of a part is followed by anything, and 
+    // every part has two boundaries
+    std::vector<int> context(ngram.begin(), ngram.end() - 1);
+    long long contexts = count(part, context);
+    if(context.back() == boundary) {
+      contexts = context.size() == 1 ? contexts / 2 : 0;
+    }
+    
+    return contexts == 0 ? 0 : (double) occurrences / contexts;
+    
+  }
+  
+  long long NgramCounter::tone_count(const ToneCode& tone) const {
+    
+    return _tones[tone.code()];
+    
+  }
+  
+  long long NgramCounter::syllables() const {
+    
+    return _syllables;
+    
+  }
+  
+  int NgramCounter::order() const {
+    
+    return _order;
+    
+  }
+  
+  PhoneInventory& NgramCounter::inventory() const {
+    
+    return *_inventory;
+    
+  }
+  
+  void NgramCounter::clear() {
+    
+    for(int part = 0; part < 3; part++) {
+      _counts[part].clear();
+      for(int length = 0; length < max_order; length++) {
+        _totals[part][length] = 0;
+      }
+    }
+    for(int i = 0; i < ToneCode::count; i++) {
+      _tones[i] = 0;
+    }
+    _syllables = 0;
+    
+  }
+  
+  int NgramCounter::id(const PhoneCode& phone) {
+    
+    std::unordered_map<uint64_t, int>::iterator found = 
+      _ids.find(phone.code());
+    if(found != _ids.end()) {
+      return found->second;
+    }
+    
+    int result = _inventory->intern(phone);
+    if(result > ngram_max_id) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "Too many distinct phones for n-gram keys.");
+    }
+    _ids[phone.code()] = result;
+    
+    return result;
+    
+  }
+  
+  void NgramCounter::count(int part, const int* ids, int size) {
+    
+    // The part runs from the boundary before it to the boundary after it
+    std::unordered_map<uint64_t, long long>& counts = _counts[part];
+    int length = size + 2;
+    for(int i = 0; i < length; i++) {
+      uint64_t ngram_key = 0;
+      for(int j = 0; j < _order && i + j < length; j++) {
+        int position = i + j;
+        uint64_t symbol = position == 0 || position == length - 1 ? 
+                          ngram_boundary : ids[position - 1] + 1;
+        ngram_key |= symbol << (16 * j);
+        counts[ngram_key]++;
+        _totals[part][j]++;
+      }
+    }
+    
+  }
+  
+  bool NgramCounter::key(const std::vector<int>& ngram, uint64_t& result) 
+    const {
+    
+    if(ngram.empty() || (int) ngram.size() > _order) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The n-gram is not a length that is counted.");
+    }
+    
+    result = 0;
+    for(int i = 0; i < (int) ngram.size(); i++) {
+      uint64_t symbol;
+      if(ngram[i] == boundary) {
+        symbol = ngram_boundary;
+      }
+      else if(ngram[i] >= 0 && ngram[i] <= ngram_max_id) {
+        symbol = ngram[i] + 1;
+      }
+      else {
+        return false;
+      }
+      result |= symbol << (16 * i);
+    }
+    
+    return true;
+    
+  }
+
+// FeatureIndex::Bitmap
+  
+  FeatureIndex::Bitmap::~Bitmap() {}
+  
+  FeatureIndex::Bitmap::Bitmap(int size) {
+    
+    if(size < 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "A bitmap cannot have a negative size.");
+    }
+    
+    // Initialize essential fields
+    _words.assign((size + 63) / 64, 0);
+    _size = size;
+    
+  }
+  
+  FeatureIndex::Bitmap& FeatureIndex::Bitmap::operator&=(const Bitmap& other) {
+    
+    check_size(other);
+    for(int i = 0; i < (int) _words.size(); i++) {
+      _words[i] &= other._words[i];
+    }
+    
+    return *this;
+    
+  }
+  
+  FeatureIndex::Bitmap& FeatureIndex::Bitmap::operator|=(const Bitmap& other) {
+    
+    check_size(other);
+    for(int i = 0; i < (int) _words.size(); i++) {
+      _words[i] |= other._words[i];
+    }
+    
+    return *this;
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::Bitmap::operator&(const Bitmap& other) 
+    const {
+    
+    Bitmap result = *this;
+    result &= other;
+    
+    return result;
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::Bitmap::operator|(const Bitmap& other) 
+    const {
+    
+    Bitmap result = *this;
+    result |= other;
+    
+    return result;
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::Bitmap::operator~() const {
+    
+    Bitmap result = *this;
+    for(int i = 0; i < (int) _words.size(); i++) {
+      result._words[i] = ~_words[i];
+    }
+    
+    // Keep the bits past the end clear
+    if(_size % 64) {
+      result._words.back() &= ~0ULL >> (64 - _size % 64);
+    }
+    
+    return result;
+    
+  }
+  
+  bool FeatureIndex::Bitmap::operator==(const Bitmap& other) const {
+    
+    return _size == other._size && _words == other._words;
+    
+  }
+  
+  bool FeatureIndex::Bitmap::operator!=(const Bitmap& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  bool FeatureIndex::Bitmap::operator[](int index) const {
+    
+    index = checked_index(index, _size);
+    return _words[index / 64] >> (index % 64) & 1;
+    
+  }
+  
+  void FeatureIndex::Bitmap::set(int index) {
+    
+    index = checked_index(index, _size);
+    _words[index / 64] |= 1ULL << (index % 64);
+    
+  }
+  
+  int FeatureIndex::Bitmap::size() const {
+    
+    return _size;
+    
+  }
+  
+  int FeatureIndex::Bitmap::count() const {
+    
+    int result = 0;
+    for(int i = 0; i < (int) _words.size(); i++) {
+      result += popcount(_words[i]);
+    }
+    
+    return result;
+    
+  }
+  
+  void FeatureIndex::Bitmap::indices(std::vector<int>& output) const {
+    
+    for(int i = 0; i < (int) _words.size(); i++) {
+      for(uint64_t word = _words[i]; word; word &= word - 1) {
+        output.push_back(64 * i + lowest_bit(word));
+      }
+    }
+    
+  }
+  
+  const uint64_t* FeatureIndex::Bitmap::words() const {
+    
+    return _words.data();
+    
+  }
+  
+  void FeatureIndex::Bitmap::check_size(const Bitmap& other) const {
+    
+    if(other._size != _size) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "The bitmaps cover different numbers of phones.");
+    }
+    
+  }
+
+// FeatureIndex
+  
+  FeatureIndex::~FeatureIndex() {}
+  
+  FeatureIndex::FeatureIndex(const PhoneCode* phones, int size) {
+    
+    if(size < 0) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "An index cannot have a negative size.");
+    }
+    
+    // Initialize essential fields
+    _phones.assign(phones, phones + size);
+    build();
+    
+  }
+  
+  FeatureIndex::FeatureIndex(const PhoneInventory& inventory) {
+    
+    // Initialize essential fields
+    int size = inventory.size();
+    _phones.reserve(size);
+    for(int id = 0; id < size; id++) {
+      _phones.push_back(inventory[id]);
+    }
+    build();
+    
+  }
+  
+  FeatureIndex::FeatureIndex(const ColumnarSequence& sequence) {
+    
+    if(sequence.phone_count() > std::numeric_limits<int>::max()) {
+      LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+      throw expt::ValueError(expt::literal, 
+                             "Too many phones for a feature index.");
+    }
+    
+    // Initialize essential fields
+    _phones.assign(sequence.codes(), sequence.codes() + sequence.phone_count());
+    build();
+    
+  }
+  
+  PhoneCode FeatureIndex::operator[](int index) const {
+    
+    return _phones[checked_index(index, size())];
+    
+  }
+  
+  int FeatureIndex::size() const {
+    
+    return _phones.size();
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::vowels() const {
+    
+    return _vowels;
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::consonants() const {
+    
+    return _consonants;
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::phonation(
+    Phone::Phonation phonation) const {
+    
+    return _phonations[checked_value(phonation, phonations)];
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::nasalization(
+    Phone::Nasalization nasalization) const {
+    
+    return _nasalizations[checked_value(nasalization, nasalizations)];
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::roundedness(
+    Vowel::Roundedness roundedness) const {
+    
+    return _roundednesses[checked_value(roundedness, roundednesses)];
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::manner(Consonant::Manner manner) 
+    const {
+    
+    return _manners[checked_value(manner, manners)];
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::place(Consonant::Place place) 
+    const {
+    
+    return _places[checked_value(place, places)];
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::vot(Consonant::VOT vot) const {
+    
+    return _vots[checked_value(vot, vots)];
+    
+  }
+  
+  const FeatureIndex::Bitmap& FeatureIndex::mechanism(
+    Consonant::Mechanism mechanism) const {
+    
+    return _mechanisms[checked_value(mechanism, mechanisms)];
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::place(Consonant::Place first, 
+                                           Consonant::Place last) const {
+    
+    checked_value(first, places);
+    checked_value(last, places);
+    Bitmap result(size());
+    for(int i = first; i <= last; i++) {
+      result |= _places[i];
+    }
+    
+    return result;
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::vot(Consonant::VOT first, 
+                                         Consonant::VOT last) const {
+    
+    checked_value(first, vots);
+    checked_value(last, vots);
+    Bitmap result(size());
+    for(int i = first; i <= last; i++) {
+      result |= _vots[i];
+    }
+    
+    return result;
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::height(float low, float high) const {
+    
+    return range(_heights, heights, low, high, true);
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::backness(float low, float high) const {
+    
+    return range(_backnesses, backnesses, low, high, false);
+    
+  }
+  
+  void FeatureIndex::build() {
+    
+    int size = _phones.size();
+    Bitmap empty(size);
+    _vowels = _consonants = empty;
+    std::fill(_phonations, _phonations + phonations, empty);
+    std::fill(_nasalizations, _nasalizations + nasalizations, empty);
+    std::fill(_roundednesses, _roundednesses + roundednesses, empty);
+    std::fill(_manners, _manners + manners, empty);
+    std::fill(_places, _places + places, empty);
+    std::fill(_vots, _vots + vots, empty);
+    std::fill(_mechanisms, _mechanisms + mechanisms, empty);
+    std::fill(_heights, _heights + heights, empty);
+    std::fill(_backnesses, _backnesses + backnesses, empty);
+    
+    // The features index the bitmaps directly, so only whole phones are kept
+    for(int i = 0; i < size; i++) {
+      const PhoneCode& phone = _phones[i];
+      if(phone.violation() != Phone::no_violation) {
+        LANG_INSTRUMENT_COUNT(Instrumentation::value_error);
+        throw expt::ValueError(expt::literal, 
+                               "Only articulable phones can be indexed.");
+      }
+      _phonations[phone.phonation()].set(i);
+      _nasalizations[phone.nasalization()].set(i);
+      if(phone.is_vowel()) {
+        _vowels.set(i);
+        _roundednesses[phone.roundedness()].set(i);
+        int height = std::min(std::max((int) phone.height(), 0), heights - 1);
+        int backness = std::min(std::max((int) phone.backness(), 0), 
+                                backnesses - 1);
+        _heights[height].set(i);
+        _backnesses[backness].set(i);
+      }
+      else {
+        _consonants.set(i);
+        _manners[phone.manner()].set(i);
+        _places[phone.place()].set(i);
+        _vots[phone.vot()].set(i);
+        _mechanisms[phone.mechanism()].set(i);
+      }
+    }
+    
+  }
+  
+  FeatureIndex::Bitmap FeatureIndex::range(const Bitmap* buckets, 
+                                           int bucket_count, float low, 
+                                           float high, bool height) const {
+    
+    Bitmap result(size());
+    for(int bucket = 0; bucket < bucket_count; bucket++) {
+      
+      // Bucket b holds [b, b + 1), except the top one, which only holds b
+      bool top = bucket == bucket_count - 1;
+      if(bucket > high || (top ? bucket < low : bucket + 1 <= low)) {
+        continue;
+      }
+      if(low <= bucket && (top || bucket + 1 <= high)) {
+        result |= buckets[bucket];
+        continue;
+      }
+      
+      std::vector<int> members;
+      buckets[bucket].indices(members);
+      for(int i = 0; i < (int) members.size(); i++) {
+        const PhoneCode& phone = _phones[members[i]];
+        float value = height ? phone.height() : phone.backness();
+        if(value >= low && value <= high) {
+          result.set(members[i]);
+        }
+      }
+      
+    }
+    
+    return result;
+    
+  }
+
+// SoundChange::Rule
+  
+  SoundChange::Rule::~Rule() {}
+  
+  SoundChange::Rule::Rule() {
+    
+    // Initialize essential fields
+    _kinds = vowel_kind | consonant_kind;
+    _parts = ~0u;
+    _phonations = ~0u;
+    _nasalizations = ~0u;
+    _roundednesses = ~0u;
+    _manners = ~0u;
+    _places = ~0u;
+    _vots = ~0u;
+    _mechanisms = ~0u;
+    _restricted = 0;
+    _heights[0] = 0.0;
+    _heights[1] = 6.0;
+    _backnesses[0] = 0.0;
+    _backnesses[1] = 4.0;
+    
+    _phonation = -1;
+    _nasalization = -1;
+    _roundedness = -1;
+    _manner = -1;
+    _place = -1;
+    _vot = -1;
+    _mechanism = -1;
+    _height_change = 0.0;
+    _backness_change = 0.0;
+    _length_change = 0.0;
+    _vot_change = 0;
+    
+  }
+  
+  void SoundChange::Rule::allow(int feature, uint32_t& set, uint32_t values) {
+    
+    if(!((_restricted >> feature) & 1)) {
+      set = 0;
+      _restricted |= 1u << feature;
+    }
+    
+    set |= values;
+    
+  }
+  
+  void SoundChange::Rule::match_vowels() {
+    
+    _kinds &= vowel_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_consonants() {
+    
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_part(Syllable::Part part) {
+    
+    allow(part_feature, _parts, 1u << part);
+    
+  }
+  
+  void SoundChange::Rule::match_phonation(Phone::Phonation phonation) {
+    
+    allow(phonation_feature, _phonations, 1u << phonation);
+    
+  }
+  
+  void SoundChange::Rule::match_nasalization(
+      Phone::Nasalization nasalization) {
+    
+    allow(nasalization_feature, _nasalizations, 1u << nasalization);
+    
+  }
+  
+  void SoundChange::Rule::match_roundedness(Vowel::Roundedness roundedness) {
+    
+    allow(roundedness_feature, _roundednesses, 1u << roundedness);
+    _kinds &= vowel_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_manner(Consonant::Manner manner) {
+    
+    allow(manner_feature, _manners, 1u << manner);
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_place(Consonant::Place place) {
+    
+    allow(place_feature, _places, 1u << place);
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_vot(Consonant::VOT vot) {
+    
+    allow(vot_feature, _vots, 1u << vot);
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_mechanism(Consonant::Mechanism mechanism) {
+    
+    allow(mechanism_feature, _mechanisms, 1u << mechanism);
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_place(Consonant::Place first, 
+                                      Consonant::Place last) {
+    
+    allow(place_feature, _places, value_range(first, last));
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_vot(Consonant::VOT first, 
+                                    Consonant::VOT last) {
+    
+    allow(vot_feature, _vots, value_range(first, last));
+    _kinds &= consonant_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_height(float low, float high) {
+    
+    _heights[0] = low;
+    _heights[1] = high;
+    _kinds &= vowel_kind;
+    
+  }
+  
+  void SoundChange::Rule::match_backness(float low, float high) {
+    
+    _backnesses[0] = low;
+    _backnesses[1] = high;
+    _kinds &= vowel_kind;
+    
+  }
+  
+  void SoundChange::Rule::set_phonation(Phone::Phonation new_phonation) {
+    
+    _phonation = new_phonation;
+    
+  }
+  
+  void SoundChange::Rule::set_nasalization(
+      Phone::Nasalization new_nasalization) {
+    
+    _nasalization = new_nasalization;
+    
+  }
+  
+  void SoundChange::Rule::set_roundedness(
+      Vowel::Roundedness new_roundedness) {
+    
+    _roundedness = new_roundedness;
+    
+  }
+  
+  void SoundChange::Rule::set_manner(Consonant::Manner new_manner) {
+    
+    _manner = new_manner;
+    
+  }
+  
+  void SoundChange::Rule::set_place(Consonant::Place new_place) {
+    
+    _place = new_place;
+    
+  }
+  
+  void SoundChange::Rule::set_vot(Consonant::VOT new_vot) {
+    
+    _vot = new_vot;
+    
+  }
+  
+  void SoundChange::Rule::set_mechanism(Consonant::Mechanism new_mechanism) {
+    
+    _mechanism = new_mechanism;
+    
+  }
+  
+  void SoundChange::Rule::raise(float val) {
+    
+    _height_change += val;
+    
+  }
+  
+  void SoundChange::Rule::lower(float val) {
+    
+    _height_change -= val;
+    
+  }
+  
+  void SoundChange::Rule::move_back(float val) {
+    
+    _backness_change += val;
+    
+  }
+  
+  void SoundChange::Rule::move_forward(float val) {
+    
+    _backness_change -= val;
+    
+  }
+  
+  void SoundChange::Rule::later_vot(int val) {
+    
+    _vot_change += val;
+    
+  }
+  
+  void SoundChange::Rule::earlier_vot(int val) {
+    
+    _vot_change -= val;
+    
+  }
+  
+  void SoundChange::Rule::lengthen(float val) {
+    
+    _length_change += val;
+    
+  }
+  
+  void SoundChange::Rule::shorten(float val) {
+    
+    _length_change -= val;
+    
+  }
+  
+  bool SoundChange::Rule::matches(const Syllable::Slot& phone, 
+                                  Syllable::Part part) const {
+    
+    // The kinds of phone are mixed unpredictably, so every test is made 
+    // without branching and the tests for the other kind are thrown away
+    uint64_t code = phone.code().code();
+    uint32_t kind = code & kind_mask;
+    uint32_t common = (_kinds >> kind) & (_parts >> part) & 
+      (_phonations >> field(code, phonation_shift, phonation_mask)) & 
+      (_nasalizations >> field(code, nasalization_shift, nasalization_mask));
+    
+    float height = phone.height();
+    float backness = phone.backness();
+    uint32_t vowel = 
+      (_roundednesses >> field(code, roundedness_shift, roundedness_mask)) & 
+      (height >= _heights[0]) & (height <= _heights[1]) & 
+      (backness >= _backnesses[0]) & (backness <= _backnesses[1]);
+    
+    uint32_t consonant = (_manners >> field(code, manner_shift, manner_mask)) &
+      (_places >> field(code, place_shift, place_mask)) & 
+      (_vots >> field(code, vot_shift, vot_mask)) & 
+      (_mechanisms >> field(code, mechanism_shift, mechanism_mask));
+    
+    return common & (kind ? consonant : vowel) & 1;
+    
+  }
+  
+  bool SoundChange::Rule::matches(PhoneCode phone, 
+                                  Syllable::Part part) const {
+    
+    return matches(Syllable::Slot(phone), part);
+    
+  }
+  
+  Phone::Violation SoundChange::Rule::apply(Syllable::Slot& slot) const {
+    
+    PhoneCode phone = slot.code();
+    uint64_t code = phone.code();
+    Phone::Phonation phonation = _phonation < 0 ? phone.phonation() : 
+                                 (Phone::Phonation) _phonation;
+    Phone::Nasalization nasalization = _nasalization < 0 ? 
+                                       phone.nasalization() : 
+                                       (Phone::Nasalization) _nasalization;
+    float length = phone.length() + _length_change;
+    
+    // Check the changed phone before anything is encoded
+    float height = 0;
+    float backness = 0;
+    if(phone.is_vowel()) {
+      height = slot.height() + _height_change;
+      backness = slot.backness() + _backness_change;
+      Vowel::Roundedness roundedness = _roundedness < 0 ? 
+                                       phone.roundedness() : 
+                                       (Vowel::Roundedness) _roundedness;
+      Phone::Violation violation = Vowel::check(height, backness, roundedness, 
+                                                nasalization, 
+                                                phone.is_r_colored(), 
+                                                phonation, length);
+      if(violation != Phone::no_violation) {
+        return violation;
+      }
+      
+      code = with_field(code, roundedness_shift, roundedness_mask, 
+                        roundedness);
+      code = with_field(code, height_shift, height_mask, quantize(height));
+      code = with_field(code, backness_shift, backness_mask, 
+                        quantize(backness));
+    }
+    else {
+      Consonant::Manner manner = _manner < 0 ? phone.manner() : 
+                                 (Consonant::Manner) _manner;
+      Consonant::Place place = _place < 0 ? phone.place() : 
+                               (Consonant::Place) _place;
+      Consonant::Mechanism mechanism = _mechanism < 0 ? phone.mechanism() : 
+                                       (Consonant::Mechanism) _mechanism;
+      
+      // There are no VOTs past either end of the enumeration
+      int vot = (_vot < 0 ? phone.vot() : _vot) + _vot_change;
+      vot = std::max((int) Consonant::completely_voiced, 
+                     std::min((int) Consonant::strongly_aspirated, vot));
+      
+      // A consonant without a secondary articulation keeps none
+      Consonant::Place secondary = phone.secondary_articulation();
+      if(secondary == phone.place()) {
+        secondary = place;
+      }
+      
+      Phone::Violation violation = Consonant::check(manner, place, phonation, 
+                                                    (Consonant::VOT) vot, 
+                                                    nasalization, mechanism, 
+                                                    length);
+      if(violation != Phone::no_violation) {
+        return violation;
+      }
+      
+      code = with_field(code, manner_shift, manner_mask, manner);
+      code = with_field(code, place_shift, place_mask, place);
+      code = with_field(code, secondary_shift, secondary_mask, secondary);
+      code = with_field(code, vot_shift, vot_mask, vot);
+      code = with_field(code, mechanism_shift, mechanism_mask, mechanism);
+    }
+    
+    code = with_field(code, phonation_shift, phonation_mask, phonation);
+    code = with_field(code, nasalization_shift, nasalization_mask, 
+                      nasalization);
+    phone.set_code(with_length(code, length));
+    slot = Syllable::Slot(phone, height, backness);
+    
+    return Phone::no_violation;
+    
+  }
+  
+  Phone::Violation SoundChange::Rule::apply(PhoneCode& phone) const {
+    
+    Syllable::Slot slot(phone);
+    Phone::Violation violation = apply(slot);
+    phone = slot.code();
+    return violation;
+    
+  }
+
+// SoundChange
+  
+  SoundChange::~SoundChange() {}
+  
+  SoundChange::SoundChange() {}
+  
+  SoundChange::SoundChange(std::initializer_list<Rule> rules) {
+    
+    // Initialize essential fields
+    _rules.assign(rules.begin(), rules.end());
+    
+  }
+  
+  const SoundChange::Rule& SoundChange::operator[](int index) const {
+    
+    return _rules[checked_index(index, size())];
+    
+  }
+  
+  int SoundChange::size() const {
+    
+    return _rules.size();
+    
+  }
+  
+  void SoundChange::add(const Rule& rule) {
+    
+    _rules.push_back(rule);
+    
+  }
+  
+  void SoundChange::clear() {
+    
+    _rules.clear();
+    
+  }
+  
+  long long SoundChange::apply(Syllable& syllable, 
+                               std::vector<Rejection>* rejections) const {
+    
+    ChangeCache cache(_rules);
+    PhoneChanger changer = {cache, rejections, 0, 0, 0};
+    syllable.visit_slots(changer);
+    
+    return changer.changed;
+    
+  }
+  
+  long long SoundChange::apply(PhoneticSequence& sequence, 
+                               std::vector<Rejection>* rejections) const {
+    
+    ChangeCache cache(_rules);
+    long long changed = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      PhoneChanger changer = {cache, rejections, i, 0, 0};
+      sequence[i].visit_slots(changer);
+      changed += changer.changed;
+    }
+    
+    return changed;
+    
+  }
+  
+  long long SoundChange::apply(ColumnarSequence& sequence, 
+                               std::vector<Rejection>* rejections) const {
+    
+    // set does not move the columns, so the pointers stay valid
+    const PhoneCode* codes = sequence.codes();
+    const int* offsets = sequence.offsets();
+    const uint16_t* onset_sizes = sequence.onset_sizes();
+    const uint16_t* nucleus_sizes = sequence.nucleus_sizes();
+    
+    ChangeCache cache(_rules);
+    long long changed = 0;
+    for(int i = 0; i < sequence.size(); i++) {
+      int onset_end = offsets[i] + onset_sizes[i];
+      int nucleus_end = onset_end + nucleus_sizes[i];
+      for(int j = offsets[i]; j < offsets[i + 1]; j++) {
+        Syllable::Part part = j < onset_end ? Syllable::onset_part : 
+                              j < nucleus_end ? Syllable::nucleus_part : 
+                              Syllable::coda_part;
+        // A change smaller than the quantization leaves the code as it was
+        Syllable::Slot phone(codes[j]);
+        cache.change(phone, part, i, j - offsets[i], rejections);
+        if(phone.code() != codes[j]) {
+          sequence.set(j, phone.code());
+          changed++;
+        }
+      }
+    }
+    
+    return changed;
+    
+  }
+
+// Instrumentation::Timer
+  
+  Instrumentation::Timer::~Timer() {
+    
+    Instrumentation::record(_event, Instrumentation::now() - _start);
+    
+  }
+  
+  Instrumentation::Timer::Timer(Event event) {
+    
+    // Initialize essential fields
+    _event = event;
+    _start = Instrumentation::now();
+    
+  }
+
+// Instrumentation
+  
+  bool Instrumentation::enabled() {
+
+#ifdef LANG_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+    
+  }
+  
+  void Instrumentation::record(Event event, long long nanoseconds) {
+    
+    EventCounters& counters = thread_counters();
+    increment(counters.counts[event], 1);
+    increment(counters.nanoseconds[event], nanoseconds);
+    
+    EventRegistry& registry = event_registry();
+    TraceHook hook = registry.hook.load(std::memory_order_acquire);
+    if(hook) {
+      hook(event, nanoseconds, registry.data.load(std::memory_order_acquire));
+    }
+    
+  }
+  
+  Instrumentation::Snapshot Instrumentation::snapshot() {
+    
+    EventRegistry& registry = event_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    long long totals[2][event_count];
+    total_counts(registry, totals);
+    
+    Snapshot result;
+    for(int i = 0; i < event_count; i++) {
+      result.counts[i] = totals[0][i] - registry.baseline[0][i];
+      result.nanoseconds[i] = totals[1][i] - registry.baseline[1][i];
+    }
+    
+    return result;
+    
+  }
+  
+  void Instrumentation::reset() {
+    
+    // Counters are only ever written by their own threads, so instead of 
+    // being zeroed, the current totals become the new starting point
+    EventRegistry& registry = event_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    total_counts(registry, registry.baseline);
+    
+  }
+  
+  void Instrumentation::set_trace_hook(TraceHook hook, void* data) {
+    
+    EventRegistry& registry = event_registry();
+    registry.data.store(data, std::memory_order_release);
+    registry.hook.store(hook, std::memory_order_release);
+    
+  }
+  
+  Instrumentation::Event Instrumentation::decode_event(
+    PhoneticEncoding encoding) {
+    
+    return (Event) (x_sampa_decode + encoding);
+    
+  }
+  
+  Instrumentation::Event Instrumentation::encode_event(
+    PhoneticEncoding encoding) {
+    
+    return (Event) (x_sampa_encode + encoding);
+    
+  }
+  
+  long long Instrumentation::now() {
+    
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    
+  }
+
+// EnumNames
+  
+  constexpr const char* EnumNames::phonations[];
+  constexpr const char* EnumNames::nasalizations[];
+  constexpr const char* EnumNames::heights[];
+  constexpr const char* EnumNames::backnesses[];
+  constexpr const char* EnumNames::roundednesses[];
+  constexpr const char* EnumNames::manners[];
+  constexpr const char* EnumNames::places[];
+  constexpr const char* EnumNames::vots[];
+  constexpr const char* EnumNames::mechanisms[];
+
+// Functions
+  
+  Phone::Phonation& lang::operator++(Phone::Phonation& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Phone::Phonation lang::operator++(Phone::Phonation& start_val, int) {
+    
+    Phone::Phonation result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Phone::Phonation& lang::operator--(Phone::Phonation& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Phone::Phonation lang::operator--(Phone::Phonation& start_val, int) {
+    
+    Phone::Phonation result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Phone::Phonation& lang::operator+=(Phone::Phonation& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Phone::Phonation& lang::operator-=(Phone::Phonation& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Phone::Phonation phonation) {
+    
+    return name(phonation);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Phone::Phonation& result) {
+    
+    return find_name<EnumNames::phonations>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Phone::Phonation& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Phone::Nasalization& lang::operator++(Phone::Nasalization& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Phone::Nasalization lang::operator++(Phone::Nasalization& start_val, int) {
+    
+    Phone::Nasalization result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Phone::Nasalization& lang::operator--(Phone::Nasalization& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Phone::Nasalization lang::operator--(Phone::Nasalization& start_val, int) {
+    
+    Phone::Nasalization result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Phone::Nasalization& lang::operator+=(Phone::Nasalization& start_val, 
+                                        int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Phone::Nasalization& lang::operator-=(Phone::Nasalization& start_val, 
+                                        int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Phone::Nasalization nasalization) {
+    
+    return name(nasalization);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Phone::Nasalization& result) {
+    
+    return find_name<EnumNames::nasalizations>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Phone::Nasalization& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Vowel::Height& lang::operator++(Vowel::Height& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Vowel::Height lang::operator++(Vowel::Height& start_val, int) {
+    
+    Vowel::Height result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Vowel::Height& lang::operator--(Vowel::Height& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Vowel::Height lang::operator--(Vowel::Height& start_val, int) {
+    
+    Vowel::Height result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Vowel::Height& lang::operator+=(Vowel::Height& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Vowel::Height& lang::operator-=(Vowel::Height& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Vowel::Height height) {
+    
+    return name(height);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Vowel::Height& result) {
+    
+    return find_name<EnumNames::heights>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Vowel::Height& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Vowel::Backness& lang::operator++(Vowel::Backness& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Vowel::Backness lang::operator++(Vowel::Backness& start_val, int) {
+    
+    Vowel::Backness result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Vowel::Backness& lang::operator--(Vowel::Backness& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Vowel::Backness lang::operator--(Vowel::Backness& start_val, int) {
+    
+    Vowel::Backness result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Vowel::Backness& lang::operator+=(Vowel::Backness& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Vowel::Backness& lang::operator-=(Vowel::Backness& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Vowel::Backness backness) {
+    
+    return name(backness);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Vowel::Backness& result) {
+    
+    return find_name<EnumNames::backnesses>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Vowel::Backness& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Vowel::Roundedness& lang::operator++(Vowel::Roundedness& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Vowel::Roundedness lang::operator++(Vowel::Roundedness& start_val, int) {
+    
+    Vowel::Roundedness result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Vowel::Roundedness& lang::operator--(Vowel::Roundedness& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Vowel::Roundedness lang::operator--(Vowel::Roundedness& start_val, int) {
+    
+    Vowel::Roundedness result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Vowel::Roundedness& lang::operator+=(Vowel::Roundedness& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Vowel::Roundedness& lang::operator-=(Vowel::Roundedness& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Vowel::Roundedness roundedness) {
+    
+    return name(roundedness);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Vowel::Roundedness& result) {
+    
+    return find_name<EnumNames::roundednesses>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Vowel::Roundedness& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Consonant::Manner& lang::operator++(Consonant::Manner& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Consonant::Manner lang::operator++(Consonant::Manner& start_val, int) {
+    
+    Consonant::Manner result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Consonant::Manner& lang::operator--(Consonant::Manner& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Consonant::Manner lang::operator--(Consonant::Manner& start_val, int) {
+    
+    Consonant::Manner result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Consonant::Manner& lang::operator+=(Consonant::Manner& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Consonant::Manner& lang::operator-=(Consonant::Manner& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Consonant::Manner manner) {
+    
+    return name(manner);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Consonant::Manner& result) {
+    
+    return find_name<EnumNames::manners>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Consonant::Manner& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Consonant::Place& lang::operator++(Consonant::Place& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Consonant::Place lang::operator++(Consonant::Place& start_val, int) {
+    
+    Consonant::Place result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Consonant::Place& lang::operator--(Consonant::Place& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Consonant::Place lang::operator--(Consonant::Place& start_val, int) {
+    
+    Consonant::Place result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Consonant::Place& lang::operator+=(Consonant::Place& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Consonant::Place& lang::operator-=(Consonant::Place& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Consonant::Place place) {
+    
+    return name(place);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Consonant::Place& result) {
+    
+    return find_name<EnumNames::places>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Consonant::Place& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Consonant::VOT& lang::operator++(Consonant::VOT& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Consonant::VOT lang::operator++(Consonant::VOT& start_val, int) {
+    
+    Consonant::VOT result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Consonant::VOT& lang::operator--(Consonant::VOT& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Consonant::VOT lang::operator--(Consonant::VOT& start_val, int) {
+    
+    Consonant::VOT result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Consonant::VOT& lang::operator+=(Consonant::VOT& start_val, int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Consonant::VOT& lang::operator-=(Consonant::VOT& start_val, int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Consonant::VOT vot) {
+    
+    return name(vot);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Consonant::VOT& result) {
+    
+    return find_name<EnumNames::vots>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Consonant::VOT& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Consonant::Mechanism& lang::operator++(Consonant::Mechanism& start_val) {
+    
+    return step(start_val, 1);
+    
+  }
+  
+  Consonant::Mechanism lang::operator++(Consonant::Mechanism& start_val, int) {
+    
+    Consonant::Mechanism result = start_val;
+    step(start_val, 1);
+    return result;
+    
+  }
+  
+  Consonant::Mechanism& lang::operator--(Consonant::Mechanism& start_val) {
+    
+    return step(start_val, -1);
+    
+  }
+  
+  Consonant::Mechanism lang::operator--(Consonant::Mechanism& start_val, int) {
+    
+    Consonant::Mechanism result = start_val;
+    step(start_val, -1);
+    return result;
+    
+  }
+  
+  Consonant::Mechanism& lang::operator+=(Consonant::Mechanism& start_val, 
+                                         int val) {
+    
+    return step(start_val, val);
+    
+  }
+  
+  Consonant::Mechanism& lang::operator-=(Consonant::Mechanism& start_val, 
+                                         int val) {
+    
+    return step_back(start_val, val);
+    
+  }
+  
+  std::string lang::string(Consonant::Mechanism mechanism) {
+    
+    return name(mechanism);
+    
+  }
+  
+  bool lang::parse(const char* name, int length, Consonant::Mechanism& result) {
+    
+    return find_name<EnumNames::mechanisms>(name, length, result);
+    
+  }
+  
+  bool lang::parse(const std::string& name, Consonant::Mechanism& result) {
+    
+    return parse(name.data(), name.size(), result);
+    
+  }
+  
+  Syllable::iterator lang::operator+(
+    Syllable::iterator::difference_type offset, 
+    const Syllable::iterator& iterator) {
+    
+    return iterator + offset;
+    
+  }
+  
+  Syllable::const_iterator lang::operator+(
+    Syllable::const_iterator::difference_type offset, 
+    const Syllable::const_iterator& iterator) {
+    
+    return iterator + offset;
+    
+  }
+  
+  void lang::encode(const PhoneticSequence& sequence, std::string& output, 
+                    PhoneticEncoding encoding, char separator) {
+    
+    encode_sequence(sequence, output, encoding, separator);
+    
+  }
+  
+  void lang::encode(const ArenaSequence& sequence, std::string& output, 
+                    PhoneticEncoding encoding, char separator) {
+    
+    encode_sequence(sequence, output, encoding, separator);
+    
+  }
+  
+  void lang::tone_histogram(const PhoneticSequence& sequence, 
+                            long long counts[ToneCode::count]) {
+    
+    count_tones(sequence, counts);
+    
+  }
+  
+  void lang::tone_histogram(const ArenaSequence& sequence, 
+                            long long counts[ToneCode::count]) {
+    
+    count_tones(sequence, counts);
+    
+  }
+  
+  void lang::write_corpus(const PhoneticSequence& sequence, 
+                          std::ostream& output) {
+    
+    write_sequence(sequence, output);
+    
+  }
+  
+  void lang::write_corpus(const ArenaSequence& sequence, 
+                          std::ostream& output) {
+    
+    write_sequence(sequence, output);
+    
+  }
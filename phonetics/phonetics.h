@@ -5,7 +5,11 @@ This header file contains the definitions of the phonetics portion of the lang
 library.
 
 Contents:
-
+  
+  Enumerations:
+    
+    enum PhoneticEncoding
+  
   Classes:
     
     class ImpossibleArticulation
@@ -13,6 +17,7 @@ Contents:
     class Phone
       enum Phonation
       enum Nasalization
+      enum Violation
     class Vowel
       enum Height
       enum Backness
@@ -22,14 +27,72 @@ Contents:
       enum Place
       enum VOT
       enum Mechanism
+      class Table
+    class PhoneCode
     class Tone
+    class ToneCode
+      enum Contour
+    class Arena
     class Syllable
+      enum Part
+      class Span
+    class ThreadPool
+    class Decoder
+    class Transcoder
     typedef PhoneticSequence
+    class ArenaAllocator
+    typedef ArenaSequence
+    class SyllableView
+    class CorpusView
+    class PhoneInventory
+    class ColumnarSequence
+    class PhoneFeatures
+    class Aligner
+      struct Step
+    class SyllableIndex
+    class EncodingCache
+    class Lexicon
+      class Pronunciation
+    class NgramCounter
+    class FeatureIndex
+      class Bitmap
+    class SoundChange
+      class Rule
+      struct Rejection
+    class Instrumentation
+      enum Event
+      struct Snapshot
+      class Timer
+    class EnumNames
+  
+  Specializations:
+    
+    struct std::hash<PhoneCode>
+    struct std::hash<Vowel>
+    struct std::hash<Consonant>
+    struct std::hash<Tone>
+    struct std::hash<ToneCode>
+    struct std::hash<Syllable>
 */
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <unordered_map>
 #include <initializer_list>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <iterator>
 
 #include "expt.h"
 
@@ -38,6 +101,21 @@ Contents:
 
 namespace lang {
   
+  // Enumerations
+  
+  enum PhoneticEncoding {x_sampa      = 0, 
+                         kirschenbaum = 1, 
+                         unicode      = 2};
+    
+    /*
+    This enumeration provides the set of phonetic transcription systems 
+    supported by this library for decoding and encoding syllables.
+      
+      x_sampa:      Extended Speech Assessment Methods Phonetic Alphabet
+      kirschenbaum: Kirschenbaum ASCII-IPA.  This system has no tone marks.
+      unicode:      Standard IPA symbols encoded in UTF-8
+    */
+  
   // Classes
   
   class ImpossibleArticulation : public expt::Exception {
@@ -45,7 +123,9 @@ namespace lang {
     /*
     This exception should be thrown whenever an attempt is made to create a 
     phone that is considered impossible or elsewhere in phonetics when 
-    something that would be impossible to create is created.
+    something that would be impossible to create is created.  The messages 
+    thrown by this library are passed as literals, so throwing one allocates 
+    nothing.
     */
     
     public:
@@ -74,6 +154,27 @@ namespace lang {
                     this exception to be thrown.
         */
       
+      ImpossibleArticulation(const char* message);
+        
+        /*
+        C string constructor
+        
+        Parameters:
+          message: An error message, which is copied into the exception
+        */
+      
+      ImpossibleArticulation(expt::Literal, const char* message);
+        
+        /*
+        Literal constructor
+        
+        The message is not copied, so it must outlive the exception and every 
+        copy of it.
+        
+        Parameters:
+          message: A static error message
+        */
+      
       ImpossibleArticulation(const ImpossibleArticulation& original);
         
         /*
@@ -86,13 +187,125 @@ namespace lang {
       operator expt::Exception();
         
         /*
-        Returns a generic exception with the same message.
+        Returns a generic exception with the same message.  A literal message 
+        is not copied.
         */
       
       operator expt::ValueError();
         
         /*
-        Returns a ValueError with the same message.
+        Returns a ValueError with the same message.  A literal message is not 
+        copied.
+        */
+    
+  };
+  
+  class DecodingFailed : public expt::ValueError {
+    
+    /*
+    This exception should be thrown when a phonetic transcription cannot be 
+    decoded.  It records the byte offset in the transcription at which 
+    decoding failed.  If no message is given, message() formats one from the 
+    offset and what() is "transcription could not be decoded".
+    */
+    
+    protected:
+      
+      long long _position;
+        
+        /*
+        The byte offset in the transcription at which decoding failed, or -1 if
+        it is unknown.  It is wide enough for offsets into streams.
+        */
+    
+    public:
+      
+      ~DecodingFailed();
+        
+        /*
+        Destructor
+        */
+      
+      DecodingFailed();
+        
+        /*
+        Empty constructor
+        
+        This will produce a DecodingFailed with no message and an unknown 
+        position.
+        */
+      
+      DecodingFailed(std::string message);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          message: An error message to provide information about what caused 
+                    this exception to be thrown.
+        */
+      
+      DecodingFailed(const char* message);
+        
+        /*
+        C string constructor
+        
+        Parameters:
+          message: An error message, which is copied into the exception
+        */
+      
+      DecodingFailed(expt::Literal, const char* message);
+        
+        /*
+        Literal constructor
+        
+        The message is not copied, so it must outlive the exception and every 
+        copy of it.
+        
+        Parameters:
+          message: A static error message
+        */
+      
+      DecodingFailed(long long position);
+        
+        /*
+        Position constructor
+        
+        Nothing is allocated.  The message is formatted from the position 
+        when message() is called.
+        
+        Parameters:
+          position: The byte offset in the transcription at which decoding 
+                    failed
+        */
+      
+      DecodingFailed(const DecodingFailed& original);
+        
+        /*
+        Copy constructor
+        
+        Parameters:
+          original: Other DecodingFailed to be copied
+        */
+      
+      DecodingFailed& operator=(const DecodingFailed& other);
+        
+        /*
+        Standard field-wise assignment
+        */
+      
+      std::string message() const;
+        
+        /*
+        Returns the error message.  If the position constructor was used and 
+        no message has been set since, it is formatted from the position.
+        */
+      
+      long long position() const;
+        
+        /*
+        Returns the byte offset in the transcription at which decoding failed, 
+        or -1 if it is unknown.
         */
     
   };
@@ -107,6 +320,8 @@ namespace lang {
     Pure virtual functions that child classes must implement:
     
       virtual std::string description() const
+      virtual Violation violation() const
+      virtual std::size_t hash() const
     */
     
     public:
@@ -138,6 +353,40 @@ namespace lang {
         included in the Phone class so that it can be used by both vowels and 
         voiced consonants.
         */
+      
+      enum Violation {no_violation          = 0, 
+                      height_out_of_range   = 1, 
+                      backness_out_of_range = 2, 
+                      nonpositive_length    = 3, 
+                      closed_glottis_vowel  = 4, 
+                      voiceless_voiced_vot  = 5, 
+                      voiced_glottal_stop   = 6, 
+                      impossible_place      = 7, 
+                      voiced_ejective       = 8, 
+                      oral_nasal            = 9, 
+                      undefined_value       = 10};
+        
+        /*
+        This enumeration lists the rules that an articulation can break.  It 
+        is returned by the validity checks and the non-throwing try_ functions 
+        of Phone, Vowel, and Consonant, which never throw 
+        ImpossibleArticulation.  no_violation is 0 so that a result can be 
+        tested as a bool.
+          
+          height_out_of_range:    A vowel height outside 0.0 to 6.0
+          backness_out_of_range:  A vowel backness outside 0.0 to 4.0
+          nonpositive_length:     A length <= 0
+          closed_glottis_vowel:   A vowel with glottal_closure phonation
+          voiceless_voiced_vot:   Voiceless phonation with a voice-onset time 
+                                  earlier than not_aspirated
+          voiced_glottal_stop:    A glottal stop that is not voiceless
+          impossible_place:       A manner that cannot be articulated at the 
+                                  place given, such as a pharyngeal stop
+          voiced_ejective:        An ejective that is not voiceless
+          oral_nasal:             A nasal consonant that is not nasalized
+          undefined_value:        A field outside its enumeration, which can 
+                                  only come from a cast or a corrupt PhoneCode
+        */
     
     protected:
       
@@ -191,6 +440,18 @@ namespace lang {
         
         Parameters:
           new_nasalization: The new nasalization value
+        
+        Exceptions:
+          ImpossibleArticulation: Thrown if the phone is a nasal consonant and 
+                                  new_nasalization is oral.
+        */
+      
+      Violation try_set_nasalization(Nasalization new_nasalization);
+        
+        /*
+        Like set_nasalization, but returns the rule that the new nasalization 
+        would break instead of throwing.  The phone is only changed if 
+        no_violation is returned.
         */
       
       bool is_nasal() const;
@@ -221,6 +482,14 @@ namespace lang {
                                   phone.
         */
       
+      Violation try_set_phonation(Phonation new_phonation);
+        
+        /*
+        Like set_phonation, but returns the rule that the new phonation would 
+        break instead of throwing.  The phone is only changed if no_violation 
+        is returned.
+        */
+      
       void incr_phonation(int val = 1);
         
         /*
@@ -273,6 +542,14 @@ namespace lang {
           ImpossibleArticulation: Thrown if new_length is <= 0.
         */
       
+      Violation try_set_length(float new_length);
+        
+        /*
+        Like set_length, but returns nonpositive_length instead of throwing if 
+        new_length is <= 0.  The phone is only changed if no_violation is 
+        returned.
+        */
+      
       void lengthen(float val);
         
         /*
@@ -295,6 +572,14 @@ namespace lang {
                                   length of the phone to be <= 0.
         */
       
+      Violation try_shorten(float val);
+        
+        /*
+        Like shorten, but returns nonpositive_length instead of throwing if the
+        length would become <= 0.  The phone is only changed if no_violation 
+        is returned.
+        */
+      
       void double_length();
         
         /*
@@ -313,6 +598,22 @@ namespace lang {
         Returns a string description of the phone which describes all of its 
         defining characteristics.
         */
+      
+      virtual Violation violation() const = 0;
+        
+        /*
+        Returns the first rule that the phone's current fields break, or 
+        no_violation if the phone is articulable.  This is the check that the 
+        throwing constructors and setters and the try_ functions share.
+        */
+      
+      virtual std::size_t hash() const = 0;
+        
+        /*
+        Returns a hash of the phone.  Equal phones have equal hashes, and a 
+        phone hashes the same as its PhoneCode, so the value is the same from 
+        one run of a program to the next.
+        */
     
   };
   
@@ -404,6 +705,12 @@ namespace lang {
         This library classifies all vowels as either r-colored or not r-
         colored.  If this field is true, the vowel is r-colored.
         */
+      
+      static constexpr uint32_t _phonations = 0x3FF & ~(1 << glottal_closure);
+        
+        /*
+        Bit p is set if a vowel can have Phonation p.
+        */
     
     public:
       
@@ -486,6 +793,49 @@ namespace lang {
                                 passed for phonation.
       */
     
+    static constexpr Violation check(float height, float backness, 
+                                     Roundedness roundedness, 
+                                     Nasalization nasalization = oral, 
+                                     bool r_colored = false, 
+                                     Phonation phonation = modal, 
+                                     float length = 1.0);
+      
+      /*
+      Returns the first rule that a vowel with the fields given would break, or
+      no_violation if it could be articulated.  This never throws, so it is the
+      cheap way to test candidate vowels in bulk, and it can be evaluated at 
+      compile time.
+      */
+    
+    static constexpr bool articulable(Phonation phonation);
+      
+      /*
+      Returns whether a vowel can have the phonation given, which is a single 
+      bit test against a compile-time mask.  Every phonation but 
+      glottal_closure is articulable.
+      */
+    
+    static constexpr bool defined(Roundedness roundedness, 
+                                  Nasalization nasalization, 
+                                  Phonation phonation);
+      
+      /*
+      Returns whether every value given is one that its enumeration names.
+      */
+    
+    static Violation try_make(Vowel& result, float height, float backness, 
+                              Roundedness roundedness, 
+                              Nasalization nasalization = oral, 
+                              bool r_colored = false, 
+                              Phonation phonation = modal, float length = 1.0);
+      
+      /*
+      Non-throwing counterpart of the detailed constructor.  If the fields 
+      given pass check, result is set to the new vowel and no_violation is 
+      returned.  Otherwise result is left unchanged and the rule broken is 
+      returned.
+      */
+    
     Vowel(const Vowel& original);
       
       /*
@@ -501,13 +851,13 @@ namespace lang {
       Standard field-wise assignment
       */
     
-    bool operator==(const Vowel& other);
+    bool operator==(const Vowel& other) const;
       
       /*
       Vowels are equal if all of their fields are equal.
       */
     
-    bool operator!=(const Vowel& other);
+    bool operator!=(const Vowel& other) const;
       
       /*
       Vowels are equal if all of their fields are equal.
@@ -520,6 +870,18 @@ namespace lang {
       characteristics using standard IPA terminology.
       */
     
+    Violation violation() const;
+      
+      /*
+      Returns the result of check for the vowel's current fields.
+      */
+    
+    std::size_t hash() const;
+      
+      /*
+      Returns the hash of the vowel's PhoneCode.
+      */
+    
     float height() const;
       
       /*
@@ -543,6 +905,13 @@ namespace lang {
                                 is outside of the range specified above.
       */
     
+    Violation try_set_height(float new_height);
+      
+      /*
+      Like set_height, but returns height_out_of_range instead of throwing.  
+      The vowel is only changed if no_violation is returned.
+      */
+    
     void raise(float val = 1.0);
       
       /*
@@ -557,6 +926,13 @@ namespace lang {
                                 the height to exceed 6.0.
       */
     
+    Violation try_raise(float val = 1.0);
+      
+      /*
+      Like raise, but returns height_out_of_range instead of throwing.  The 
+      vowel is only changed if no_violation is returned.
+      */
+    
     void lower(float val = 1.0);
       
       /*
@@ -571,6 +947,13 @@ namespace lang {
                                 the height of the vowel to be negative.
       */
     
+    Violation try_lower(float val = 1.0);
+      
+      /*
+      Like lower, but returns height_out_of_range instead of throwing.  The 
+      vowel is only changed if no_violation is returned.
+      */
+    
     float backness() const;
       
       /*
@@ -593,6 +976,13 @@ namespace lang {
                                 that exceeds the range specified above.
       */
     
+    Violation try_set_backness(float new_backness);
+      
+      /*
+      Like set_backness, but returns backness_out_of_range instead of 
+      throwing.  The vowel is only changed if no_violation is returned.
+      */
+    
     void move_back(float val = 1.0);
       
       /*
@@ -608,6 +998,13 @@ namespace lang {
                                 the vowel's backness to exceed 4.0.
       */
     
+    Violation try_move_back(float val = 1.0);
+      
+      /*
+      Like move_back, but returns backness_out_of_range instead of throwing.  
+      The vowel is only changed if no_violation is returned.
+      */
+    
     void move_forward(float val = 1.0);
       
       /*
@@ -623,6 +1020,13 @@ namespace lang {
                                 the vowel's backness to be negative.
       */
     
+    Violation try_move_forward(float val = 1.0);
+      
+      /*
+      Like move_forward, but returns backness_out_of_range instead of 
+      throwing.  The vowel is only changed if no_violation is returned.
+      */
+    
     Roundedness roundedness() const;
       
       /*
@@ -767,6 +1171,48 @@ namespace lang {
         */
       
       Mechanism _mechanism;
+      
+      class Table;
+        
+        /*
+        The compile-time validity table used by articulable.  It is defined 
+        after the class because building it needs rules to be complete.
+        */
+      
+      static constexpr uint32_t impossible_places(Manner manner);
+        
+        /*
+        Returns a mask in which bit p is set if manner cannot be articulated at
+        Place p.  These are the shaded cells of the IPA consonant chart.
+        */
+      
+      static constexpr Violation place_rules(Manner manner, Place place, 
+                                             Phonation phonation);
+        
+        /*
+        Applies the rules that depend on the place of articulation and returns
+        the first that is broken, or no_violation.
+        */
+      
+      static constexpr Violation voicing_rules(Manner manner, 
+                                               Phonation phonation, VOT vot, 
+                                               Nasalization nasalization, 
+                                               Mechanism mechanism);
+        
+        /*
+        Applies the rules that do not depend on the place of articulation and 
+        returns the first that is broken, or no_violation.
+        */
+      
+      static constexpr Violation rules(Manner manner, Place place, 
+                                       Phonation phonation, VOT vot, 
+                                       Nasalization nasalization, 
+                                       Mechanism mechanism);
+        
+        /*
+        Applies all of the articulation rules and returns the first that is 
+        broken.  Table is generated from the same rules.
+        */
     
     public:
       
@@ -814,6 +1260,55 @@ namespace lang {
                                   impossible consonant.
         */
       
+      static constexpr Violation check(Manner manner, Place place, 
+                                       Phonation phonation, VOT vot, 
+                                       Nasalization nasalization = oral, 
+                                       Mechanism mechanism = pul_eg, 
+                                       float length = 1.0);
+        
+        /*
+        Returns the first rule that a consonant with the fields given would 
+        break, or no_violation if it could be articulated.  This never throws,
+        so it is the cheap way to test candidate consonants in bulk, and it can
+        be evaluated at compile time.  Articulable consonants are recognized 
+        with one bit test in Table; the rules are only consulted to name the 
+        one that was broken.
+        */
+      
+      static constexpr bool articulable(Manner manner, Place place, 
+                                        Phonation phonation, VOT vot, 
+                                        Nasalization nasalization = oral, 
+                                        Mechanism mechanism = pul_eg);
+        
+        /*
+        Returns whether a consonant with the fields given can be articulated, 
+        apart from its length.  This is a single bit test against Table, after 
+        checking that the fields are defined.
+        */
+      
+      static constexpr bool defined(Manner manner, Place place, 
+                                    Phonation phonation, VOT vot, 
+                                    Nasalization nasalization, 
+                                    Mechanism mechanism);
+        
+        /*
+        Returns whether every value given is one that its enumeration names, 
+        and so can be used to index Table.
+        */
+      
+      static Violation try_make(Consonant& result, Manner manner, Place place, 
+                                Phonation phonation, VOT vot, 
+                                Nasalization nasalization = oral, 
+                                Mechanism mechanism = pul_eg, 
+                                float length = 1.0);
+        
+        /*
+        Non-throwing counterpart of the standard constructor.  If the fields 
+        given pass check, result is set to the new consonant and no_violation 
+        is returned.  Otherwise result is left unchanged and the rule broken is
+        returned.
+        */
+      
       Consonant(const Consonant& original);
         
         /*
@@ -848,6 +1343,18 @@ namespace lang {
         its defining features.
         */
       
+      Violation violation() const;
+        
+        /*
+        Returns the result of check for the consonant's current fields.
+        */
+      
+      std::size_t hash() const;
+        
+        /*
+        Returns the hash of the consonant's PhoneCode.
+        */
+      
       Manner manner() const;
       
         /*
@@ -868,6 +1375,14 @@ namespace lang {
                                   consonant.
         */
       
+      Violation try_set_manner(Manner new_manner);
+        
+        /*
+        Like set_manner, but returns the rule that the new manner would break 
+        instead of throwing.  The consonant is only changed if no_violation is
+        returned.
+        */
+      
       void incr_manner(int val = 1);
         
         /*
@@ -917,6 +1432,14 @@ namespace lang {
                                   would result in an impossible consonant.
         */
       
+      Violation try_set_place(Place new_place);
+        
+        /*
+        Like set_place, but returns the rule that the new place would break 
+        instead of throwing.  The consonant is only changed if no_violation is
+        returned.
+        */
+      
       void incr_place(int val = 1);
         
         /*
@@ -1033,6 +1556,14 @@ namespace lang {
           ImpossibleArticulation: Thrown if the new voice-onset time given 
                                   would result in an impossible consonant.
         */
+      
+      Violation try_set_vot(VOT new_vot);
+        
+        /*
+        Like set_vot, but returns the rule that the new voice-onset time would
+        break instead of throwing.  The consonant is only changed if 
+        no_violation is returned.
+        */
         
       void later_vot(int val = 1);
         
@@ -1081,6 +1612,14 @@ namespace lang {
                                   would result in an impossible consonant.
         */
       
+      Violation try_set_mechanism(Mechanism new_mechanism);
+        
+        /*
+        Like set_mechanism, but returns the rule that the new mechanism would 
+        break instead of throwing.  The consonant is only changed if 
+        no_violation is returned.
+        */
+      
       void incr_mechanism(int val = 1);
         
         /*
@@ -1103,34 +1642,300 @@ namespace lang {
     
   };
   
-  class Tone {
+  class PhoneCode {
     
     /*
-    This class represents one tone pattern to be applied to a syllable.  It is 
-    essentially a wrapper around an array of three integers.  These integers 
-    must be between -2 and 2, with negative numbers representing low pitches 
-    and positive numbers representing high pitches.
+    This class is a compact encoding of a single vowel or consonant packed into
+    one 64-bit integer.  It is meant for situations where very large numbers of
+    phones need to be stored, such as whole corpora, and the full Vowel and 
+    Consonant classes would take up too much memory.  Because the whole phone 
+    is one integer, comparing two PhoneCodes is a single integer comparison.
+    
+    PhoneCode deliberately has no user-declared destructor or copy operations 
+    so that it stays trivially copyable and can be copied with memcpy.
+    
+    Layout of the code, starting from the least significant bit:
+      
+      bit 0:        kind (0 for vowels, 1 for consonants)
+      bits 1-4:     phonation
+      bits 5-6:     nasalization
+      bits 7-31:    vowel or consonant features (see below)
+      bits 32-63:   length, stored as the bit pattern of a 32-bit float
+    
+    Vowel features:
+      
+      bits 7-8:     roundedness
+      bit 9:        r-colored
+      bits 10-20:   height, in steps of 1/256
+      bits 21-31:   backness, in steps of 1/256
+    
+    Consonant features:
+      
+      bits 7-10:    manner
+      bits 11-15:   place
+      bits 16-20:   secondary articulation
+      bits 21-23:   voice-onset time
+      bits 24-25:   mechanism
+    
+    Consonants always round-trip exactly.  Length is stored exactly.  Vowel 
+    height and backness are quantized to the nearest 1/256, so any vowel whose 
+    height and backness are multiples of 1/256 (which includes every value in 
+    the Height and Backness enumerations as well as halves and quarters) 
+    round-trips exactly.
     */
     
     protected:
-        
-      int _array[3];
+      
+      uint64_t _code;
         
         /*
-        This array represents a chronological pattern of pitch across a 
-        syllable.  Each integer in the array must be between -2 and 2, with 
-        negative numbers representing low pitches and positive numbers 
-        representing high pitches.  Any function that modifies this field 
-        should ensure that no integer value exceeds this valid range.
+        The packed representation described above
         */
     
     public:
       
-      class iterator {
+      PhoneCode();
         
-        protected:
-          
-          Tone* _tone;
+        /*
+        Empty constructor
+        
+        The default PhoneCode is the code of the default Vowel, a Schwa.
+        */
+      
+      PhoneCode(const Vowel& vowel);
+        
+        /*
+        Vowel constructor
+        
+        Parameters:
+          vowel: The vowel to be encoded
+        */
+      
+      PhoneCode(const Consonant& consonant);
+        
+        /*
+        Consonant constructor
+        
+        Parameters:
+          consonant: The consonant to be encoded
+        */
+      
+      PhoneCode(const Phone& phone);
+        
+        /*
+        Phone constructor
+        
+        Parameters:
+          phone: The phone to be encoded.  Must be a Vowel or a Consonant.
+        
+        Exceptions:
+          expt::ValueError: Thrown if phone is neither a Vowel nor a Consonant.
+        */
+      
+      bool operator==(const PhoneCode& other) const;
+        
+        /*
+        PhoneCodes are equal if their codes are equal.
+        */
+      
+      bool operator!=(const PhoneCode& other) const;
+        
+        /*
+        PhoneCodes are equal if their codes are equal.
+        */
+      
+      bool operator<(const PhoneCode& other) const;
+        
+        /*
+        Compares the raw codes.  This gives an arbitrary but consistent order 
+        that can be used for sorting.
+        */
+      
+      std::size_t hash() const;
+        
+        /*
+        Returns a hash of the code, with its bits mixed so that it can be used 
+        directly by hash tables.
+        */
+      
+      std::string description() const;
+        
+        /*
+        Returns the same description as the phone's own description().  Each 
+        thread keeps a small cache of the descriptions it built most recently, 
+        so describing the same phones over and over does not rebuild them.
+        */
+      
+      uint64_t code() const;
+        
+        /*
+        Returns the raw 64-bit code.
+        */
+      
+      void set_code(uint64_t new_code);
+        
+        /*
+        Replaces the raw 64-bit code.  No validation is done, so this should 
+        only be passed values previously returned by code().
+        
+        Parameters:
+          new_code: The new raw code
+        */
+      
+      bool is_vowel() const;
+        
+        /*
+        Returns true if this is the code of a vowel.
+        */
+      
+      bool is_consonant() const;
+        
+        /*
+        Returns true if this is the code of a consonant.
+        */
+      
+      Vowel vowel() const;
+        
+        /*
+        Decodes the PhoneCode into a Vowel.
+        
+        Exceptions:
+          expt::ValueError: Thrown if this is not the code of a vowel.
+          ImpossibleArticulation: Thrown if the encoded vowel is not 
+                                  articulable.  See violation.
+        */
+      
+      Consonant consonant() const;
+        
+        /*
+        Decodes the PhoneCode into a Consonant.
+        
+        Exceptions:
+          expt::ValueError: Thrown if this is not the code of a consonant.
+          ImpossibleArticulation: Thrown if the encoded consonant is not 
+                                  articulable.  See violation.
+        */
+      
+      Phone::Violation violation() const;
+        
+        /*
+        Returns the first rule that the encoded phone breaks, or 
+        Phone::no_violation, using the same check as Vowel and Consonant 
+        without decoding the phone.
+        */
+      
+      Phone::Phonation phonation() const;
+        
+        /*
+        Returns the phonation of the encoded phone.
+        */
+      
+      Phone::Nasalization nasalization() const;
+        
+        /*
+        Returns the nasalization of the encoded phone.
+        */
+      
+      float length() const;
+        
+        /*
+        Returns the length of the encoded phone.
+        */
+      
+      float height() const;
+        
+        /*
+        Returns the quantized height of the encoded vowel.  Only meaningful if 
+        is_vowel() is true.
+        */
+      
+      float backness() const;
+        
+        /*
+        Returns the quantized backness of the encoded vowel.  Only meaningful 
+        if is_vowel() is true.
+        */
+      
+      Vowel::Roundedness roundedness() const;
+        
+        /*
+        Returns the roundedness of the encoded vowel.  Only meaningful if 
+        is_vowel() is true.
+        */
+      
+      bool is_r_colored() const;
+        
+        /*
+        Returns whether the encoded vowel is r-colored.  Only meaningful if 
+        is_vowel() is true.
+        */
+      
+      Consonant::Manner manner() const;
+        
+        /*
+        Returns the manner of articulation of the encoded consonant.  Only 
+        meaningful if is_consonant() is true.
+        */
+      
+      Consonant::Place place() const;
+        
+        /*
+        Returns the place of articulation of the encoded consonant.  Only 
+        meaningful if is_consonant() is true.
+        */
+      
+      Consonant::Place secondary_articulation() const;
+        
+        /*
+        Returns the secondary place of articulation of the encoded consonant, 
+        which is equal to place() if there is no secondary articulation.  Only 
+        meaningful if is_consonant() is true.
+        */
+      
+      Consonant::VOT vot() const;
+        
+        /*
+        Returns the voice-onset time of the encoded consonant.  Only 
+        meaningful if is_consonant() is true.
+        */
+      
+      Consonant::Mechanism mechanism() const;
+        
+        /*
+        Returns the airstream mechanism of the encoded consonant.  Only 
+        meaningful if is_consonant() is true.
+        */
+    
+  };
+  
+  class Tone {
+    
+    /*
+    This class represents one tone pattern to be applied to a syllable.  It is 
+    essentially a wrapper around an array of three integers.  These integers 
+    must be between -2 and 2, with negative numbers representing low pitches 
+    and positive numbers representing high pitches.
+    */
+    
+    protected:
+        
+      int _array[3];
+        
+        /*
+        This array represents a chronological pattern of pitch across a 
+        syllable.  Each integer in the array must be between -2 and 2, with 
+        negative numbers representing low pitches and positive numbers 
+        representing high pitches.  Any function that modifies this field 
+        should ensure that no integer value exceeds this valid range.
+        */
+    
+    public:
+      
+      class iterator {
+        
+        protected:
+          
+          Tone* _tone;
             
             /*
             The Tone through which this iterator is iterating
@@ -1186,11 +1991,11 @@ namespace lang {
           
           iterator& operator++();
             
-          iterator& operator++(int);
+          iterator operator++(int);
           
           iterator& operator--();
           
-          iterator& operator--(int);
+          iterator operator--(int);
           
           bool operator==(const iterator& other) const;
             
@@ -1376,11 +2181,11 @@ namespace lang {
           
           const_iterator& operator++();
             
-          const_iterator& operator++(int);
+          const_iterator operator++(int);
           
           const_iterator& operator--();
           
-          const_iterator& operator--(int);
+          const_iterator operator--(int);
           
           bool operator==(const const_iterator& other) const;
             
@@ -1585,11 +2390,11 @@ namespace lang {
         defined order.
         */
       
-      Tone& operator++(int);
+      Tone operator++(int);
         
         /*
         Iterates the Tone through the entire set of possible tones in a pre-
-        defined order.
+        defined order, and returns the Tone as it was before.
         */
       
       Tone& operator--();
@@ -1599,11 +2404,11 @@ namespace lang {
         defined order.
         */
       
-      Tone& operator--(int);
+      Tone operator--(int);
         
         /*
         Iterates the Tone through the entire set of possible tones in a pre-
-        defined order.
+        defined order, and returns the Tone as it was before.
         */
       
       bool operator==(const Tone& other) const;
@@ -1618,6 +2423,12 @@ namespace lang {
         Tones are equal if all three integer values are equal.
         */
       
+      std::size_t hash() const;
+        
+        /*
+        Returns a hash of the three integer values.
+        */
+      
       int& operator[](int index);
         
         /*
@@ -1642,10 +2453,13 @@ namespace lang {
           expt::IndexError: Thrown if the bounds check fails.
         */
       
-      operator int();
+      int& unchecked(int index);
+      
+      const int& unchecked(int index) const;
         
         /*
-        Returns the internal array.
+        The fast counterpart of operator[].  index must be from 0 to 2.  Not 
+        bounds checked, and negative indices are not allowed.
         */
       
       iterator begin();
@@ -1656,7 +2470,7 @@ namespace lang {
       
       const_iterator end() const;
       
-      int array() const;
+      std::array<int, 3> array() const;
         
         /*
         Returns a copy of the internal array of integers.
@@ -1664,1213 +2478,7428 @@ namespace lang {
     
   };
   
-  class Syllable {
+  class ToneCode {
     
     /*
-    This class represents a phonetic syllable.
+    This class is a compact encoding of a Tone packed into one byte.  There 
+    are only 125 tone patterns, so each is given a number from 0 to 124, and 
+    everything else about it (its levels, its contour, and its place in the 
+    order used by ++ and --) is looked up in tables that are built once, on 
+    first use.  It is meant for storing the tones of whole corpora and for 
+    tone statistics, where three ints and a bounds-checked iterator per tone 
+    cost too much.
+    
+    ToneCode deliberately has no user-declared destructor or copy operations 
+    so that it stays trivially copyable and can be copied with memcpy.
+    
+    The code of the levels {a, b, c} is 25 * (a + 2) + 5 * (b + 2) + (c + 2), 
+    so comparing two codes compares the tones level by level.
+    
+    ++ and -- step through every tone in a pre-defined order: by contour in 
+    the order of the Contour enumeration, then by code within each contour.  
+    Tone's own ++ and -- use the same order.
     */
     
+    public:
+      
+      static const int count = 125;
+        
+        /*
+        The number of distinct codes, which run from 0 to count - 1
+        */
+      
+      enum Contour {level_tone   = 0, 
+                    rising_tone  = 1, 
+                    falling_tone = 2, 
+                    peaking_tone = 3, 
+                    dipping_tone = 4};
+        
+        /*
+        This enumeration represents the overall shape of a tone.  Level tones 
+        stay at one pitch.  Rising and falling tones move in one direction, 
+        possibly with a level stretch.  Peaking tones rise and then fall, and 
+        dipping tones fall and then rise.
+        */
+    
     protected:
       
-      std::vector<Phone*> _onset;
+      uint8_t _code;
+        
+        /*
+        The code described above, from 0 to count - 1
+        */
+    
+    public:
+      
+      ToneCode();
+        
+        /*
+        Empty constructor
+        
+        The default ToneCode is the code of the default Tone, {0, 0, 0}.
+        */
+      
+      ToneCode(const Tone& tone);
+        
+        /*
+        Tone constructor
+        
+        Parameters:
+          tone: The tone to be encoded
+        
+        Exceptions:
+          ImpossibleArticulation: Thrown if any level of tone is < -2 or > 2.
+        */
+      
+      ToneCode(int tone1, int tone2, int tone3);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          The three parameters are the levels of the tone in chronological 
+          order, as for Tone.
+        
+        Exceptions:
+          ImpossibleArticulation: Thrown if any argument is < -2 or > 2.
+        */
       
-      std::vector<Phone*> _nucleus;
+      ToneCode& operator++();
       
-      std::vector<Phone*> _coda;
+      ToneCode operator++(int);
       
-      Tone _tone;
+      ToneCode& operator--();
       
-      std::vector<Vowel> _vowels;
+      ToneCode operator--(int);
         
         /*
-        This vector contains all of the vowels used in the syllable so that 
-        they can be pointed to from the onset, nucleus, and coda vectors.
+        Iterate through every tone in the pre-defined order described above.  
+        Will go around the horn.
         */
       
-      std::vector<Consonant> _consonants;
+      bool operator==(const ToneCode& other) const;
         
         /*
-        This vector contains all of the consonants used in the syllable so that
-        they can be pointed to from the onset, nucleus, and coda vectors.
+        ToneCodes are equal if their codes are equal.
         */
-    
-    public:
       
-      class iterator {
+      bool operator!=(const ToneCode& other) const;
         
-        protected:
-          
-          Syllable* _syllable;
-            
-            /*
-            The Syllable through which this iterator is iterating
-            */
-          
-          int _position;
-            
-            /*
-            The iterator's position in the Syllable, defined as an index as if 
-            the entire Syllable were one vector.  
-            
-            Any function that moves the iterator should be bounds checked to 
-            ensure that this value is always a valid index.
-            */
+        /*
+        ToneCodes are equal if their codes are equal.
+        */
+      
+      bool operator<(const ToneCode& other) const;
         
-        public:
-          
-          ~iterator();
-            
-            /*
-            Destructor
-            */
-          
-          iterator(Syllable& syllable, int position = 0);
-            
-            /*
-            Standard constructor
-            
-            Parameters:
-              syllable: The Syllable through which this iterator is iterating
-              position: The index in the Syllable where this iterator will 
-                        start.  Negative indices are allowed.  Bounds checked.
-            
-            Exceptions:
-              expt::IndexError: Thrown if a value is passed for position that 
-                                is out of bounds.
-            */
-          
-          iterator(const iterator& original);
-            
-            /*
-            Copy constructor
-            
-            Parameters:
-              original: Other iterator to be copied
-            */
+        /*
+        Compares the codes, which orders tones by their first level, then 
+        their second, then their third.
+        */
+      
+      std::size_t hash() const;
+        
+        /*
+        Returns a hash of the code, with its bits mixed so that it can be used 
+        directly by hash tables.
+        */
+      
+      uint8_t code() const;
+        
+        /*
+        Returns the code, from 0 to count - 1.
+        */
+      
+      void set_code(uint8_t new_code);
+        
+        /*
+        Replaces the code.  No validation is done, so new_code must be less 
+        than count.
+        
+        Parameters:
+          new_code: The new code
+        */
+      
+      Tone tone() const;
+        
+        /*
+        Decodes the ToneCode into a Tone.
+        */
+      
+      int level(int index) const;
+        
+        /*
+        Returns the level at the given index.  Not bounds checked: index must 
+        be 0, 1, or 2.
+        */
+      
+      const int8_t* begin() const;
+      
+      const int8_t* end() const;
+        
+        /*
+        Return pointers to the three levels in the shared table, for iteration 
+        without bounds checks.  The pointers stay valid for the whole program.
+        */
+      
+      Contour contour() const;
+        
+        /*
+        Returns the overall shape of the tone.
+        */
+      
+      int rank() const;
+        
+        /*
+        Returns the position of the tone in the order used by ++ and --, from 
+        0 to count - 1.
+        */
+    
+  };
+  
+  class Arena {
+    
+    /*
+    This class is a monotonic memory arena.  Memory is handed out by bumping a 
+    pointer through large blocks, individual allocations are never freed, and 
+    everything is given back at once by release() or the destructor.  
+    Syllables and ArenaSequences built on one arena therefore cost almost 
+    nothing to allocate and nothing to free, which suits work whose results 
+    all die together, such as one request or one document.
+    
+    An Arena is not thread-safe.  Anything allocated from it must not be used 
+    after it is released.
+    */
+    
+    public:
+      
+      static const std::size_t default_block_size = 64 * 1024;
+        
+        /*
+        The default number of bytes that the arena requests from the heap at a 
+        time
+        */
+    
+    protected:
+      
+      std::size_t _block_size;
+      
+      std::vector<void*> _blocks;
+        
+        /*
+        Every block of _block_size bytes obtained from the heap, in order
+        */
+      
+      std::size_t _used;
+        
+        /*
+        The number of blocks in _blocks that have been handed out from since 
+        the last reset.  Allocations are carved from the last of them.
+        */
+      
+      std::vector<void*> _large;
+        
+        /*
+        The blocks made for allocations larger than half of _block_size
+        */
+      
+      char* _next;
+      
+      char* _end;
+        
+        /*
+        The unused part of the current block
+        */
+      
+      std::size_t _allocated;
+        
+        /*
+        The total number of bytes handed out since the last release or reset
+        */
+      
+      std::size_t _reserved;
+        
+        /*
+        The total size of the blocks in _blocks and _large
+        */
+    
+    public:
+      
+      ~Arena();
+        
+        /*
+        Destructor
+        
+        Releases all of the arena's memory.
+        */
+      
+      Arena(std::size_t block_size = default_block_size);
+        
+        /*
+        Standard constructor
+        
+        No memory is requested until the first allocation.
+        
+        Parameters:
+          block_size: The number of bytes requested from the heap at a time.  
+                      Allocations larger than half of this get a block of 
+                      their own.
+        
+        Exceptions:
+          expt::ValueError: Thrown if block_size is 0.
+        */
+      
+      Arena(const Arena& original) = delete;
+      
+      Arena& operator=(const Arena& other) = delete;
+        
+        /*
+        Arenas cannot be copied, because what they have handed out cannot 
+        move.
+        */
+      
+      void* allocate(std::size_t size, 
+                     std::size_t alignment = alignof(std::max_align_t));
+        
+        /*
+        Returns size bytes of memory aligned to alignment, which must be a 
+        power of two.  Alignments larger than alignof(std::max_align_t) are 
+        met by padding, which can cost up to alignment - 1 bytes.  The memory 
+        is valid until the arena is released.
+        
+        Exceptions:
+          expt::ValueError: Thrown if alignment is not a power of two.
+          std::bad_alloc:   Thrown if the heap is exhausted.
+        */
+      
+      void release();
+        
+        /*
+        Gives all of the arena's memory back to the heap at once.  Objects 
+        still living in the arena are not destroyed; that is only safe for 
+        objects that own nothing outside the arena.  A Syllable may, since its 
+        materialized phones are always on the heap, so Syllables and 
+        ArenaSequences are destroyed before their arena is released.
+        */
+      
+      void reset();
+        
+        /*
+        Like release, except that the arena keeps its regular blocks and hands
+        them out again, so that an arena reused for one job after another 
+        stops going to the heap at all.  Only the blocks made for large 
+        allocations are given back.
+        */
+      
+      std::size_t allocated() const;
+        
+        /*
+        Returns the number of bytes handed out since the last release or 
+        reset.
+        */
+      
+      std::size_t reserved() const;
+        
+        /*
+        Returns the number of bytes currently obtained from the heap.
+        */
+    
+  };
+  
+  class Syllable {
+    
+    /*
+    This class represents a phonetic syllable.
+    
+    All of the phones in a syllable are stored in order in one contiguous 
+    array of Slots, with the onset, nucleus, and coda expressed as ranges of 
+    indices in that array.  A Slot is a PhoneCode and the exact height and 
+    backness of a vowel, sixteen bytes in all, so up to inline_capacity 
+    phones are stored inside the Syllable itself, typical syllables never 
+    allocate, and copying one copies a few words.
+    
+    The accessors that return a Phone by reference, such as operator[], 
+    phones(), and the non-const iterators and Views, need real Vowel and 
+    Consonant objects.  The first phone reached through one of them 
+    materializes every phone into a separate array on the heap, which then 
+    lasts until phones are added or removed.  Getting an iterator or a View 
+    reaches no phone, so it does not materialize them, and the const 
+    iterators and Views never do, since they yield phones by value from the 
+    Slots.  Once a phone has been reached through a non-const accessor, the 
+    materialized phones are the syllable's phones, since they may have been 
+    changed in place, and they are packed back into the Slots when the array 
+    is released.  Reading through the const accessors leaves the Slots the 
+    syllable's phones.  Materializing from a const syllable is safe to do 
+    from several threads at once.
+    
+    Longer syllables store their phones on the heap, or in an Arena if one is 
+    given to the constructor.  A syllable's arena never changes.  Copies are 
+    made on the heap unless another arena is given, and a syllable that is 
+    moved from takes the arena with it.
+    
+    Every syllable also carries a stamp (see stamp()) that changes whenever 
+    it may have changed, so that caches such as EncodingCache can tell 
+    whether a syllable is still the one they saw without comparing phones.
+    */
+    
+    public:
+      
+      class Slot {
+        
+        /*
+        One phone stored in a Syllable, as its PhoneCode.  A PhoneCode 
+        quantizes the height and backness of a vowel, so the Slot keeps them 
+        exactly beside it, and a phone is always read back from a Slot as it 
+        was stored.  A Slot is trivially copyable, so the phones of a syllable 
+        are copied and moved as raw memory, and it says which kind of phone it 
+        holds without a virtual call.
+        */
+        
+        protected:
           
-          iterator& operator=(const iterator& other);
+          PhoneCode _code;
             
             /*
-            Standard field-wise assignment
+            The packed phone
             */
           
-          iterator& operator++();
-            
-          iterator& operator++(int);
-          
-          iterator& operator--();
+          float _height;
           
-          iterator& operator--(int);
-          
-          bool operator==(const iterator& other) const;
+          float _backness;
             
             /*
-            Iterators are equal that are at the same position in the same 
-            Syllable.
+            The exact height and backness of a vowel, or 0 for a consonant
             */
+        
+        public:
           
-          bool operator!=(const iterator& other) const;
+          Slot(PhoneCode code);
             
             /*
-            Iterators are equal that are at the same position in the same
-            Syllable.
-            */
-          
-          bool operator>(const iterator& other) const;
+            Code constructor
             
-            /*
-            Compares the positions of the two iterators.
+            Parameters:
+              code: The code of the phone to be stored
             */
           
-          bool operator>(int position) const;
+          Slot(PhoneCode code, float height, float backness);
             
             /*
-            Compares the position of this iterator to an integer position.
+            Exact constructor
+            
+            Parameters:
+              code:     The code of the phone to be stored
+              height:   The exact height of the vowel, which code holds 
+                        quantized.  Ignored if code is a consonant's.
+              backness: The exact backness of the vowel, which code holds 
+                        quantized.  Ignored if code is a consonant's.
             */
           
-          bool operator<(const iterator& other) const;
+          Slot(const Vowel& vowel);
             
             /*
-            Compares the positions of the two iterators.
+            Vowel constructor
+            
+            Parameters:
+              vowel: The vowel to be stored
             */
           
-          bool operator<(int position) const;
+          Slot(const Consonant& consonant);
             
             /*
-            Compares the position of this iterator to an integer position.
+            Consonant constructor
+            
+            Parameters:
+              consonant: The consonant to be stored
             */
           
-          bool operator>=(const iterator& other) const;
+          Slot(const Phone& phone);
             
             /*
-            Compares the positions of the two iterators.
+            Phone constructor
+            
+            Parameters:
+              phone: The phone to be stored.  Must be a Vowel or a Consonant.
+            
+            Exceptions:
+              expt::ValueError: Thrown if phone is neither a Vowel nor a 
+                                Consonant.
             */
           
-          bool operator>=(int position) const;
+          bool operator==(const Slot& other) const;
             
             /*
-            Compares the position of this iterator to an integer position.
+            Slots are equal if they hold equal phones.
             */
           
-          bool operator<=(const iterator& other) const;
+          bool operator!=(const Slot& other) const;
             
             /*
-            Compares the positions of the two iterators.
+            Slots are equal if they hold equal phones.
             */
           
-          bool operator<=(int position) const;
+          bool is_vowel() const;
             
             /*
-            Compares the position of this iterator to an integer position.
+            Returns true if this Slot holds a vowel.
             */
           
-          iterator& operator+=(int val);
-          
-          iterator& operator-=(int val);
-          
-          Phone* operator[](int index);
+          bool is_consonant() const;
             
             /*
-            Allows the iterator to be de-referenced with an offset.  Returns 
-            the Phone* index places away from the iterator's current position.
+            Returns true if this Slot holds a consonant.
             */
           
-          Phone* operator*();
+          PhoneCode code() const;
             
             /*
-            Returns the Phone* at the iterator's current position in the 
-            Syllable.
+            Returns the code of the phone held in this Slot, in which the 
+            height and backness of a vowel are quantized.
             */
           
-          Phone* operator->();
+          float height() const;
           
-          Syllable& syllable() const;
+          float backness() const;
             
             /*
-            Returns a reference to the Syllable this iterator is operating on.
+            Return the exact height and backness of the vowel held in this 
+            Slot, or 0 if it holds a consonant.
             */
           
-          void set_syllable(Syllable& new_syllable);
+          Vowel vowel() const;
             
             /*
-            Moves this iterator to a different Syllable.  Position is 
-            unchanged.
+            Decodes the vowel held in this Slot.
             
-            Parameters:
-              new_syllable: New syllable
+            Exceptions:
+              expt::ValueError: Thrown if this Slot holds a consonant.
             */
           
-          int position() const;
+          Consonant consonant() const;
             
             /*
-            Returns the current position of the iterator.
+            Decodes the consonant held in this Slot.
+            
+            Exceptions:
+              expt::ValueError: Thrown if this Slot holds a vowel.
             */
+        
+      };
+      
+      template <class Value>
+      class Arrow {
+        
+        /*
+        What operator-> returns for the iterators that yield phones by value 
+        rather than by reference.  It holds the value for as long as the 
+        expression that asked for it.
+        */
+        
+        protected:
           
-          int inverse_position() const;
+          Value _value;
             
             /*
-            Returns the position of the iterator as a negative int measured 
-            from the end of the Syllable.
+            The value that the iterator yielded
             */
+        
+        public:
           
-          void set_position(int position);
+          explicit Arrow(const Value& value);
             
             /*
-            Moves the iterator to the position give.
+            Standard constructor
             
             Parameters:
-              position: The new position as an index in the Syllable.  Negative
-                        indices allowed.  Bounds checked.
+              value: The value that the iterator yielded
+            */
+          
+          const Value* operator->() const;
             
-            Exceptions:
-              expt::IndexError: Thrown if the bounds check fails.
+            /*
+            Returns a pointer to the value.
             */
-      
+        
       };
+    
+    protected:
       
-      class const_iterator {
+      class Cell {
         
-        protected:
+        /*
+        One phone materialized from a Slot, for the accessors that return 
+        phones by reference.  A Cell holds either a Vowel or a Consonant 
+        directly rather than a pointer to one.
+        */
+        
+        public:
           
-          const Syllable* _syllable;
+          bool _is_vowel;
             
             /*
-            The Syllable through which this iterator is iterating
+            Which member of the union below is in use
             */
           
-          int _position;
-            
-            /*
-            The iterator's position in the Syllable, defined as an index as if 
-            the entire Syllable were one vector.  
-            
-            Any function that moves the iterator should be bounds checked to 
-            ensure that this value is always a valid index.
-            */
-        
-        public:
+          union {
+            Vowel _vowel;
+            Consonant _consonant;
+          };
           
-          ~const_iterator();
+          ~Cell();
             
             /*
             Destructor
             */
           
-          const_iterator(const Syllable& syllable, int position = 0);
+          Cell(const Slot& slot);
             
             /*
             Standard constructor
             
             Parameters:
-              syllable: The Syllable through which this iterator is iterating
-              position: The index in the Syllable where this iterator will 
-                        start.  Negative indices are allowed.  Bounds checked.
+              slot: The Slot holding the phone to be materialized
+            */
+          
+          Cell(const Cell& original) = delete;
+          
+          Cell& operator=(const Cell& other) = delete;
             
-            Exceptions:
-              expt::IndexError: Thrown if a value is passed for position that 
-                                is out of bounds.
+            /*
+            Cells stay where they were made, since references to them are 
+            handed out.
             */
           
-          const_iterator(const const_iterator& original);
+          Phone& phone();
+          
+          const Phone& phone() const;
             
             /*
-            Copy constructor
-            
-            Parameters:
-              original: Other const_iterator to be copied.
+            Returns the phone held in this Cell.
             */
           
-          const_iterator& operator=(const const_iterator& other);
+          Slot slot() const;
             
             /*
-            Standard field-wise assignment
+            Packs the phone held in this Cell, as it is now, into a Slot.
             */
+        
+      };
+    
+    public:
+      
+      enum Part {onset_part   = 0, 
+                 nucleus_part = 1, 
+                 coda_part    = 2};
+        
+        /*
+        This enumeration names the parts of a syllable, for visitors passed to 
+        visit.
+        */
+      
+      class Span {
+        
+        /*
+        A read-only view of consecutive phones in a Syllable, as Slots, that 
+        neither copies nor allocates.  The Slots are read by value, from the 
+        syllable's materialized phones if those have been changed in place, 
+        and a Span can be used in a range-based for loop.  A Span is only 
+        valid until the syllable it came from is next changed.
+        */
+        
+        friend class Syllable;
+        
+        protected:
           
-          const_iterator& operator++();
+          const Slot* _begin;
             
-          const_iterator& operator++(int);
-          
-          const_iterator& operator--();
-          
-          const_iterator& operator--(int);
+            /*
+            The first Slot in the view
+            */
           
-          bool operator==(const const_iterator& other) const;
+          const Cell* _cells;
             
             /*
-            Iterators are equal that are at the same position in the same 
-            Syllable.
+            The materialized phones at the same positions as the Slots, if they
+            are to be read instead, and null otherwise
             */
           
-          bool operator!=(const const_iterator& other) const;
+          int _size;
             
             /*
-            Iterators are equal that are at the same position in the same
-            Syllable.
+            The number of Slots in the view
             */
+        
+        public:
           
-          bool operator>(const const_iterator& other) const;
+          class iterator {
             
             /*
-            Compares the positions of the two iterators.
+            An input iterator over the Slots in a Span
             */
+            
+            protected:
+              
+              const Slot* _slot;
+                
+                /*
+                The Slot at the iterator's current position
+                */
+              
+              const Cell* _cell;
+                
+                /*
+                The Cell at the same position, or null if there are no Cells
+                */
+            
+            public:
+              
+              typedef std::input_iterator_tag iterator_category;
+              
+              typedef Slot value_type;
+              
+              typedef std::ptrdiff_t difference_type;
+              
+              typedef const Slot* pointer;
+              
+              typedef Slot reference;
+                
+                /*
+                The standard iterator types
+                */
+              
+              ~iterator();
+                
+                /*
+                Destructor
+                */
+              
+              iterator(const Slot* slot, const Cell* cell);
+                
+                /*
+                Standard constructor
+                
+                Parameters:
+                  slot: The Slot at the iterator's position
+                  cell: The Cell at the same position, or null
+                */
+              
+              iterator& operator++();
+              
+              iterator operator++(int);
+                
+                /*
+                Move the iterator to the next Slot in the view.
+                */
+              
+              bool operator==(const iterator& other) const;
+              
+              bool operator!=(const iterator& other) const;
+              
+              Slot operator*() const;
+            
+          };
           
-          bool operator>(int position) const;
+          ~Span();
             
             /*
-            Compares the position of this iterator to an integer position.
+            Destructor
             */
           
-          bool operator<(const const_iterator& other) const;
+          Span(const Slot* begin, int size);
             
             /*
-            Compares the positions of the two iterators.
+            Standard constructor
+            
+            Parameters:
+              begin: The first Slot in the view
+              size:  The number of Slots in the view
             */
           
-          bool operator<(int position) const;
+          Slot operator[](int index) const;
             
             /*
-            Compares the position of this iterator to an integer position.
+            Returns the Slot at the given index in the view.
+            
+            Bounds checked.  Negative indices allowed.
+            
+            Exceptions:
+              expt::IndexError: Thrown if the bounds check fails.
             */
           
-          bool operator>=(const const_iterator& other) const;
+          Slot unchecked(int index) const;
             
             /*
-            Compares the positions of the two iterators.
+            Returns the Slot at the given index, which must be from 0 to 
+            size() - 1.  Not bounds checked.
             */
           
-          bool operator>=(int position) const;
+          iterator begin() const;
+          
+          iterator end() const;
             
             /*
-            Compares the position of this iterator to an integer position.
+            Return iterators at the first Slot and one past the last.
             */
           
-          bool operator<=(const const_iterator& other) const;
+          int size() const;
             
             /*
-            Compares the positions of the two iterators.
+            Returns the number of Slots in the view.
             */
           
-          bool operator<=(int position) const;
+          bool empty() const;
             
             /*
-            Compares the position of this iterator to an integer position.
+            Returns true if the view has no Slots.
             */
+        
+      };
+      
+      template <class Kind>
+      class View {
+        
+        /*
+        A view of some of the phones in a Syllable that neither copies nor 
+        allocates.  It is what onset(), nucleus(), coda(), vowels(), and 
+        consonants() return.  Kind is Phone for the phones in a part of the 
+        syllable, or Vowel or Consonant for the phones of one kind, in which 
+        case the phones of the other kind are skipped.  Any of them may be 
+        const.  Getting a View does not materialize the syllable's phones.  A 
+        View of a non-const Kind yields references, and materializes them once 
+        a phone is reached through it.  A View of a const Kind never does: it 
+        yields each phone by value, a Slot for const Phone and a Vowel or 
+        Consonant otherwise.
+        
+        Because of the skipping, size() and operator[] take time linear in the 
+        number of phones the view covers, which is never more than the size of 
+        the syllable.  A View is only valid until the syllable it came from is 
+        next changed.
+        */
+        
+        public:
           
-          const_iterator& operator+=(int val);
+          typedef typename std::conditional<std::is_const<Kind>::value, 
+                                            const Syllable, 
+                                            Syllable>::type SyllableType;
+            
+            /*
+            The type of Syllable that the view covers, which is const if Kind 
+            is
+            */
           
-          const_iterator& operator-=(int val);
+          typedef typename std::conditional<
+            std::is_same<Kind, const Phone>::value, Slot, 
+            typename std::remove_const<Kind>::type>::type value_type;
           
-          const Phone* operator[](int index) const;
+          typedef typename std::conditional<std::is_const<Kind>::value, 
+                                            value_type, 
+                                            Kind&>::type reference;
             
             /*
-            Allows the iterator to be de-referenced with an offset.  Returns 
-            the Phone* index places away from the iterator's current position.
+            The types of the phones the view yields, by value if Kind is const
             */
           
-          const Phone* operator*() const;
+          class iterator {
             
             /*
-            Returns the Phone* at the iterator's current position in the 
-            Syllable.
+            A forward iterator over the phones in a View
             */
+            
+            protected:
+              
+              SyllableType* _syllable;
+                
+                /*
+                The Syllable that the view covers
+                */
+              
+              int _position;
+                
+                /*
+                The iterator's current position in the Syllable
+                */
+              
+              int _end;
+                
+                /*
+                One past the last position in the view, where skipping stops
+                */
+            
+            public:
+              
+              typedef std::forward_iterator_tag iterator_category;
+              
+              typedef typename View::value_type value_type;
+              
+              typedef std::ptrdiff_t difference_type;
+              
+              typedef typename std::conditional<std::is_const<Kind>::value, 
+                                                Arrow<value_type>, 
+                                                Kind*>::type pointer;
+              
+              typedef typename View::reference reference;
+                
+                /*
+                The standard iterator types
+                */
+              
+              ~iterator();
+                
+                /*
+                Destructor
+                */
+              
+              iterator(SyllableType* syllable, int position, int end);
+                
+                /*
+                Standard constructor
+                
+                Parameters:
+                  syllable: The Syllable that the view covers
+                  position: The first position to consider.  If it does not 
+                            hold a Kind, the iterator starts at the next one 
+                            that does.
+                  end:      One past the last position in the view
+                */
+              
+              iterator& operator++();
+              
+              iterator operator++(int);
+                
+                /*
+                Move the iterator to the next phone in the view.
+                */
+              
+              bool operator==(const iterator& other) const;
+              
+              bool operator!=(const iterator& other) const;
+              
+              reference operator*() const;
+              
+              pointer operator->() const;
+            
+          };
+        
+        protected:
           
-          const Phone* operator->() const;
-          
-          const Syllable& syllable() const;
+          SyllableType* _syllable;
             
             /*
-            Returns a reference to the Syllable this iterator is operating on.
+            The Syllable that the view covers
             */
           
-          void set_syllable(const Syllable& new_syllable);
+          int _begin;
             
             /*
-            Moves this iterator to a different Syllable.  Position is 
-            unchanged.
+            The first position in the view
+            */
+          
+          int _end;
             
-            Parameters:
-              new_syllable: New syllable
+            /*
+            One past the last position in the view
             */
           
-          int position() const;
+          static bool holds(const Slot& slot);
             
             /*
-            Returns the current position of the iterator.
+            Returns true if slot holds a phone that belongs in the view.  A 
+            phone never changes kind, so the Slot says so even while the 
+            materialized phones have been changed.
             */
+        
+        public:
           
-          int inverse_position() const;
+          ~View();
             
             /*
-            Returns the position of the iterator as a negative int measured 
-            from the end of the Syllable.
+            Destructor
             */
           
-          void set_position(int position);
+          View(SyllableType* syllable, int begin, int end);
             
             /*
-            Moves the iterator to the position give.
+            Standard constructor
             
             Parameters:
-              position: The new position as an index in the Syllable.  Negative
-                        indices allowed.  Bounds checked.
+              syllable: The Syllable that the view covers
+              begin:    The first position in the view
+              end:      One past the last position in the view
+            */
+          
+          reference operator[](int index) const;
+            
+            /*
+            Returns the phone at the given index in the view.
+            
+            Bounds checked.  Negative indices allowed.
             
             Exceptions:
               expt::IndexError: Thrown if the bounds check fails.
             */
+          
+          iterator begin() const;
+          
+          iterator end() const;
+          
+          int size() const;
+            
+            /*
+            Returns the number of phones in the view.
+            */
+          
+          bool empty() const;
+            
+            /*
+            Returns true if the view has no phones.
+            */
         
       };
       
-      ~Syllable();
+      static const int inline_capacity = 8;
         
         /*
-        Destructor
+        The number of phones that can be stored without allocating
         */
       
-      Syllable();
+      static const int phone_encoding_size = 64;
         
         /*
-        Empty constructor
-        
-        The default syllable is just a Schwa.
+        The most bytes a single phone (or the tone) can take up when encoded in
+        any of the supported transcription systems
         */
+    
+    friend class Decoder;
+    
+    friend class SoundChange;
+    
+    protected:
       
-      Syllable(const std::vector<const Phone*> onset, 
-               const std::vector<const Phone*> nucleus, 
-               const std::vector<const Phone*> coda, 
-               const Tone tone = {0, 0, 0});
+      Slot* _heap;
         
         /*
-        Detailed constructor
-        
-        Parameters:
-          onset:    A vector of pointers to the phones representing the 
-                    syllable onset
-          nucleus:  A vector of pointers to the phones representing the 
-                    syllable nucleus.  Cannot be empty.
-          coda:     A vector of pointers to the phones representing the 
-                    syllable coda
-          tone:     The tone of the syllable.
-        
-        Exceptions:
-          ImpossibleArticulation: Thrown if nucleus is an empty vector.
+        Storage for the phones when there are more than inline_capacity of 
+        them.  Null while the phones are stored inline.
         */
       
-      Syllable(std::string transcription, PhoneticEncoding encoding = x-sampa);
-      
+      Arena* _arena;
+        
         /*
-        Transcription constructor
-
-        Constructs a syllable from a string containing a phonetic transcription
-        representing a single syllable.  See the enumeration PhoneticEncoding 
-        for a list of supported transcription systems.
-
-        Parameters:
-          transcription:  A phonetic transcription representing a single 
-                          syllable.  The transcription may be enclosed in 
-                          square brackets or not enclosed.  It may not be 
-                          enclosed in any other type of bracket.
-          encoding:       This parameter specifies which transcription system 
-                          the transcription is encoded in using the set of 
-                          options provided by the PhoneticEncoding enumeration.
-
-        Exceptions:
-          DecodingFailed: Thrown if transcription cannot be recognized as a 
-                          single valid syllable in the specified transcription 
-                          system.
+        The arena that _heap is allocated from, or null for the heap
         */
       
-      Syllable(const Syllable& original);
+      int _capacity;
         
         /*
-        Copy constructor
-        
-        Parameters:
-          original: The other Syllable to be copied
+        The number of Slots available in the current storage
         */
       
-      Syllable& operator=(const Syllable& other);
+      int _size;
         
         /*
-        Standard field-wise assignment
+        The total number of phones in the syllable
         */
       
-      bool operator==(const Syllable& other) const;
-      
-      bool operator!=(const Syllable& other) const;
-      
-      Phone& operator[](int index);
-      
-      const Phone& operator[](int index) const;
-      
-      iterator begin();
-      
-      iterator end();
-      
-      iterator onset_begin();
+      int _onset_size;
         
         /*
-        Returns an iterator at the start of the syllable onset.
+        The onset is stored at indices [0, _onset_size).
         */
       
-      iterator onset_end();
+      int _nucleus_size;
         
         /*
-        Returns an iterator at the end of the syllable onset.
+        The nucleus is stored at indices [_onset_size, _onset_size + 
+        _nucleus_size), and the coda takes up the remaining indices up to 
+        _size.
         */
       
-      iterator nucleus_begin();
+      ToneCode _tone;
+      
+      uint64_t _stamp;
         
         /*
-        Returns an iterator at the start of the syllable nucleus.
+        The value returned by stamp()
         */
       
-      iterator nucleus_end();
+      mutable std::atomic<Cell*> _cells;
         
         /*
-        Returns an iterator at the end of the syllable nucleus.
+        The materialized phones, one for each Slot, or null if the phones have 
+        not been asked for by reference since they were last added or removed
         */
       
-      iterator coda_begin();
+      mutable std::atomic<bool> _changed;
         
         /*
-        Returns an iterator at the start of the syllable coda.
+        Whether a way to change the materialized phones has been handed out, 
+        which makes them rather than the Slots the phones of the syllable
         */
       
-      iterator coda_end();
+      alignas(Slot) unsigned char _inline[inline_capacity * sizeof(Slot)];
         
         /*
-        Returns an iterator at the end of the syllable coda.
+        Raw storage for up to inline_capacity Slots.  Only the first _size 
+        Slots are in use while _heap is null.
         */
       
-      const_iterator begin() const;
-      
-      const_iterator end() const;
+      Slot* slots();
       
-      const_iterator onset_begin() const;
+      const Slot* slots() const;
         
         /*
-        Returns an iterator at the start of the syllable onset.
+        Returns the start of the array of Slots currently in use.  While the 
+        materialized phones have been changed, the Slots may be out of date.
         */
       
-      const_iterator onset_end() const;
+      Cell* cells();
         
         /*
-        Returns an iterator at the end of the syllable onset.
+        Returns the materialized phones, materializing them first if they do 
+        not exist.  The phones may then be changed through the result, so from
+        here on they are the phones of the syllable.
         */
       
-      const_iterator nucleus_begin() const;
+      const Cell* cells() const;
         
         /*
-        Returns an iterator at the start of the syllable nucleus.
+        Returns the materialized phones for reading, materializing them first 
+        if they do not exist.  Safe to call from several threads at once.
         */
       
-      const_iterator nucleus_end() const;
+      const Cell* materialize() const;
         
         /*
-        Returns an iterator at the end of the syllable nucleus.
+        Does the work of cells() when the phones have not been materialized.
         */
       
-      const_iterator coda_begin() const;
+      const Cell* changed_cells() const;
         
         /*
-        Returns an iterator at the start of the syllable coda.
+        Returns the materialized phones if they have been changed and the 
+        Slots are out of date, and null otherwise.
         */
       
-      const_iterator coda_end() const;
+      Slot slot(int index) const;
         
         /*
-        Returns an iterator at the end of the syllable coda.
+        Returns the Slot at the given absolute index, up to date.  Not bounds 
+        checked.
         */
       
-      const std::vector<Phone*>& onset() const;
+      template <class Kind>
+      static Kind& phone_at(Syllable* syllable, int index, Kind*);
+      
+      static Slot phone_at(const Syllable* syllable, int index, 
+                           const Phone*);
+      
+      static Vowel phone_at(const Syllable* syllable, int index, 
+                            const Vowel*);
+      
+      static Consonant phone_at(const Syllable* syllable, int index, 
+                                const Consonant*);
         
         /*
-        Returns a const reference to the internal vector of Phone pointers 
-        representing the syllable onset.
+        Return the phone at the given absolute index for a View of Kind: by 
+        reference to the materialized phone if the syllable is not const, and 
+        otherwise by value from its Slot.  The last parameter only chooses the 
+        overload.  Not bounds checked.
         */
       
-      const std::vector<Phone*>& nucleus() const;
+      void settle();
         
         /*
-        Returns a const reference to the internal vector of Phone pointers 
-        representing the syllable nucleus.
+        Packs any changes made to the materialized phones back into the Slots 
+        and releases them.  Every reference to a phone is invalidated.
         */
       
-      const std::vector<Phone*>& coda() const;
+      template <class Visitor>
+      void visit_slots(Visitor& visitor);
         
         /*
-        Returns a const reference to the internal vector of Phone pointers 
-        representing the syllable coda.
+        Calls visitor(slot, part) for each Slot in order, where slot is a 
+        Slot& that the visitor can replace, without materializing the phones.  
+        The visitor returns true if it changed the Slot, and the stamp only 
+        changes if one did.
         */
       
-      const std::vector<Phone*> phones() const;
+      void copy_slots(const Syllable& original);
         
         /*
-        Returns a const vector containing pointers to all of the Phones in the 
-        syllable, in order.
+        Copies the phones of original, up to date, into this syllable's 
+        storage, which must already have room for them and hold no 
+        materialized phones, and takes on its size.
         */
       
-      std::vector<Vowel>& vowels();
+      void reserve(int capacity);
         
         /*
-        Returns a reference to the internal vector containing all of the 
-        syllable's vowels.  This allows operations to be performed on all 
-        vowels in the syllable.
+        Makes sure that at least capacity Slots are available, moving the 
+        phones to the heap if necessary.
         */
       
-      const std::vector<Vowel>& vowels() const;
+      void transcribe(const char* transcription, int length, 
+                      PhoneticEncoding encoding);
         
         /*
-        Returns a const reference to the internal vector containing all of the 
-        syllable's vowels.
+        Initializes the syllable from a transcription, for the transcription 
+        constructors.
+        
+        Exceptions:
+          DecodingFailed: Thrown if the transcription cannot be decoded.
         */
       
-      std::vector<Consonant>& consonants();
+      void insert_slot(const Slot& slot, int index);
         
         /*
-        Returns a reference to the internal vector containing all of the 
-        syllable's consonants.  This allows operations to be performed on all
-        consonants in the syllable.
+        Inserts slot at the given absolute index, shifting the following phones
+        back by one.  Not bounds checked.
         */
       
-      const std::vector<Consonant>& consonants() const;
+      void remove_slot(int index);
         
         /*
-        Returns a const reference to the internal vector containing all of the 
-        syllable's consonants.
+        Removes the Slot at the given absolute index, shifting the following 
+        phones forward by one.  Not bounds checked.
         */
       
-      Tone tone() const;
+      void clear();
         
         /*
-        Returns the syllable's tone.
+        Releases all of the phones, the materialized ones, and any heap 
+        storage.
         */
       
-      void insert_onset(Phone new_phone, int position);
+      int encode_phone(int index, PhoneticEncoding encoding, 
+                       char* buffer) const;
         
         /*
-        Inserts a new phone into the syllable onset.
-        
-        Parameters:
-          new_phone:  The new phone to be inserted
-          position:   An index in the syllable onset.  Bounds checked.  
-                      Negative indices allowed.
-        
-        Exceptions:
-          expt::IndexError: Thrown if the bounds check fails.
+        Writes the transcription of the phone at the given absolute index into 
+        buffer, which must have room for phone_encoding_size bytes.  Not bounds
+        checked.  Returns the number of bytes written.
         */
       
-      void insert_nucleus(Phone new_phone, int position);
+      int encode_tone(PhoneticEncoding encoding, char* buffer) const;
         
         /*
-        Inserts a new phone into the syllable nucleus.
-        
-        Parameters:
-          new_phone:  The new phone to be inserted
-          position:   An index in the syllable nucleus.  Bounds checked.  
-                      Negative indices allowed.
-        
-        Exceptions:
-          expt::IndexError: Thrown if the bounds check fails.
+        Writes the transcription of the tone into buffer, which must have room 
+        for phone_encoding_size bytes.  Returns the number of bytes written, 
+        which is 0 for a toneless syllable or an encoding with no tone marks.
         */
+    
+    public:
       
-      void insert_coda(Phone new_phone, int position);
+      class const_iterator;
+      
+      class iterator {
         
         /*
-        Inserts a new phone into the syllable coda.
-        
-        Parameters:
-          new_phone:  The new phone to be inserted
-          position:   An index in the syllable coda.  Bounds checked.  
-                      Negative indices allowed.
+        A random-access iterator over the phones of a Syllable, counting 
+        through the onset, nucleus, and coda as if the entire Syllable were 
+        one vector.  It meets the requirements of a standard random-access 
+        iterator, so std:: algorithms can be used on syllables directly.  
+        Since the phones are Vowels and Consonants reached through Phone 
+        references, algorithms that only read or modify phones in place work, 
+        but ones that move phones from one position to another, such as 
+        std::sort, do not.
         
-        Exceptions:
-          expt::IndexError: Thrown if the bounds check fails.
+        Only construction and set_position() are bounds checked.  Moving the 
+        iterator and dereferencing it are not, like a pointer, and an 
+        iterator is invalidated by anything that adds or removes phones.  The 
+        phones are not materialized until the iterator is first dereferenced.
         */
-      
-      void remove_onset(int index);
-        
-        /*
-        Removes the phone at the given index.
         
-        Parameters:
-          index: An index in the syllable onset.  Bounds checked.  Negative 
-                  indices allowed.
+        friend class const_iterator;
         
-        Exceptions:
-          expt::IndexError: Thrown if the bounds check fails.
+        protected:
+          
+          Syllable* _syllable;
+            
+            /*
+            The Syllable through which this iterator is iterating
+            */
+          
+          int _position;
+            
+            /*
+            The iterator's position in the Syllable, as an index as if the 
+            entire Syllable were one vector
+            */
+        
+        public:
+          
+          typedef std::random_access_iterator_tag iterator_category;
+          
+          typedef Phone value_type;
+          
+          typedef std::ptrdiff_t difference_type;
+          
+          typedef Phone* pointer;
+          
+          typedef Phone& reference;
+            
+            /*
+            The standard iterator types
+            */
+          
+          ~iterator();
+            
+            /*
+            Destructor
+            */
+          
+          iterator();
+            
+            /*
+            Empty constructor
+            
+            The iterator belongs to no Syllable and may only be assigned to.
+            */
+          
+          iterator(Syllable& syllable, int position = 0);
+            
+            /*
+            Standard constructor
+            
+            Parameters:
+              syllable: The Syllable through which this iterator is iterating
+              position: The index in the Syllable where this iterator will 
+                        start, which may be one past the last phone.  
+                        Negative indices are allowed.  Bounds checked.
+            
+            Exceptions:
+              expt::IndexError: Thrown if a value is passed for position that 
+                                is out of bounds.
+            */
+          
+          iterator(const iterator& original);
+            
+            /*
+            Copy constructor
+            
+            Parameters:
+              original: Other iterator to be copied
+            */
+          
+          iterator& operator=(const iterator& other);
+            
+            /*
+            Standard field-wise assignment
+            */
+          
+          iterator& operator++();
+            
+          iterator operator++(int);
+          
+          iterator& operator--();
+          
+          iterator operator--(int);
+          
+          iterator& operator+=(difference_type offset);
+          
+          iterator& operator-=(difference_type offset);
+          
+          iterator operator+(difference_type offset) const;
+          
+          iterator operator-(difference_type offset) const;
+            
+            /*
+            Move the iterator by the given number of phones.  Not bounds 
+            checked.
+            */
+          
+          difference_type operator-(const iterator& other) const;
+            
+            /*
+            Returns the number of phones from other to this iterator.  Both 
+            must be in the same Syllable.
+            */
+          
+          bool operator==(const iterator& other) const;
+            
+            /*
+            Iterators are equal that are at the same position in the same 
+            Syllable.
+            */
+          
+          bool operator!=(const iterator& other) const;
+            
+            /*
+            Iterators are equal that are at the same position in the same
+            Syllable.
+            */
+          
+          bool operator>(const iterator& other) const;
+          
+          bool operator<(const iterator& other) const;
+          
+          bool operator>=(const iterator& other) const;
+          
+          bool operator<=(const iterator& other) const;
+            
+            /*
+            Compare the positions of two iterators in the same Syllable.
+            */
+          
+          bool operator>(int position) const;
+          
+          bool operator<(int position) const;
+          
+          bool operator>=(int position) const;
+          
+          bool operator<=(int position) const;
+            
+            /*
+            Compare the position of this iterator to an integer position.
+            */
+          
+          Phone& operator*() const;
+            
+            /*
+            Returns the phone at the iterator's current position in the 
+            Syllable.  Not bounds checked.
+            */
+          
+          Phone* operator->() const;
+          
+          Phone& operator[](difference_type offset) const;
+            
+            /*
+            Returns the phone offset places away from the iterator's current 
+            position.  Not bounds checked.
+            */
+          
+          Syllable& syllable() const;
+            
+            /*
+            Returns a reference to the Syllable this iterator is operating on.
+            */
+          
+          void set_syllable(Syllable& new_syllable);
+            
+            /*
+            Moves this iterator to a different Syllable.  Position is 
+            unchanged.  Not bounds checked.
+            
+            Parameters:
+              new_syllable: New syllable
+            */
+          
+          int position() const;
+            
+            /*
+            Returns the current position of the iterator.
+            */
+          
+          int inverse_position() const;
+            
+            /*
+            Returns the position of the iterator as a negative int measured 
+            from the end of the Syllable.
+            */
+          
+          void set_position(int position);
+            
+            /*
+            Moves the iterator to the position given.
+            
+            Parameters:
+              position: The new position as an index in the Syllable, which 
+                        may be one past the last phone.  Negative indices 
+                        allowed.  Bounds checked.
+            
+            Exceptions:
+              expt::IndexError: Thrown if the bounds check fails.
+            */
+      
+      };
+      
+      class const_iterator {
+        
+        /*
+        The read-only counterpart of iterator, with the same rules for bounds 
+        checking.  It yields each phone as its Slot, by value, so iterating 
+        over a const Syllable never materializes its phones.  An iterator 
+        converts to a const_iterator.
         */
+        
+        protected:
+          
+          const Syllable* _syllable;
+            
+            /*
+            The Syllable through which this iterator is iterating
+            */
+          
+          int _position;
+            
+            /*
+            The iterator's position in the Syllable, as an index as if the 
+            entire Syllable were one vector
+            */
+        
+        public:
+          
+          typedef std::random_access_iterator_tag iterator_category;
+          
+          typedef Slot value_type;
+          
+          typedef std::ptrdiff_t difference_type;
+          
+          typedef Arrow<Slot> pointer;
+          
+          typedef Slot reference;
+            
+            /*
+            The standard iterator types
+            */
+          
+          ~const_iterator();
+            
+            /*
+            Destructor
+            */
+          
+          const_iterator();
+            
+            /*
+            Empty constructor
+            
+            The iterator belongs to no Syllable and may only be assigned to.
+            */
+          
+          const_iterator(const Syllable& syllable, int position = 0);
+            
+            /*
+            Standard constructor
+            
+            Parameters:
+              syllable: The Syllable through which this iterator is iterating
+              position: The index in the Syllable where this iterator will 
+                        start, which may be one past the last phone.  
+                        Negative indices are allowed.  Bounds checked.
+            
+            Exceptions:
+              expt::IndexError: Thrown if a value is passed for position that 
+                                is out of bounds.
+            */
+          
+          const_iterator(const const_iterator& original);
+            
+            /*
+            Copy constructor
+            
+            Parameters:
+              original: Other const_iterator to be copied.
+            */
+          
+          const_iterator(const iterator& original);
+            
+            /*
+            Conversion constructor
+            
+            Parameters:
+              original: An iterator at the position to start from
+            */
+          
+          const_iterator& operator=(const const_iterator& other);
+            
+            /*
+            Standard field-wise assignment
+            */
+          
+          const_iterator& operator++();
+            
+          const_iterator operator++(int);
+          
+          const_iterator& operator--();
+          
+          const_iterator operator--(int);
+          
+          const_iterator& operator+=(difference_type offset);
+          
+          const_iterator& operator-=(difference_type offset);
+          
+          const_iterator operator+(difference_type offset) const;
+          
+          const_iterator operator-(difference_type offset) const;
+            
+            /*
+            Move the iterator by the given number of phones.  Not bounds 
+            checked.
+            */
+          
+          difference_type operator-(const const_iterator& other) const;
+            
+            /*
+            Returns the number of phones from other to this iterator.  Both 
+            must be in the same Syllable.
+            */
+          
+          bool operator==(const const_iterator& other) const;
+            
+            /*
+            Iterators are equal that are at the same position in the same 
+            Syllable.
+            */
+          
+          bool operator!=(const const_iterator& other) const;
+            
+            /*
+            Iterators are equal that are at the same position in the same
+            Syllable.
+            */
+          
+          bool operator>(const const_iterator& other) const;
+          
+          bool operator<(const const_iterator& other) const;
+          
+          bool operator>=(const const_iterator& other) const;
+          
+          bool operator<=(const const_iterator& other) const;
+            
+            /*
+            Compare the positions of two iterators in the same Syllable.
+            */
+          
+          bool operator>(int position) const;
+          
+          bool operator<(int position) const;
+          
+          bool operator>=(int position) const;
+          
+          bool operator<=(int position) const;
+            
+            /*
+            Compare the position of this iterator to an integer position.
+            */
+          
+          Slot operator*() const;
+            
+            /*
+            Returns the phone at the iterator's current position in the 
+            Syllable.  Not bounds checked.
+            */
+          
+          Arrow<Slot> operator->() const;
+          
+          Slot operator[](difference_type offset) const;
+            
+            /*
+            Returns the phone offset places away from the iterator's current 
+            position.  Not bounds checked.
+            */
+          
+          const Syllable& syllable() const;
+            
+            /*
+            Returns a reference to the Syllable this iterator is operating on.
+            */
+          
+          void set_syllable(const Syllable& new_syllable);
+            
+            /*
+            Moves this iterator to a different Syllable.  Position is 
+            unchanged.  Not bounds checked.
+            
+            Parameters:
+              new_syllable: New syllable
+            */
+          
+          int position() const;
+            
+            /*
+            Returns the current position of the iterator.
+            */
+          
+          int inverse_position() const;
+            
+            /*
+            Returns the position of the iterator as a negative int measured 
+            from the end of the Syllable.
+            */
+          
+          void set_position(int position);
+            
+            /*
+            Moves the iterator to the position given.
+            
+            Parameters:
+              position: The new position as an index in the Syllable, which 
+                        may be one past the last phone.  Negative indices 
+                        allowed.  Bounds checked.
+            
+            Exceptions:
+              expt::IndexError: Thrown if the bounds check fails.
+            */
+        
+      };
+      
+      ~Syllable();
+        
+        /*
+        Destructor
+        */
+      
+      Syllable();
+        
+        /*
+        Empty constructor
+        
+        The default syllable is just a Schwa.
+        */
+      
+      explicit Syllable(Arena* arena);
+        
+        /*
+        Arena constructor
+        
+        The same as the empty constructor, except that if the syllable ever 
+        grows beyond inline_capacity phones, they are stored in arena instead 
+        of on the heap.  Typically used to make syllables to decode into.
+        
+        Parameters:
+          arena: The arena for the syllable's phones, or null for the heap.  
+                 It must outlive the syllable.
+        */
+      
+      Syllable(const std::vector<const Phone*>& onset, 
+               const std::vector<const Phone*>& nucleus, 
+               const std::vector<const Phone*>& coda, 
+               const Tone& tone = {0, 0, 0});
+        
+        /*
+        Detailed constructor
+        
+        Parameters:
+          onset:    A vector of pointers to the phones representing the 
+                    syllable onset
+          nucleus:  A vector of pointers to the phones representing the 
+                    syllable nucleus.  Cannot be empty.
+          coda:     A vector of pointers to the phones representing the 
+                    syllable coda
+          tone:     The tone of the syllable.
+        
+        Exceptions:
+          ImpossibleArticulation: Thrown if nucleus is an empty vector.
+        */
+      
+      Syllable(const std::string& transcription, 
+               PhoneticEncoding encoding = lang::x_sampa);
+        
+        /*
+        Transcription constructor
+
+        Constructs a syllable from a string containing a phonetic transcription
+        representing a single syllable.  See the enumeration PhoneticEncoding 
+        for a list of supported transcription systems.
+
+        Parameters:
+          transcription:  A phonetic transcription representing a single 
+                          syllable.  The transcription may be enclosed in 
+                          square brackets or not enclosed.  It may not be 
+                          enclosed in any other type of bracket.
+          encoding:       This parameter specifies which transcription system 
+                          the transcription is encoded in using the set of 
+                          options provided by the PhoneticEncoding enumeration.
+
+        Exceptions:
+          DecodingFailed: Thrown if transcription cannot be recognized as a 
+                          single valid syllable in the specified transcription 
+                          system.
+        */
+      
+      Syllable(const char* transcription, 
+               PhoneticEncoding encoding = lang::x_sampa);
+        
+        /*
+        Transcription constructor for null-terminated strings, so that string 
+        literals are decoded in place instead of being copied into a 
+        std::string first.  Otherwise the same as the std::string version.
+        */
+      
+      Syllable(const Syllable& original);
+        
+        /*
+        Copy constructor
+        
+        Parameters:
+          original: The other Syllable to be copied
+        */
+      
+      Syllable(const Syllable& original, Arena* arena);
+        
+        /*
+        Arena copy constructor
+        
+        Copies original into a syllable whose phones are stored in arena.
+        
+        Parameters:
+          original: The other Syllable to be copied
+          arena:    The arena for the copy's phones, or null for the heap
+        */
+      
+      Syllable(Syllable&& original) noexcept;
+        
+        /*
+        Move constructor
+        
+        If original's phones are on the heap, this syllable takes over that 
+        storage instead of copying it.  Because it is noexcept, containers 
+        such as PhoneticSequence move syllables rather than copying them when 
+        they grow.  original is left with no phones, and it should only be 
+        assigned to or destroyed.
+        
+        Parameters:
+          original: The other Syllable to be moved from
+        */
+      
+      Syllable& operator=(const Syllable& other);
+        
+        /*
+        Standard field-wise assignment
+        */
+      
+      Syllable& operator=(Syllable&& other) noexcept;
+        
+        /*
+        Move assignment.  Takes over other's heap storage like the move 
+        constructor if both syllables use the same arena, and copies it 
+        otherwise.  Either way other is left in the same state.
+        */
+      
+      bool operator==(const Syllable& other) const;
+      
+      bool operator!=(const Syllable& other) const;
+      
+      std::size_t hash() const;
+        
+        /*
+        Returns a hash of the syllable's phones, the sizes of its parts, and 
+        its tone.  Equal syllables have equal hashes whatever their storage, 
+        and the value is the same from one run of a program to the next.
+        */
+      
+      Phone& operator[](int index);
+      
+      const Phone& operator[](int index) const;
+        
+        /*
+        Returns the phone at the given index, counting through the onset, 
+        nucleus, and coda as if the entire Syllable were one vector.
+        
+        Bounds checked.  Negative indices allowed.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+        */
+      
+      Phone& unchecked(int index);
+      
+      const Phone& unchecked(int index) const;
+        
+        /*
+        The fast counterpart of operator[] for inner loops.  index must be 
+        from 0 to size() - 1.  Not bounds checked, and negative indices are not
+        allowed.
+        */
+      
+      iterator begin();
+      
+      iterator end();
+      
+      iterator onset_begin();
+        
+        /*
+        Returns an iterator at the start of the syllable onset.
+        */
+      
+      iterator onset_end();
+        
+        /*
+        Returns an iterator at the end of the syllable onset.
+        */
+      
+      iterator nucleus_begin();
+        
+        /*
+        Returns an iterator at the start of the syllable nucleus.
+        */
+      
+      iterator nucleus_end();
+        
+        /*
+        Returns an iterator at the end of the syllable nucleus.
+        */
+      
+      iterator coda_begin();
+        
+        /*
+        Returns an iterator at the start of the syllable coda.
+        */
+      
+      iterator coda_end();
+        
+        /*
+        Returns an iterator at the end of the syllable coda.
+        */
+      
+      const_iterator begin() const;
+      
+      const_iterator end() const;
+      
+      const_iterator onset_begin() const;
+        
+        /*
+        Returns an iterator at the start of the syllable onset.
+        */
+      
+      const_iterator onset_end() const;
+        
+        /*
+        Returns an iterator at the end of the syllable onset.
+        */
+      
+      const_iterator nucleus_begin() const;
+        
+        /*
+        Returns an iterator at the start of the syllable nucleus.
+        */
+      
+      const_iterator nucleus_end() const;
+        
+        /*
+        Returns an iterator at the end of the syllable nucleus.
+        */
+      
+      const_iterator coda_begin() const;
+        
+        /*
+        Returns an iterator at the start of the syllable coda.
+        */
+      
+      const_iterator coda_end() const;
+        
+        /*
+        Returns an iterator at the end of the syllable coda.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the total number of phones in the syllable.
+        */
+      
+      int onset_size() const;
+        
+        /*
+        Returns the number of phones in the syllable onset.
+        */
+      
+      int nucleus_size() const;
+        
+        /*
+        Returns the number of phones in the syllable nucleus.
+        */
+      
+      int coda_size() const;
+        
+        /*
+        Returns the number of phones in the syllable coda.
+        */
+      
+      View<Phone> onset();
+      
+      View<const Phone> onset() const;
+        
+        /*
+        Returns a view of the phones in the syllable onset, in order.  It 
+        refers to the phones in place, so nothing is copied.
+        */
+      
+      View<Phone> nucleus();
+      
+      View<const Phone> nucleus() const;
+        
+        /*
+        Returns a view of the phones in the syllable nucleus, in order.  It 
+        refers to the phones in place, so nothing is copied.
+        */
+      
+      View<Phone> coda();
+      
+      View<const Phone> coda() const;
+        
+        /*
+        Returns a view of the phones in the syllable coda, in order.  It 
+        refers to the phones in place, so nothing is copied.
+        */
+      
+      std::vector<Phone*> phones();
+        
+        /*
+        Returns a vector containing pointers to all of the Phones in the 
+        syllable, in order.  The phones are materialized, and since they can 
+        be changed through the pointers, they are then the syllable's phones.
+        The pointers are only valid until the next insertion or removal.
+        */
+      
+      std::vector<const Phone*> phones() const;
+        
+        /*
+        Returns a vector containing read-only pointers to all of the Phones in
+        the syllable, in order.  The phones are materialized, but the Slots 
+        stay the syllable's phones.  The pointers are only valid until the 
+        next insertion or removal.
+        */
+      
+      Span span() const;
+        
+        /*
+        Returns a view of all of the phones in the syllable, in order.  Unlike 
+        phones(), this does not allocate.
+        */
+      
+      Span onset_span() const;
+      
+      Span nucleus_span() const;
+      
+      Span coda_span() const;
+        
+        /*
+        Return views of the phones in each part of the syllable, in order.
+        */
+      
+      template <class Visitor>
+      void visit(Visitor&& visitor) const;
+        
+        /*
+        Calls visitor(phone, part) for each phone in order, where phone is a 
+        const Vowel& or a const Consonant& and part is the Part it belongs to.
+        The kind of each phone is read from its Slot, so a visitor with an 
+        overload for each kind is called directly and can be inlined, without 
+        virtual calls, casts, or allocation.  Unless they have been changed in
+        place, the phones are decoded into temporaries rather than 
+        materialized.
+        
+        Parameters:
+          visitor: A function object callable with both kinds of phone
+        */
+      
+      template <class Visitor>
+      void visit(Visitor&& visitor);
+        
+        /*
+        Like the const visit, but phone is a Vowel& or a Consonant& that the 
+        visitor can change in place.
+        */
+      
+      View<Vowel> vowels();
+        
+        /*
+        Returns a view of all of the syllable's vowels, in order.  This allows 
+        operations to be performed on all vowels in the syllable in place.
+        */
+      
+      View<const Vowel> vowels() const;
+        
+        /*
+        Returns a read-only view of all of the syllable's vowels, in order.
+        */
+      
+      View<Consonant> consonants();
+        
+        /*
+        Returns a view of all of the syllable's consonants, in order.  This 
+        allows operations to be performed on all consonants in the syllable in 
+        place.
+        */
+      
+      View<const Consonant> consonants() const;
+        
+        /*
+        Returns a read-only view of all of the syllable's consonants, in order.
+        */
+      
+      Arena* arena() const;
+        
+        /*
+        Returns the arena holding the syllable's phones, or null if they are on
+        the heap.
+        */
+      
+      Tone tone() const;
+        
+        /*
+        Returns the syllable's tone.
+        */
+      
+      ToneCode tone_code() const;
+        
+        /*
+        Returns the syllable's tone as it is stored, without decoding it.
+        */
+      
+      uint64_t stamp() const;
+        
+        /*
+        Returns a number that identifies the syllable's current contents.  
+        Every constructor, and every member function that changes the 
+        syllable or returns a way to change it, such as a non-const 
+        operator[], iterator, View or visit, gives the syllable a stamp that 
+        no syllable has had before.  A copy shares the stamp of its original.  
+        Two syllables with the same stamp are therefore equal, although equal 
+        syllables need not share a stamp.
+        
+        A change made later through a reference, pointer, iterator, or View 
+        that was obtained earlier, or through the pointers that phones() 
+        returns, cannot be seen.  Call touch() after making one.
+        */
+      
+      void touch();
+        
+        /*
+        Gives the syllable a new stamp, so that anything that remembered the 
+        old one treats the syllable as changed.
+        */
+      
+      void insert_onset(const Phone& new_phone, int position);
+        
+        /*
+        Inserts a copy of a new phone into the syllable onset before the given 
+        position.
+        
+        Parameters:
+          new_phone:  The new phone to be inserted.  Must be a Vowel or a 
+                      Consonant.
+          position:   An index in the syllable onset.  Bounds checked.  
+                      Negative indices allowed.  May also be equal to the 
+                      size of the onset, in which case the phone is appended.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+          expt::ValueError: Thrown if new_phone is neither a Vowel nor a 
+                            Consonant.
+        */
+      
+      void insert_nucleus(const Phone& new_phone, int position);
+        
+        /*
+        Inserts a copy of a new phone into the syllable nucleus before the given 
+        position.
+        
+        Parameters:
+          new_phone:  The new phone to be inserted.  Must be a Vowel or a 
+                      Consonant.
+          position:   An index in the syllable nucleus.  Bounds checked.  
+                      Negative indices allowed.  May also be equal to the 
+                      size of the nucleus, in which case the phone is appended.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+          expt::ValueError: Thrown if new_phone is neither a Vowel nor a 
+                            Consonant.
+        */
+      
+      void insert_coda(const Phone& new_phone, int position);
+        
+        /*
+        Inserts a copy of a new phone into the syllable coda before the given 
+        position.
+        
+        Parameters:
+          new_phone:  The new phone to be inserted.  Must be a Vowel or a 
+                      Consonant.
+          position:   An index in the syllable coda.  Bounds checked.  
+                      Negative indices allowed.  May also be equal to the 
+                      size of the coda, in which case the phone is appended.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+          expt::ValueError: Thrown if new_phone is neither a Vowel nor a 
+                            Consonant.
+        */
+      
+      void remove_onset(int index);
+        
+        /*
+        Removes the phone at the given index.
+        
+        Parameters:
+          index: An index in the syllable onset.  Bounds checked.  Negative 
+                  indices allowed.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+        */
+      
+      void remove_nucleus(int index);
+        
+        /*
+        Removes the phone at the given index.
+        
+        Parameters:
+          index: An index in the syllable nucleus.  Bounds checked.  Negative
+                  indices allowed.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+          ImpossibleArticulation: Thrown if removing the phone would leave the
+                                  nucleus empty.
+        */
+      
+      void remove_coda(int index);
+        
+        /*
+        Removes the phone at the given index.
+        
+        Parameters:
+          index: An index in the syllable coda.  Bounds checked.  Negative 
+                  indices allowed.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+        */
+      
+      std::string unicode() const;
+        
+        /*
+        Returns the IPA representation of the syllable, using Unicode 
+        characters where necessary.  Will be enclosed in square brackets.
+        */
+
+      std::string kirschenbaum() const;
+
+        /*
+        Returns the IPA representation of the syllable using Kirschenbaum 
+        encoding.  Will be enclosed in square brackets.
+        */
+      
+      std::string x_sampa() const;
+        
+        /*
+        Returns the IPA representation of the syllable using X-SAMPA encoding. 
+        Will be enclosed in square brackets.
+        */
+      
+      void encode(std::string& output, 
+                  PhoneticEncoding encoding = lang::x_sampa) const;
+        
+        /*
+        Appends the transcription of the syllable to output without any other 
+        allocation than output's own growth, so that a single string can be 
+        reused for many syllables.  Unlike unicode(), kirschenbaum() and 
+        x_sampa(), the transcription is not enclosed in square brackets.
+        
+        Parameters:
+          output:   The string to which the transcription will be appended
+          encoding: The transcription system to be used
+        */
+      
+      int encode(char* buffer, int capacity, 
+                 PhoneticEncoding encoding = lang::x_sampa) const;
+        
+        /*
+        Writes the transcription of the syllable into a caller-provided buffer.
+        No null terminator is written, and nothing is written past capacity 
+        bytes.
+        
+        Parameters:
+          buffer:   The start of the buffer
+          capacity: The number of bytes available in buffer
+          encoding: The transcription system to be used
+        
+        Returns the full length of the transcription in bytes.  If this is 
+        greater than capacity, the transcription was cut off.
+        */
+      
+      template <class OutputIterator>
+      OutputIterator encode(OutputIterator output, 
+                            PhoneticEncoding encoding = lang::x_sampa) const;
+        
+        /*
+        Writes the transcription of the syllable to an output iterator over 
+        chars, one phone at a time.
+        
+        Parameters:
+          output:   The iterator to which the transcription will be written
+          encoding: The transcription system to be used
+        
+        Returns the iterator past the last byte written.
+        */
+    
+  };
+  
+  class ThreadPool {
+    
+    /*
+    This class runs loops over many independent items on a fixed set of 
+    threads.  The calling thread works alongside the pool's threads, and the 
+    items are handed out in chunks from a shared atomic counter, so threads 
+    that finish early simply take more chunks.  One loop runs at a time; 
+    concurrent calls to run() wait their turn.  A task may itself call run() 
+    on the same pool, in which case the nested loop runs entirely on the 
+    thread that called it.
+    */
+    
+    protected:
+      
+      std::vector<std::thread> _workers;
+        
+        /*
+        The threads owned by the pool, not including the calling thread
+        */
+      
+      std::mutex _mutex;
+        
+        /*
+        Guards the fields describing the current loop
+        */
+      
+      std::mutex _run_mutex;
+        
+        /*
+        Makes sure only one loop runs at a time
+        */
+      
+      std::condition_variable _started;
+        
+        /*
+        Signaled when a loop starts or the pool is stopping
+        */
+      
+      std::condition_variable _finished;
+        
+        /*
+        Signaled when the last worker finishes its part of a loop
+        */
+      
+      const std::function<void(int, int)>* _task;
+      
+      int _count;
+      
+      int _grain;
+        
+        /*
+        The current loop's task, number of items, and chunk size
+        */
+      
+      std::atomic<int> _next;
+        
+        /*
+        The first item that has not been handed out yet
+        */
+      
+      int _active;
+        
+        /*
+        The number of workers still working on the current loop
+        */
+      
+      long _generation;
+        
+        /*
+        Incremented each time a loop starts, so that workers can tell a new 
+        loop from one they have already worked on
+        */
+      
+      bool _stopping;
+      
+      std::exception_ptr _error;
+        
+        /*
+        The first exception thrown by the task in the current loop
+        */
+      
+      void work();
+        
+        /*
+        The main loop of each worker thread
+        */
+      
+      void share();
+        
+        /*
+        Takes chunks of the current loop until there are none left.
+        */
+    
+    public:
+      
+      ~ThreadPool();
+        
+        /*
+        Destructor
+        
+        Waits for the worker threads to exit.
+        */
+      
+      ThreadPool(int threads = 0);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          threads: The number of threads that will work on each loop, 
+                    including the calling thread.  If 0, the number of 
+                    hardware threads is used.
+        
+        Exceptions:
+          expt::ValueError: Thrown if threads is negative.
+        */
+      
+      ThreadPool(const ThreadPool& original) = delete;
+      
+      ThreadPool& operator=(const ThreadPool& other) = delete;
+        
+        /*
+        Thread pools cannot be copied.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of threads that work on each loop, including the 
+        calling thread.
+        */
+      
+      void run(int count, const std::function<void(int, int)>& task, 
+               int grain = 0);
+        
+        /*
+        Calls task on consecutive ranges of the items [0, count) until all of 
+        them have been covered, and returns once every call has finished.
+        
+        Parameters:
+          count:  The number of items
+          task:   Called with the start and end of a range of items.  Calls 
+                  may run concurrently.
+          grain:  The number of items in each range.  If 0, one is chosen from
+                  count and the number of threads.
+        
+        Exceptions:
+          Rethrows the first exception thrown by task, after the loop has 
+          stopped.  Ranges that had not started by then are skipped.
+        */
+    
+  };
+  
+  class Decoder {
+    
+    /*
+    This class decodes phonetic transcriptions into Syllables.  It works in a 
+    single pass over the transcription, matching the longest symbol at each 
+    position using lookup tables built from the library's constant symbol 
+    tables, and builds the Syllable in place without any intermediate strings.
+    
+    Failures are reported by byte offset.  The non-throwing decode() returns 
+    the offset, and the throwing version only creates a DecodingFailed when the
+    transcription is actually invalid.
+    
+    A phone is a base symbol followed by any number of diacritics.  Consonants 
+    before the first vowel form the onset, the following vowels (or consonants 
+    marked as syllabic) form the nucleus, and the remaining consonants form the
+    coda.  Tone marks may appear anywhere and are collected into the 
+    syllable's tone, and stress marks are allowed (and ignored) at the start.
+    
+    Decoders hold no state while decoding, so one can be shared between 
+    threads.
+    */
+    
+    protected:
+      
+      PhoneticEncoding _encoding;
+        
+        /*
+        The transcription system this decoder reads
+        */
+      
+      bool append(uint64_t code, bool syllabic, int& phase, 
+                  Syllable& syllable) const;
+        
+        /*
+        Appends a decoded phone to the end of syllable, in the onset, nucleus, 
+        or coda depending on phase.
+        
+        Parameters:
+          code:     The phone as a raw PhoneCode
+          syllabic: Whether the phone was marked as syllabic
+          phase:    0 while in the onset, 1 in the nucleus, and 2 in the coda. 
+                    Updated to the part of the syllable the phone was placed 
+                    in.
+          syllable: The Syllable being decoded
+        
+        Returns false if the phone is impossible or cannot be placed after the 
+        phones already in syllable.
+        */
+      
+      int parse(const char* transcription, int length, 
+                Syllable& syllable) const;
+        
+        /*
+        Does the work of the non-throwing decode(), except that syllable is 
+        left holding whatever had been read when decoding fails.
+        */
+    
+    public:
+      
+      ~Decoder();
+        
+        /*
+        Destructor
+        */
+      
+      Decoder(PhoneticEncoding encoding = lang::x_sampa);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          encoding: The transcription system to be decoded
+        */
+      
+      Decoder(const Decoder& original);
+        
+        /*
+        Copy constructor
+        
+        Parameters:
+          original: Other Decoder to be copied
+        */
+      
+      Decoder& operator=(const Decoder& other);
+        
+        /*
+        Standard field-wise assignment
+        */
+      
+      PhoneticEncoding encoding() const;
+        
+        /*
+        Returns the transcription system this decoder reads.
+        */
+      
+      void set_encoding(PhoneticEncoding new_encoding);
+        
+        /*
+        Sets the transcription system this decoder reads.
+        
+        Parameters:
+          new_encoding: The new transcription system
+        */
+      
+      int decode(const char* transcription, int length, 
+                 Syllable& syllable) const;
+        
+        /*
+        Decodes a transcription of a single syllable into syllable without 
+        throwing.
+        
+        Parameters:
+          transcription:  The transcription to be decoded.  May be enclosed in 
+                          square brackets.  Does not need to be null-
+                          terminated.
+          length:         The length of the transcription in bytes
+          syllable:       The Syllable that will be replaced by the result.  
+                          If decoding fails, it is left as the default 
+                          syllable, a single Schwa with no tone.
+        
+        Returns -1 if decoding succeeded, or the byte offset at which it failed
+        otherwise.
+        */
+      
+      Syllable decode(const std::string& transcription) const;
+        
+        /*
+        Decodes a transcription of a single syllable.
+        
+        Parameters:
+          transcription: The transcription to be decoded.  May be enclosed in 
+                          square brackets.
+        
+        Exceptions:
+          DecodingFailed: Thrown if transcription cannot be recognized as a 
+                          single valid syllable.  The exception records the 
+                          byte offset at which decoding failed.
+        */
+      
+      int decode(const char* const* transcriptions, const int* lengths, 
+                 int count, Syllable* syllables, int* failures, 
+                 ThreadPool& pool) const;
+        
+        /*
+        Decodes many transcriptions in parallel without throwing.
+        
+        Parameters:
+          transcriptions: The transcriptions to be decoded.  Do not need to be 
+                          null-terminated.
+          lengths:        The length in bytes of each transcription
+          count:          The number of transcriptions
+          syllables:      Receives the result for each transcription, in the 
+                          same order.  Transcriptions that fail leave a default
+                          Syllable.
+          failures:       Receives -1 for each transcription that was decoded, 
+                          or the byte offset at which it failed
+          pool:           The threads to decode with
+        
+        Returns the number of transcriptions that failed.
+        */
+      
+      int decode(const std::vector<std::string>& transcriptions, 
+                 std::vector<Syllable>& syllables, std::vector<int>& failures, 
+                 ThreadPool& pool) const;
+        
+        /*
+        Decodes many transcriptions in parallel without throwing.
+        
+        Parameters:
+          transcriptions: The transcriptions to be decoded
+          syllables:      Resized to hold the result for each transcription, 
+                          in the same order.  Transcriptions that fail leave a 
+                          default Syllable.
+          failures:       Resized to hold -1 for each transcription that was 
+                          decoded, or the byte offset at which it failed.  A 
+                          DecodingFailed can be made from each offset.
+          pool:           The threads to decode with
+        
+        Returns the number of transcriptions that failed.
+        */
+    
+  };
+  
+  class Transcoder {
+    
+    /*
+    This class converts transcriptions from one phonetic encoding to another.  
+    Transcriptions are separated by whitespace, which is copied through 
+    unchanged, and each one may be enclosed in square brackets.
+    
+    When every symbol in a transcription has an exact equivalent in the target
+    encoding, the symbols are translated one for one without building a 
+    Syllable.  The syllable structure and the articulation of each phone are 
+    checked just as a Decoder would check them.  Anything else is decoded into 
+    a Syllable and encoded again, which picks the closest symbols available in 
+    the target encoding.
+    
+    Streams are processed in a pipeline: one thread reads chunks of the input,
+    the calling thread transcodes them, and another thread writes the results.
+    */
+    
+    protected:
+      
+      PhoneticEncoding _source;
+        
+        /*
+        The encoding of the transcriptions being read
+        */
+      
+      PhoneticEncoding _target;
+        
+        /*
+        The encoding of the transcriptions being written
+        */
+      
+      int _chunk_size;
+        
+        /*
+        The number of bytes read from a stream at a time
+        */
+      
+      int translate(const char* transcription, int length, 
+                    std::string& output) const;
+        
+        /*
+        Translates a transcription symbol by symbol and appends it to output.
+        
+        Returns -1 if the translation succeeded, -2 if some symbol has no exact
+        equivalent in the target encoding (in which case output may have been 
+        partly written), or the byte offset at which the transcription is 
+        invalid.
+        */
+    
+    public:
+      
+      static const int default_chunk_size = 1 << 20;
+        
+        /*
+        The default number of bytes read from a stream at a time
+        */
+      
+      ~Transcoder();
+        
+        /*
+        Destructor
+        */
+      
+      Transcoder(PhoneticEncoding source, PhoneticEncoding target, 
+                 int chunk_size = default_chunk_size);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          source:     The encoding of the transcriptions being read
+          target:     The encoding of the transcriptions being written
+          chunk_size: The number of bytes read from a stream at a time
+        
+        Exceptions:
+          expt::ValueError: Thrown if chunk_size is not positive.
+        */
+      
+      Transcoder(const Transcoder& original);
+        
+        /*
+        Copy constructor
+        
+        Parameters:
+          original: Other Transcoder to be copied
+        */
+      
+      Transcoder& operator=(const Transcoder& other);
+        
+        /*
+        Standard field-wise assignment
+        */
+      
+      PhoneticEncoding source() const;
+        
+        /*
+        Returns the encoding of the transcriptions being read.
+        */
+      
+      PhoneticEncoding target() const;
+        
+        /*
+        Returns the encoding of the transcriptions being written.
+        */
+      
+      int transcode(const char* transcription, int length, 
+                    std::string& output) const;
+        
+        /*
+        Transcodes a single transcription without throwing and appends the 
+        result to output.  Square brackets are kept if present.
+        
+        Parameters:
+          transcription:  The transcription to be transcoded.  Does not need to
+                          be null-terminated.
+          length:         The length of the transcription in bytes
+          output:         The string to which the result will be appended.  
+                          Left as it was if transcoding fails.
+        
+        Returns -1 if transcoding succeeded, or the byte offset at which it 
+        failed otherwise.
+        */
+      
+      std::string transcode(const std::string& transcription) const;
+        
+        /*
+        Transcodes a single transcription.
+        
+        Parameters:
+          transcription: The transcription to be transcoded
+        
+        Exceptions:
+          DecodingFailed: Thrown if transcription cannot be decoded.
+        */
+      
+      long long transcode(std::istream& input, std::ostream& output) const;
+        
+        /*
+        Transcodes every transcription in input, writing them with the same 
+        whitespace to output.
+        
+        Parameters:
+          input:  The stream to read from until it is exhausted
+          output: The stream to write to
+        
+        Returns the number of bytes read.
+        
+        Exceptions:
+          DecodingFailed: Thrown if a transcription cannot be decoded.  The 
+                          position is the offset in input of the failing byte,
+                          and everything before the failing transcription's 
+                          chunk has been written.
+          Exception:      Thrown if input cannot be read or output cannot be 
+                          written.  An exception thrown by either stream is 
+                          rethrown as it is, after both threads have stopped.
+        */
+    
+  };
+  
+  typedef std::vector<Syllable> PhoneticSequence;
+  
+  template <class T>
+  class ArenaAllocator {
+    
+    /*
+    This class is a standard allocator that takes its memory from an Arena.  
+    Deallocation does nothing; the memory is reclaimed when the arena is 
+    released.  Allocators are equal if they share an arena.
+    */
+    
+    template <class U> friend class ArenaAllocator;
+    
+    protected:
+      
+      Arena* _arena;
+    
+    public:
+      
+      typedef T value_type;
+      
+      ArenaAllocator(Arena& arena) noexcept;
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          arena: The arena to allocate from.  It must outlive every container 
+                 using the allocator.
+        */
+      
+      template <class U>
+      ArenaAllocator(const ArenaAllocator<U>& original) noexcept;
+        
+        /*
+        Rebinding constructor, used by containers to allocate their internal 
+        types from the same arena
+        */
+      
+      T* allocate(std::size_t count);
+      
+      void deallocate(T* pointer, std::size_t count) noexcept;
+      
+      Arena& arena() const noexcept;
+      
+      template <class U>
+      bool operator==(const ArenaAllocator<U>& other) const noexcept;
+      
+      template <class U>
+      bool operator!=(const ArenaAllocator<U>& other) const noexcept;
+    
+  };
+  
+  typedef std::vector<Syllable, ArenaAllocator<Syllable> > ArenaSequence;
+    
+    /*
+    A PhoneticSequence whose buffer is stored in an Arena.  The syllables 
+    themselves allocate from the heap unless they are constructed with an 
+    arena too.
+    
+    encode, tone_histogram, write_corpus, ColumnarSequence and Aligner take 
+    an ArenaSequence as it is.  Anything else that needs a PhoneticSequence 
+    needs a copy, PhoneticSequence(sequence.begin(), sequence.end()), which 
+    copies every syllable out of the arena.
+    
+    Destroying an ArenaSequence still runs the destructor of every syllable, 
+    in time linear in its length, as for any std::vector.  The destructors 
+    cannot be skipped: a syllable owns its materialized phones, which are on 
+    the heap, and its phones too if it was not given the arena, and those 
+    would leak.  For a syllable that owns neither, the destructor is two 
+    null checks.
+    */
+  
+  class SyllableView {
+    
+    /*
+    This class gives read-only access to a syllable stored in a binary corpus
+    (see CorpusView) without copying it.  Phones are read as PhoneCodes, 
+    straight from the corpus's storage.  A SyllableView is only valid while 
+    the CorpusView it came from is.
+    */
+    
+    protected:
+      
+      const unsigned char* _record;
+        
+        /*
+        The syllable's record in the corpus
+        */
+      
+      const PhoneCode* _phones;
+        
+        /*
+        The syllable's first phone in the corpus
+        */
+      
+      int _onset_size;
+      
+      int _nucleus_size;
+      
+      int _coda_size;
+        
+        /*
+        The sizes of the parts of the syllable, copied out of the record
+        */
+    
+    public:
+      
+      ~SyllableView();
+        
+        /*
+        Destructor
+        */
+      
+      SyllableView(const unsigned char* record, const PhoneCode* phones);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          record: The syllable's record in a corpus
+          phones: The start of the corpus's phones
+        */
+      
+      SyllableView(const SyllableView& original);
+        
+        /*
+        Copy constructor
+        
+        Parameters:
+          original: Other SyllableView to be copied
+        */
+      
+      SyllableView& operator=(const SyllableView& other);
+        
+        /*
+        Standard field-wise assignment
+        */
+      
+      PhoneCode operator[](int index) const;
+        
+        /*
+        Returns the phone at the given index of the whole syllable.  Negative 
+        indices count from the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      int size() const;
+      
+      int onset_size() const;
+      
+      int nucleus_size() const;
+      
+      int coda_size() const;
+        
+        /*
+        Return the number of phones in the whole syllable and in each part.
+        */
+      
+      PhoneCode onset(int index) const;
+      
+      PhoneCode nucleus(int index) const;
+      
+      PhoneCode coda(int index) const;
+        
+        /*
+        Return the phone at the given index of the onset, nucleus or coda.  
+        Negative indices count from the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      const PhoneCode* phones() const;
+        
+        /*
+        Returns the start of the syllable's size() phones, in order.
+        */
+      
+      Tone tone() const;
+        
+        /*
+        Returns the tone of the syllable.
+        */
+      
+      Syllable syllable() const;
+        
+        /*
+        Returns a copy of the syllable as an ordinary Syllable.
+        */
+    
+  };
+  
+  class CorpusView {
+    
+    /*
+    This class reads a PhoneticSequence stored in the library's binary corpus 
+    format, as written by write_corpus(), without decoding it.  Files are 
+    memory-mapped where the platform allows it, so opening a corpus only 
+    reads the pages that are actually used.
+    
+    The format is a 32-byte header, one 16-byte record per syllable, and one 
+    8-byte PhoneCode per phone.  Numbers are in the byte order of the machine 
+    that wrote the file, which is checked when the file is opened.
+      
+      header:   "LANGCRP" and a null byte, the format version (4 bytes), the 
+                byte order mark 0x01020304 (4 bytes), the number of syllables 
+                (8 bytes), and the number of phones (8 bytes)
+      record:   The index of the syllable's first phone (4 bytes), the onset, 
+                nucleus and coda sizes (2 bytes each), the three tone levels 
+                (1 signed byte each), and three bytes of padding
+    
+    Opening a corpus checks the header and every record, which is enough to 
+    keep every view within the corpus, but it does not read the phones.  The 
+    phones are trusted to be ones written by write_corpus(): the rest of the 
+    library assumes a PhoneCode is articulable, so a corpus from an untrusted 
+    source should be opened with check_phones.
+    */
+    
+    protected:
+      
+      const unsigned char* _data;
+        
+        /*
+        The start of the corpus in memory
+        */
+      
+      std::size_t _length;
+        
+        /*
+        The length of the corpus in bytes
+        */
+      
+      void* _mapping;
+        
+        /*
+        The memory mapping of the corpus file, or null if the corpus is not 
+        memory-mapped
+        */
+      
+      std::vector<unsigned char> _buffer;
+        
+        /*
+        A copy of the file for platforms without memory mapping
+        */
+      
+      int _size;
+        
+        /*
+        The number of syllables in the corpus
+        */
+      
+      void load(const std::string& path, bool check_phones);
+        
+        /*
+        Maps or reads the corpus file at path and validates it, for the file 
+        constructors.
+        
+        Exceptions:
+          expt::Exception:  Thrown if the file cannot be opened or read.
+          expt::ValueError: Thrown if the file is not a valid corpus.
+        */
+      
+      void validate(bool check_phones);
+        
+        /*
+        Checks the header and every record, and sets _size.  Each syllable 
+        must lie within the phones, have a nucleus, and have a valid tone.
+        
+        Parameters:
+          check_phones: Whether to also check that every phone code is 
+                        articulable, which reads every phone in the corpus
+        
+        Exceptions:
+          expt::ValueError: Thrown if the data is not a valid corpus.
+        */
+    
+    public:
+      
+      static const int version = 1;
+        
+        /*
+        The version of the binary corpus format read and written by this 
+        library
+        */
+      
+      ~CorpusView();
+        
+        /*
+        Destructor
+        
+        Unmaps the corpus file if it was mapped.
+        */
+      
+      CorpusView(const std::string& path, bool check_phones = false);
+        
+        /*
+        File constructor
+        
+        Parameters:
+          path:         The path of a corpus file
+          check_phones: Whether to check every phone code as well as the 
+                        header and records
+        
+        Exceptions:
+          expt::Exception:  Thrown if the file cannot be opened or read.
+          expt::ValueError: Thrown if the file is not a valid corpus.
+        */
+      
+      CorpusView(const char* path, bool check_phones = false);
+        
+        /*
+        File constructor for null-terminated paths, so that a string literal 
+        path with check_phones given is not taken for the memory constructor.
+        Otherwise the same as the std::string version.
+        */
+      
+      CorpusView(const void* data, std::size_t length, 
+                 bool check_phones = false);
+        
+        /*
+        Memory constructor
+        
+        Parameters:
+          data:         A corpus already in memory, aligned to 8 bytes.  It is 
+                        not copied, and needs to outlive the CorpusView.
+          length:       The length of the corpus in bytes
+          check_phones: Whether to check every phone code as well as the 
+                        header and records
+        
+        Exceptions:
+          expt::ValueError: Thrown if the data is not a valid corpus.
+        */
+      
+      CorpusView(const CorpusView& original) = delete;
+      
+      CorpusView& operator=(const CorpusView& other) = delete;
+        
+        /*
+        Corpus views own their mapping and cannot be copied.
+        */
+      
+      SyllableView operator[](int index) const;
+        
+        /*
+        Returns the syllable at the given index.  Negative indices count from 
+        the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of syllables in the corpus.
+        */
+      
+      long long phone_count() const;
+        
+        /*
+        Returns the number of phones in the corpus.
+        */
+      
+      PhoneticSequence sequence() const;
+        
+        /*
+        Returns a copy of the whole corpus as ordinary Syllables.
+        */
+    
+  };
+  
+  class PhoneInventory {
+    
+    /*
+    This class interns phones, handing out a small integer ID for each 
+    distinct phone.  IDs start at 0 and are given out in the order in which 
+    phones are first seen, so that a corpus can store them in place of full 
+    phones and compare them as integers.  Each description is built once, 
+    when its phone is first interned.
+    
+    All of the member functions can be called from several threads at once. 
+    Interning and find() take a lock, but operator[], size() and 
+    description() only read memory that never moves once it is published, 
+    so lookups by ID never wait.  References returned by description() stay 
+    valid for the lifetime of the inventory.
+    */
+    
+    protected:
+      
+      struct Entry {
+        
+        PhoneCode code;
+        
+        std::string description;
+        
+      };
+        
+        /*
+        An interned phone together with its description
+        */
+      
+      static const int first_chunk = 64;
+      
+      static const int chunk_count = 25;
+        
+        /*
+        Entries are stored in chunks that double in size, the first holding 
+        first_chunk entries.  chunk_count chunks hold just under INT_MAX 
+        entries.
+        */
+      
+      std::unordered_map<uint64_t, int> _ids;
+        
+        /*
+        The ID of each interned phone, keyed by its raw PhoneCode
+        */
+      
+      std::atomic<Entry*> _chunks[chunk_count];
+        
+        /*
+        The interned phones, indexed by ID.  Chunks are allocated as they are 
+        needed and are never moved, and an entry is never changed once it 
+        has been written.
+        */
+      
+      std::atomic<int> _size;
+        
+        /*
+        The number of interned phones.  It is stored only after the newest 
+        entry has been written, so every ID below it can be read without the 
+        lock.
+        */
+      
+      mutable std::mutex _mutex;
+        
+        /*
+        Guards _ids and the writing of entries
+        */
+      
+      const Entry& entry(int id) const;
+        
+        /*
+        Returns the entry with the given ID.
+        
+        Exceptions:
+          expt::IndexError: Thrown if no phone has the given ID.
+        */
+    
+    public:
+      
+      ~PhoneInventory();
+        
+        /*
+        Destructor
+        */
+      
+      PhoneInventory();
+        
+        /*
+        Empty constructor
+        
+        This will produce an inventory with no phones.
+        */
+      
+      PhoneInventory(const PhoneInventory& original) = delete;
+      
+      PhoneInventory& operator=(const PhoneInventory& other) = delete;
+        
+        /*
+        Inventories hand out references to their contents and cannot be 
+        copied.
+        */
+      
+      static PhoneInventory& global();
+        
+        /*
+        Returns an inventory shared by the whole program.
+        */
+      
+      PhoneCode operator[](int id) const;
+        
+        /*
+        Returns the phone with the given ID.
+        
+        Exceptions:
+          expt::IndexError: Thrown if no phone has the given ID.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of phones interned so far.
+        */
+      
+      int intern(const PhoneCode& phone);
+      
+      int intern(const Phone& phone);
+        
+        /*
+        Returns the ID of phone, adding it to the inventory if necessary.
+        
+        Exceptions:
+          expt::ValueError: Thrown if phone is neither a Vowel nor a 
+                            Consonant, or if the inventory is full.
+        */
+      
+      void intern(const Syllable& syllable, std::vector<int>& ids);
+        
+        /*
+        Interns every phone in syllable and appends their IDs to ids, in order.
+        */
+      
+      int find(const PhoneCode& phone) const;
+        
+        /*
+        Returns the ID of phone, or -1 if it has not been interned.
+        */
+      
+      const std::string& description(int id) const;
+        
+        /*
+        Returns the description of the phone with the given ID.  See 
+        PhoneCode::description().
+        
+        Exceptions:
+          expt::IndexError: Thrown if no phone has the given ID.
+        */
+    
+  };
+  
+  class ColumnarSequence {
+    
+    /*
+    This class stores a PhoneticSequence as columns, one array per feature, 
+    so that questions about a whole sequence such as "how many voiceless 
+    velar stops are there" or "what is the mean vowel height" are answered by 
+    scanning a few contiguous arrays instead of visiting every Phone.  The 
+    scans use SSE2 where it is available.
+    
+    Phone columns have one entry per phone, with the phones of each syllable 
+    stored in order and the syllables one after another.  Features that a 
+    phone does not have hold a placeholder: manner and place are 
+    not_applicable for vowels, and height and backness are 0 for consonants. 
+    Every phone is also kept as a PhoneCode, so converting back to a 
+    PhoneticSequence is exact up to the quantization described in PhoneCode.
+    
+    Syllable columns have one entry per syllable: the index of its first 
+    phone, the sizes of its parts, and its tone.
+    */
+    
+    protected:
+      
+      std::vector<PhoneCode> _codes;
+      
+      std::vector<uint8_t> _phonations;
+      
+      std::vector<uint8_t> _manners;
+      
+      std::vector<uint8_t> _places;
+      
+      std::vector<float> _heights;
+      
+      std::vector<float> _backnesses;
+      
+      std::vector<float> _lengths;
+        
+        /*
+        The phone columns described above
+        */
+      
+      std::vector<int> _offsets;
+        
+        /*
+        The index of each syllable's first phone, followed by the number of 
+        phones, so that syllable i's phones are [_offsets[i], _offsets[i + 1])
+        */
+      
+      std::vector<uint16_t> _onset_sizes;
+      
+      std::vector<uint16_t> _nucleus_sizes;
+      
+      std::vector<ToneCode> _tones;
+        
+        /*
+        The syllable columns
+        */
+    
+    public:
+      
+      static const uint8_t not_applicable = 0xFF;
+        
+        /*
+        The value of the manner and place columns for vowels
+        */
+      
+      ~ColumnarSequence();
+        
+        /*
+        Destructor
+        */
+      
+      ColumnarSequence();
+        
+        /*
+        Empty constructor
+        
+        This will produce a sequence with no syllables.
+        */
+      
+      ColumnarSequence(const PhoneticSequence& sequence);
+      
+      ColumnarSequence(const ArenaSequence& sequence);
+        
+        /*
+        Conversion constructors
+        
+        Parameters:
+          sequence: The syllables to be stored
+        
+        Exceptions:
+          expt::ValueError: Thrown if a phone is neither a Vowel nor a 
+                            Consonant.
+        */
+      
+      void append(const Syllable& syllable);
+        
+        /*
+        Adds syllable to the end of the sequence.
+        
+        Exceptions:
+          expt::ValueError: Thrown if a phone is neither a Vowel nor a 
+                            Consonant.
+        */
+      
+      void reserve(int syllables, long long phones);
+        
+        /*
+        Makes room for the given numbers of syllables and phones.
+        */
+      
+      void clear();
+        
+        /*
+        Removes every syllable.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of syllables.
+        */
+      
+      long long phone_count() const;
+        
+        /*
+        Returns the number of phones.
+        */
+      
+      void set(long long index, PhoneCode phone);
+        
+        /*
+        Replaces the phone at the given index of the phone columns.  Negative 
+        indices count from the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      Syllable syllable(int index) const;
+        
+        /*
+        Returns a copy of the syllable at the given index.  Negative indices 
+        count from the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      PhoneticSequence sequence() const;
+        
+        /*
+        Returns a copy of the whole sequence as ordinary Syllables.
+        */
+      
+      long long count_vowels() const;
+        
+        /*
+        Returns the number of vowels.
+        */
+      
+      long long count(Phone::Phonation phonation) const;
+        
+        /*
+        Returns the number of phones with the given phonation.
+        */
+      
+      long long count(Consonant::Manner manner, Consonant::Place place) const;
+      
+      long long count(Consonant::Manner manner, Consonant::Place place, 
+                      Phone::Phonation phonation) const;
+        
+        /*
+        Return the number of consonants with the given manner and place, and 
+        optionally phonation.
+        */
+      
+      double mean_height() const;
+      
+      double mean_backness() const;
+        
+        /*
+        Return the mean height or backness of the vowels, or 0 if there are no
+        vowels.
+        */
+      
+      double total_length() const;
+        
+        /*
+        Returns the sum of the lengths of all of the phones.
+        */
+      
+      const PhoneCode* codes() const;
+      
+      const uint8_t* phonations() const;
+      
+      const uint8_t* manners() const;
+      
+      const uint8_t* places() const;
+      
+      const float* heights() const;
+      
+      const float* backnesses() const;
+      
+      const float* lengths() const;
+        
+        /*
+        Return the start of each phone column, phone_count() entries long, for 
+        scans that the member functions do not cover.  The pointers are 
+        invalidated by append, reserve, and clear.
+        */
+      
+      const int* offsets() const;
+        
+        /*
+        Returns the start of the offset column, size() + 1 entries long.
+        */
+      
+      const uint16_t* onset_sizes() const;
+      
+      const uint16_t* nucleus_sizes() const;
+        
+        /*
+        Return the start of each part size column, size() entries long.
+        */
+      
+      const ToneCode* tones() const;
+        
+        /*
+        Returns the start of the tone column, size() entries long.
+        */
+      
+      Tone tone(int index) const;
+        
+        /*
+        Returns the tone of the syllable at the given index.  Negative indices 
+        count from the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      void tone_histogram(long long counts[ToneCode::count]) const;
+        
+        /*
+        Adds the number of syllables with each tone to counts, which is indexed
+        by ToneCode code.  counts is not cleared first.
+        
+        Parameters:
+          counts: An array of ToneCode::count counts
+        */
+    
+  };
+  
+  class PhoneFeatures {
+    
+    /*
+    This class stores a batch of phones, such as an inventory, as columns of 
+    numeric features so that phonetic distances between them can be computed 
+    many at a time.  The kernels use AVX when the library is compiled with it 
+    enabled, SSE2 otherwise where it is available, and plain loops elsewhere; 
+    all of them give the same results as the scalar distance().
+    
+    Each phone is described by feature_count features, all between 0 and 1:
+      
+      0: consonantal, 0 for vowels and 1 for consonants
+      1: height divided by Vowel::close (vowels only)
+      2: backness divided by Vowel::back (vowels only)
+      3: rounded, 1 for exolabial and endolabial vowels
+      4: place divided by Consonant::glottal (consonants only)
+      5: manner divided by Consonant::nasal (consonants only)
+      6: phonation divided by Phone::strident
+      7: nasalization divided by Phone::strongly_nasal
+    
+    Features that a phone does not have are 0.  The distance between two 
+    phones is the Euclidean distance between their features, so it is 0 for 
+    identical features and at most the square root of feature_count.
+    */
+    
+    public:
+      
+      static const int feature_count = 8;
+    
+    protected:
+      
+      std::vector<PhoneCode> _phones;
+        
+        /*
+        The phones, in the order they were added
+        */
+      
+      std::vector<float> _columns[feature_count];
+        
+        /*
+        One column per feature, each with one entry per phone
+        */
+    
+    public:
+      
+      ~PhoneFeatures();
+        
+        /*
+        Destructor
+        */
+      
+      PhoneFeatures();
+        
+        /*
+        Empty constructor
+        
+        This will produce a batch with no phones.
+        */
+      
+      PhoneFeatures(const std::vector<PhoneCode>& phones);
+        
+        /*
+        Conversion constructor
+        
+        Parameters:
+          phones: The phones to be stored, in order
+        */
+      
+      static void features(const PhoneCode& phone, float* output);
+        
+        /*
+        Writes the feature_count features of phone to output.
+        */
+      
+      static float distance(const PhoneCode& phone1, const PhoneCode& phone2);
+        
+        /*
+        Returns the distance between two phones, one pair at a time.
+        */
+      
+      void append(const PhoneCode& phone);
+        
+        /*
+        Adds phone to the end of the batch.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of phones.
+        */
+      
+      PhoneCode operator[](int index) const;
+        
+        /*
+        Returns the phone at the given index.  Negative indices count from the 
+        end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      float distance(int index1, int index2) const;
+        
+        /*
+        Returns the distance between the phones at the given indices.  
+        Negative indices count from the end.
+        
+        Exceptions:
+          expt::IndexError: Thrown if either index is out of range.
+        */
+      
+      void distances(const PhoneCode& phone, float* output) const;
+      
+      void distances(int index, float* output) const;
+        
+        /*
+        Write the distance from phone, or from the phone at index, to every 
+        phone in the batch to output, which needs room for size() floats.
+        
+        Exceptions:
+          expt::IndexError: Thrown if index is out of range.
+        */
+      
+      void distance_matrix(float* output) const;
+      
+      void distance_matrix(float* output, ThreadPool& pool) const;
+        
+        /*
+        Write the distance between every pair of phones to output, which needs 
+        room for size() * size() floats.  Row i holds the distances from phone 
+        i, and the rows can be shared out among the threads of pool.
+        */
+    
+  };
+  
+  class Aligner {
+    
+    /*
+    This class aligns two strings of phones, such as a dictionary 
+    pronunciation and an observed one, by weighted edit distance 
+    (Needleman-Wunsch).  Inserting or deleting a phone costs gap_cost(), and 
+    substituting one phone for another costs substitution_weight() times the 
+    PhoneFeatures distance between them, so that near misses such as [k] for 
+    [g] cost less than [k] for [a].  Identical phones cost nothing.
+    
+    Sequences are aligned phone by phone across syllable boundaries.  Phone 
+    indices for a PhoneticSequence count through all of its syllables in 
+    order.
+    
+    An Aligner holds no state besides its costs, so one can be used from 
+    several threads at once.
+    */
+    
+    public:
+      
+      struct Step {
+        
+        /*
+        One column of an alignment: the index of a phone in each string that 
+        are aligned with each other, with -1 on the side of a gap.
+        */
+        
+        int first;
+        
+        int second;
+        
+      };
+    
+    protected:
+      
+      float _gap_cost;
+      
+      float _substitution_weight;
+        
+        /*
+        The costs described above
+        */
+    
+    public:
+      
+      ~Aligner();
+        
+        /*
+        Destructor
+        */
+      
+      Aligner(float gap_cost = 1, float substitution_weight = 1);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          gap_cost:            The cost of inserting or deleting one phone
+          substitution_weight: The cost of substituting one phone for another,
+                               per unit of feature distance
+        
+        Exceptions:
+          expt::ValueError: Thrown if gap_cost is not positive or 
+                            substitution_weight is negative.
+        */
+      
+      float gap_cost() const;
+      
+      float substitution_weight() const;
+        
+        /*
+        Return the costs that the aligner was constructed with.
+        */
+      
+      float substitution_cost(const PhoneCode& phone1, 
+                              const PhoneCode& phone2) const;
+        
+        /*
+        Returns the cost of aligning phone1 with phone2.
+        */
+      
+      float distance(const PhoneCode* first, int first_size, 
+                     const PhoneCode* second, int second_size, 
+                     int band = -1) const;
+      
+      float distance(const PhoneticSequence& first, 
+                     const PhoneticSequence& second, int band = -1) const;
+      
+      float distance(const ArenaSequence& first, const ArenaSequence& second, 
+                     int band = -1) const;
+        
+        /*
+        Return the cost of the cheapest alignment of first with second, using 
+        two rows of the alignment matrix at a time.
+        
+        Parameters:
+          first:       The first string of phones
+          first_size:  The number of phones in first
+          second:      The second string of phones
+          second_size: The number of phones in second
+          band:        If not negative, only alignments that never get more 
+                       than band phones further through one string than the 
+                       other are considered, which takes time proportional to
+                       band rather than to the length of second.  If no such 
+                       alignment exists, infinity is returned.
+        */
+      
+      float align(const PhoneCode* first, int first_size, 
+                  const PhoneCode* second, int second_size, 
+                  std::vector<Step>& steps) const;
+      
+      float align(const PhoneticSequence& first, 
+                  const PhoneticSequence& second, 
+                  std::vector<Step>& steps) const;
+      
+      float align(const ArenaSequence& first, const ArenaSequence& second, 
+                  std::vector<Step>& steps) const;
+        
+        /*
+        Like distance, but also replaces the contents of steps with the 
+        cheapest alignment itself, in order.  This keeps the whole alignment 
+        matrix, so it takes memory proportional to the product of the lengths.
+        
+        Returns the cost of the alignment.
+        */
+      
+      static int edit_distance(const PhoneCode* first, int first_size, 
+                               const PhoneCode* second, int second_size);
+      
+      static int edit_distance(const PhoneticSequence& first, 
+                               const PhoneticSequence& second);
+      
+      static int edit_distance(const ArenaSequence& first, 
+                               const ArenaSequence& second);
+        
+        /*
+        Return the unweighted Levenshtein distance between first and second, 
+        in which every insertion, deletion and substitution costs 1.  If 
+        either string has at most 64 phones, this uses Myers' bit-parallel 
+        algorithm, which handles a whole column of the alignment matrix in a 
+        few word operations.
+        */
+      
+      void distances(const std::vector<PhoneticSequence>& first, 
+                     const std::vector<PhoneticSequence>& second, 
+                     float* output, ThreadPool& pool, int band = -1) const;
+        
+        /*
+        Writes the distance between first[i] and second[i] to output[i] for 
+        every i, sharing the pairs out among the threads of pool.
+        
+        Exceptions:
+          expt::ValueError: Thrown if first and second are not the same size.
+        */
+    
+  };
+  
+  class SyllableIndex {
+    
+    /*
+    This class counts the distinct syllables (types) in a stream of syllables 
+    (tokens), giving each type a small integer ID in the order in which it is 
+    first seen.  Types are found in an open-addressed hash table keyed by 
+    Syllable::hash(), so adding a token takes constant time and only copies 
+    the syllable the first time it is seen.
+    
+    A SyllableIndex is not thread-safe.
+    */
+    
+    protected:
+      
+      std::vector<int> _slots;
+        
+        /*
+        The hash table: the ID stored in each slot, or -1 for an empty slot.  
+        Its size is a power of two, and it is kept at most half full.
+        */
+      
+      std::vector<Syllable> _syllables;
+      
+      std::vector<std::size_t> _hashes;
+      
+      std::vector<long long> _counts;
+        
+        /*
+        The syllable, its hash, and its number of tokens for each ID
+        */
+      
+      long long _tokens;
+        
+        /*
+        The total number of tokens added
+        */
+      
+      int probe(const Syllable& syllable, std::size_t hash) const;
+        
+        /*
+        Returns the slot holding syllable, or the empty slot where it would go.
+        */
+      
+      void grow();
+        
+        /*
+        Doubles the size of the hash table.
+        */
+    
+    public:
+      
+      ~SyllableIndex();
+        
+        /*
+        Destructor
+        */
+      
+      SyllableIndex();
+        
+        /*
+        Empty constructor
+        
+        This will produce an index with no syllables.
+        */
+      
+      int add(const Syllable& syllable, long long count = 1);
+        
+        /*
+        Adds count tokens of syllable and returns its ID.
+        
+        Exceptions:
+          expt::ValueError: Thrown if count is negative.
+        */
+      
+      void add(const PhoneticSequence& sequence);
+        
+        /*
+        Adds one token of each syllable in sequence.
+        */
+      
+      int find(const Syllable& syllable) const;
+        
+        /*
+        Returns the ID of syllable, or -1 if it has not been added.
+        */
+      
+      const Syllable& operator[](int id) const;
+        
+        /*
+        Returns the syllable with the given ID.  The reference is invalidated 
+        by the next call to add.
+        
+        Exceptions:
+          expt::IndexError: Thrown if no syllable has the given ID.
+        */
+      
+      long long count(int id) const;
+        
+        /*
+        Returns the number of tokens of the syllable with the given ID.
+        
+        Exceptions:
+          expt::IndexError: Thrown if no syllable has the given ID.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of types.
+        */
+      
+      long long tokens() const;
+        
+        /*
+        Returns the number of tokens.
+        */
+      
+      void clear();
+        
+        /*
+        Removes every syllable.
+        */
+    
+  };
+  
+  class EncodingCache {
+    
+    /*
+    This class remembers the transcription of the syllable at each position 
+    of a sequence, in each encoding, so that re-encoding a sequence after a 
+    small edit only transcribes the syllables that changed.  Each entry keeps 
+    the stamp (see Syllable::stamp) of the syllable it was made from, so 
+    whether a syllable has changed is one comparison, with no hashing or 
+    comparing of phones.  A syllable that has been replaced, or changed 
+    through any member function of Syllable, misses the cache.  A change made 
+    through a phone reference or pointer obtained before the last encode is 
+    not seen until Syllable::touch is called on that syllable.
+    
+    The cache holds one entry per position in each encoding, so it is never 
+    larger than the longest sequence encoded since the last clear().
+    
+    An EncodingCache is not thread-safe.
+    */
+    
+    protected:
+      
+      std::vector<uint64_t> _stamps[3];
+        
+        /*
+        The stamp of the syllable last transcribed at each position in each 
+        encoding, or 0 if there is none.  No syllable has the stamp 0.
+        */
+      
+      std::vector<std::string> _transcriptions[3];
+        
+        /*
+        The transcription of the syllable last transcribed at each position in 
+        each encoding
+        */
+      
+      long long _misses;
+        
+        /*
+        The number of transcriptions made
+        */
+    
+    public:
+      
+      ~EncodingCache();
+        
+        /*
+        Destructor
+        */
+      
+      EncodingCache();
+        
+        /*
+        Empty constructor
+        
+        This will produce a cache with no entries.
+        */
+      
+      const std::string& encode(int position, const Syllable& syllable, 
+                                PhoneticEncoding encoding = lang::x_sampa);
+        
+        /*
+        Returns the same transcription as Syllable::encode, only transcribing 
+        syllable if it has changed since it, or the syllable it was copied 
+        from, was last encoded at position in the same encoding.  The 
+        reference is invalidated by the next call to encode or clear.
+        
+        Parameters:
+          position: The position of the syllable in its sequence
+          syllable: The syllable to be encoded
+          encoding: The transcription system to be used
+        
+        Exceptions:
+          expt::IndexError: Thrown if position is negative.
+        */
+      
+      void encode(const PhoneticSequence& sequence, std::string& output, 
+                  PhoneticEncoding encoding = lang::x_sampa, 
+                  char separator = ' ');
+        
+        /*
+        Appends the same text to output as lang::encode, using the cache for 
+        each syllable, and drops the entries past the end of the sequence in 
+        that encoding.
+        
+        Parameters:
+          sequence:  The syllables to be encoded
+          output:    The string to which the transcriptions will be appended
+          encoding:  The transcription system to be used
+          separator: The character placed between syllables
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of positions that the cache has entries for, in 
+        the encoding with the most.
+        */
+      
+      long long misses() const;
+        
+        /*
+        Returns the number of times a syllable has had to be transcribed.
+        */
+      
+      void clear();
+        
+        /*
+        Removes every entry.
+        */
+    
+  };
+  
+  class Lexicon {
+    
+    /*
+    This class maps words to their pronunciations, for a lexicon that is 
+    loaded once and then read by many threads.  All of the pronunciations are 
+    stored together in the binary corpus layout (see CorpusView) and are read 
+    through SyllableViews, so a lookup copies nothing and nothing it returns 
+    can change the lexicon.  Words are found in an open-addressed hash table.
+    
+    Words are added and then the lexicon is frozen.  Once freeze() has been 
+    called the lexicon cannot be changed, and any number of threads may call 
+    its const member functions at the same time without locking, since they 
+    only read.  Before then a Lexicon is not thread-safe.
+    */
+    
+    public:
+      
+      class Pronunciation {
+        
+        /*
+        A read-only view of the pronunciation of one word in a Lexicon.  It is 
+        only valid while the Lexicon it came from is, and until the next call 
+        to add.
+        */
+        
+        protected:
+          
+          const unsigned char* _records;
+            
+            /*
+            The record of the word's first syllable
+            */
+          
+          const PhoneCode* _phones;
+            
+            /*
+            The start of the lexicon's phones
+            */
+          
+          int _size;
+            
+            /*
+            The number of syllables in the pronunciation
+            */
+        
+        public:
+          
+          ~Pronunciation();
+            
+            /*
+            Destructor
+            */
+          
+          Pronunciation(const unsigned char* records, const PhoneCode* phones, 
+                        int size);
+            
+            /*
+            Standard constructor
+            
+            Parameters:
+              records: The record of the first syllable
+              phones:  The start of the lexicon's phones
+              size:    The number of syllables
+            */
+          
+          SyllableView operator[](int index) const;
+            
+            /*
+            Returns the syllable at the given index.  Negative indices count 
+            from the end.
+            
+            Exceptions:
+              expt::IndexError: Thrown if index is out of range.
+            */
+          
+          int size() const;
+            
+            /*
+            Returns the number of syllables in the pronunciation.
+            */
+          
+          PhoneticSequence sequence() const;
+            
+            /*
+            Returns a copy of the pronunciation as ordinary Syllables.
+            */
+        
+      };
+    
+    protected:
+      
+      std::vector<int> _slots;
+        
+        /*
+        The hash table: the ID stored in each slot, or -1 for an empty slot.  
+        Its size is a power of two, and it is kept at most half full.
+        */
+      
+      std::string _words;
+        
+        /*
+        Every word, one after another
+        */
+      
+      std::vector<std::size_t> _word_offsets;
+        
+        /*
+        Where each word starts in _words, followed by the length of _words, so 
+        that word i is [_word_offsets[i], _word_offsets[i + 1])
+        */
+      
+      std::vector<std::size_t> _hashes;
+        
+        /*
+        The hash of each word
+        */
+      
+      std::vector<int> _syllable_offsets;
+        
+        /*
+        The index of each word's first syllable, followed by the number of 
+        syllables, in the same way as _word_offsets
+        */
+      
+      std::vector<unsigned char> _records;
+        
+        /*
+        One 16-byte binary corpus record per syllable
+        */
+      
+      std::vector<PhoneCode> _phones;
+        
+        /*
+        The phones of every syllable in order
+        */
+      
+      bool _frozen;
+        
+        /*
+        Whether freeze() has been called
+        */
+      
+      int probe(const std::string& word, std::size_t hash) const;
+        
+        /*
+        Returns the slot holding word, or the empty slot where it would go.
+        */
+      
+      void grow();
+        
+        /*
+        Doubles the size of the hash table.
+        */
+    
+    public:
+      
+      ~Lexicon();
+        
+        /*
+        Destructor
+        */
+      
+      Lexicon();
+        
+        /*
+        Empty constructor
+        
+        This will produce a lexicon with no words that is not frozen.
+        */
+      
+      int add(const std::string& word, const PhoneticSequence& pronunciation);
+        
+        /*
+        Adds a word and its pronunciation and returns the word's ID.  IDs are 
+        given out in order from 0.
+        
+        Exceptions:
+          expt::ValueError: Thrown if the lexicon is frozen, if word is already
+                            in it, if a syllable has more than 65535 phones in 
+                            some part, or if the lexicon would have more than 
+                            2^32 - 1 phones.
+        */
+      
+      void freeze();
+        
+        /*
+        Makes the lexicon read-only, so that it can be shared between threads.  
+        Nothing is moved, so Pronunciations taken before the call stay valid.
+        */
+      
+      bool frozen() const;
+        
+        /*
+        Returns true if freeze() has been called.
+        */
+      
+      int find(const std::string& word) const;
+        
+        /*
+        Returns the ID of word, or -1 if it is not in the lexicon.
+        */
+      
+      Pronunciation operator[](int id) const;
+        
+        /*
+        Returns the pronunciation of the word with the given ID.
+        
+        Exceptions:
+          expt::IndexError: Thrown if no word has the given ID.
+        */
+      
+      std::string word(int id) const;
+        
+        /*
+        Returns the word with the given ID.
+        
+        Exceptions:
+          expt::IndexError: Thrown if no word has the given ID.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of words.
+        */
+      
+      long long phone_count() const;
+        
+        /*
+        Returns the number of phones in all of the pronunciations.
+        */
+    
+  };
+  
+  class NgramCounter {
+    
+    /*
+    This class gathers phonotactic statistics: how often each n-gram of phones
+    occurs within the onsets, nuclei, and codas of a corpus, from single phones
+    up to n-grams of order() phones, and how often each tone occurs.  Each 
+    part is padded with a boundary at either end, so that the n-grams also say
+    which phones begin and end a part, and an empty part is counted as a pair 
+    of boundaries.
+    
+    Phones are identified by their IDs in a PhoneInventory, and an n-gram is 
+    looked up by packing its IDs into one integer.  Each counter remembers the
+    IDs it has already asked for, so the inventory is only locked the first 
+    time a counter sees each phone.  Large corpora can be counted on a 
+    ThreadPool, in which case each thread counts its own share of the corpus 
+    into a separate table and the tables are merged at the end.
+    
+    An NgramCounter is not thread-safe.
+    */
+    
+    public:
+      
+      static const int max_order = 4;
+        
+        /*
+        The longest n-grams that can be counted
+        */
+      
+      static const int boundary = -1;
+        
+        /*
+        The ID that stands for the edge of a part in n-grams
+        */
+    
+    protected:
+      
+      int _order;
+        
+        /*
+        The longest n-grams counted
+        */
+      
+      PhoneInventory* _inventory;
+        
+        /*
+        The inventory that gives phones their IDs
+        */
+      
+      std::unordered_map<uint64_t, int> _ids;
+        
+        /*
+        The IDs already looked up in _inventory, keyed by raw PhoneCode
+        */
+      
+      std::unordered_map<uint64_t, long long> _counts[3];
+        
+        /*
+        The count of each n-gram in each Syllable::Part.  The key of an n-gram 
+        holds each ID plus 1 in 16 bits, with the first phone in the lowest 
+        bits, and the boundary as 0xFFFF.
+        */
+      
+      long long _totals[3][max_order];
+        
+        /*
+        The number of n-grams of each length counted in each part
+        */
+      
+      long long _tones[ToneCode::count];
+        
+        /*
+        The number of syllables with each tone, indexed by ToneCode code
+        */
+      
+      long long _syllables;
+        
+        /*
+        The number of syllables counted
+        */
+      
+      std::vector<int> _buffer;
+        
+        /*
+        Space for the IDs of one syllable's phones
+        */
+      
+      int id(const PhoneCode& phone);
+        
+        /*
+        Returns the ID of phone, interning it if necessary.
+        
+        Exceptions:
+          expt::ValueError: Thrown if the inventory has too many phones for 
+                            n-gram keys.
+        */
+      
+      void count(int part, const int* ids, int size);
+        
+        /*
+        Counts the n-grams of one part, given the IDs of its phones.
+        */
+      
+      bool key(const std::vector<int>& ngram, uint64_t& result) const;
+        
+        /*
+        Packs ngram into a key.  Returns false if some ID cannot be in the 
+        table.
+        
+        Exceptions:
+          expt::ValueError: Thrown if ngram is empty or longer than order().
+        */
+    
+    public:
+      
+      ~NgramCounter();
+        
+        /*
+        Destructor
+        */
+      
+      NgramCounter(int order = 3, 
+                   PhoneInventory& inventory = PhoneInventory::global());
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          order:     The longest n-grams to be counted
+          inventory: The inventory that gives phones their IDs
+        
+        Exceptions:
+          expt::ValueError: Thrown if order is < 1 or > max_order.
+        */
+      
+      void add(const Syllable& syllable);
+      
+      void add(const SyllableView& syllable);
+        
+        /*
+        Count the n-grams and the tone of one syllable.
+        
+        Exceptions:
+          expt::ValueError: Thrown if the inventory has too many phones for 
+                            n-gram keys (more than 65534).
+        */
+      
+      void add(const PhoneticSequence& sequence);
+      
+      void add(const CorpusView& corpus);
+      
+      void add(const PhoneticSequence& sequence, ThreadPool& pool);
+      
+      void add(const CorpusView& corpus, ThreadPool& pool);
+        
+        /*
+        Count every syllable in a sequence or a binary corpus, optionally 
+        sharing the work between the threads of pool.
+        
+        Exceptions:
+          expt::ValueError: Thrown if the inventory has too many phones for 
+                            n-gram keys (more than 65534).
+        */
+      
+      void merge(const NgramCounter& other);
+        
+        /*
+        Adds all of other's counts to this counter's.
+        
+        Exceptions:
+          expt::ValueError: Thrown if other has a different order or 
+                            inventory.
+        */
+      
+      long long count(Syllable::Part part, const std::vector<int>& ngram) 
+        const;
+        
+        /*
+        Returns the number of times ngram occurred in the given part.
+        
+        Parameters:
+          part:  The part of the syllable
+          ngram: The IDs of the phones in order, with boundary for the edges 
+                 of the part
+        
+        Exceptions:
+          expt::ValueError: Thrown if ngram is empty or longer than order().
+        */
+      
+      long long total(Syllable::Part part, int length) const;
+        
+        /*
+        Returns the number of n-grams of the given length counted in the given
+        part.
+        
+        Exceptions:
+          expt::ValueError: Thrown if length is < 1 or > order().
+        */
+      
+      double probability(Syllable::Part part, const std::vector<int>& ngram) 
+        const;
+        
+        /*
+        Returns the probability of the last phone in ngram given the phones 
+        before it, as estimated from the counts, so that {boundary, id} gives 
+        the probability that the part starts with id, and {id, boundary} that
+        it ends there after id.  A single phone is given its share of all of 
+        the phones and boundaries in the part.  Returns 0 if the phones before
+        the last have never been followed by anything.
+        
+        Exceptions:
+          expt::ValueError: Thrown if ngram is empty or longer than order().
+        */
+      
+      long long tone_count(const ToneCode& tone) const;
+        
+        /*
+        Returns the number of syllables counted with the given tone.
+        */
+      
+      long long syllables() const;
+        
+        /*
+        Returns the number of syllables counted.
+        */
+      
+      int order() const;
+        
+        /*
+        Returns the longest n-grams counted.
+        */
+      
+      PhoneInventory& inventory() const;
+        
+        /*
+        Returns the inventory that gives phones their IDs.
+        */
+      
+      void clear();
+        
+        /*
+        Resets every count to 0.
+        */
+    
+  };
+  
+  class FeatureIndex {
+    
+    /*
+    This class is an inverted index over the features of a list of phones, 
+    such as an inventory or every phone in a corpus.  Each value of each 
+    enumerated feature has a Bitmap with one bit per phone, and vowels are 
+    also bucketed by whole steps of height and backness, so that queries such 
+    as "consonants with a velar or uvular place and a VOT of at least 
+    weakly_aspirated" are answered by combining bitmaps 64 phones at a time 
+    instead of decoding every phone:
+      
+      index.consonants() & 
+      (index.place(Consonant::velar) | index.place(Consonant::uvular)) & 
+      index.vot(Consonant::weakly_aspirated, Consonant::strongly_aspirated)
+    
+    The index is built once and cannot be changed.  Its const member 
+    functions can be called from several threads at once.
+    */
+    
+    public:
+      
+      class Bitmap {
+        
+        /*
+        A set of phones in a FeatureIndex, stored as one bit per phone.
+        */
+        
+        protected:
+          
+          std::vector<uint64_t> _words;
+            
+            /*
+            The bits, 64 to a word, with phone i at bit i % 64 of word i / 64.
+            Bits past _size are always clear.
+            */
+          
+          int _size;
+            
+            /*
+            The number of phones that the bitmap covers
+            */
+          
+          void check_size(const Bitmap& other) const;
+            
+            /*
+            Exceptions:
+              expt::ValueError: Thrown if other covers a different number of 
+                                phones.
+            */
+        
+        public:
+          
+          ~Bitmap();
+            
+            /*
+            Destructor
+            */
+          
+          Bitmap(int size = 0);
+            
+            /*
+            Standard constructor
+            
+            Parameters:
+              size: The number of phones that the bitmap covers.  Every bit 
+                    starts clear.
+            
+            Exceptions:
+              expt::ValueError: Thrown if size is negative.
+            */
+          
+          Bitmap& operator&=(const Bitmap& other);
+          
+          Bitmap& operator|=(const Bitmap& other);
+          
+          Bitmap operator&(const Bitmap& other) const;
+          
+          Bitmap operator|(const Bitmap& other) const;
+            
+            /*
+            Intersection and union
+            
+            Exceptions:
+              expt::ValueError: Thrown if the bitmaps cover different numbers 
+                                of phones.
+            */
+          
+          Bitmap operator~() const;
+            
+            /*
+            Returns the complement, every phone that is not in this bitmap.
+            */
+          
+          bool operator==(const Bitmap& other) const;
+            
+            /*
+            Bitmaps are equal if they cover the same phones and hold the same 
+            bits.
+            */
+          
+          bool operator!=(const Bitmap& other) const;
+            
+            /*
+            Bitmaps are equal if they cover the same phones and hold the same 
+            bits.
+            */
+          
+          bool operator[](int index) const;
+            
+            /*
+            Returns whether the phone at the given index is in the bitmap.
+            
+            Bounds checked.  Negative indices allowed.
+            
+            Exceptions:
+              expt::IndexError: Thrown if the bounds check fails.
+            */
+          
+          void set(int index);
+            
+            /*
+            Adds the phone at the given index to the bitmap.
+            
+            Bounds checked.  Negative indices allowed.
+            
+            Exceptions:
+              expt::IndexError: Thrown if the bounds check fails.
+            */
+          
+          int size() const;
+            
+            /*
+            Returns the number of phones that the bitmap covers.
+            */
+          
+          int count() const;
+            
+            /*
+            Returns the number of phones in the bitmap.
+            */
+          
+          void indices(std::vector<int>& output) const;
+            
+            /*
+            Appends the index of every phone in the bitmap to output, in 
+            increasing order.
+            */
+          
+          const uint64_t* words() const;
+            
+            /*
+            Returns the bits, (size() + 63) / 64 words long.
+            */
+        
+      };
+    
+    protected:
+      
+      std::vector<PhoneCode> _phones;
+        
+        /*
+        The phones, in order
+        */
+      
+      static const int phonations = Phone::strident + 1;
+      
+      static const int nasalizations = Phone::strongly_nasal + 1;
+      
+      static const int roundednesses = Vowel::endolabial + 1;
+      
+      static const int manners = Consonant::nasal + 1;
+      
+      static const int places = Consonant::glottal + 1;
+      
+      static const int vots = Consonant::strongly_aspirated + 1;
+      
+      static const int mechanisms = Consonant::implosive + 1;
+      
+      static const int heights = Vowel::close + 1;
+      
+      static const int backnesses = Vowel::back + 1;
+        
+        /*
+        The number of values of each feature, and so of bitmaps for it
+        */
+      
+      Bitmap _vowels;
+      
+      Bitmap _consonants;
+      
+      Bitmap _phonations[phonations];
+      
+      Bitmap _nasalizations[nasalizations];
+      
+      Bitmap _roundednesses[roundednesses];
+      
+      Bitmap _manners[manners];
+      
+      Bitmap _places[places];
+      
+      Bitmap _vots[vots];
+      
+      Bitmap _mechanisms[mechanisms];
+        
+        /*
+        One bitmap for each value of each feature, indexed by the value
+        */
+      
+      Bitmap _heights[heights];
+      
+      Bitmap _backnesses[backnesses];
+        
+        /*
+        The vowels with heights or backnesses from each whole step up to the 
+        next, with the top step on its own
+        */
+      
+      void build();
+        
+        /*
+        Fills in the bitmaps from _phones.
+        
+        Exceptions:
+          expt::ValueError: Thrown if any phone has a Phone::Violation.
+        */
+      
+      Bitmap range(const Bitmap* buckets, int bucket_count, float low, 
+                   float high, bool height) const;
+        
+        /*
+        Returns the vowels with heights (or backnesses) in [low, high], using 
+        whole buckets where they fit inside the range and checking phones one 
+        at a time in the buckets at its edges.
+        */
+    
+    public:
+      
+      ~FeatureIndex();
+        
+        /*
+        Destructor
+        */
+      
+      FeatureIndex(const PhoneCode* phones, int size);
+        
+        /*
+        Standard constructor
+        
+        Parameters:
+          phones: The phones to be indexed, which are copied
+          size:   The number of phones
+        
+        Exceptions:
+          expt::ValueError: Thrown if size is negative or any of the phones 
+                            has a Phone::Violation.
+        */
+      
+      FeatureIndex(const PhoneInventory& inventory);
+        
+        /*
+        Inventory constructor
+        
+        Indexes the phones interned so far, so that bit i is the phone with 
+        ID i.
+        
+        Parameters:
+          inventory: The inventory to be indexed
+        
+        Exceptions:
+          expt::ValueError: Thrown if any of the phones has a 
+                            Phone::Violation.
+        */
+      
+      FeatureIndex(const ColumnarSequence& sequence);
+        
+        /*
+        Sequence constructor
+        
+        Indexes every phone of the sequence, so that bit i is phone i of the 
+        phone columns.
+        
+        Parameters:
+          sequence: The sequence to be indexed
+        
+        Exceptions:
+          expt::ValueError: Thrown if the sequence has more than 2^31 - 1 
+                            phones or any of them has a Phone::Violation.
+        */
+      
+      PhoneCode operator[](int index) const;
+        
+        /*
+        Returns the phone at the given index.
+        
+        Bounds checked.  Negative indices allowed.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of phones indexed.
+        */
+      
+      const Bitmap& vowels() const;
+      
+      const Bitmap& consonants() const;
+      
+      const Bitmap& phonation(Phone::Phonation phonation) const;
+      
+      const Bitmap& nasalization(Phone::Nasalization nasalization) const;
+      
+      const Bitmap& roundedness(Vowel::Roundedness roundedness) const;
+      
+      const Bitmap& manner(Consonant::Manner manner) const;
+      
+      const Bitmap& place(Consonant::Place place) const;
+      
+      const Bitmap& vot(Consonant::VOT vot) const;
+      
+      const Bitmap& mechanism(Consonant::Mechanism mechanism) const;
+        
+        /*
+        Return the phones with the given feature.  Vowel features only 
+        include vowels and consonant features only include consonants.
+        
+        Exceptions:
+          expt::ValueError: Thrown if the value is not one of the enumeration.
+        */
+      
+      Bitmap place(Consonant::Place first, Consonant::Place last) const;
+      
+      Bitmap vot(Consonant::VOT first, Consonant::VOT last) const;
+        
+        /*
+        Return the consonants with a place or VOT from first to last, 
+        inclusive.  The range is empty if last is before first.
+        
+        Exceptions:
+          expt::ValueError: Thrown if first or last is not one of the 
+                            enumeration.
+        */
+      
+      Bitmap height(float low, float high) const;
+      
+      Bitmap backness(float low, float high) const;
+        
+        /*
+        Return the vowels with a height or backness from low to high, 
+        inclusive, as quantized by PhoneCode.
+        */
+    
+  };
+  
+  class SoundChange {
+    
+    /*
+    This class applies an ordered list of sound change rules, such as "raise 
+    front vowels by one height" or "aspirate voiceless stops in onsets", to a 
+    whole sequence in one pass.  Each Rule is a set of features to match and a
+    set of changes to make, and both work directly on the Slot or PhoneCode of
+    each phone, so applying a rule takes a few bit tests and no virtual calls.
+    What the rules do to each distinct phone in each part of a syllable is 
+    also remembered for the rest of a call to apply, so a large corpus, which
+    has only a few hundred distinct phones, costs about one table lookup per 
+    phone however many rules there are.
+    
+    The rules are applied to each phone in order, so a rule sees the phone as 
+    the rules before it left it.  A change that would make a phone 
+    impossible is not made.  The phone is left as it was before that rule, 
+    the rejection is reported, and the remaining rules carry on.
+    */
+    
+    public:
+      
+      class Rule {
+        
+        /*
+        One sound change.  A new Rule matches every phone and changes nothing.
+        Each match_ function narrows the phones that the rule matches.  
+        Calling one several times for the same feature matches any of the 
+        values given, and different features must all match.  Vowel features 
+        only match vowels and consonant features only match consonants.
+        
+        The changes mirror the mutators of Phone, Vowel, and Consonant, but 
+        instead of changing a phone they record what should be done to every 
+        phone that matches.  Vowel changes are ignored for consonants and 
+        consonant changes for vowels.
+        */
+        
+        protected:
+          
+          uint32_t _kinds;
+          
+          uint32_t _parts;
+          
+          uint32_t _phonations;
+          
+          uint32_t _nasalizations;
+          
+          uint32_t _roundednesses;
+          
+          uint32_t _manners;
+          
+          uint32_t _places;
+          
+          uint32_t _vots;
+          
+          uint32_t _mechanisms;
+            
+            /*
+            The values of each feature that match, with value v at bit v.  
+            Vowels are kind 0 and consonants kind 1.
+            */
+          
+          uint32_t _restricted;
+            
+            /*
+            The features above, other than kind, that a match_ function has 
+            been called for, with _parts at bit 0
+            */
+          
+          float _heights[2];
+          
+          float _backnesses[2];
+            
+            /*
+            The inclusive ranges of height and backness that match
+            */
+          
+          int _phonation;
+          
+          int _nasalization;
+          
+          int _roundedness;
+          
+          int _manner;
+          
+          int _place;
+          
+          int _vot;
+          
+          int _mechanism;
+            
+            /*
+            The new value of each feature, or -1 to keep its value
+            */
+          
+          float _height_change;
+          
+          float _backness_change;
+          
+          float _length_change;
+          
+          int _vot_change;
+            
+            /*
+            The amounts to add to each feature
+            */
+          
+          void allow(int feature, uint32_t& set, uint32_t values);
+            
+            /*
+            Adds values to the matching values of a feature.  The first call 
+            for a feature replaces every value with none.
+            */
+        
+        public:
+          
+          ~Rule();
+            
+            /*
+            Destructor
+            */
+          
+          Rule();
+            
+            /*
+            Empty constructor
+            
+            This will produce a rule that matches every phone and changes 
+            nothing.
+            */
+          
+          void match_vowels();
+          
+          void match_consonants();
+            
+            /*
+            Match only vowels or only consonants.
+            */
+          
+          void match_part(Syllable::Part part);
+            
+            /*
+            Matches phones in the given part of a syllable.
+            */
+          
+          void match_phonation(Phone::Phonation phonation);
+          
+          void match_nasalization(Phone::Nasalization nasalization);
+          
+          void match_roundedness(Vowel::Roundedness roundedness);
+          
+          void match_manner(Consonant::Manner manner);
+          
+          void match_place(Consonant::Place place);
+          
+          void match_vot(Consonant::VOT vot);
+          
+          void match_mechanism(Consonant::Mechanism mechanism);
+            
+            /*
+            Match phones with the given feature.
+            */
+          
+          void match_place(Consonant::Place first, Consonant::Place last);
+          
+          void match_vot(Consonant::VOT first, Consonant::VOT last);
+            
+            /*
+            Match consonants with a place or VOT from first to last, 
+            inclusive.
+            */
+          
+          void match_height(float low, float high);
+          
+          void match_backness(float low, float high);
+            
+            /*
+            Match vowels with a height or backness from low to high, 
+            inclusive.  Each call replaces the range given before.
+            */
+          
+          void set_phonation(Phone::Phonation new_phonation);
+          
+          void set_nasalization(Phone::Nasalization new_nasalization);
+          
+          void set_roundedness(Vowel::Roundedness new_roundedness);
+          
+          void set_manner(Consonant::Manner new_manner);
+          
+          void set_place(Consonant::Place new_place);
+          
+          void set_vot(Consonant::VOT new_vot);
+          
+          void set_mechanism(Consonant::Mechanism new_mechanism);
+            
+            /*
+            Give every matching phone the value given.  A consonant without a
+            secondary articulation that is given a new place still has none.
+            */
+          
+          void raise(float val = 1.0);
+          
+          void lower(float val = 1.0);
+          
+          void move_back(float val = 1.0);
+          
+          void move_forward(float val = 1.0);
+            
+            /*
+            Change the height or backness of every matching vowel by val.  
+            Calls add up, so a rule that is raised twice raises by both.
+            */
+          
+          void later_vot(int val = 1);
+          
+          void earlier_vot(int val = 1);
+            
+            /*
+            Move the VOT of every matching consonant val places in the VOT 
+            enumeration, stopping at either end of it.  Calls add up.
+            */
+          
+          void lengthen(float val);
+          
+          void shorten(float val);
+            
+            /*
+            Change the length of every matching phone by val.  Calls add up.
+            */
+          
+          bool matches(const Syllable::Slot& phone, 
+                       Syllable::Part part) const;
+          
+          bool matches(PhoneCode phone, Syllable::Part part) const;
+            
+            /*
+            Return whether the rule matches phone in the given part of a 
+            syllable.  A vowel's height and backness are matched exactly in a 
+            Slot, and as quantized in a PhoneCode.
+            */
+          
+          Phone::Violation apply(Syllable::Slot& phone) const;
+          
+          Phone::Violation apply(PhoneCode& phone) const;
+            
+            /*
+            Make the rule's changes to phone, whether or not it matches, and 
+            return no_violation.  If the changed phone would not be 
+            articulable, phone is left unchanged and the rule that it would 
+            break is returned instead.  A vowel's new height and backness are 
+            kept exactly in a Slot, and quantized in a PhoneCode.
+            */
+        
+      };
+      
+      struct Rejection {
+        
+        /*
+        A change that was not made because the phone would have become 
+        impossible
+        */
+        
+        int syllable;
+          
+          /*
+          The index of the syllable in the sequence
+          */
+        
+        int position;
+          
+          /*
+          The index of the phone in the syllable
+          */
+        
+        int rule;
+          
+          /*
+          The index of the rule
+          */
+        
+        PhoneCode phone;
+          
+          /*
+          The phone as it was before the rule, which is how it was left
+          */
+        
+        Phone::Violation violation;
+          
+          /*
+          The rule of articulation that the change would have broken
+          */
+        
+      };
+    
+    protected:
+      
+      std::vector<Rule> _rules;
+        
+        /*
+        The rules, in the order they are applied
+        */
+    
+    public:
+      
+      ~SoundChange();
+        
+        /*
+        Destructor
+        */
+      
+      SoundChange();
+        
+        /*
+        Empty constructor
+        
+        This will produce a SoundChange with no rules, which changes nothing.
+        */
+      
+      SoundChange(std::initializer_list<Rule> rules);
+        
+        /*
+        List constructor
+        
+        Parameters:
+          rules: The rules, in the order they are to be applied
+        */
+      
+      const Rule& operator[](int index) const;
+        
+        /*
+        Returns the rule at the given index.
+        
+        Bounds checked.  Negative indices allowed.
+        
+        Exceptions:
+          expt::IndexError: Thrown if the bounds check fails.
+        */
+      
+      int size() const;
+        
+        /*
+        Returns the number of rules.
+        */
+      
+      void add(const Rule& rule);
+        
+        /*
+        Adds rule after the rules already added.
+        */
+      
+      void clear();
+        
+        /*
+        Removes every rule.
+        */
+      
+      long long apply(Syllable& syllable, 
+                      std::vector<Rejection>* rejections = nullptr) const;
+      
+      long long apply(PhoneticSequence& sequence, 
+                      std::vector<Rejection>* rejections = nullptr) const;
+      
+      long long apply(ColumnarSequence& sequence, 
+                      std::vector<Rejection>* rejections = nullptr) const;
+        
+        /*
+        Apply every rule to every phone and return the number of phones 
+        changed.  The phones of a Syllable or PhoneticSequence are matched and 
+        changed in their Slots, so heights and backnesses stay exact.  A 
+        ColumnarSequence holds PhoneCodes, whose heights and backnesses are 
+        quantized as described in PhoneCode.  Both kinds of sequence give the 
+        same results as long as every height and backness, before and after 
+        the changes, is a multiple of 1/256.
+        
+        Parameters:
+          rejections: If not null, every change that was not made is added to
+                      the end of it.  The syllable index of a rejection from a
+                      single Syllable is 0.
+        */
+    
+  };
+  
+  class Instrumentation {
+    
+    /*
+    This class counts and times the operations that usually dominate the cost 
+    of phonetic processing: decoding and encoding transcriptions in each 
+    PhoneticEncoding, copying syllables, and the exceptions thrown for 
+    impossible articulations, failed decodings, and other errors.
+    
+    The library's own hooks are only compiled in when LANG_INSTRUMENTATION is 
+    defined.  Otherwise the LANG_INSTRUMENT_ macros expand to nothing, so the 
+    hooks cost nothing, snapshot() reports zeros, and no trace hook is ever 
+    called, although the class itself can still be used by hand.
+    
+    Each thread counts into its own block of counters, so that a hot loop on 
+    one thread never contends with another.  snapshot() adds up the blocks of
+    every thread, along with those of threads that have already finished.  A 
+    snapshot taken while other threads are counting is not an atomic picture 
+    of all of them, but each count in it is a value that the count really 
+    had.
+    
+    Timings use a steady clock and include any time spent in nested 
+    operations, so decoding a syllable that is then copied counts the copy 
+    both on its own and as part of the decoding.
+    */
+    
+    public:
+      
+      enum Event {x_sampa_decode          = 0, 
+                  kirschenbaum_decode     = 1, 
+                  unicode_decode          = 2, 
+                  x_sampa_encode          = 3, 
+                  kirschenbaum_encode     = 4, 
+                  unicode_encode          = 5, 
+                  syllable_copy           = 6, 
+                  impossible_articulation = 7, 
+                  decoding_failed         = 8, 
+                  value_error             = 9, 
+                  index_error             = 10, 
+                  other_exception         = 11};
+        
+        /*
+        This enumeration represents the operations that are counted.  The 
+        decoding and encoding events are timed, and the rest are only 
+        counted.  The exception events count exceptions of exactly that type 
+        when they are thrown, so a DecodingFailed is not also counted as a 
+        value_error, and other_exception counts plain expt::Exceptions.
+        */
+      
+      static const int event_count = 12;
+        
+        /*
+        The number of events, which run from 0 to event_count - 1
+        */
+      
+      struct Snapshot {
+        
+        /*
+        How many times each event happened, and how long the timed events 
+        took in total, indexed by Event.
+        */
+        
+        long long counts[event_count];
+        
+        long long nanoseconds[event_count];
+        
+      };
+      
+      typedef void (*TraceHook)(Event event, long long nanoseconds, 
+                                void* data);
+        
+        /*
+        A function to be called after every event, with the time it took (0 if
+        the event is not timed) and the data it was installed with.  It is 
+        called on the thread where the event happened, so it must be 
+        thread-safe, and it must not throw.
+        */
+      
+      class Timer {
+        
+        /*
+        This class times one event from its construction to its destruction, 
+        and records it when it is destroyed, even by an exception.
+        */
+        
+        protected:
+          
+          Event _event;
+            
+            /*
+            The event being timed
+            */
+          
+          long long _start;
+            
+            /*
+            When the event started, in nanoseconds of the steady clock
+            */
+        
+        public:
+          
+          ~Timer();
+            
+            /*
+            Destructor
+            
+            Records the event with the time since construction.
+            */
+          
+          Timer(Event event);
+            
+            /*
+            Standard constructor
+            
+            Parameters:
+              event: The event to be timed
+            */
+          
+          Timer(const Timer& original) = delete;
+          
+          Timer& operator=(const Timer& other) = delete;
+            
+            /*
+            A Timer times exactly one event, so it cannot be copied.
+            */
+        
+      };
+      
+      static bool enabled();
+        
+        /*
+        Returns whether the library was built with LANG_INSTRUMENTATION, that 
+        is, whether its own operations are being counted.
+        */
+      
+      static void record(Event event, long long nanoseconds = 0);
+        
+        /*
+        Counts one occurrence of event that took the given time, and passes it
+        on to the trace hook, if there is one.
+        */
+      
+      static Snapshot snapshot();
+        
+        /*
+        Returns the counts and times of every event since the last reset(), 
+        over all threads.
+        */
+      
+      static void reset();
+        
+        /*
+        Starts the counts and times of every event over from 0.
+        */
+      
+      static void set_trace_hook(TraceHook hook, void* data = 0);
+        
+        /*
+        Installs hook to be called after every event, or removes it if hook is
+        null.  Threads that are already counting may still call the old hook 
+        for events that were in progress, so data must outlive any work that 
+        was running when it was replaced.
+        */
+      
+      static Event decode_event(PhoneticEncoding encoding);
+      
+      static Event encode_event(PhoneticEncoding encoding);
+        
+        /*
+        Return the event for decoding or encoding in the given encoding.
+        */
+      
+      static long long now();
+        
+        /*
+        Returns the current time of the steady clock in nanoseconds.
+        */
+    
+  };
+
+#ifdef LANG_INSTRUMENTATION
+#define LANG_INSTRUMENT_COUNT(event) \
+  lang::Instrumentation::record(event)
+#define LANG_INSTRUMENT_TIME(event) \
+  lang::Instrumentation::Timer lang_instrumentation_timer(event)
+#else
+#define LANG_INSTRUMENT_COUNT(event) ((void) 0)
+#define LANG_INSTRUMENT_TIME(event) ((void) 0)
+#endif
+    
+    /*
+    The hooks compiled into the library's hot paths.  LANG_INSTRUMENT_COUNT 
+    counts one event, and LANG_INSTRUMENT_TIME times an event until the end 
+    of the enclosing block.  Both expand to nothing unless 
+    LANG_INSTRUMENTATION is defined.
+    */
+  
+  class EnumNames {
+    
+    /*
+    This class holds the name of every value of the enumerations of Phone, 
+    Vowel, and Consonant, indexed by value and spelled the same as the 
+    enumerators.  The tables are compile-time constants, so they can be used 
+    in constant expressions and nothing is allocated to read them.  See name
+    and parse.
+    */
+    
+    public:
+      
+      static constexpr const char* phonations[Phone::strident + 1] = {
+        "voiceless", "breathy", "slack", "modal", "stiff", "creaky", 
+        "glottal_closure", "faucalized", "harsh", "strident"
+      };
+      
+      static constexpr const char* nasalizations[Phone::strongly_nasal + 1] = {
+        "oral", "nasal", "strongly_nasal"
+      };
+      
+      static constexpr const char* heights[Vowel::close + 1] = {
+        "open", "near_open", "open_mid", "mid", "close_mid", "near_close", 
+        "close"
+      };
+      
+      static constexpr const char* backnesses[Vowel::back + 1] = {
+        "front", "near_front", "central", "near_back", "back"
+      };
+      
+      static constexpr const char* roundednesses[Vowel::endolabial + 1] = {
+        "unrounded", "exolabial", "endolabial"
+      };
+      
+      static constexpr const char* manners[Consonant::nasal + 1] = {
+        "lateral_flap", "lateral_approximant", "lateral_fricative", "trill", 
+        "flap", "approximant", "nsib_fricative", "sib_fricative", "stop", 
+        "nasal"
+      };
+      
+      static constexpr const char* places[Consonant::glottal + 1] = {
+        "bilabial", "labiodental", "dentolabial", "bidental", 
+        "apical_linguolabial", "laminal_linguolabial", "apical_lower_lip", 
+        "laminal_lower_lip", "interdental", "apical_dental", "laminal_dental", 
+        "apical_alveolar", "laminal_alveolar", "apical_palato_alveolar", 
+        "laminal_palato_alveolar", "apical_retroflex", "laminal_retroflex", 
+        "subapical_retroflex", "alveolo_palatal", "palatal", "velar", 
+        "uvular", "pharyngeal", "epiglottal", "glottal"
+      };
+      
+      static constexpr const char* vots[Consonant::strongly_aspirated + 1] = {
+        "completely_voiced", "moderately_voiced", "weakly_voiced", 
+        "not_aspirated", "weakly_aspirated", "moderately_aspirated", 
+        "strongly_aspirated"
+      };
+      
+      static constexpr const char* mechanisms[Consonant::implosive + 1] = {
+        "pul_eg", "ejective", "click", "implosive"
+      };
+    
+  };
+  
+  // Functions
+  
+  Phone::Phonation& operator++(Phone::Phonation& start_val);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will 
+    go around the horn.
+    */
+  
+  Phone::Phonation operator++(Phone::Phonation& start_val, int);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will 
+    go around the horn.
+    */
+  
+  Phone::Phonation& operator--(Phone::Phonation& start_val);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will 
+    go around the horn.
+    */
+  
+  Phone::Phonation operator--(Phone::Phonation& start_val, int);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will 
+    go around the horn.
+    */
+    
+  Phone::Phonation& operator+=(Phone::Phonation& start_val, int val);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will 
+    go around the horn.
+    */
+  
+  Phone::Phonation& operator-=(Phone::Phonation& start_val, int val);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will 
+    go around the horn.
+    */
+  
+  std::string string(Phone::Phonation phonation);
+    
+    /*
+    Returns the name of the Phonation value in string form.
+    
+    Parameters:
+      phonation: Phonation to convert
+    */
+  
+  constexpr const char* name(Phone::Phonation phonation);
+    
+    /*
+    Returns the name of the Phonation value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Phone::Phonation& result);
+  
+  bool parse(const std::string& name, Phone::Phonation& result);
+    
+    /*
+    Finds the Phonation value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Phone::Nasalization& operator++(Phone::Nasalization& start_val);
+    
+    /*
+    Iterates through the Nasalization enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Phone::Nasalization operator++(Phone::Nasalization& start_val, int);
+    
+    /*
+    Iterates through the Nasalization enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Phone::Nasalization& operator--(Phone::Nasalization& start_val);
+    
+    /*
+    Iterates through the Nasalization enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Phone::Nasalization operator--(Phone::Nasalization& start_val, int);
+    
+    /*
+    Iterates through the Phonation enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Phone::Nasalization& operator+=(Phone::Nasalization& start_val, int val);
+    
+    /*
+    Iterates through the Nasalization enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Phone::Nasalization& operator-=(Phone::Nasalization& start_val, int val);
+    
+    /*
+    Iterates through the Nasalization enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Phone::Nasalization nasalization);
+    
+    /*
+    Returns the name of the Nasalization value in string form.
+    
+    Parameters:
+      nasalization: Nasalization to be converted
+    */
+  
+  constexpr const char* name(Phone::Nasalization nasalization);
+    
+    /*
+    Returns the name of the Nasalization value, which is spelled the same as 
+    the enumerator.  The names are compile-time constants, so nothing is ever
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Phone::Nasalization& result);
+  
+  bool parse(const std::string& name, Phone::Nasalization& result);
+    
+    /*
+    Finds the Nasalization value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Vowel::Height& operator++(Vowel::Height& start_val);
+    
+    /*
+    Iterates through the Height enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Height operator++(Vowel::Height& start_val, int);
+    
+    /*
+    Iterates through the Height enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Height& operator--(Vowel::Height& start_val);
+    
+    /*
+    Iterates through the Height enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Height operator--(Vowel::Height& start_val, int);
+    
+    /*
+    Iterates through the Height enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Vowel::Height& operator+=(Vowel::Height& start_val, int val);
+    
+    /*
+    Iterates through the Height enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Height& operator-=(Vowel::Height& start_val, int val);
+    
+    /*
+    Iterates through the Height enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Vowel::Height height);
+    
+    /*
+    Returns the name of the Height value in string form.
+    
+    Parameters:
+      height: Height to be converted
+    */
+  
+  constexpr const char* name(Vowel::Height height);
+    
+    /*
+    Returns the name of the Height value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Vowel::Height& result);
+  
+  bool parse(const std::string& name, Vowel::Height& result);
+    
+    /*
+    Finds the Height value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Vowel::Backness& operator++(Vowel::Backness& start_val);
+    
+    /*
+    Iterates through the Backness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Backness operator++(Vowel::Backness& start_val, int);
+    
+    /*
+    Iterates through the Backness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Backness& operator--(Vowel::Backness& start_val);
+    
+    /*
+    Iterates through the Backness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Backness operator--(Vowel::Backness& start_val, int);
+    
+    /*
+    Iterates through the Backness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Vowel::Backness& operator+=(Vowel::Backness& start_val, int val);
+    
+    /*
+    Iterates through the Backness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Backness& operator-=(Vowel::Backness& start_val, int val);
+    
+    /*
+    Iterates through the Backness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Vowel::Backness backness);
+    
+    /*
+    Returns the name of the Backness value in string form.
+    
+    Parameters:
+      backness: Backness to be converted
+    */
+  
+  constexpr const char* name(Vowel::Backness backness);
+    
+    /*
+    Returns the name of the Backness value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Vowel::Backness& result);
+  
+  bool parse(const std::string& name, Vowel::Backness& result);
+    
+    /*
+    Finds the Backness value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Vowel::Roundedness& operator++(Vowel::Roundedness& start_val);
+    
+    /*
+    Iterates through the Roundedness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Roundedness operator++(Vowel::Roundedness& start_val, int);
+    
+    /*
+    Iterates through the Roundedness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Roundedness& operator--(Vowel::Roundedness& start_val);
+    
+    /*
+    Iterates through the Roundedness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Roundedness operator--(Vowel::Roundedness& start_val, int);
+    
+    /*
+    Iterates through the Roundedness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Vowel::Roundedness& operator+=(Vowel::Roundedness& start_val, int val);
+    
+    /*
+    Iterates through the Roundedness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Vowel::Roundedness& operator-=(Vowel::Roundedness& start_val, int val);
+    
+    /*
+    Iterates through the Roundedness enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Vowel::Roundedness roundedness);
+    
+    /*
+    Returns the name of the Roundedness value in string form.
+    
+    Parameters:
+      roundedness: Roundedness to be converted
+    */
+  
+  constexpr const char* name(Vowel::Roundedness roundedness);
+    
+    /*
+    Returns the name of the Roundedness value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Vowel::Roundedness& result);
+  
+  bool parse(const std::string& name, Vowel::Roundedness& result);
+    
+    /*
+    Finds the Roundedness value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Consonant::Manner& operator++(Consonant::Manner& start_val);
+    
+    /*
+    Iterates through the Manner enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Manner operator++(Consonant::Manner& start_val, int);
+    
+    /*
+    Iterates through the Manner enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Manner& operator--(Consonant::Manner& start_val);
+    
+    /*
+    Iterates through the Manner enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Manner operator--(Consonant::Manner& start_val, int);
+    
+    /*
+    Iterates through the Manner enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Consonant::Manner& operator+=(Consonant::Manner& start_val, int val);
+    
+    /*
+    Iterates through the Manner enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Manner& operator-=(Consonant::Manner& start_val, int val);
+    
+    /*
+    Iterates through the Manner enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Consonant::Manner manner);
+    
+    /*
+    Returns the name of the Manner value in string form.
+    
+    Parameters:
+      manner: Manner to be converted
+    */
+  
+  constexpr const char* name(Consonant::Manner manner);
+    
+    /*
+    Returns the name of the Manner value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Consonant::Manner& result);
+  
+  bool parse(const std::string& name, Consonant::Manner& result);
+    
+    /*
+    Finds the Manner value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Consonant::Place& operator++(Consonant::Place& start_val);
+    
+    /*
+    Iterates through the Place enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Place operator++(Consonant::Place& start_val, int);
+    
+    /*
+    Iterates through the Place enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Place& operator--(Consonant::Place& start_val);
+    
+    /*
+    Iterates through the Place enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Place operator--(Consonant::Place& start_val, int);
+    
+    /*
+    Iterates through the Place enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Consonant::Place& operator+=(Consonant::Place& start_val, int val);
+    
+    /*
+    Iterates through the Place enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Place& operator-=(Consonant::Place& start_val, int val);
+    
+    /*
+    Iterates through the Place enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Consonant::Place place);
+    
+    /*
+    Returns the name of the Place value in string form.
+    
+    Parameters:
+      place: Place to be converted
+    */
+  
+  constexpr const char* name(Consonant::Place place);
+    
+    /*
+    Returns the name of the Place value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Consonant::Place& result);
+  
+  bool parse(const std::string& name, Consonant::Place& result);
+    
+    /*
+    Finds the Place value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Consonant::VOT& operator++(Consonant::VOT& start_val);
+    
+    /*
+    Iterates through the VOT enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::VOT operator++(Consonant::VOT& start_val, int);
+    
+    /*
+    Iterates through the VOT enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::VOT& operator--(Consonant::VOT& start_val);
+    
+    /*
+    Iterates through the VOT enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::VOT operator--(Consonant::VOT& start_val, int);
+    
+    /*
+    Iterates through the VOT enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Consonant::VOT& operator+=(Consonant::VOT& start_val, int val);
+    
+    /*
+    Iterates through the VOT enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::VOT& operator-=(Consonant::VOT& start_val, int val);
+    
+    /*
+    Iterates through the VOT enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Consonant::VOT vot);
+    
+    /*
+    Returns the name of the VOT value in string form.
+    
+    Parameters:
+      vot: VOT to be converted
+    */
+  
+  constexpr const char* name(Consonant::VOT vot);
+    
+    /*
+    Returns the name of the VOT value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Consonant::VOT& result);
+  
+  bool parse(const std::string& name, Consonant::VOT& result);
+    
+    /*
+    Finds the VOT value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  Consonant::Mechanism& operator++(Consonant::Mechanism& start_val);
+    
+    /*
+    Iterates through the Mechanism enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Mechanism operator++(Consonant::Mechanism& start_val, int);
+    
+    /*
+    Iterates through the Mechanism enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Mechanism& operator--(Consonant::Mechanism& start_val);
+    
+    /*
+    Iterates through the Mechanism enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Mechanism operator--(Consonant::Mechanism& start_val, int);
+    
+    /*
+    Iterates through the Mechanism enumeration in numerical order.  Will go 
+    around the horn.
+    */
+    
+  Consonant::Mechanism& operator+=(Consonant::Mechanism& start_val, int val);
+    
+    /*
+    Iterates through the Mechanism enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  Consonant::Mechanism& operator-=(Consonant::Mechanism& start_val, int val);
+    
+    /*
+    Iterates through the Mechanism enumeration in numerical order.  Will go 
+    around the horn.
+    */
+  
+  std::string string(Consonant::Mechanism mechanism);
+    
+    /*
+    Returns the name of the Mechanism value in string form.
+    
+    Parameters:
+      mechanism: Mechanism to be converted
+    */
+  
+  constexpr const char* name(Consonant::Mechanism mechanism);
+    
+    /*
+    Returns the name of the Mechanism value, which is spelled the same as the 
+    enumerator.  The names are compile-time constants, so nothing is ever 
+    allocated.
+    */
+  
+  bool parse(const char* name, int length, Consonant::Mechanism& result);
+  
+  bool parse(const std::string& name, Consonant::Mechanism& result);
+    
+    /*
+    Finds the Mechanism value with the given name, as returned by name, and 
+    stores it in result.  Returns false and leaves result unchanged if there 
+    is no such value.  The name is looked up in a perfect hash table built 
+    at compile time, so parsing allocates nothing.
+    */
+  
+  void encode(const PhoneticSequence& sequence, std::string& output, 
+              PhoneticEncoding encoding = lang::x_sampa, 
+              char separator = ' ');
+  
+  void encode(const ArenaSequence& sequence, std::string& output, 
+              PhoneticEncoding encoding = lang::x_sampa, 
+              char separator = ' ');
+    
+    /*
+    Appends the transcriptions of all of the syllables in sequence to output, 
+    separated by separator.  Nothing is allocated apart from output's own 
+    growth.
+    
+    Parameters:
+      sequence:  The syllables to be encoded
+      output:    The string to which the transcriptions will be appended
+      encoding:  The transcription system to be used
+      separator: The character placed between syllables
+    */
+  
+  void tone_histogram(const PhoneticSequence& sequence, 
+                      long long counts[ToneCode::count]);
+  
+  void tone_histogram(const ArenaSequence& sequence, 
+                      long long counts[ToneCode::count]);
+    
+    /*
+    Adds the number of syllables in sequence with each tone to counts, which is
+    indexed by ToneCode code.  counts is not cleared first, so several 
+    sequences can be counted together.
+    
+    Parameters:
+      sequence: The syllables to be counted
+      counts:   An array of ToneCode::count counts
+    */
+  
+  void write_corpus(const PhoneticSequence& sequence, std::ostream& output);
+  
+  void write_corpus(const ArenaSequence& sequence, std::ostream& output);
+    
+    /*
+    Writes sequence to output in the binary corpus format read by CorpusView.
+    
+    Parameters:
+      sequence: The syllables to be written
+      output:   A binary stream to write to
+    
+    Exceptions:
+      expt::ValueError: Thrown if a syllable has more than 65535 phones in some
+                        part, has a tone level outside [-128, 127], or the 
+                        corpus has more than 2^32 - 1 phones.
+      expt::Exception:  Thrown if writing fails.
+    */
+  
+  Syllable::iterator operator+(Syllable::iterator::difference_type offset, 
+                               const Syllable::iterator& iterator);
+  
+  Syllable::const_iterator operator+(
+    Syllable::const_iterator::difference_type offset, 
+    const Syllable::const_iterator& iterator);
+    
+    /*
+    Move an iterator by the given number of phones, with the offset first.  
+    Not bounds checked.
+    */
+  
+  // Constant expressions
+  
+  constexpr const char* name(Phone::Phonation phonation) {
+    
+    return EnumNames::phonations[phonation];
+    
+  }
+  
+  constexpr const char* name(Phone::Nasalization nasalization) {
+    
+    return EnumNames::nasalizations[nasalization];
+    
+  }
+  
+  constexpr const char* name(Vowel::Height height) {
+    
+    return EnumNames::heights[height];
+    
+  }
+  
+  constexpr const char* name(Vowel::Backness backness) {
+    
+    return EnumNames::backnesses[backness];
+    
+  }
+  
+  constexpr const char* name(Vowel::Roundedness roundedness) {
+    
+    return EnumNames::roundednesses[roundedness];
+    
+  }
+  
+  constexpr const char* name(Consonant::Manner manner) {
+    
+    return EnumNames::manners[manner];
+    
+  }
+  
+  constexpr const char* name(Consonant::Place place) {
+    
+    return EnumNames::places[place];
+    
+  }
+  
+  constexpr const char* name(Consonant::VOT vot) {
+    
+    return EnumNames::vots[vot];
+    
+  }
+  
+  constexpr const char* name(Consonant::Mechanism mechanism) {
+    
+    return EnumNames::mechanisms[mechanism];
+    
+  }
+  
+  constexpr bool Vowel::articulable(Phonation phonation) {
+    
+    return _phonations >> phonation & 1;
+    
+  }
+  
+  constexpr bool Vowel::defined(Roundedness roundedness, 
+                                Nasalization nasalization, 
+                                Phonation phonation) {
+    
+    // Comparing as unsigned also rejects negative values
+    return (unsigned) roundedness <= endolabial 
+        && (unsigned) nasalization <= strongly_nasal 
+        && (unsigned) phonation <= strident;
+    
+  }
+  
+  constexpr Phone::Violation Vowel::check(float height, float backness, 
+                                          Roundedness roundedness, 
+                                          Nasalization nasalization, bool, 
+                                          Phonation phonation, float length) {
+    
+    // Written so that NaN fails every range
+    return !defined(roundedness, nasalization, phonation) ? undefined_value
+         : !(height >= 0.0 && height <= 6.0) ? height_out_of_range
+         : !(backness >= 0.0 && backness <= 4.0) ? backness_out_of_range
+         : !(length > 0.0) ? nonpositive_length
+         : !articulable(phonation) ? closed_glottis_vowel
+         : no_violation;
+    
+  }
+  
+  constexpr uint32_t Consonant::impossible_places(Manner manner) {
+    
+    return manner <= lateral_fricative 
+             ? 1 << bilabial | 1 << labiodental | 1 << dentolabial 
+               | 1 << bidental | 1 << pharyngeal | 1 << epiglottal 
+               | 1 << glottal
+         : manner == trill ? 1 << velar | 1 << glottal
+         : manner == flap ? 1 << glottal
+         : manner == stop ? 1 << pharyngeal
+         : manner == nasal ? 1 << pharyngeal | 1 << epiglottal | 1 << glottal
+         : 0;
+    
+  }
+  
+  constexpr Phone::Violation Consonant::place_rules(Manner manner, 
+                                                    Place place, 
+                                                    Phonation phonation) {
+    
+    return manner == stop && place == glottal && phonation != voiceless 
+             ? voiced_glottal_stop
+         : impossible_places(manner) >> place & 1 ? impossible_place
+         : no_violation;
+    
+  }
+  
+  constexpr Phone::Violation Consonant::voicing_rules(Manner manner, 
+                                                      Phonation phonation, 
+                                                      VOT vot, 
+                                                      Nasalization nasalization,
+                                                      Mechanism mechanism) {
+    
+    return phonation == voiceless && vot < not_aspirated 
+             ? voiceless_voiced_vot
+         : mechanism == ejective && phonation != voiceless ? voiced_ejective
+         : manner == nasal && nasalization == oral ? oral_nasal
+         : no_violation;
+    
+  }
+  
+  constexpr Phone::Violation Consonant::rules(Manner manner, Place place, 
+                                              Phonation phonation, VOT vot, 
+                                              Nasalization nasalization, 
+                                              Mechanism mechanism) {
+    
+    return place_rules(manner, place, phonation) != no_violation 
+             ? place_rules(manner, place, phonation)
+         : voicing_rules(manner, phonation, vot, nasalization, mechanism);
+    
+  }
+  
+  class Consonant::Table {
+    
+    /*
+    This class holds one bit for every combination of manner, place, 
+    phonation, voice-onset time, mechanism, and nasalization, set if 
+    Consonant's rules find nothing wrong with it.  The bits are generated at 
+    compile time, so checking a consonant costs one load and one shift.
+    
+    Each 64-bit word covers one manner, place, and phonation, and within it 
+    bit (mechanism * 7 + vot) * 2 + nasalized covers the rest.  The rules only 
+    ask whether a consonant is nasalized at all, so nasal and strongly_nasal 
+    share a bit.
+    */
+    
+    public:
       
-      void remove_nucleus(int index);
+      static constexpr int vots = strongly_aspirated + 1;
+      
+      static constexpr int word_count = 
+        (nasal + 1) * (glottal + 1) * (strident + 1);
+      
+      static constexpr int word(Manner manner, Place place, 
+                                Phonation phonation) {
         
-        /*
-        Removes the phone at the given index.
+        return (manner * (glottal + 1) + place) * (strident + 1) + phonation;
         
-        Parameters:
-          index: An index in the syllable nucleus.  Bounds checked.  Negative
-                  indices allowed.
+      }
+      
+      static constexpr int bit(VOT vot, Nasalization nasalization, 
+                               Mechanism mechanism) {
         
-        Exceptions:
-          expt::IndexError: Thrown if the bounds check fails.
-        */
+        return (mechanism * vots + vot) * 2 + (nasalization != oral);
+        
+      }
       
-      void remove_coda(int index);
+      static constexpr int bit_count = (implosive + 1) * vots * 2;
+      
+      static constexpr uint64_t voicing_bits(Manner manner, 
+                                             Phonation phonation, 
+                                             int position = 0) {
         
-        /*
-        Removes the phone at the given index.
+        // The bits of a word from position upwards, as far as voicing_rules 
+        // are concerned
+        return position == bit_count ? 0
+             : (uint64_t) (voicing_rules(manner, phonation, 
+                                         (VOT) (position / 2 % vots), 
+                                         position % 2 ? Phone::nasal 
+                                                      : Phone::oral, 
+                                         (Mechanism) (position / 2 / vots)) 
+                           == no_violation) << position 
+               | voicing_bits(manner, phonation, position + 1);
         
-        Parameters:
-          index: An index in the syllable coda.  Bounds checked.  Negative 
-                  indices allowed.
+      }
+      
+      static constexpr uint64_t voicing_word(int index) {
         
-        Exceptions:
-          expt::IndexError: Thrown if the bounds check fails.
-        */
+        return voicing_bits((Manner) (index / (strident + 1)), 
+                            (Phonation) (index % (strident + 1)));
+        
+      }
       
-      std::string unicode() const;
+      static constexpr uint64_t build(Manner manner, Place place, 
+                                      Phonation phonation);
+      
+      static constexpr uint64_t build(int index) {
         
-        /*
-        Returns the IPA representation of the syllable, using Unicode 
-        characters where necessary.  Will be enclosed in square brackets.
-        */
-
-      std::string kirschenbaum() const;
-
-        /*
-        Returns the IPA representation of the syllable using Kirschenbaum 
-        encoding.  Will be enclosed in square brackets.
-        */
-
-      std::string x-sampa() const;
-
-        /*
-        Returns the IPA representation of the syllable using X-SAMPA encoding. 
-        Will be enclosed in square brackets.
-        */
+        return build((Manner) (index / (strident + 1) / (glottal + 1)), 
+                     (Place) (index / (strident + 1) % (glottal + 1)), 
+                     (Phonation) (index % (strident + 1)));
+        
+      }
+      
+      template <int... I>
+      struct Indices {};
+      
+      template <class First, class Second>
+      struct Join;
+      
+      template <int... First, int... Second>
+      struct Join<Indices<First...>, Indices<Second...> > {
+        
+        typedef Indices<First..., (sizeof...(First) + Second)...> type;
+        
+      };
+      
+      template <int N, bool small = (N < 2)>
+      struct Count {
+        
+        // Halving keeps the instantiation depth logarithmic in N
+        typedef typename Join<typename Count<N / 2>::type, 
+                              typename Count<N - N / 2>::type>::type type;
+        
+      };
+      
+      template <int N>
+      struct Count<N, true> {
+        
+        typedef typename std::conditional<N == 0, Indices<>, 
+                                          Indices<0> >::type type;
+        
+      };
+      
+      template <class List>
+      struct VoicingWords;
+      
+      template <int... I>
+      struct VoicingWords<Indices<I...> > {
+        
+        // Voicing depends on only the manner and phonation of a word, so 
+        // these are worked out once rather than once per place
+        static constexpr uint64_t value[sizeof...(I)] = {voicing_word(I)...};
+        
+      };
+      
+      typedef VoicingWords<Count<(nasal + 1) * (strident + 1)>::type> 
+        voicing_words;
+      
+      template <class List>
+      struct Words;
+      
+      template <int... I>
+      struct Words<Indices<I...> > {
+        
+        static constexpr uint64_t value[sizeof...(I)] = {build(I)...};
+        
+      };
+      
+      typedef Words<Count<word_count>::type> words;
     
   };
   
-  typedef std::vector<Syllable> PhoneticSequence;
+  template <int... I>
+  constexpr uint64_t Consonant::Table::VoicingWords<
+    Consonant::Table::Indices<I...> >::value[];
   
-  // Functions
+  template <int... I>
+  constexpr uint64_t 
+    Consonant::Table::Words<Consonant::Table::Indices<I...> >::value[];
   
-  Phone::Phonation& operator++(Phone::Phonation& start_val);
+  constexpr uint64_t Consonant::Table::build(Manner manner, Place place, 
+                                             Phonation phonation) {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will 
-    go around the horn.
-    */
+    return place_rules(manner, place, phonation) != no_violation ? 0 
+         : voicing_words::value[manner * (strident + 1) + phonation];
+    
+  }
+  
+  constexpr bool Consonant::defined(Manner manner, Place place, 
+                                    Phonation phonation, VOT vot, 
+                                    Nasalization nasalization, 
+                                    Mechanism mechanism) {
+    
+    return (unsigned) manner <= nasal && (unsigned) place <= glottal 
+        && (unsigned) phonation <= strident 
+        && (unsigned) vot <= strongly_aspirated 
+        && (unsigned) nasalization <= strongly_nasal 
+        && (unsigned) mechanism <= implosive;
+    
+  }
   
-  Phone::Phonation& operator++(Phone::Phonation& start_val, int);
+  constexpr bool Consonant::articulable(Manner manner, Place place, 
+                                        Phonation phonation, VOT vot, 
+                                        Nasalization nasalization, 
+                                        Mechanism mechanism) {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will 
-    go around the horn.
-    */
+    return defined(manner, place, phonation, vot, nasalization, mechanism) 
+        && Table::words::value[Table::word(manner, place, phonation)] 
+             >> Table::bit(vot, nasalization, mechanism) & 1;
+    
+  }
   
-  Phone::Phonation& operator--(Phone::Phonation& start_val);
+  constexpr Phone::Violation Consonant::check(Manner manner, Place place, 
+                                              Phonation phonation, VOT vot, 
+                                              Nasalization nasalization, 
+                                              Mechanism mechanism, 
+                                              float length) {
+    
+    return !defined(manner, place, phonation, vot, nasalization, mechanism) 
+             ? undefined_value
+         : !(length > 0.0) ? nonpositive_length
+         : articulable(manner, place, phonation, vot, nasalization, mechanism)
+             ? no_violation
+         : rules(manner, place, phonation, vot, nasalization, mechanism);
+    
+  }
+  
+  // Inline functions
+  
+  inline Syllable::Slot::Slot(PhoneCode code) {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will 
-    go around the horn.
-    */
+    // Initialize essential fields
+    _code = code;
+    _height = code.is_vowel() ? code.height() : 0;
+    _backness = code.is_vowel() ? code.backness() : 0;
+    
+  }
   
-  Phone::Phonation& operator--(Phone::Phonation& start_val, int);
+  inline Syllable::Slot::Slot(PhoneCode code, float height, 
+                              float backness) {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will 
-    go around the horn.
-    */
+    // Initialize essential fields
+    _code = code;
+    _height = code.is_vowel() ? height : 0;
+    _backness = code.is_vowel() ? backness : 0;
     
-  Phone::Phonation& operator+=(Phone::Phonation& start_val, int val);
+  }
+  
+  inline bool Syllable::Slot::operator==(const Slot& other) const {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will 
-    go around the horn.
-    */
+    return _code == other._code && _height == other._height && 
+           _backness == other._backness;
+    
+  }
   
-  Phone::Phonation& operator-=(Phone::Phonation& start_val, int val);
+  inline bool Syllable::Slot::operator!=(const Slot& other) const {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will 
-    go around the horn.
-    */
+    return !(*this == other);
+    
+  }
   
-  std::string string(Phone::Phonation& phonation);
+  inline bool Syllable::Slot::is_vowel() const {
     
-    /*
-    Returns the name of the Phonation value in string form.
+    return _code.is_vowel();
     
-    Parameters:
-      phonation: Phonation to convert
-    */
+  }
   
-  Phone::Nasalization& operator++(Phone::Nasalization& start_val);
+  inline bool Syllable::Slot::is_consonant() const {
     
-    /*
-    Iterates through the Nasalization enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _code.is_consonant();
+    
+  }
   
-  Phone::Nasalization& operator++(Phone::Nasalization& start_val, int);
+  inline PhoneCode Syllable::Slot::code() const {
     
-    /*
-    Iterates through the Nasalization enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _code;
+    
+  }
   
-  Phone::Nasalization& operator--(Phone::Nasalization& start_val);
+  inline float Syllable::Slot::height() const {
     
-    /*
-    Iterates through the Nasalization enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _height;
+    
+  }
   
-  Phone::Nasalization& operator--(Phone::Nasalization& start_val, int);
+  inline float Syllable::Slot::backness() const {
     
-    /*
-    Iterates through the Phonation enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _backness;
     
-  Phone::Nasalization& operator+=(Phone::Nasalization& start_val, int val);
+  }
+  
+  inline Syllable::Span::iterator::~iterator() {}
+  
+  inline Syllable::Span::iterator::iterator(const Slot* slot, 
+                                            const Cell* cell) {
     
-    /*
-    Iterates through the Nasalization enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    // Initialize essential fields
+    _slot = slot;
+    _cell = cell;
+    
+  }
   
-  Phone::Nasalization& operator-=(Phone::Nasalization& start_val, int val);
+  inline Syllable::Span::iterator& 
+  Syllable::Span::iterator::operator++() {
     
-    /*
-    Iterates through the Nasalization enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    _slot++;
+    if(_cell) {
+      _cell++;
+    }
+    
+    return *this;
+    
+  }
   
-  std::string string(Phone::Nasalization& nasalization);
+  inline Syllable::Span::iterator 
+  Syllable::Span::iterator::operator++(int) {
     
-    /*
-    Returns the name of the Nasalization value in string form.
+    iterator result(*this);
+    ++*this;
+    return result;
     
-    Parameters:
-      nasalization: Nasalization to be converted
-    */
+  }
   
-  Vowel::Height& operator++(Vowel::Height& start_val);
+  inline bool Syllable::Span::iterator::operator==(const iterator& other) 
+      const {
     
-    /*
-    Iterates through the Height enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _slot == other._slot;
+    
+  }
   
-  Vowel::Height& operator++(Vowel::Height& start_val, int);
+  inline bool Syllable::Span::iterator::operator!=(const iterator& other) 
+      const {
     
-    /*
-    Iterates through the Height enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _slot != other._slot;
+    
+  }
   
-  Vowel::Height& operator--(Vowel::Height& start_val);
+  inline Syllable::Slot Syllable::Span::iterator::operator*() const {
     
-    /*
-    Iterates through the Height enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    if(_cell) {
+      return _cell->slot();
+    }
+    
+    return *_slot;
+    
+  }
   
-  Vowel::Height& operator--(Vowel::Height& start_val, int);
+  inline Syllable::Slot Syllable::Span::unchecked(int index) const {
     
-    /*
-    Iterates through the Height enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    if(_cells) {
+      return _cells[index].slot();
+    }
     
-  Vowel::Height& operator+=(Vowel::Height& start_val, int val);
+    return _begin[index];
     
-    /*
-    Iterates through the Height enumeration in numerical order.  Will go 
-    around the horn.
-    */
+  }
   
-  Vowel::Height& operator-=(Vowel::Height& start_val, int val);
+  inline Syllable::Span::iterator Syllable::Span::begin() const {
     
-    /*
-    Iterates through the Height enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return iterator(_begin, _cells);
+    
+  }
   
-  std::string string(Vowel::Height& height);
+  inline Syllable::Span::iterator Syllable::Span::end() const {
     
-    /*
-    Returns the name of the Height value in string form.
+    return iterator(_begin + _size, _cells ? _cells + _size : 0);
     
-    Parameters:
-      height: Height to be converted
-    */
+  }
   
-  Vowel::Backness& operator++(Vowel::Backness& start_val);
+  inline int Syllable::Span::size() const {
     
-    /*
-    Iterates through the Backness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _size;
+    
+  }
   
-  Vowel::Backness& operator++(Vowel::Backness& start_val, int);
+  inline bool Syllable::Span::empty() const {
     
-    /*
-    Iterates through the Backness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _size == 0;
+    
+  }
   
-  Vowel::Backness& operator--(Vowel::Backness& start_val);
+  inline Phone& Syllable::Cell::phone() {
     
-    /*
-    Iterates through the Backness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    if(_is_vowel) {
+      return _vowel;
+    }
+    
+    return _consonant;
+    
+  }
   
-  Vowel::Backness& operator--(Vowel::Backness& start_val, int);
+  inline const Phone& Syllable::Cell::phone() const {
     
-    /*
-    Iterates through the Backness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    if(_is_vowel) {
+      return _vowel;
+    }
+    
+    return _consonant;
+    
+  }
+  
+  inline Syllable::iterator::~iterator() {}
+  
+  inline Syllable::iterator::iterator() {
+    
+    // Initialize essential fields
+    _syllable = 0;
+    _position = 0;
+    
+  }
+  
+  inline Syllable::iterator::iterator(const iterator& original) {
+    
+    // Initialize essential fields
+    _syllable = original._syllable;
+    _position = original._position;
+    
+  }
+  
+  inline Syllable::iterator& 
+  Syllable::iterator::operator=(const iterator& other) {
+    
+    // Transfer fields
+    _syllable = other._syllable;
+    _position = other._position;
+    
+    return *this;
+    
+  }
+  
+  inline Syllable::iterator& Syllable::iterator::operator++() {
+    
+    ++_position;
+    return *this;
+    
+  }
+  
+  inline Syllable::iterator Syllable::iterator::operator++(int) {
+    
+    iterator result(*this);
+    ++_position;
+    return result;
+    
+  }
+  
+  inline Syllable::iterator& Syllable::iterator::operator--() {
+    
+    --_position;
+    return *this;
+    
+  }
+  
+  inline Syllable::iterator Syllable::iterator::operator--(int) {
+    
+    iterator result(*this);
+    --_position;
+    return result;
+    
+  }
+  
+  inline Syllable::iterator& 
+  Syllable::iterator::operator+=(difference_type offset) {
+    
+    _position += offset;
+    return *this;
+    
+  }
+  
+  inline Syllable::iterator& 
+  Syllable::iterator::operator-=(difference_type offset) {
+    
+    _position -= offset;
+    return *this;
+    
+  }
+  
+  inline Syllable::iterator 
+  Syllable::iterator::operator+(difference_type offset) const {
+    
+    iterator result(*this);
+    result._position += offset;
+    return result;
+    
+  }
+  
+  inline Syllable::iterator 
+  Syllable::iterator::operator-(difference_type offset) const {
+    
+    iterator result(*this);
+    result._position -= offset;
+    return result;
+    
+  }
+  
+  inline Syllable::iterator::difference_type 
+  Syllable::iterator::operator-(const iterator& other) const {
+    
+    return _position - other._position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator==(const iterator& other) const {
+    
+    return _syllable == other._syllable && _position == other._position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator!=(const iterator& other) const {
+    
+    return !(*this == other);
+    
+  }
+  
+  inline bool Syllable::iterator::operator>(const iterator& other) const {
+    
+    return _position > other._position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator<(const iterator& other) const {
+    
+    return _position < other._position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator>=(const iterator& other) const {
+    
+    return _position >= other._position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator<=(const iterator& other) const {
+    
+    return _position <= other._position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator>(int position) const {
+    
+    return this->position() > position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator<(int position) const {
+    
+    return this->position() < position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator>=(int position) const {
+    
+    return this->position() >= position;
+    
+  }
+  
+  inline bool Syllable::iterator::operator<=(int position) const {
+    
+    return this->position() <= position;
+    
+  }
+  
+  inline Phone& Syllable::iterator::operator*() const {
+    
+    return _syllable->cells()[_position].phone();
+    
+  }
+  
+  inline Phone* Syllable::iterator::operator->() const {
+    
+    return &**this;
+    
+  }
+  
+  inline Phone& Syllable::iterator::operator[](difference_type offset) const {
+    
+    return _syllable->cells()[_position + offset].phone();
+    
+  }
+  
+  inline Syllable& Syllable::iterator::syllable() const {
+    
+    return *_syllable;
+    
+  }
+  
+  inline void Syllable::iterator::set_syllable(Syllable& new_syllable) {
+    
+    _syllable = &new_syllable;
+    
+  }
+  
+  inline int Syllable::iterator::position() const {
+    
+    return _position;
+    
+  }
+  
+  inline int Syllable::iterator::inverse_position() const {
+    
+    return position() - _syllable->_size;
+    
+  }
+  
+  inline Syllable::const_iterator::~const_iterator() {}
+  
+  inline Syllable::const_iterator::const_iterator() {
+    
+    // Initialize essential fields
+    _syllable = 0;
+    _position = 0;
+    
+  }
+  
+  inline Syllable::const_iterator::const_iterator(
+    const const_iterator& original) {
+    
+    // Initialize essential fields
+    _syllable = original._syllable;
+    _position = original._position;
+    
+  }
+  
+  inline Syllable::const_iterator::const_iterator(const iterator& original) {
+    
+    // Initialize essential fields
+    _syllable = original._syllable;
+    _position = original._position;
+    
+  }
+  
+  inline Syllable::const_iterator& 
+  Syllable::const_iterator::operator=(const const_iterator& other) {
+    
+    // Transfer fields
+    _syllable = other._syllable;
+    _position = other._position;
+    
+    return *this;
+    
+  }
+  
+  inline Syllable::const_iterator& Syllable::const_iterator::operator++() {
+    
+    ++_position;
+    return *this;
+    
+  }
+  
+  inline Syllable::const_iterator Syllable::const_iterator::operator++(int) {
     
-  Vowel::Backness& operator+=(Vowel::Backness& start_val, int val);
+    const_iterator result(*this);
+    ++_position;
+    return result;
     
-    /*
-    Iterates through the Backness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+  }
   
-  Vowel::Backness& operator-=(Vowel::Backness& start_val, int val);
+  inline Syllable::const_iterator& Syllable::const_iterator::operator--() {
     
-    /*
-    Iterates through the Backness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    --_position;
+    return *this;
+    
+  }
   
-  std::string string(Vowel::Backness& backness);
+  inline Syllable::const_iterator Syllable::const_iterator::operator--(int) {
     
-    /*
-    Returns the name of the Backness value in string form.
+    const_iterator result(*this);
+    --_position;
+    return result;
     
-    Parameters:
-      backness: Backness to be converted
-    */
+  }
   
-  Vowel::Roundedness& operator++(Vowel::Roundedness& start_val);
+  inline Syllable::const_iterator& 
+  Syllable::const_iterator::operator+=(difference_type offset) {
     
-    /*
-    Iterates through the Roundedness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    _position += offset;
+    return *this;
+    
+  }
   
-  Vowel::Roundedness& operator++(Vowel::Roundedness& start_val, int);
+  inline Syllable::const_iterator& 
+  Syllable::const_iterator::operator-=(difference_type offset) {
     
-    /*
-    Iterates through the Roundedness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    _position -= offset;
+    return *this;
+    
+  }
   
-  Vowel::Roundedness& operator--(Vowel::Roundedness& start_val);
+  inline Syllable::const_iterator 
+  Syllable::const_iterator::operator+(difference_type offset) const {
     
-    /*
-    Iterates through the Roundedness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    const_iterator result(*this);
+    result._position += offset;
+    return result;
+    
+  }
   
-  Vowel::Roundedness& operator--(Vowel::Roundedness& start_val, int);
+  inline Syllable::const_iterator 
+  Syllable::const_iterator::operator-(difference_type offset) const {
     
-    /*
-    Iterates through the Roundedness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    const_iterator result(*this);
+    result._position -= offset;
+    return result;
     
-  Vowel::Roundedness& operator+=(Vowel::Roundedness& start_val, int val);
+  }
+  
+  inline Syllable::const_iterator::difference_type 
+  Syllable::const_iterator::operator-(const const_iterator& other) const {
     
-    /*
-    Iterates through the Roundedness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _position - other._position;
+    
+  }
   
-  Vowel::Roundedness& operator-=(Vowel::Roundedness& start_val, int val);
+  inline bool 
+  Syllable::const_iterator::operator==(const const_iterator& other) const {
     
-    /*
-    Iterates through the Roundedness enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _syllable == other._syllable && _position == other._position;
+    
+  }
   
-  std::string string(Vowel::Roundedness& roundedness);
+  inline bool 
+  Syllable::const_iterator::operator!=(const const_iterator& other) const {
     
-    /*
-    Returns the name of the Roundedness value in string form.
+    return !(*this == other);
     
-    Parameters:
-      roundedness: Roundedness to be converted
-    */
+  }
   
-  Consonant::Manner& operator++(Consonant::Manner& start_val);
+  inline bool 
+  Syllable::const_iterator::operator>(const const_iterator& other) const {
     
-    /*
-    Iterates through the Manner enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _position > other._position;
+    
+  }
   
-  Consonant::Manner& operator++(Consonant::Manner& start_val, int);
+  inline bool 
+  Syllable::const_iterator::operator<(const const_iterator& other) const {
     
-    /*
-    Iterates through the Manner enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _position < other._position;
+    
+  }
   
-  Consonant::Manner& operator--(Consonant::Manner& start_val);
+  inline bool 
+  Syllable::const_iterator::operator>=(const const_iterator& other) const {
     
-    /*
-    Iterates through the Manner enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _position >= other._position;
+    
+  }
   
-  Consonant::Manner& operator--(Consonant::Manner& start_val, int);
+  inline bool 
+  Syllable::const_iterator::operator<=(const const_iterator& other) const {
     
-    /*
-    Iterates through the Manner enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _position <= other._position;
     
-  Consonant::Manner& operator+=(Consonant::Manner& start_val, int val);
+  }
+  
+  inline bool Syllable::const_iterator::operator>(int position) const {
     
-    /*
-    Iterates through the Manner enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return this->position() > position;
+    
+  }
   
-  Consonant::Manner& operator-=(Consonant::Manner& start_val, int val);
+  inline bool Syllable::const_iterator::operator<(int position) const {
     
-    /*
-    Iterates through the Manner enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return this->position() < position;
+    
+  }
   
-  std::string string(Consonant::Manner& manner);
+  inline bool Syllable::const_iterator::operator>=(int position) const {
     
-    /*
-    Returns the name of the Manner value in string form.
+    return this->position() >= position;
     
-    Parameters:
-      manner: Manner to be converted
-    */
-  Consonant::Place& operator++(Consonant::Place& start_val);
+  }
+  
+  inline bool Syllable::const_iterator::operator<=(int position) const {
     
-    /*
-    Iterates through the Place enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return this->position() <= position;
+    
+  }
   
-  Consonant::Place& operator++(Consonant::Place& start_val, int);
+  inline Syllable::Slot Syllable::const_iterator::operator*() const {
     
-    /*
-    Iterates through the Place enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _syllable->slot(_position);
+    
+  }
   
-  Consonant::Place& operator--(Consonant::Place& start_val);
+  inline Syllable::Arrow<Syllable::Slot> 
+  Syllable::const_iterator::operator->() const {
     
-    /*
-    Iterates through the Place enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return Arrow<Slot>(**this);
+    
+  }
   
-  Consonant::Place& operator--(Consonant::Place& start_val, int);
+  inline Syllable::Slot 
+  Syllable::const_iterator::operator[](difference_type offset) const {
     
-    /*
-    Iterates through the Place enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return _syllable->slot(_position + offset);
     
-  Consonant::Place& operator+=(Consonant::Place& start_val, int val);
+  }
+  
+  inline const Syllable& Syllable::const_iterator::syllable() const {
     
-    /*
-    Iterates through the Place enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return *_syllable;
+    
+  }
   
-  Consonant::Place& operator-=(Consonant::Place& start_val, int val);
+  inline void 
+  Syllable::const_iterator::set_syllable(const Syllable& new_syllable) {
     
-    /*
-    Iterates through the Place enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    _syllable = &new_syllable;
+    
+  }
   
-  std::string string(Consonant::Place& place);
+  inline int Syllable::const_iterator::position() const {
     
-    /*
-    Returns the name of the Place value in string form.
+    return _position;
     
-    Parameters:
-      place: Place to be converted
-    */
+  }
   
-  Consonant::VOT& operator++(Consonant::VOT& start_val);
+  inline int Syllable::const_iterator::inverse_position() const {
     
-    /*
-    Iterates through the VOT enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return position() - _syllable->_size;
+    
+  }
   
-  Consonant::VOT& operator++(Consonant::VOT& start_val, int);
+  inline Syllable::Cell* Syllable::cells() {
     
-    /*
-    Iterates through the VOT enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    const Syllable& self = *this;
+    Cell* result = const_cast<Cell*>(self.cells());
+    _changed.store(true, std::memory_order_relaxed);
+    return result;
+    
+  }
   
-  Consonant::VOT& operator--(Consonant::VOT& start_val);
+  inline const Syllable::Cell* Syllable::cells() const {
     
-    /*
-    Iterates through the VOT enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    const Cell* result = _cells.load(std::memory_order_acquire);
+    if(result) {
+      return result;
+    }
+    
+    return materialize();
+    
+  }
   
-  Consonant::VOT& operator--(Consonant::VOT& start_val, int);
+  inline Phone& Syllable::unchecked(int index) {
     
-    /*
-    Iterates through the VOT enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    touch();
+    return cells()[index].phone();
     
-  Consonant::VOT& operator+=(Consonant::VOT& start_val, int val);
+  }
+  
+  inline const Phone& Syllable::unchecked(int index) const {
     
-    /*
-    Iterates through the VOT enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return cells()[index].phone();
+    
+  }
   
-  Consonant::VOT& operator-=(Consonant::VOT& start_val, int val);
+  // Templates
+  
+  template <class Value>
+  Syllable::Arrow<Value>::Arrow(const Value& value) : _value(value) {}
+  
+  template <class Value>
+  const Value* Syllable::Arrow<Value>::operator->() const {
     
-    /*
-    Iterates through the VOT enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    return &_value;
+    
+  }
   
-  std::string string(Consonant::VOT& vot);
+  template <class Kind>
+  Kind& Syllable::phone_at(Syllable* syllable, int index, Kind*) {
     
-    /*
-    Returns the name of the VOT value in string form.
+    return static_cast<Kind&>(syllable->cells()[index].phone());
     
-    Parameters:
-      vot: VOT to be converted
-    */
+  }
   
-  Consonant::Mechanism& operator++(Consonant::Mechanism& start_val);
+  template <class OutputIterator>
+  OutputIterator Syllable::encode(OutputIterator output, 
+                                  PhoneticEncoding encoding) const {
+    
+    LANG_INSTRUMENT_TIME(Instrumentation::encode_event(encoding));
+    
+    char buffer[phone_encoding_size];
+    for(int i = 0; i < _size; i++) {
+      int length = encode_phone(i, encoding, buffer);
+      for(int j = 0; j < length; j++) {
+        *output = buffer[j];
+        ++output;
+      }
+    }
+    
+    int length = encode_tone(encoding, buffer);
+    for(int j = 0; j < length; j++) {
+      *output = buffer[j];
+      ++output;
+    }
+    
+    return output;
+    
+  }
+  
+  template <class Visitor>
+  void Syllable::visit(Visitor&& visitor) const {
+    
+    const Cell* cells = changed_cells();
+    const Slot* phones = slots();
+    int nucleus_end = _onset_size + _nucleus_size;
+    for(int i = 0; i < _size; i++) {
+      Part part = i < _onset_size ? onset_part : 
+                  i < nucleus_end ? nucleus_part : coda_part;
+      if(cells) {
+        const Cell& cell = cells[i];
+        if(cell._is_vowel) {
+          visitor(cell._vowel, part);
+        }
+        else {
+          visitor(cell._consonant, part);
+        }
+      }
+      else if(phones[i].is_vowel()) {
+        const Vowel vowel = phones[i].vowel();
+        visitor(vowel, part);
+      }
+      else {
+        const Consonant consonant = phones[i].consonant();
+        visitor(consonant, part);
+      }
+    }
+    
+  }
+  
+  template <class Visitor>
+  void Syllable::visit_slots(Visitor& visitor) {
+    
+    settle();
+    Slot* phones = slots();
+    int nucleus_end = _onset_size + _nucleus_size;
+    bool changed = false;
+    for(int i = 0; i < _size; i++) {
+      Part part = i < _onset_size ? onset_part : 
+                  i < nucleus_end ? nucleus_part : coda_part;
+      changed |= visitor(phones[i], part);
+    }
+    
+    if(changed) {
+      touch();
+    }
+    
+  }
+  
+  template <class Visitor>
+  void Syllable::visit(Visitor&& visitor) {
+    
+    touch();
+    Cell* cells = this->cells();
+    int nucleus_end = _onset_size + _nucleus_size;
+    for(int i = 0; i < _size; i++) {
+      Part part = i < _onset_size ? onset_part : 
+                  i < nucleus_end ? nucleus_part : coda_part;
+      if(cells[i]._is_vowel) {
+        visitor(cells[i]._vowel, part);
+      }
+      else {
+        visitor(cells[i]._consonant, part);
+      }
+    }
+    
+  }
+  
+  // ArenaAllocator
     
-    /*
-    Iterates through the Mechanism enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    template <class T>
+    ArenaAllocator<T>::ArenaAllocator(Arena& arena) noexcept : 
+        _arena(&arena) {}
+    
+    template <class T>
+    template <class U>
+    ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& original) 
+        noexcept : _arena(original._arena) {}
+    
+    template <class T>
+    T* ArenaAllocator<T>::allocate(std::size_t count) {
+      
+      return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+      
+    }
+    
+    template <class T>
+    void ArenaAllocator<T>::deallocate(T*, std::size_t) noexcept {}
+    
+    template <class T>
+    Arena& ArenaAllocator<T>::arena() const noexcept {
+      
+      return *_arena;
+      
+    }
+    
+    template <class T>
+    template <class U>
+    bool ArenaAllocator<T>::operator==(const ArenaAllocator<U>& other) const 
+        noexcept {
+      
+      return _arena == other._arena;
+      
+    }
+    
+    template <class T>
+    template <class U>
+    bool ArenaAllocator<T>::operator!=(const ArenaAllocator<U>& other) const 
+        noexcept {
+      
+      return _arena != other._arena;
+      
+    }
   
-  Consonant::Mechanism& operator++(Consonant::Mechanism& start_val, int);
+};
+
+// Specializations
+
+namespace std {
+  
+  /*
+  These let the phonetic types be used as keys in std::unordered_map and 
+  std::unordered_set.  Each one calls the type's hash().
+  */
+  
+  template <>
+  struct hash<lang::PhoneCode> {
     
-    /*
-    Iterates through the Mechanism enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    std::size_t operator()(const lang::PhoneCode& phone) const {
+      
+      return phone.hash();
+      
+    }
+    
+  };
   
-  Consonant::Mechanism& operator--(Consonant::Mechanism& start_val);
+  template <>
+  struct hash<lang::Vowel> {
     
-    /*
-    Iterates through the Mechanism enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    std::size_t operator()(const lang::Vowel& vowel) const {
+      
+      return vowel.hash();
+      
+    }
+    
+  };
   
-  Consonant::Mechanism& operator--(Consonant::Mechanism& start_val, int);
+  template <>
+  struct hash<lang::Consonant> {
     
-    /*
-    Iterates through the Mechanism enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    std::size_t operator()(const lang::Consonant& consonant) const {
+      
+      return consonant.hash();
+      
+    }
     
-  Consonant::Mechanism& operator+=(Consonant::Mechanism& start_val, int val);
+  };
+  
+  template <>
+  struct hash<lang::Tone> {
     
-    /*
-    Iterates through the Mechanism enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    std::size_t operator()(const lang::Tone& tone) const {
+      
+      return tone.hash();
+      
+    }
+    
+  };
   
-  Consonant::Mechanism& operator-=(Consonant::Mechanism& start_val, int val);
+  template <>
+  struct hash<lang::ToneCode> {
     
-    /*
-    Iterates through the Mechanism enumeration in numerical order.  Will go 
-    around the horn.
-    */
+    std::size_t operator()(const lang::ToneCode& code) const {
+      
+      return code.hash();
+      
+    }
+    
+  };
   
-  std::string string(Consonant::Mechanism& mechanism);
+  template <>
+  struct hash<lang::Syllable> {
     
-    /*
-    Returns the name of the Mechanism value in string form.
+    std::size_t operator()(const lang::Syllable& syllable) const {
+      
+      return syllable.hash();
+      
+    }
     
-    Parameters:
-      mechanism: Mechanism to be converted
-    */
+  };
   
 };
 
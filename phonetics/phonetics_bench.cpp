@@ -0,0 +1,943 @@
+/*
+Filename: phonetics_bench.cpp
+
+Benchmarks for the phonetics portion of the lang library
+*/
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <numeric>
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+
+#include "phonetics.h"
+
+using namespace lang;
+
+// Fixtures
+
+namespace {
+  
+  // Syllables of the kind found in a pronouncing dictionary, in X-SAMPA
+  const char* const sample_transcriptions[] = {
+    "\"strENkT", "p_hA:", "kIt", "m@", "\"wO:t", "@r", "sk_hwE@r", "bju:",
+    "tSIld", "dZVmp", "\"T_hIN", "%kA:n", "fl{S", "grIps", "n=", "ju:",
+    "\"lVv", "SO:r", "t_hEkst", "v@U", "ma_H_L", "t_hOI", "\"baI", "ZA~",
+    "k_wet_j", "h\\A:", "mAm", "pl{nt", "stOp", "Dis"
+  };
+  
+  const int sample_count = sizeof(sample_transcriptions) / sizeof(char*);
+  
+  std::vector<std::string> transcriptions(PhoneticEncoding encoding,
+                                          int count) {
+    
+    // The samples repeated to make a corpus of count syllables
+    std::vector<std::string> result;
+    for(int i = 0; i < count; i++) {
+      std::string transcription;
+      Syllable(sample_transcriptions[i % sample_count]).encode(transcription,
+                                                              encoding);
+      result.push_back(transcription);
+    }
+    
+    return result;
+    
+  }
+  
+  PhoneticSequence corpus(int count) {
+    
+    PhoneticSequence result;
+    for(int i = 0; i < count; i++) {
+      result.push_back(Syllable(sample_transcriptions[i % sample_count]));
+    }
+    
+    return result;
+    
+  }
+  
+  const int corpus_size = 10000;
+  
+};
+
+// Phones
+
+static void BM_VowelConstruction(benchmark::State& state) {
+  
+  for(auto _ : state) {
+    Vowel vowel(Vowel::near_open, Vowel::near_front, Vowel::unrounded,
+                Phone::nasal, false, Phone::modal, 2.0);
+    benchmark::DoNotOptimize(vowel);
+  }
+  
+}
+BENCHMARK(BM_VowelConstruction);
+
+static void BM_ConsonantConstruction(benchmark::State& state) {
+  
+  for(auto _ : state) {
+    Consonant consonant(Consonant::stop, Consonant::velar, Phone::voiceless,
+                        Consonant::moderately_aspirated);
+    benchmark::DoNotOptimize(consonant);
+  }
+  
+}
+BENCHMARK(BM_ConsonantConstruction);
+
+static void BM_ConsonantValidation(benchmark::State& state) {
+  
+  // Tries every manner and place, most of which are possible and some not
+  for(auto _ : state) {
+    int possible = 0;
+    for(int manner = 0; manner <= Consonant::nasal; manner++) {
+      for(int place = 0; place <= Consonant::glottal; place++) {
+        try {
+          Consonant consonant((Consonant::Manner) manner,
+                              (Consonant::Place) place,
+                              Phone::modal, Consonant::completely_voiced);
+          possible++;
+        }
+        catch(ImpossibleArticulation&) {}
+      }
+    }
+    benchmark::DoNotOptimize(possible);
+  }
+  
+}
+BENCHMARK(BM_ConsonantValidation);
+
+static void BM_ConsonantCheck(benchmark::State& state) {
+  
+  // The same enumeration as BM_ConsonantValidation without exceptions
+  for(auto _ : state) {
+    int possible = 0;
+    for(int manner = 0; manner <= Consonant::nasal; manner++) {
+      for(int place = 0; place <= Consonant::glottal; place++) {
+        possible += !Consonant::check((Consonant::Manner) manner, 
+                                      (Consonant::Place) place, 
+                                      Phone::modal, 
+                                      Consonant::completely_voiced);
+      }
+    }
+    benchmark::DoNotOptimize(possible);
+  }
+  
+}
+BENCHMARK(BM_ConsonantCheck);
+
+static void BM_PhoneCodeRoundTrip(benchmark::State& state) {
+  
+  Consonant consonant(Consonant::sib_fricative,
+                      Consonant::laminal_palato_alveolar,
+                      Phone::voiceless, Consonant::not_aspirated);
+  for(auto _ : state) {
+    PhoneCode code(consonant);
+    benchmark::DoNotOptimize(code.consonant());
+  }
+  
+}
+BENCHMARK(BM_PhoneCodeRoundTrip);
+
+static void BM_Description(benchmark::State& state) {
+  
+  Vowel vowel(Vowel::close, Vowel::back, Vowel::exolabial);
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(vowel.description());
+  }
+  
+}
+BENCHMARK(BM_Description);
+
+static void BM_EnumString(benchmark::State& state) {
+  
+  for(auto _ : state) {
+    for(int i = 0; i <= Consonant::glottal; i++) {
+      benchmark::DoNotOptimize(lang::string((Consonant::Place) i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (Consonant::glottal + 1));
+  
+}
+BENCHMARK(BM_EnumString);
+
+static void BM_EnumParse(benchmark::State& state) {
+  
+  // Parses every Place name, as when loading a configuration
+  std::vector<std::string> names;
+  for(int i = 0; i <= Consonant::glottal; i++) {
+    names.push_back(name((Consonant::Place) i));
+  }
+  for(auto _ : state) {
+    for(int i = 0; i < (int) names.size(); i++) {
+      Consonant::Place place = Consonant::bilabial;
+      benchmark::DoNotOptimize(parse(names[i], place));
+      benchmark::DoNotOptimize(place);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * names.size());
+  
+}
+BENCHMARK(BM_EnumParse);
+
+// Syllables
+
+static void BM_SyllableCopy(benchmark::State& state) {
+  
+  Syllable syllable("\"strENkT");
+  for(auto _ : state) {
+    Syllable copy(syllable);
+    benchmark::DoNotOptimize(copy);
+  }
+  
+}
+BENCHMARK(BM_SyllableCopy);
+
+static void BM_SyllableAssignment(benchmark::State& state) {
+  
+  Syllable syllable1("\"strENkT");
+  Syllable syllable2("p_hA:");
+  for(auto _ : state) {
+    syllable2 = syllable1;
+    benchmark::DoNotOptimize(syllable2);
+    syllable2 = Syllable();
+  }
+  
+}
+BENCHMARK(BM_SyllableAssignment);
+
+static void BM_SequenceGrowth(benchmark::State& state) {
+  
+  // Syllables too long to be stored inline, so growing the sequence would 
+  // allocate for every one of them if they were copied rather than moved
+  Syllable syllable("a");
+  for(int i = 0; i < 2 * Syllable::inline_capacity; i++) {
+    syllable.insert_coda(Consonant(), 0);
+  }
+  for(auto _ : state) {
+    PhoneticSequence sequence;
+    for(int i = 0; i < 1000; i++) {
+      sequence.push_back(syllable);
+    }
+    benchmark::DoNotOptimize(sequence.data());
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+  
+}
+BENCHMARK(BM_SequenceGrowth);
+
+static void BM_ArenaSequence(benchmark::State& state) {
+  
+  // BM_SequenceGrowth with the buffer and the phones stored in an arena, 
+  // which is reset rather than freeing every syllable
+  Syllable syllable("a");
+  for(int i = 0; i < 2 * Syllable::inline_capacity; i++) {
+    syllable.insert_coda(Consonant(), 0);
+  }
+  Arena arena;
+  for(auto _ : state) {
+    {
+      ArenaSequence sequence{ArenaAllocator<Syllable>(arena)};
+      for(int i = 0; i < 1000; i++) {
+        sequence.push_back(Syllable(syllable, &arena));
+      }
+      benchmark::DoNotOptimize(sequence.data());
+    }
+    arena.reset();
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+  
+}
+BENCHMARK(BM_ArenaSequence);
+
+static void BM_ToneIteration(benchmark::State& state) {
+  
+  const Tone tone(1, 0, -1);
+  for(auto _ : state) {
+    int sum = 0;
+    for(Tone::const_iterator i = tone.begin(); i != tone.end(); ++i) {
+      sum += *i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  
+}
+BENCHMARK(BM_ToneIteration);
+
+static void BM_ToneCodeIteration(benchmark::State& state) {
+  
+  const ToneCode code(1, 0, -1);
+  for(auto _ : state) {
+    int sum = 0;
+    for(int8_t level : code) {
+      sum += level;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  
+}
+BENCHMARK(BM_ToneCodeIteration);
+
+static void BM_ToneHistogram(benchmark::State& state) {
+  
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    long long counts[ToneCode::count] = {};
+    tone_histogram(sequence, counts);
+    benchmark::DoNotOptimize(counts);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_ToneHistogram);
+
+static void BM_ColumnarToneHistogram(benchmark::State& state) {
+  
+  ColumnarSequence columns(corpus(corpus_size));
+  for(auto _ : state) {
+    long long counts[ToneCode::count] = {};
+    columns.tone_histogram(counts);
+    benchmark::DoNotOptimize(counts);
+  }
+  state.SetItemsProcessed(state.iterations() * columns.size());
+  
+}
+BENCHMARK(BM_ColumnarToneHistogram);
+
+static void BM_SequenceTraversal(benchmark::State& state) {
+  
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    int vowels = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      for(int j = 0; j < syllable.size(); j++) {
+        vowels += PhoneCode(syllable[j]).is_vowel();
+      }
+    }
+    benchmark::DoNotOptimize(vowels);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SequenceTraversal);
+
+static void BM_SequenceChecked(benchmark::State& state) {
+  
+  // Total phone length through the bounds-checked operator[]
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    float length = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      for(int j = 0; j < syllable.size(); j++) {
+        length += syllable[j].length();
+      }
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SequenceChecked);
+
+static void BM_SequenceUnchecked(benchmark::State& state) {
+  
+  // The query in BM_SequenceChecked, without bounds checks
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    float length = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      for(int j = 0; j < syllable.size(); j++) {
+        length += syllable.unchecked(j).length();
+      }
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SequenceUnchecked);
+
+static void BM_SequenceAlgorithm(benchmark::State& state) {
+  
+  // The same query with std::accumulate over the iterators
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    float length = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      const Syllable& syllable = sequence[i];
+      length = std::accumulate(syllable.begin(), syllable.end(), length, 
+                               [](float total, Syllable::Slot slot) {
+                                 return total + slot.code().length();
+                               });
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SequenceAlgorithm);
+
+namespace {
+  
+  struct VowelCounter {
+    
+    int vowels;
+    
+    void operator()(const Vowel&, Syllable::Part) {
+      
+      vowels++;
+      
+    }
+    
+    void operator()(const Consonant&, Syllable::Part) {}
+    
+  };
+  
+};
+
+static void BM_SequenceVisit(benchmark::State& state) {
+  
+  // The query in BM_SequenceTraversal, without virtual calls
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    VowelCounter counter = {0};
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      sequence[i].visit(counter);
+    }
+    benchmark::DoNotOptimize(counter.vowels);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SequenceVisit);
+
+static void BM_SequenceSpan(benchmark::State& state) {
+  
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    int vowels = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      for(const Syllable::Slot& slot : sequence[i].span()) {
+        vowels += slot.is_vowel();
+      }
+    }
+    benchmark::DoNotOptimize(vowels);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SequenceSpan);
+
+static void BM_SyllableIndex(benchmark::State& state) {
+  
+  // Type and token counting, one token at a time
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    SyllableIndex index;
+    index.add(sequence);
+    benchmark::DoNotOptimize(index.size());
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SyllableIndex);
+
+static void BM_NgramCounter(benchmark::State& state) {
+  
+  // Trigrams of every part, on one thread or sharded over a pool
+  PhoneticSequence sequence = corpus(corpus_size);
+  ThreadPool pool(state.range(0));
+  for(auto _ : state) {
+    NgramCounter counter(3);
+    if(state.range(0) == 1) {
+      counter.add(sequence);
+    }
+    else {
+      counter.add(sequence, pool);
+    }
+    benchmark::DoNotOptimize(counter.syllables());
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_NgramCounter)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+static void BM_LexiconLookup(benchmark::State& state) {
+  
+  // Every thread reads the same frozen lexicon
+  static const Lexicon lexicon = []() {
+    Lexicon result;
+    PhoneticSequence sequence = corpus(corpus_size);
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      result.add("word" + std::to_string(i), PhoneticSequence(1, sequence[i]));
+    }
+    result.freeze();
+    return result;
+  }();
+  std::vector<std::string> words;
+  for(int i = 0; i < 1000; i++) {
+    words.push_back("word" + std::to_string(i * 7 % corpus_size));
+  }
+  for(auto _ : state) {
+    int phones = 0;
+    for(int i = 0; i < (int) words.size(); i++) {
+      Lexicon::Pronunciation pronunciation = lexicon[lexicon.find(words[i])];
+      phones += pronunciation[0].size();
+    }
+    benchmark::DoNotOptimize(phones);
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+  
+}
+BENCHMARK(BM_LexiconLookup)->Threads(1)->Threads(2)->Threads(4)->UseRealTime();
+
+static void BM_ColumnarCount(benchmark::State& state) {
+  
+  // The query in BM_SequenceTraversal and a narrower one, over columns
+  ColumnarSequence columns(corpus(corpus_size));
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(columns.count_vowels());
+    benchmark::DoNotOptimize(columns.count(Consonant::stop, Consonant::velar,
+                                           Phone::voiceless));
+  }
+  state.SetItemsProcessed(state.iterations() * columns.size());
+  
+}
+BENCHMARK(BM_ColumnarCount);
+
+static void BM_FeatureScan(benchmark::State& state) {
+  
+  // Aspirated velar and uvular consonants, one phone at a time
+  ColumnarSequence columns(corpus(corpus_size));
+  const PhoneCode* codes = columns.codes();
+  for(auto _ : state) {
+    int matches = 0;
+    for(int i = 0; i < columns.phone_count(); i++) {
+      matches += codes[i].is_consonant() && 
+                 (codes[i].place() == Consonant::velar || 
+                  codes[i].place() == Consonant::uvular) && 
+                 codes[i].vot() >= Consonant::weakly_aspirated;
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * columns.phone_count());
+  
+}
+BENCHMARK(BM_FeatureScan);
+
+static void BM_FeatureIndex(benchmark::State& state) {
+  
+  // The same query, with bitmaps
+  FeatureIndex index(ColumnarSequence(corpus(corpus_size)));
+  for(auto _ : state) {
+    FeatureIndex::Bitmap matches = index.consonants() & 
+      (index.place(Consonant::velar) | index.place(Consonant::uvular)) & 
+      index.vot(Consonant::weakly_aspirated, Consonant::strongly_aspirated);
+    benchmark::DoNotOptimize(matches.count());
+  }
+  state.SetItemsProcessed(state.iterations() * index.size());
+  
+}
+BENCHMARK(BM_FeatureIndex);
+
+static void BM_ColumnarMeanHeight(benchmark::State& state) {
+  
+  ColumnarSequence columns(corpus(corpus_size));
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(columns.mean_height());
+  }
+  state.SetItemsProcessed(state.iterations() * columns.size());
+  
+}
+BENCHMARK(BM_ColumnarMeanHeight);
+
+// Sound changes
+
+namespace {
+  
+  SoundChange round_trip_changes(int repeats) {
+    
+    // Raise front vowels and aspirate voiceless onset stops, then undo both,
+    // so that after the first pass the corpus stays the same.  The four 
+    // rules are repeated to make a larger rule set.
+    SoundChange::Rule raising;
+    raising.match_backness(0, 1);
+    raising.raise(1.0);
+    SoundChange::Rule aspiration;
+    aspiration.match_manner(Consonant::stop);
+    aspiration.match_phonation(Phone::voiceless);
+    aspiration.match_part(Syllable::onset_part);
+    aspiration.later_vot(1);
+    
+    SoundChange::Rule lowering(raising);
+    lowering.lower(2.0);
+    SoundChange::Rule deaspiration(aspiration);
+    deaspiration.earlier_vot(2);
+    
+    SoundChange result;
+    for(int i = 0; i < repeats; i++) {
+      result.add(raising);
+      result.add(aspiration);
+      result.add(lowering);
+      result.add(deaspiration);
+    }
+    
+    return result;
+    
+  }
+  
+};
+
+static void BM_SoundChangePerPhone(benchmark::State& state) {
+  
+  // The changes in round_trip_changes(1), made one phone at a time through 
+  // the mutators
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    long long rejected = 0;
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      Syllable& syllable = sequence[i];
+      for(int j = 0; j < syllable.size(); j++) {
+        Phone& phone = syllable[j];
+        Vowel* vowel = dynamic_cast<Vowel*>(&phone);
+        if(vowel) {
+          if(vowel->backness() <= 1) {
+            rejected += vowel->try_raise(1.0) != Phone::no_violation;
+            rejected += vowel->try_lower(1.0) != Phone::no_violation;
+          }
+          continue;
+        }
+        Consonant* consonant = dynamic_cast<Consonant*>(&phone);
+        if(j < syllable.onset_size() && 
+           consonant->manner() == Consonant::stop && 
+           consonant->phonation() == Phone::voiceless) {
+          int vot = std::min(consonant->vot() + 1, 
+                             (int) Consonant::strongly_aspirated);
+          rejected += consonant->try_set_vot((Consonant::VOT) vot) != 
+                      Phone::no_violation;
+          vot = std::max(consonant->vot() - 1, 
+                         (int) Consonant::completely_voiced);
+          rejected += consonant->try_set_vot((Consonant::VOT) vot) != 
+                      Phone::no_violation;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(rejected);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SoundChangePerPhone);
+
+static void BM_SoundChangeSequence(benchmark::State& state) {
+  
+  PhoneticSequence sequence = corpus(corpus_size);
+  SoundChange changes = round_trip_changes(state.range(0));
+  std::vector<SoundChange::Rejection> rejections;
+  for(auto _ : state) {
+    rejections.clear();
+    benchmark::DoNotOptimize(changes.apply(sequence, &rejections));
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_SoundChangeSequence)->Arg(1)->Arg(250);
+
+static void BM_SoundChangeColumns(benchmark::State& state) {
+  
+  ColumnarSequence columns(corpus(corpus_size));
+  SoundChange changes = round_trip_changes(state.range(0));
+  std::vector<SoundChange::Rejection> rejections;
+  for(auto _ : state) {
+    rejections.clear();
+    benchmark::DoNotOptimize(changes.apply(columns, &rejections));
+  }
+  state.SetItemsProcessed(state.iterations() * columns.size());
+  
+}
+BENCHMARK(BM_SoundChangeColumns)->Arg(1)->Arg(250);
+
+// Distances
+
+namespace {
+  
+  std::vector<PhoneCode> inventory(int count) {
+    
+    // The corpus's phones repeated to make an inventory of count phones
+    PhoneticSequence sequence = corpus(sample_count);
+    std::vector<PhoneCode> phones;
+    for(int i = 0; (int) phones.size() < count; i++) {
+      const Syllable& syllable = sequence[i % sample_count];
+      for(int j = 0; j < syllable.size() && (int) phones.size() < count; j++) {
+        phones.push_back(PhoneCode(syllable[j]));
+      }
+    }
+    
+    return phones;
+    
+  }
+  
+};
+
+static void BM_PairwiseDistance(benchmark::State& state) {
+  
+  // One pair at a time, for comparison with BM_DistanceMatrix
+  std::vector<PhoneCode> phones = inventory(state.range(0));
+  std::vector<float> matrix(phones.size() * phones.size());
+  for(auto _ : state) {
+    for(int i = 0; i < (int) phones.size(); i++) {
+      for(int j = 0; j < (int) phones.size(); j++) {
+        matrix[i * phones.size() + j] = PhoneFeatures::distance(phones[i], 
+                                                                phones[j]);
+      }
+    }
+    benchmark::DoNotOptimize(matrix.data());
+  }
+  state.SetItemsProcessed(state.iterations() * matrix.size());
+  
+}
+BENCHMARK(BM_PairwiseDistance)->Arg(1000);
+
+static void BM_DistanceMatrix(benchmark::State& state) {
+  
+  PhoneFeatures batch(inventory(state.range(0)));
+  std::vector<float> matrix((std::size_t) batch.size() * batch.size());
+  for(auto _ : state) {
+    batch.distance_matrix(matrix.data());
+    benchmark::DoNotOptimize(matrix.data());
+  }
+  state.SetItemsProcessed(state.iterations() * matrix.size());
+  
+}
+BENCHMARK(BM_DistanceMatrix)->Arg(1000)->Arg(10000);
+
+static void BM_DistanceMatrixParallel(benchmark::State& state) {
+  
+  PhoneFeatures batch(inventory(10000));
+  std::vector<float> matrix((std::size_t) batch.size() * batch.size());
+  ThreadPool pool(state.range(0));
+  for(auto _ : state) {
+    batch.distance_matrix(matrix.data(), pool);
+    benchmark::DoNotOptimize(matrix.data());
+  }
+  state.SetItemsProcessed(state.iterations() * matrix.size());
+  
+}
+BENCHMARK(BM_DistanceMatrixParallel)->Arg(4)->UseRealTime();
+
+// Alignment
+
+static void BM_AlignmentDistance(benchmark::State& state) {
+  
+  // Pairs of neighbouring words from the corpus, with a band if range(0) is 
+  // not negative
+  PhoneticSequence sequence = corpus(1000);
+  std::vector<PhoneticSequence> words;
+  for(int i = 0; i + 3 <= (int) sequence.size(); i += 3) {
+    words.push_back(PhoneticSequence(sequence.begin() + i, 
+                                     sequence.begin() + i + 3));
+  }
+  Aligner aligner;
+  int band = state.range(0);
+  for(auto _ : state) {
+    float total = 0;
+    for(int i = 0; i + 1 < (int) words.size(); i++) {
+      total += aligner.distance(words[i], words[i + 1], band);
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (words.size() - 1));
+  
+}
+BENCHMARK(BM_AlignmentDistance)->Arg(-1)->Arg(2);
+
+static void BM_EditDistance(benchmark::State& state) {
+  
+  PhoneticSequence sequence = corpus(1000);
+  std::vector<PhoneticSequence> words;
+  for(int i = 0; i + 3 <= (int) sequence.size(); i += 3) {
+    words.push_back(PhoneticSequence(sequence.begin() + i, 
+                                     sequence.begin() + i + 3));
+  }
+  for(auto _ : state) {
+    int total = 0;
+    for(int i = 0; i + 1 < (int) words.size(); i++) {
+      total += Aligner::edit_distance(words[i], words[i + 1]);
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (words.size() - 1));
+  
+}
+BENCHMARK(BM_EditDistance);
+
+// Decoding and encoding
+
+static void BM_Decode(benchmark::State& state) {
+  
+  PhoneticEncoding encoding = (PhoneticEncoding) state.range(0);
+  std::vector<std::string> input = transcriptions(encoding, corpus_size);
+  Decoder decoder(encoding);
+  Syllable syllable;
+  long long bytes = 0;
+  for(auto _ : state) {
+    for(int i = 0; i < (int) input.size(); i++) {
+      decoder.decode(input[i].data(), input[i].size(), syllable);
+      bytes += input[i].size();
+    }
+    benchmark::DoNotOptimize(syllable);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+  state.SetBytesProcessed(bytes);
+  
+}
+BENCHMARK(BM_Decode)->Arg(x_sampa)->Arg(kirschenbaum)->Arg(unicode);
+
+static void BM_DecodeParallel(benchmark::State& state) {
+  
+  std::vector<std::string> input = transcriptions(x_sampa, corpus_size * 10);
+  ThreadPool pool(state.range(0));
+  Decoder decoder;
+  PhoneticSequence output;
+  std::vector<int> failures;
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(decoder.decode(input, output, failures, pool));
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+  
+}
+BENCHMARK(BM_DecodeParallel)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+static void BM_Encode(benchmark::State& state) {
+  
+  PhoneticEncoding encoding = (PhoneticEncoding) state.range(0);
+  PhoneticSequence sequence = corpus(corpus_size);
+  std::string output;
+  for(auto _ : state) {
+    output.clear();
+    encode(sequence, output, encoding);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  state.SetBytesProcessed(state.iterations() * output.size());
+  
+}
+BENCHMARK(BM_Encode)->Arg(x_sampa)->Arg(kirschenbaum)->Arg(unicode);
+
+static void BM_EncodeCached(benchmark::State& state) {
+  
+  // Re-rendering after an edit, as an editor does on every keystroke
+  PhoneticEncoding encoding = (PhoneticEncoding) state.range(0);
+  PhoneticSequence sequence = corpus(corpus_size);
+  EncodingCache cache;
+  std::string output;
+  cache.encode(sequence, output, encoding);
+  for(auto _ : state) {
+    sequence[sequence.size() / 2].insert_coda(Consonant(), 0);
+    output.clear();
+    cache.encode(sequence, output, encoding);
+    benchmark::DoNotOptimize(output.data());
+    sequence[sequence.size() / 2].remove_coda(0);
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  state.SetBytesProcessed(state.iterations() * output.size());
+  
+}
+BENCHMARK(BM_EncodeCached)->Arg(x_sampa)->Arg(kirschenbaum)->Arg(unicode);
+
+static void BM_EncodeString(benchmark::State& state) {
+  
+  // The allocating accessor, for comparison with BM_Encode
+  PhoneticSequence sequence = corpus(corpus_size);
+  for(auto _ : state) {
+    for(int i = 0; i < (int) sequence.size(); i++) {
+      benchmark::DoNotOptimize(sequence[i].unicode());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * sequence.size());
+  
+}
+BENCHMARK(BM_EncodeString);
+
+static void BM_TranscodeStream(benchmark::State& state) {
+  
+  std::vector<std::string> input = transcriptions(x_sampa, corpus_size);
+  std::string text;
+  for(int i = 0; i < (int) input.size(); i++) {
+    text += input[i];
+    text += '\n';
+  }
+  
+  Transcoder transcoder(x_sampa, unicode);
+  for(auto _ : state) {
+    std::istringstream in(text);
+    std::ostringstream out;
+    transcoder.transcode(in, out);
+    benchmark::DoNotOptimize(out.tellp());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  
+}
+BENCHMARK(BM_TranscodeStream)->UseRealTime();
+
+static void BM_BoundsCheckFailure(benchmark::State& state) {
+  
+  // Throwing and catching the IndexError of a failed bounds check
+  Syllable syllable("ka");
+  for(auto _ : state) {
+    try {
+      benchmark::DoNotOptimize(&syllable[5]);
+    }
+    catch(expt::IndexError& e) {
+      benchmark::DoNotOptimize(e.index());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  
+}
+BENCHMARK(BM_BoundsCheckFailure);
+
+static void BM_ArticulationFailure(benchmark::State& state) {
+  
+  // Throwing and catching an ImpossibleArticulation with a fixed message
+  for(auto _ : state) {
+    try {
+      Vowel vowel(7, 2, Vowel::unrounded);
+      benchmark::DoNotOptimize(&vowel);
+    }
+    catch(std::exception& e) {
+      benchmark::DoNotOptimize(e.what());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  
+}
+BENCHMARK(BM_ArticulationFailure);
+
+static void BM_InstrumentationRecord(benchmark::State& state) {
+  
+  // The cost of one counted event, paid by every hook when the library is 
+  // built with LANG_INSTRUMENTATION
+  for(auto _ : state) {
+    Instrumentation::record(Instrumentation::syllable_copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+  
+}
+BENCHMARK(BM_InstrumentationRecord);
+
+static void BM_InstrumentationTimer(benchmark::State& state) {
+  
+  // The cost of one timed event, including both clock reads
+  for(auto _ : state) {
+    Instrumentation::Timer timer(Instrumentation::unicode_decode);
+  }
+  state.SetItemsProcessed(state.iterations());
+  
+}
+BENCHMARK(BM_InstrumentationTimer);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,240 @@
+/*
+Filename: phonetics_fuzz.cpp
+
+Fuzz target for the phonetic transcription decoders
+
+Every input is decoded in each of the supported transcription systems.
+Whenever decoding succeeds, the syllable is encoded again in every system and
+the result must decode back to the same syllable, and re-encoding in the
+original system must be stable.  Any other outcome, or any exception, aborts.
+
+Built with -fsanitize=fuzzer, this is a libFuzzer target.  Built with
+-DLANG_FUZZ_REPLAY, it instead runs every file named on the command line (or
+every file in a directory named on the command line) through the same checks,
+so that the corpus can be replayed as a regression test without libFuzzer.  
+Replay also runs every pair of phonation, aspiration and ejective marks on a 
+set of consonants that covers each airstream mechanism, since the fuzzer 
+rarely stacks two diacritics on one phone.
+*/
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#ifdef LANG_FUZZ_REPLAY
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "phonetics.h"
+
+using namespace lang;
+
+namespace {
+  
+  const PhoneticEncoding encodings[] = {x_sampa, kirschenbaum, unicode};
+  
+  const int encoding_count = sizeof(encodings) / sizeof(PhoneticEncoding);
+  
+  const Decoder decoders[] = {Decoder(x_sampa), Decoder(kirschenbaum),
+                              Decoder(unicode)};
+  
+  // Kirschenbaum has no tone marks, no spelling for several diacritics, and 
+  // some spellings that are ambiguous (h<?> is both a breathy [h] and [ɦ], 
+  // and s; is both a palatalized [s] and [ɕ]), so it only has to preserve 
+  // the syllables it can spell: those decoded from it that have no breathy 
+  // or palatalized phones.
+  bool lossless(int source, int target, const Syllable& syllable) {
+    
+    if(encodings[target] != kirschenbaum) {
+      return true;
+    }
+    if(source != target) {
+      return false;
+    }
+    
+    for(int i = 0; i < syllable.size(); i++) {
+      PhoneCode phone(syllable[i]);
+      if(phone.phonation() == Phone::breathy) {
+        return false;
+      }
+      if(phone.is_consonant() && 
+         phone.secondary_articulation() == Consonant::palatal) {
+        return false;
+      }
+    }
+    
+    return true;
+    
+  }
+  
+  void fail(const char* check, const char* data, int size,
+            PhoneticEncoding encoding) {
+    
+    std::fprintf(stderr, "Round trip failed (%s) in encoding %d for input: ",
+                 check, (int) encoding);
+    std::fwrite(data, 1, size, stderr);
+    std::fputc('\n', stderr);
+    std::abort();
+    
+  }
+  
+  bool same_shape(const Syllable& a, const Syllable& b) {
+    
+    return a.onset_size() == b.onset_size() &&
+           a.nucleus_size() == b.nucleus_size() && a.size() == b.size();
+    
+  }
+  
+  void round_trip(const char* data, int size) {
+    
+    Syllable syllable;
+    Syllable again;
+    std::string first;
+    std::string second;
+    for(int i = 0; i < encoding_count; i++) {
+      if(decoders[i].decode(data, size, syllable) != -1) {
+        continue;
+      }
+      
+      for(int j = 0; j < encoding_count; j++) {
+        first.clear();
+        syllable.encode(first, encodings[j]);
+        
+        // Every phone the decoders produce has a spelling in every system, 
+        // so the result must decode, and always to the same syllable in a 
+        // lossless system.
+        if(decoders[j].decode(first.data(), first.size(), again) != -1) {
+          fail("re-decoding", data, size, encodings[j]);
+        }
+        if(lossless(i, j, syllable) ? again != syllable : 
+                            !same_shape(again, syllable)) {
+          fail("equality", data, size, encodings[j]);
+        }
+        
+        second.clear();
+        again.encode(second, encodings[j]);
+        if(second != first) {
+          fail("re-encoding", data, size, encodings[j]);
+        }
+      }
+      
+      // The encoders must agree with each other about the length.
+      char buffer[256];
+      int length = syllable.encode(buffer, sizeof(buffer), encodings[i]);
+      first.clear();
+      syllable.encode(first, encodings[i]);
+      if(length != (int) first.size() ||
+         first.compare(0, std::string::npos, buffer,
+                       std::min(length, (int) sizeof(buffer))) != 0) {
+        fail("buffer encoding", data, size, encodings[i]);
+      }
+    }
+    
+  }
+  
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  
+  try {
+    round_trip((const char*) data, size);
+  }
+  catch(std::exception& e) {
+    std::fprintf(stderr, "Unexpected exception: %s\n", e.what());
+    std::abort();
+  }
+  
+  return 0;
+  
+}
+
+#ifdef LANG_FUZZ_REPLAY
+
+namespace {
+  
+  void replay(const std::string& path, int& count) {
+    
+    struct stat status;
+    if(stat(path.c_str(), &status) != 0) {
+      std::cerr << "Cannot open " << path << '\n';
+      std::exit(1);
+    }
+    
+    if(S_ISDIR(status.st_mode)) {
+      DIR* directory = opendir(path.c_str());
+      while(dirent* entry = readdir(directory)) {
+        if(entry->d_name[0] != '.') {
+          replay(path + '/' + entry->d_name, count);
+        }
+      }
+      closedir(directory);
+      return;
+    }
+    
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string input = contents.str();
+    LLVMFuzzerTestOneInput((const uint8_t*) input.data(), input.size());
+    count++;
+    
+  }
+  
+  // Pulmonic consonants of each phonation, clicks and implosives
+  const char* stacked_bases[][2] = {{"p", "p"}, {"b", "b"}, {"5", "\xC9\xAB"}, 
+                                    {"n", "n"}, {"r", "r"}, {"l", "l"}, 
+                                    {"O\\", "\xCA\x98"}, {"|\\", "\xC7\x80"}, 
+                                    {"b_<", "\xC9\x93"}};
+  
+  // Voiceless, breathy, creaky, aspirated and ejective
+  const char* stacked_marks[][2] = {{"_0", "\xCC\xA5"}, {"_t", "\xCC\xA4"}, 
+                                    {"_k", "\xCC\xB0"}, {"_h", "\xCA\xB0"}, 
+                                    {"_>", "\xCA\xBC"}};
+  
+  void replay_stacked(int& count) {
+    
+    const int base_count = sizeof(stacked_bases) / sizeof(stacked_bases[0]);
+    const int mark_count = sizeof(stacked_marks) / sizeof(stacked_marks[0]);
+    
+    // X-SAMPA and Unicode, which spell every one of the marks
+    const int spellings[] = {0, 1};
+    for(int spelling : spellings) {
+      for(int base = 0; base < base_count; base++) {
+        for(int first = 0; first < mark_count; first++) {
+          for(int second = 0; second < mark_count; second++) {
+            std::string input = std::string(stacked_bases[base][spelling]) + 
+                                stacked_marks[first][spelling] + 
+                                stacked_marks[second][spelling] + "a";
+            LLVMFuzzerTestOneInput((const uint8_t*) input.data(), 
+                                   input.size());
+            count++;
+          }
+        }
+      }
+    }
+    
+  }
+  
+};
+
+int main(int argc, char** argv) {
+  
+  int count = 0;
+  for(int i = 1; i < argc; i++) {
+    replay(argv[i], count);
+  }
+  replay_stacked(count);
+  std::cout << "Replayed " << count << " inputs\n";
+  
+  return 0;
+  
+}
+
+#endif
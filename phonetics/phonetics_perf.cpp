@@ -0,0 +1,332 @@
+/*
+Filename: phonetics_perf.cpp
+
+Throughput regression check for the phonetic transcription decoders and
+encoders
+
+Decodes and encodes a fixed corpus in each supported transcription system,
+and measures the peak memory of the whole run.  Throughput is not measured in
+absolute terms, which would say as much about the machine as about the code.
+Each decode and encode is timed against a reference workload run in the same
+process over the same bytes, a table-driven checksum that does not use the
+library, and the measurement is how many times longer than the reference it
+takes.  The measurements are compared against a baseline, and the program exits
+with a nonzero status if any of them is worse than the baseline by more than a
+tolerance.
+
+Usage:
+  perf.o baseline [tolerance]   Compare against baseline, allowing measurements
+                                to be worse by the fraction tolerance (0.25 by
+                                default).
+  perf.o --write baseline       Measure and write a new baseline.
+
+Each timing is the best of several repetitions, in CPU time rather than wall
+time, and the reference is timed alongside the library so that both see the
+machine in the same state.  If anything regresses, the whole run is measured
+again, up to three times, keeping the best value of each measurement, so a
+regression has to persist to fail the check.  The baseline,
+phonetics_baseline.txt, is checked in and make test compares against it.
+After a change that is meant to move performance, make baseline rewrites it,
+and the new file is committed with the change.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+#include <time.h>
+#include <sys/resource.h>
+
+#include "phonetics.h"
+
+using namespace lang;
+
+namespace {
+  
+  // Syllables of the kind found in a pronouncing dictionary, in X-SAMPA
+  const char* const sample_transcriptions[] = {
+    "\"strENkT", "p_hA:", "kIt", "m@", "\"wO:t", "@r", "sk_hwE@r", "bju:",
+    "tSIld", "dZVmp", "\"T_hIN", "%kA:n", "fl{S", "grIps", "n=", "ju:",
+    "\"lVv", "SO:r", "t_hEkst", "v@U", "ma_H_L", "t_hOI", "\"baI", "ZA~",
+    "k_wet_j", "h\\A:", "mAm", "pl{nt", "stOp", "Dis"
+  };
+  
+  const int sample_count = sizeof(sample_transcriptions) / sizeof(char*);
+  
+  const int corpus_size = 20000;
+  
+  const int repetitions = 15;
+  
+  const int attempts = 3;
+  
+  const double default_tolerance = 0.25;
+  
+  const uint32_t checksum_prime = 16777619;
+  
+  const char* const encoding_names[] = {"x_sampa", "kirschenbaum", "unicode"};
+  
+  struct Measurement {
+    
+    std::string name;
+    double value;
+    bool higher_is_better;
+    
+  };
+  
+  volatile uint32_t checksum_sink;
+  
+  double cpu_seconds() {
+    
+    // Time spent running this thread, so that other processes on a busy 
+    // machine do not count against it
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+    
+  }
+  
+  void checksum(const std::vector<std::string>& input) {
+    
+    // An FNV-1a checksum through a byte table, which has the shape of a 
+    // decoder's inner loop: one load, one lookup, and a dependent update 
+    // per byte
+    uint32_t table[256];
+    for(int i = 0; i < 256; i++) {
+      table[i] = i * 0x9E3779B9u;
+    }
+    
+    uint32_t result = 2166136261u;
+    for(int i = 0; i < (int) input.size(); i++) {
+      const std::string& text = input[i];
+      for(int j = 0; j < (int) text.size(); j++) {
+        result = (result ^ table[(unsigned char) text[j]]) * checksum_prime;
+      }
+    }
+    checksum_sink = result;
+    
+  }
+  
+  template <class Function>
+  double relative_time(Function function, 
+                       const std::vector<std::string>& input) {
+    
+    // The reference runs over the same input just before each repetition, 
+    // so that both see the machine in the same state
+    double best = 0;
+    double best_reference = 0;
+    for(int i = 0; i < repetitions; i++) {
+      double start = cpu_seconds();
+      checksum(input);
+      double middle = cpu_seconds();
+      function();
+      double end = cpu_seconds();
+      if(i == 0 || middle - start < best_reference) {
+        best_reference = middle - start;
+      }
+      if(i == 0 || end - middle < best) {
+        best = end - middle;
+      }
+    }
+    
+    return best / best_reference;
+    
+  }
+  
+  void measure_encoding(PhoneticEncoding encoding,
+                        std::vector<Measurement>& results) {
+    
+    // The samples repeated to make a corpus of corpus_size syllables
+    std::vector<std::string> input;
+    for(int i = 0; i < corpus_size; i++) {
+      std::string transcription;
+      Syllable(sample_transcriptions[i % sample_count]).encode(transcription,
+                                                              encoding);
+      input.push_back(transcription);
+    }
+    
+    Decoder decoder(encoding);
+    PhoneticSequence sequence(corpus_size);
+    double decoding = relative_time([&]() {
+      for(int i = 0; i < corpus_size; i++) {
+        if(decoder.decode(input[i].data(), input[i].size(), sequence[i])
+           != -1) {
+          std::cerr << "Cannot decode " << input[i] << '\n';
+          std::exit(1);
+        }
+      }
+    }, input);
+    
+    // The encoder's reference reads what it writes
+    std::string output;
+    encode(sequence, output, encoding);
+    double encoding_time = relative_time([&]() {
+      output.clear();
+      encode(sequence, output, encoding);
+    }, std::vector<std::string>(1, output));
+    
+    std::string prefix = encoding_names[encoding];
+    results.push_back({prefix + ".decode.relative_time", decoding, false});
+    results.push_back({prefix + ".encode.relative_time", encoding_time,
+                       false});
+    
+  }
+  
+  std::vector<Measurement> measure() {
+    
+    std::vector<Measurement> results;
+    measure_encoding(x_sampa, results);
+    measure_encoding(kirschenbaum, results);
+    measure_encoding(unicode, results);
+    
+    // ru_maxrss is in kilobytes on Linux
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    results.push_back({"peak_memory_kilobytes", (double) usage.ru_maxrss,
+                       false});
+    
+    return results;
+    
+  }
+  
+  bool find(const std::vector<Measurement>& baseline, const std::string& name,
+            double& value) {
+    
+    for(int i = 0; i < (int) baseline.size(); i++) {
+      if(baseline[i].name == name) {
+        value = baseline[i].value;
+        return true;
+      }
+    }
+    
+    return false;
+    
+  }
+  
+  std::vector<Measurement> read_baseline(const char* path) {
+    
+    // One "name value" pair per line; lines starting with # are comments.
+    std::ifstream file(path);
+    if(!file) {
+      std::cerr << "Cannot open baseline " << path 
+                << ".  Write one with --write first.\n";
+      std::exit(1);
+    }
+    
+    std::vector<Measurement> result;
+    std::string line;
+    while(std::getline(file, line)) {
+      if(line.empty() || line[0] == '#') {
+        continue;
+      }
+      char name[128];
+      double value;
+      if(std::sscanf(line.c_str(), "%127s %lf", name, &value) != 2) {
+        std::cerr << "Malformed baseline line: " << line << '\n';
+        std::exit(1);
+      }
+      result.push_back({name, value, true});
+    }
+    
+    return result;
+    
+  }
+  
+  void write_baseline(const char* path,
+                      const std::vector<Measurement>& measurements) {
+    
+    std::ofstream file(path);
+    file << "# Baseline for phonetics_perf.cpp.  Regenerate with make baseline."
+         << '\n';
+    for(int i = 0; i < (int) measurements.size(); i++) {
+      file << measurements[i].name << ' ' << measurements[i].value << '\n';
+    }
+    
+  }
+  
+  int report(const std::vector<Measurement>& baseline, 
+             const std::vector<Measurement>& measurements, double tolerance, 
+             bool print) {
+    
+    // Returns the number of measurements worse than the baseline by more 
+    // than tolerance, printing each one if print is set
+    int regressions = 0;
+    for(int i = 0; i < (int) measurements.size(); i++) {
+      const Measurement& measurement = measurements[i];
+      double expected;
+      if(!find(baseline, measurement.name, expected)) {
+        if(print) {
+          std::printf("%-42s %12.2f   (no baseline)\n", 
+                      measurement.name.c_str(), measurement.value);
+        }
+        continue;
+      }
+      
+      double change = (measurement.value - expected) / expected;
+      bool regressed = measurement.higher_is_better ? change < -tolerance
+                                                    : change > tolerance;
+      if(print) {
+        std::printf("%-42s %12.2f %+7.1f%%%s\n", measurement.name.c_str(),
+                    measurement.value, change * 100,
+                    regressed ? "   REGRESSION" : "");
+      }
+      if(regressed) {
+        regressions++;
+      }
+    }
+    
+    return regressions;
+    
+  }
+  
+};
+
+int main(int argc, char** argv) {
+  
+  if(argc == 3 && std::strcmp(argv[1], "--write") == 0) {
+    std::vector<Measurement> measurements = measure();
+    write_baseline(argv[2], measurements);
+    std::cout << "Wrote " << measurements.size() << " measurements to "
+              << argv[2] << '\n';
+    return 0;
+  }
+  
+  if(argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " baseline [tolerance]\n"
+              << "       " << argv[0] << " --write baseline\n";
+    return 2;
+  }
+  
+  std::vector<Measurement> baseline = read_baseline(argv[1]);
+  double tolerance = argc == 3 ? std::atof(argv[2]) : default_tolerance;
+  std::vector<Measurement> measurements = measure();
+  
+  // A regression has to survive fresh measurements, keeping the best value 
+  // of each, so that a burst of noise on a shared machine does not fail the 
+  // check while a real slowdown still does
+  for(int attempt = 1; attempt < attempts && 
+      report(baseline, measurements, tolerance, false) > 0; attempt++) {
+    std::vector<Measurement> retry = measure();
+    for(int i = 0; i < (int) measurements.size(); i++) {
+      if(measurements[i].higher_is_better 
+         ? retry[i].value > measurements[i].value 
+         : retry[i].value < measurements[i].value) {
+        measurements[i] = retry[i];
+      }
+    }
+  }
+  int regressions = report(baseline, measurements, tolerance, true);
+  
+  if(regressions > 0) {
+    std::printf("%d measurement(s) regressed by more than %.0f%%\n",
+                regressions, tolerance * 100);
+    return 1;
+  }
+  
+  return 0;
+  
+}
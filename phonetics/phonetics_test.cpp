@@ -4,6 +4,22 @@ Filename: phonetics_test.cpp
 Test code for the phonetics portion of the lang library
 */
 
+#include <sstream>
+#include <streambuf>
+#include <stdexcept>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <unordered_set>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <type_traits>
+
 #include <gtest/gtest.h>
 
 #include "phonetics.h"
@@ -28,7 +44,7 @@ TEST(ImpossibleArticulationTest, standard_constructor) {
   EXPECT_EQ("", impossible_articulation2.message());
   
   ImpossibleArticulation impossible_articulation3("askdfjaklf");
-  EXPECT_EQ("askdfjaklf", impossible_articulation4.message());
+  EXPECT_EQ("askdfjaklf", impossible_articulation3.message());
   
 }
 
@@ -68,7 +84,7 @@ TEST(ImpossibleArticulationTest, value_error_conversion) {
   EXPECT_EQ(impossible_articulation1.message(), value_error1.message());
   
   // Explicit cast
-  ImpossibleArticulation impossible_articulation2();
+  ImpossibleArticulation impossible_articulation2;
   expt::ValueError value_error2 = (expt::ValueError) impossible_articulation2;
   EXPECT_EQ(impossible_articulation2.message(), value_error2.message());
   
@@ -109,7 +125,7 @@ TEST(PhoneTest, set_nasalization) {
   vowel1.set_nasalization(Phone::nasal);
   EXPECT_EQ(Phone::nasal, vowel1.nasalization());
   
-  Consonant consonant;
+  Consonant consonant1;
   consonant1.set_nasalization(Phone::strongly_nasal);
   EXPECT_EQ(Phone::strongly_nasal, consonant1.nasalization());
   
@@ -155,16 +171,16 @@ TEST(PhoneTest, set_phonation) {
   EXPECT_EQ(Phone::slack, consonant1.phonation());
   
   // ImpossibleArticulation thrown when expected
-  EXPECT_THROW(ImpossibleArticulation) {
+  EXPECT_THROW({
     consonant1.set_vot(Consonant::completely_voiced);
     consonant1.set_phonation(Phone::voiceless);
-  }
+  }, ImpossibleArticulation);
   
-  EXPECT_THROW(ImpossibleArticulation) {
+  EXPECT_THROW({
     consonant1.set_place(Consonant::glottal);
     consonant1.set_manner(Consonant::stop);
     consonant1.set_phonation(Phone::modal);
-  }
+  }, ImpossibleArticulation);
   
 }
 
@@ -179,13 +195,13 @@ TEST(PhoneTest, incr_phonation) {
   EXPECT_EQ(Phone::modal, vowel1.phonation());
   
   // ImpossibleArticulation thrown when expected
-  EXPECT_THROW(ImpossibleArticulation) {
+  EXPECT_THROW({
     Consonant consonant1(Consonant::stop, 
                          Consonant::glottal, 
                          Phone::voiceless, 
                          Consonant::moderately_aspirated);
     consonant1.incr_phonation(1);
-  }
+  }, ImpossibleArticulation);
   
 }
 
@@ -227,7 +243,7 @@ TEST(PhoneTest, set_length) {
   
   Consonant consonant1;
   consonant1.set_length(0.01);
-  EXPECT_EQ(0.01, consonant1.length());
+  EXPECT_FLOAT_EQ(0.01, consonant1.length());
   
 }
 
@@ -239,7 +255,7 @@ TEST(PhoneTest, lengthen) {
   EXPECT_EQ(1.5, vowel1.length());
   
   vowel1.lengthen(0.4);
-  EXPECT_EQ(1.9, vowel1.length());
+  EXPECT_FLOAT_EQ(1.9, vowel1.length());
   
 }
 
@@ -248,10 +264,10 @@ TEST(PhoneTest, shorten) {
   Consonant consonant1;
   consonant1.set_length(1.0);
   consonant1.shorten(0.1);
-  EXPECT_EQ(0.9, consonant1.length());
+  EXPECT_FLOAT_EQ(0.9, consonant1.length());
   
   consonant1.shorten(0.05);
-  EXPECT_EQ(0.85, consonant1.length());
+  EXPECT_FLOAT_EQ(0.85, consonant1.length());
   
 }
 
@@ -274,7 +290,7 @@ TEST(PhoneTest, halve_length) {
   Vowel vowel1;
   vowel1.set_length(1.0);
   vowel1.halve_length();
-  EXPECT_EQ(0.5, vowel1.length);
+  EXPECT_EQ(0.5, vowel1.length());
   
   Consonant consonant1;
   consonant1.set_length(2.0);
@@ -292,7 +308,7 @@ TEST(VowelTest, empty_constructor) {
   EXPECT_EQ(Vowel::central, vowel1.backness());
   EXPECT_EQ(Vowel::unrounded, vowel1.roundedness());
   EXPECT_FALSE(vowel1.is_nasal());
-  EXPECT_FALSE(vowel1.is_r-colored());
+  EXPECT_FALSE(vowel1.is_r_colored());
   EXPECT_EQ(Phone::modal, vowel1.phonation());
   EXPECT_EQ(1.0, vowel1.length());
   
@@ -307,7 +323,7 @@ TEST(VowelTest, simple_constructor) {
   EXPECT_EQ(Vowel::front, vowel1.backness());
   EXPECT_EQ(Vowel::exolabial, vowel1.roundedness());
   EXPECT_FALSE(vowel1.is_nasal());
-  EXPECT_FALSE(vowel1.is_r-colored());
+  EXPECT_FALSE(vowel1.is_r_colored());
   EXPECT_EQ(Phone::modal, vowel1.phonation());
   EXPECT_EQ(1.0, vowel1.length());
   
@@ -323,7 +339,7 @@ TEST(VowelTest, detailed_constructor) {
   EXPECT_EQ(Vowel::near_front, vowel1.backness());
   EXPECT_EQ(Vowel::endolabial, vowel1.roundedness());
   EXPECT_TRUE(vowel1.is_nasal());
-  EXPECT_TRUE(vowel1.is_r-colored());
+  EXPECT_TRUE(vowel1.is_r_colored());
   EXPECT_EQ(Phone::slack, vowel1.phonation());
   EXPECT_EQ(2.0, vowel1.length());
   
@@ -366,7 +382,7 @@ TEST(VowelTest, equality_operator) {
   Vowel vowel1(Vowel::open, Vowel::mid, Vowel::endolabial);
   Vowel vowel2(Vowel::open, Vowel::mid, Vowel::endolabial);
   EXPECT_EQ(vowel1, vowel2);
-  EXPECT_TRUE(vowel 1 == vowel2);
+  EXPECT_TRUE(vowel1 == vowel2);
   
   Vowel vowel3;
   Vowel vowel4(Vowel::open, Vowel::close_mid, Vowel::exolabial);
@@ -396,20 +412,21 @@ TEST(VowelTest, description) {
   EXPECT_EQ("mid central unrounded vowel", vowel1.description());
   
   Vowel vowel2(Vowel::close, Vowel::central, Vowel::exolabial);
-  EXPECT_EQ("close central rounded vowel");
+  EXPECT_EQ("close central rounded vowel", vowel2.description());
   
   Vowel vowel3(Vowel::near_open, Vowel::near_front, Vowel::unrounded, 
-               Phone::nasal, false, Phonation::modal, 2.0);
-  EXPECT_EQ("long nasal near-open near-front unrounded vowel");
+               Phone::nasal, false, Phone::modal, 2.0);
+  EXPECT_EQ("long nasal near-open near-front unrounded vowel", 
+            vowel3.description());
   
   Vowel vowel4(Vowel::near_open, Vowel::near_back, Vowel::endolabial, 
-               Phone::strongly_nasal, true, 3.0);
+               Phone::strongly_nasal, true, Phone::modal, 3.0);
   EXPECT_EQ("extra-long strongly-nasal r-colored near-open near-back endolabial rounded vowel",
             vowel4.description());
   
   Vowel vowel5(Vowel::near_close, Vowel::back, Vowel::unrounded, Phone::oral, 
-               false, 0.5);
-  EXPECT_EQ("short near-close back unrounded vowel");
+               false, Phone::modal, 0.5);
+  EXPECT_EQ("short near-close back unrounded vowel", vowel5.description());
   
 }
 
@@ -481,7 +498,7 @@ TEST(VowelTest, backness) {
 TEST(VowelTest, set_backness) {
   
   Vowel vowel1;
-  EXPECT_EQ(2.0, vowel1.backness())
+  EXPECT_EQ(2.0, vowel1.backness());
     
   vowel1.set_backness(1.0);
   EXPECT_EQ(1.0, vowel1.backness());
@@ -516,7 +533,7 @@ TEST(VowelTest, move_back) {
   
   vowel1.set_backness(0.0);
   vowel1.move_back(0.01);
-  EXPECT_EQ(0.01, vowel1.backness());
+  EXPECT_FLOAT_EQ(0.01, vowel1.backness());
   
 }
 
@@ -532,7 +549,7 @@ TEST(VowelTest, move_forward) {
   EXPECT_EQ(0.5, vowel1.backness());
   
   vowel1.move_forward(0.01);
-  EXPECT_EQ(0.49, vowel1.backness());
+  EXPECT_FLOAT_EQ(0.49, vowel1.backness());
   
   bool error_thrown(false);
   try {
@@ -542,7 +559,7 @@ TEST(VowelTest, move_forward) {
     error_thrown = true;
   }
   EXPECT_TRUE(error_thrown);
-  EXPECT_EQ(0.49, vowel1.backness());
+  EXPECT_FLOAT_EQ(0.49, vowel1.backness());
   
 }
 
@@ -657,7 +674,7 @@ TEST(ConsonantTest, standard_constructor) {
   Consonant consonant1(Consonant::stop, 
                        Consonant::bilabial, 
                        Phone::voiceless, 
-                       VOT::moderately_aspirated);
+                       Consonant::moderately_aspirated);
   EXPECT_EQ(Consonant::stop, consonant1.manner());
   EXPECT_EQ(Consonant::bilabial, consonant1.place());
   EXPECT_FALSE(consonant1.has_secondary_articulation());
@@ -749,7 +766,7 @@ TEST(ConsonantTest, standard_constructor) {
   EXPECT_TRUE(exception_thrown);
   
   // Error case 5 - manner-nasalization conflict
-  bool exception_thrown(false);
+  exception_thrown = false;
   try {
     Consonant consonant7(Consonant::nasal, 
                          Consonant::laminal_dental, 
@@ -782,7 +799,3387 @@ TEST(ConsonantTest, standard_constructor) {
   
 }
 
-int main() {
+TEST(PhoneCodeTest, empty_constructor) {
+  
+  // Default code is a Schwa
+  PhoneCode code1;
+  EXPECT_TRUE(code1.is_vowel());
+  EXPECT_EQ(Vowel(), code1.vowel());
+  
+}
+
+TEST(PhoneCodeTest, vowel_constructor) {
+  
+  Vowel vowel1(Vowel::near_open, Vowel::near_front, Vowel::endolabial,
+               Phone::nasal, true, Phone::slack, 2.0);
+  PhoneCode code1(vowel1);
+  EXPECT_TRUE(code1.is_vowel());
+  EXPECT_FALSE(code1.is_consonant());
+  EXPECT_EQ(Vowel::near_open, code1.height());
+  EXPECT_EQ(Vowel::near_front, code1.backness());
+  EXPECT_EQ(Vowel::endolabial, code1.roundedness());
+  EXPECT_TRUE(code1.is_r_colored());
+  EXPECT_EQ(Phone::nasal, code1.nasalization());
+  EXPECT_EQ(Phone::slack, code1.phonation());
+  EXPECT_EQ(2.0, code1.length());
+  
+}
+
+TEST(PhoneCodeTest, consonant_constructor) {
+  
+  Consonant consonant1(Consonant::nsib_fricative, 
+                       Consonant::labiodental, 
+                       Phone::voiceless, 
+                       Consonant::not_aspirated, 
+                       Phone::oral, 
+                       Consonant::pul_eg, 
+                       2.0);
+  consonant1.set_secondary_articulation(Consonant::velar);
+  PhoneCode code1(consonant1);
+  EXPECT_TRUE(code1.is_consonant());
+  EXPECT_FALSE(code1.is_vowel());
+  EXPECT_EQ(Consonant::nsib_fricative, code1.manner());
+  EXPECT_EQ(Consonant::labiodental, code1.place());
+  EXPECT_EQ(Consonant::velar, code1.secondary_articulation());
+  EXPECT_EQ(Phone::voiceless, code1.phonation());
+  EXPECT_EQ(Consonant::not_aspirated, code1.vot());
+  EXPECT_EQ(Phone::oral, code1.nasalization());
+  EXPECT_EQ(Consonant::pul_eg, code1.mechanism());
+  EXPECT_EQ(2.0, code1.length());
+  
+}
+
+TEST(PhoneCodeTest, round_trip) {
+  
+  // Vowels on the quantization grid round-trip exactly
+  Vowel vowel1(4.5, 3.25, Vowel::exolabial, Phone::strongly_nasal, false, 
+               Phone::breathy, 0.01);
+  EXPECT_EQ(vowel1, PhoneCode(vowel1).vowel());
+  
+  // Consonants always round-trip exactly
+  Consonant consonant1;
+  EXPECT_EQ(consonant1, PhoneCode(consonant1).consonant());
+  
+  Consonant consonant2(Consonant::stop, 
+                       Consonant::bilabial, 
+                       Phone::voiceless, 
+                       Consonant::moderately_aspirated);
+  consonant2.set_secondary_articulation(Consonant::palatal);
+  EXPECT_EQ(consonant2, PhoneCode(consonant2).consonant());
+  
+  // Phone constructor dispatches on the dynamic type
+  const Phone& phone1 = consonant2;
+  EXPECT_EQ(PhoneCode(consonant2), PhoneCode(phone1));
+  
+}
+
+TEST(PhoneCodeTest, equality_operator) {
+  
+  PhoneCode code1(Vowel(Vowel::open, Vowel::front, Vowel::unrounded));
+  PhoneCode code2(Vowel(Vowel::open, Vowel::front, Vowel::unrounded));
+  EXPECT_TRUE(code1 == code2);
+  EXPECT_FALSE(code1 != code2);
+  
+  PhoneCode code3(Vowel(Vowel::open, Vowel::back, Vowel::unrounded));
+  EXPECT_TRUE(code1 != code3);
+  EXPECT_TRUE(code1 < code3 || code3 < code1);
+  
+  Consonant consonant1;
+  PhoneCode code4(consonant1);
+  EXPECT_TRUE(code1 != code4);
+  
+}
+
+TEST(PhoneCodeTest, wrong_kind) {
+  
+  bool exception_thrown(false);
+  try {
+    PhoneCode(Consonant()).vowel();
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  exception_thrown = false;
+  try {
+    PhoneCode(Vowel()).consonant();
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, empty_constructor) {
+  
+  // The default syllable is just a Schwa
+  Syllable syllable1;
+  EXPECT_EQ(1, syllable1.size());
+  EXPECT_EQ(0, syllable1.onset_size());
+  EXPECT_EQ(1, syllable1.nucleus_size());
+  EXPECT_EQ(0, syllable1.coda_size());
+  EXPECT_EQ(1, syllable1.vowels().size());
+  EXPECT_EQ(Vowel(), syllable1.vowels()[0]);
+  
+}
+
+TEST(SyllableTest, detailed_constructor) {
+  
+  Consonant consonant1;
+  Vowel vowel1(Vowel::open, Vowel::front, Vowel::unrounded);
+  Consonant consonant2(Consonant::nasal, 
+                       Consonant::bilabial, 
+                       Phone::modal, 
+                       Consonant::completely_voiced, 
+                       Phone::nasal);
+  std::vector<const Phone*> onset(1, &consonant1);
+  std::vector<const Phone*> nucleus(1, &vowel1);
+  std::vector<const Phone*> coda(1, &consonant2);
+  Syllable syllable1(onset, nucleus, coda);
+  
+  // Fields initialize as expected
+  EXPECT_EQ(3, syllable1.size());
+  EXPECT_EQ(1, syllable1.onset_size());
+  EXPECT_EQ(1, syllable1.nucleus_size());
+  EXPECT_EQ(1, syllable1.coda_size());
+  EXPECT_EQ(vowel1, syllable1.vowels()[0]);
+  EXPECT_EQ(consonant1, syllable1.consonants()[0]);
+  EXPECT_EQ(consonant2, syllable1.consonants()[1]);
+  EXPECT_EQ(&syllable1[1], &syllable1.nucleus()[0]);
+  
+  // Empty nucleus
+  bool exception_thrown(false);
+  try {
+    Syllable syllable2(onset, std::vector<const Phone*>(), coda);
+  }
+  catch(ImpossibleArticulation e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, copy_constructor) {
+  
+  // Phones stored inline
+  Syllable syllable1;
+  syllable1.insert_onset(Consonant(), 0);
+  Syllable syllable2(syllable1);
+  EXPECT_TRUE(syllable1 == syllable2);
+  EXPECT_NE(&syllable1[0], &syllable2[0]);
+  
+  // Phones stored on the heap
+  Syllable syllable3;
+  for(int i = 0; i < Syllable::inline_capacity + 2; i++) {
+    syllable3.insert_coda(Consonant(), 0);
+  }
+  Syllable syllable4(syllable3);
+  EXPECT_EQ(Syllable::inline_capacity + 3, syllable4.size());
+  EXPECT_TRUE(syllable3 == syllable4);
+  
+}
+
+TEST(SyllableTest, assignment_operator) {
+  
+  Syllable syllable1;
+  Syllable syllable2;
+  for(int i = 0; i < Syllable::inline_capacity + 2; i++) {
+    syllable2.insert_onset(Consonant(), 0);
+  }
+  
+  // Growing
+  syllable1 = syllable2;
+  EXPECT_TRUE(syllable2 == syllable1);
+  
+  // Shrinking
+  Syllable syllable3;
+  syllable1 = syllable3;
+  EXPECT_TRUE(syllable3 == syllable1);
+  EXPECT_EQ(1, syllable1.size());
+  
+}
+
+TEST(SyllableTest, bracket_operator) {
+  
+  Syllable syllable1;
+  syllable1.insert_onset(Consonant(), 0);
+  EXPECT_EQ(PhoneCode(Consonant()), PhoneCode(syllable1[0]));
+  EXPECT_EQ(&syllable1[1], &syllable1[-1]);
+  
+  // IndexError thrown when expected
+  bool exception_thrown(false);
+  try {
+    syllable1[2];
+  }
+  catch(expt::IndexError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, insert) {
+  
+  Syllable syllable1;
+  Consonant consonant1;
+  Consonant consonant2(Consonant::nsib_fricative, 
+                       Consonant::labiodental, 
+                       Phone::voiceless, 
+                       Consonant::not_aspirated);
+  
+  // Onset, with appending and negative positions
+  syllable1.insert_onset(consonant1, 0);
+  syllable1.insert_onset(consonant2, 1);
+  syllable1.insert_onset(consonant2, -3);
+  EXPECT_EQ(3, syllable1.onset_size());
+  EXPECT_EQ(PhoneCode(consonant2), PhoneCode(syllable1[0]));
+  EXPECT_EQ(PhoneCode(consonant1), PhoneCode(syllable1[1]));
+  EXPECT_EQ(PhoneCode(consonant2), PhoneCode(syllable1[2]));
+  
+  // Nucleus and coda
+  Vowel vowel1(Vowel::close, Vowel::back, Vowel::exolabial);
+  syllable1.insert_nucleus(vowel1, -1);
+  syllable1.insert_coda(consonant1, 0);
+  EXPECT_EQ(2, syllable1.nucleus_size());
+  EXPECT_EQ(1, syllable1.coda_size());
+  EXPECT_EQ(PhoneCode(vowel1), PhoneCode(syllable1[4]));
+  EXPECT_EQ(PhoneCode(consonant1), PhoneCode(syllable1[5]));
+  
+  // IndexError thrown when expected
+  bool exception_thrown(false);
+  try {
+    syllable1.insert_coda(consonant1, 3);
+  }
+  catch(expt::IndexError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, remove) {
+  
+  Syllable syllable1;
+  syllable1.insert_onset(Consonant(), 0);
+  syllable1.insert_coda(Consonant(), 0);
+  syllable1.insert_nucleus(Vowel(Vowel::close, Vowel::front, 
+                                 Vowel::unrounded), 1);
+  
+  syllable1.remove_onset(0);
+  syllable1.remove_coda(-1);
+  syllable1.remove_nucleus(0);
+  EXPECT_EQ(1, syllable1.size());
+  EXPECT_EQ(PhoneCode(Vowel(Vowel::close, Vowel::front, Vowel::unrounded)), 
+            PhoneCode(syllable1[0]));
+  
+  // The nucleus cannot be emptied
+  bool exception_thrown(false);
+  try {
+    syllable1.remove_nucleus(0);
+  }
+  catch(ImpossibleArticulation e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // IndexError thrown when expected
+  exception_thrown = false;
+  try {
+    syllable1.remove_onset(0);
+  }
+  catch(expt::IndexError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, transcription_constructor) {
+  
+  Syllable syllable1("[p_hA:]");
+  Consonant consonant1(Consonant::stop, 
+                       Consonant::bilabial, 
+                       Phone::voiceless, 
+                       Consonant::moderately_aspirated);
+  Vowel vowel1(Vowel::open, Vowel::back, Vowel::unrounded);
+  vowel1.set_length(2.0);
+  EXPECT_EQ(1, syllable1.onset_size());
+  EXPECT_EQ(1, syllable1.nucleus_size());
+  EXPECT_EQ(0, syllable1.coda_size());
+  EXPECT_EQ(PhoneCode(consonant1), PhoneCode(syllable1[0]));
+  EXPECT_EQ(PhoneCode(vowel1), PhoneCode(syllable1[1]));
+  
+  // Other encodings
+  EXPECT_TRUE(syllable1 == Syllable("pʰɑː", lang::unicode));
+  EXPECT_TRUE(syllable1 == Syllable("p<h>A:", lang::kirschenbaum));
+  
+  // DecodingFailed thrown when expected
+  bool exception_thrown(false);
+  try {
+    Syllable syllable2("p_hA:X\\Y");
+  }
+  catch(DecodingFailed& e) {
+    exception_thrown = true;
+    EXPECT_EQ(7, e.position());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(DecodingFailedTest, message) {
+  
+  DecodingFailed exception1;
+  EXPECT_EQ(-1, exception1.position());
+  EXPECT_EQ("", exception1.message());
+  
+  DecodingFailed exception2(4);
+  EXPECT_EQ(4, exception2.position());
+  EXPECT_EQ("Transcription could not be decoded at byte 4.", 
+            exception2.message());
+  EXPECT_STREQ("transcription could not be decoded", exception2.what());
+  
+  DecodingFailed exception3("Bad transcription");
+  EXPECT_EQ("Bad transcription", exception3.message());
+  
+  exception1 = exception2;
+  EXPECT_EQ(4, exception1.position());
+  DecodingFailed exception4(exception2);
+  EXPECT_EQ(exception2.message(), exception4.message());
+  
+}
+
+TEST(DecodingFailedTest, standard_exception) {
+  
+  // Every exception thrown by the library can be caught as a std::exception
+  bool exception_thrown = false;
+  try {
+    Syllable("k", x_sampa);
+  }
+  catch(std::exception& e) {
+    exception_thrown = true;
+    EXPECT_STREQ("transcription could not be decoded", e.what());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  exception_thrown = false;
+  try {
+    Vowel(7, 2, Vowel::unrounded);
+  }
+  catch(std::exception& e) {
+    exception_thrown = true;
+    EXPECT_STREQ("Vowel height must be between 0.0 and 6.0.", e.what());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // Bounds checks record the index as given and the size
+  Syllable syllable("ka");
+  exception_thrown = false;
+  try {
+    syllable[-3];
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+    EXPECT_EQ(-3, e.index());
+    EXPECT_EQ(2, e.size());
+    EXPECT_EQ("Index -3 is out of range for size 2.", e.message());
+    EXPECT_STREQ("index out of range", e.what());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // Literal messages survive conversion without being copied
+  static const char message[] = "Bad transcription";
+  DecodingFailed exception1(expt::literal, message);
+  EXPECT_EQ("Bad transcription", exception1.message());
+  EXPECT_EQ(message, exception1.what());
+  ImpossibleArticulation exception2(expt::literal, message);
+  EXPECT_EQ(message, ((expt::ValueError) exception2).what());
+  EXPECT_EQ(message, ((expt::Exception) exception2).what());
+  
+  // Any other C string is copied
+  std::string buffer("Bad transcription");
+  ImpossibleArticulation exception3(buffer.c_str());
+  DecodingFailed exception4(buffer.c_str());
+  buffer.clear();
+  EXPECT_STREQ("Bad transcription", exception3.what());
+  EXPECT_STREQ("Bad transcription", exception4.what());
+  
+}
+
+TEST(DecoderTest, encoding) {
+  
+  Decoder decoder1;
+  EXPECT_EQ(lang::x_sampa, decoder1.encoding());
+  decoder1.set_encoding(lang::unicode);
+  EXPECT_EQ(lang::unicode, decoder1.encoding());
+  Decoder decoder2(decoder1);
+  EXPECT_EQ(lang::unicode, decoder2.encoding());
+  
+}
+
+TEST(DecoderTest, decode) {
+  
+  Decoder decoder1;
+  Syllable syllable1 = decoder1.decode("\"strENkT");
+  EXPECT_EQ(3, syllable1.onset_size());
+  EXPECT_EQ(1, syllable1.nucleus_size());
+  EXPECT_EQ(3, syllable1.coda_size());
+  EXPECT_EQ(PhoneCode(Vowel(Vowel::open_mid, Vowel::front, Vowel::unrounded)), 
+            PhoneCode(syllable1[3]));
+  
+  // Syllabic consonants form the nucleus
+  syllable1 = decoder1.decode("tn=");
+  EXPECT_EQ(1, syllable1.onset_size());
+  EXPECT_EQ(1, syllable1.nucleus_size());
+  EXPECT_EQ(Consonant::nasal, PhoneCode(syllable1[1]).manner());
+  
+  // Tones
+  syllable1 = decoder1.decode("ma_H");
+  EXPECT_TRUE(Tone(1, 1, 1) == syllable1.tone());
+  syllable1 = decoder1.decode("ma_H_L");
+  EXPECT_TRUE(Tone(1, 0, -1) == syllable1.tone());
+  decoder1.set_encoding(lang::unicode);
+  syllable1 = decoder1.decode("ma˥˩");
+  EXPECT_TRUE(Tone(2, 0, -2) == syllable1.tone());
+  syllable1 = decoder1.decode("ma\xCC\x8C");
+  EXPECT_TRUE(Tone(-1, 0, 1) == syllable1.tone());
+  
+  // Failure offsets
+  decoder1.set_encoding(lang::x_sampa);
+  Syllable syllable2;
+  EXPECT_EQ(-1, decoder1.decode("pa", 2, syllable2));
+  EXPECT_EQ(0, decoder1.decode("_hpa", 4, syllable2));
+  EXPECT_EQ(2, decoder1.decode("pa#", 3, syllable2));
+  EXPECT_EQ(3, decoder1.decode("[pa", 3, syllable2));
+  EXPECT_EQ(2, decoder1.decode("pt", 2, syllable2));
+  EXPECT_EQ(3, decoder1.decode("pat\"", 4, syllable2));
+  EXPECT_EQ(3, decoder1.decode("pata", 4, syllable2));
+  EXPECT_EQ(2, decoder1.decode("pa_>", 4, syllable2));
+  EXPECT_EQ(2, decoder1.decode("|\\_>e", 5, syllable2));
+  EXPECT_EQ(3, decoder1.decode("b_<_>a", 6, syllable2));
+  
+  // A breathy or creaky mark undoes the VOT of an earlier voiceless mark
+  const char* stacked1[][2] = {{"5_0_to", "5_to"}, {"n_0_k9E", "n_k9E"}, 
+                               {"r_0_td_hE", "r_td_hE"}};
+  for(int i = 0; i < 3; i++) {
+    Syllable syllable3 = decoder1.decode(stacked1[i][0]);
+    EXPECT_TRUE(decoder1.decode(stacked1[i][1]) == syllable3) << i;
+    EXPECT_EQ("[" + std::string(stacked1[i][1]) + "]", syllable3.x_sampa());
+    EXPECT_TRUE(syllable3 == Syllable(syllable3.x_sampa())) << i;
+  }
+  Decoder decoder2(lang::unicode);
+  Syllable syllable4 = decoder2.decode("l\xCC\xA5\xCC\xA4" "a\xCB\x9E");
+  EXPECT_TRUE(decoder2.decode("l\xCC\xA4" "a\xCB\x9E") == syllable4);
+  std::string output4;
+  syllable4.encode(output4, lang::unicode);
+  EXPECT_TRUE(syllable4 == Syllable(output4, lang::unicode));
+  
+  // Failures leave the default syllable
+  EXPECT_EQ(-1, decoder1.decode("p_hA:_H", 7, syllable2));
+  EXPECT_EQ(2, decoder1.decode("pt", 2, syllable2));
+  EXPECT_EQ(Syllable(), syllable2);
+  EXPECT_EQ(1, syllable2.nucleus_size());
+  EXPECT_EQ(-1, decoder1.decode("pa", 2, syllable2));
+  EXPECT_EQ(3, decoder1.decode("pata", 4, syllable2));
+  EXPECT_EQ(Syllable(), syllable2);
+  EXPECT_EQ("[@]", syllable2.x_sampa());
+  
+}
+
+TEST(SyllableTest, encode) {
+  
+  Syllable syllable1("\"p_hA:n_t_H_L");
+  EXPECT_EQ("[p_hA:n_t_H_L]", syllable1.x_sampa());
+  EXPECT_EQ("[p<h>A:n<?>]", syllable1.kirschenbaum());
+  EXPECT_EQ("[pʰɑːn̤˦˨]", syllable1.unicode());
+  
+  // Appending to a string
+  std::string output("x ");
+  syllable1.encode(output);
+  EXPECT_EQ("x p_hA:n_t_H_L", output);
+  
+  // Writing to a buffer, including one that is too small
+  char buffer[32];
+  int length = syllable1.encode(buffer, 32, lang::unicode);
+  EXPECT_EQ("pʰɑːn̤˦˨", std::string(buffer, length));
+  EXPECT_EQ(length, syllable1.encode(buffer, 3, lang::unicode));
+  EXPECT_EQ("pʰ", std::string(buffer, 3));
+  
+  // Writing to an output iterator
+  std::string output2;
+  syllable1.encode(std::back_inserter(output2), lang::kirschenbaum);
+  EXPECT_EQ("p<h>A:n<?>", output2);
+  
+  // Syllabic consonants and coarticulation
+  Syllable syllable2("tn=");
+  EXPECT_EQ("[tn=]", syllable2.x_sampa());
+  Syllable syllable3("k_wet_j");
+  EXPECT_EQ("[k_wet_j]", syllable3.x_sampa());
+  
+  // Sequences
+  PhoneticSequence sequence1;
+  sequence1.push_back(syllable2);
+  sequence1.push_back(syllable3);
+  std::string output3;
+  encode(sequence1, output3, lang::x_sampa, '.');
+  EXPECT_EQ("tn=.k_wet_j", output3);
+  
+}
+
+TEST(SyllableTest, encode_round_trip) {
+  
+  // Kirschenbaum cannot spell everything, so these only need to survive the 
+  // other two encodings
+  const char* transcriptions1[] = {"O\\a:\\", "t_?\\e_kp_>", "h\\y_X"};
+  const PhoneticEncoding lossless[] = {lang::x_sampa, lang::unicode};
+  for(int i = 0; i < 3; i++) {
+    Syllable syllable1(transcriptions1[i]);
+    for(int j = 0; j < 2; j++) {
+      std::string output;
+      syllable1.encode(output, lossless[j]);
+      EXPECT_TRUE(syllable1 == Syllable(output, lossless[j])) << output;
+    }
+  }
+  
+  // Without tones or diacritics Kirschenbaum lacks, every encoding must 
+  // give back the same syllable
+  const char* transcriptions2[] = {"s_0ts\\_hi:", "ZdI~", "[b_<E`r]", 
+                                   "\"strENkT", "p_hA:n", "tSi:ts", "n=", 
+                                   "mju:z", "x@r", "Gu"};
+  for(int i = 0; i < 10; i++) {
+    Syllable syllable2(transcriptions2[i]);
+    for(int j = 0; j < 3; j++) {
+      PhoneticEncoding encoding = (PhoneticEncoding) j;
+      std::string output;
+      syllable2.encode(output, encoding);
+      EXPECT_TRUE(syllable2 == Syllable(output, encoding)) << output;
+    }
+  }
+  
+}
+
+TEST(TranscoderTest, constructor) {
+  
+  Transcoder transcoder1(lang::x_sampa, lang::unicode);
+  EXPECT_EQ(lang::x_sampa, transcoder1.source());
+  EXPECT_EQ(lang::unicode, transcoder1.target());
+  Transcoder transcoder2(transcoder1);
+  EXPECT_EQ(lang::unicode, transcoder2.target());
+  
+  // ValueError thrown when expected
+  bool exception_thrown(false);
+  try {
+    Transcoder transcoder3(lang::x_sampa, lang::unicode, 0);
+  }
+  catch(expt::ValueError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(TranscoderTest, transcode) {
+  
+  Transcoder transcoder1(lang::x_sampa, lang::unicode);
+  EXPECT_EQ("pʰɑːn̤˦˨", transcoder1.transcode("p_hA:n_t_H_L"));
+  EXPECT_EQ("[ˈstrɛŋkθ]", transcoder1.transcode("[\"strENkT]"));
+  
+  // Symbols with no exact equivalent go through a Syllable
+  Transcoder transcoder2(lang::x_sampa, lang::kirschenbaum);
+  EXPECT_EQ("p<h>A:", transcoder2.transcode("p_hA:_H"));
+  Transcoder transcoder3(lang::kirschenbaum, lang::x_sampa);
+  EXPECT_EQ("mA:n", transcoder3.transcode("mA:n"));
+  
+  // Failures leave the output alone
+  std::string output("x");
+  EXPECT_EQ(3, transcoder1.transcode("pata", 4, output));
+  EXPECT_EQ(2, transcoder1.transcode("pt", 2, output));
+  EXPECT_EQ(3, transcoder1.transcode("[pa", 3, output));
+  EXPECT_EQ(2, transcoder2.transcode("pa#", 3, output));
+  EXPECT_EQ("x", output);
+  
+  bool exception_thrown(false);
+  try {
+    transcoder1.transcode("pa_>");
+  }
+  catch(DecodingFailed& e) {
+    exception_thrown = true;
+    EXPECT_EQ(2, e.position());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // Phones that cannot be articulated fail as they do in a Syllable
+  EXPECT_EQ(0, transcoder1.transcode("b_>a", 4, output));
+  EXPECT_EQ(1, transcoder1.transcode("ab_>", 4, output));
+  EXPECT_EQ("x", output);
+  
+}
+
+namespace {
+  
+  class FailingBuffer : public std::streambuf {
+    
+    protected:
+      
+      int_type underflow() {
+        
+        throw std::runtime_error("unreadable");
+        
+      }
+      
+      int_type overflow(int_type) {
+        
+        return traits_type::eof();
+        
+      }
+    
+  };
+  
+};
+
+TEST(TranscoderTest, stream) {
+  
+  // A small chunk size makes transcriptions cross chunk boundaries
+  Transcoder transcoder1(lang::x_sampa, lang::unicode, 5);
+  std::istringstream input1("p_hA: tn=\n  [S@N]\tk_wet_j\n");
+  std::ostringstream output1;
+  EXPECT_EQ(26, transcoder1.transcode(input1, output1));
+  EXPECT_EQ("pʰɑː tn̩\n  [ʃəŋ]\tkʷetʲ\n", output1.str());
+  
+  // Failure positions are offsets in the stream
+  std::istringstream input2("pa ta pt ka");
+  std::ostringstream output2;
+  bool exception_thrown(false);
+  try {
+    transcoder1.transcode(input2, output2);
+  }
+  catch(DecodingFailed& e) {
+    exception_thrown = true;
+    EXPECT_EQ(8, e.position());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // Offsets past the range of an int are kept
+  DecodingFailed decoding_failed1(5000000000LL);
+  EXPECT_EQ(5000000000LL, decoding_failed1.position());
+  
+  // Streams that fail are reported instead of being ignored
+  FailingBuffer buffer;
+  std::istream input3(&buffer);
+  std::ostringstream output3;
+  exception_thrown = false;
+  try {
+    transcoder1.transcode(input3, output3);
+  }
+  catch(DecodingFailed& e) {}
+  catch(expt::Exception& e) {
+    exception_thrown = true;
+    EXPECT_EQ("Could not read the transcriptions.", e.message());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  std::istringstream input4("pa ta ka");
+  std::ostream output4(&buffer);
+  exception_thrown = false;
+  try {
+    transcoder1.transcode(input4, output4);
+  }
+  catch(DecodingFailed& e) {}
+  catch(expt::Exception& e) {
+    exception_thrown = true;
+    EXPECT_EQ("Could not write the transcriptions.", e.message());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // Exceptions thrown by a stream reach the caller
+  std::istream input5(&buffer);
+  input5.exceptions(std::ios::badbit);
+  std::ostringstream output5;
+  exception_thrown = false;
+  try {
+    transcoder1.transcode(input5, output5);
+  }
+  catch(std::runtime_error& e) {
+    exception_thrown = true;
+    EXPECT_EQ(std::string("unreadable"), e.what());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(ThreadPoolTest, run) {
+  
+  ThreadPool pool1(4);
+  EXPECT_EQ(4, pool1.size());
+  
+  // Every item is covered exactly once
+  std::vector<int> counts(1000, 0);
+  pool1.run(1000, [&](int begin, int end) {
+    for(int i = begin; i < end; i++) {
+      counts[i]++;
+    }
+  }, 7);
+  for(int i = 0; i < 1000; i++) {
+    EXPECT_EQ(1, counts[i]);
+  }
+  
+  // Exceptions are passed back to the caller
+  bool exception_thrown(false);
+  try {
+    pool1.run(100, [](int begin, int end) {
+      if(begin <= 50 && 50 < end) {
+        throw expt::ValueError("Bad item");
+      }
+    }, 1);
+  }
+  catch(expt::ValueError& e) {
+    exception_thrown = true;
+    EXPECT_EQ("Bad item", e.message());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // The pool can still be used afterwards
+  std::atomic<int> total(0);
+  pool1.run(100, [&](int begin, int end) {
+    total += end - begin;
+  });
+  EXPECT_EQ(100, total);
+  
+  // Tasks can run loops on their own pool
+  std::vector<int> nested(100, 0);
+  pool1.run(10, [&](int begin, int end) {
+    for(int i = begin; i < end; i++) {
+      pool1.run(10, [&](int inner_begin, int inner_end) {
+        for(int j = inner_begin; j < inner_end; j++) {
+          nested[i * 10 + j]++;
+        }
+      }, 1);
+    }
+  }, 1);
+  for(int i = 0; i < 100; i++) {
+    EXPECT_EQ(1, nested[i]);
+  }
+  
+  ThreadPool pool2(1);
+  EXPECT_EQ(1, pool2.size());
+  
+  // Including pools with no threads of their own
+  total = 0;
+  pool2.run(5, [&](int, int) {
+    pool2.run(5, [&](int inner_begin, int inner_end) {
+      total += inner_end - inner_begin;
+    });
+  });
+  EXPECT_EQ(5, total);
+  
+}
+
+TEST(DecoderTest, batch_decode) {
+  
+  std::vector<std::string> transcriptions;
+  for(int i = 0; i < 500; i++) {
+    transcriptions.push_back(i % 100 == 3 ? "pt" : "p_hA:n");
+  }
+  
+  ThreadPool pool1(4);
+  Decoder decoder1;
+  PhoneticSequence syllables;
+  std::vector<int> failures;
+  EXPECT_EQ(5, decoder1.decode(transcriptions, syllables, failures, pool1));
+  EXPECT_EQ(500, (int) syllables.size());
+  EXPECT_EQ(500, (int) failures.size());
+  
+  // Results stay in order
+  Syllable syllable1("p_hA:n");
+  for(int i = 0; i < 500; i++) {
+    if(i % 100 == 3) {
+      EXPECT_EQ(2, failures[i]);
+      EXPECT_TRUE(Syllable() == syllables[i]);
+    }
+    else {
+      EXPECT_EQ(-1, failures[i]);
+      EXPECT_TRUE(syllable1 == syllables[i]);
+    }
+  }
+  
+}
+
+TEST(CorpusViewTest, memory) {
+  
+  PhoneticSequence sequence1;
+  sequence1.push_back(Syllable("\"strENkT"));
+  sequence1.push_back(Syllable("ma_H_L"));
+  sequence1.push_back(Syllable("n="));
+  std::ostringstream output1;
+  write_corpus(sequence1, output1);
+  std::string data1 = output1.str();
+  EXPECT_EQ(32 + 3 * 16 + 10 * 8, (int) data1.size());
+  
+  // Copy into 8-byte words to get the alignment a file mapping would have
+  std::vector<uint64_t> words((data1.size() + 7) / 8);
+  std::memcpy(words.data(), data1.data(), data1.size());
+  CorpusView corpus1(words.data(), data1.size());
+  EXPECT_EQ(3, corpus1.size());
+  EXPECT_EQ(10, corpus1.phone_count());
+  
+  SyllableView syllable1 = corpus1[0];
+  EXPECT_EQ(7, syllable1.size());
+  EXPECT_EQ(3, syllable1.onset_size());
+  EXPECT_EQ(1, syllable1.nucleus_size());
+  EXPECT_EQ(3, syllable1.coda_size());
+  EXPECT_EQ(PhoneCode(sequence1[0][3]), syllable1.nucleus(0));
+  EXPECT_EQ(PhoneCode(sequence1[0][6]), syllable1.coda(-1));
+  EXPECT_EQ(PhoneCode(sequence1[0][0]), syllable1[0]);
+  EXPECT_TRUE(sequence1[0] == syllable1.syllable());
+  EXPECT_TRUE(Tone(1, 0, -1) == corpus1[-2].tone());
+  EXPECT_EQ(1, corpus1[2].nucleus_size());
+  
+  PhoneticSequence sequence2 = corpus1.sequence();
+  EXPECT_EQ(3, (int) sequence2.size());
+  for(int i = 0; i < 3; i++) {
+    EXPECT_TRUE(sequence1[i] == sequence2[i]);
+  }
+  
+  // IndexError thrown when expected
+  bool exception_thrown(false);
+  try {
+    corpus1[3];
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  exception_thrown = false;
+  try {
+    syllable1.onset(3);
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(CorpusViewTest, invalid) {
+  
+  PhoneticSequence sequence1(2);
+  std::ostringstream output1;
+  write_corpus(sequence1, output1);
+  std::string data1 = output1.str();
+  std::vector<uint64_t> words((data1.size() + 7) / 8);
+  
+  // Truncated data and a bad header are rejected
+  int exceptions_thrown(0);
+  std::memcpy(words.data(), data1.data(), data1.size());
+  try {
+    CorpusView corpus1(words.data(), data1.size() - 8);
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  
+  reinterpret_cast<char*>(words.data())[0] = 'X';
+  try {
+    CorpusView corpus2(words.data(), data1.size());
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  
+  // So are records that point past the phones
+  std::memcpy(words.data(), data1.data(), data1.size());
+  reinterpret_cast<char*>(words.data())[32 + 16] = 5;
+  try {
+    CorpusView corpus3(words.data(), data1.size());
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  EXPECT_EQ(3, exceptions_thrown);
+  
+}
+
+TEST(CorpusViewTest, corrupt) {
+  
+  PhoneticSequence sequence1;
+  sequence1.push_back(Syllable("pa_H"));
+  std::ostringstream output1;
+  write_corpus(sequence1, output1);
+  std::string data1 = output1.str();
+  std::vector<uint64_t> words((data1.size() + 7) / 8);
+  std::memcpy(words.data(), data1.data(), data1.size());
+  CorpusView corpus1(words.data(), data1.size());
+  EXPECT_EQ(1, corpus1.size());
+  
+  // A tone level outside -2 to 2 is rejected
+  int exceptions_thrown(0);
+  reinterpret_cast<signed char*>(words.data())[32 + 10] = 5;
+  try {
+    CorpusView corpus2(words.data(), data1.size());
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  
+  // Phones are only read when asked for, and then a phone code with a 
+  // manner past the last one is rejected
+  std::memcpy(words.data(), data1.data(), data1.size());
+  words[(32 + 16) / 8] |= (uint64_t) 15 << 7;
+  CorpusView unchecked1(words.data(), data1.size());
+  EXPECT_EQ(1, unchecked1.size());
+  EXPECT_EQ(2, unchecked1.phone_count());
+  try {
+    CorpusView corpus3(words.data(), data1.size(), true);
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  
+  // And one that cannot be articulated, written to a file
+  std::memcpy(words.data(), data1.data(), data1.size());
+  uint64_t& code1 = words[(32 + 16) / 8];
+  code1 &= ~((uint64_t) 0x1FF << 7);
+  code1 |= (uint64_t) Consonant::nasal << 7 | 
+           (uint64_t) Consonant::pharyngeal << 11;
+  {
+    std::ofstream output2("corpus_corrupt.bin", std::ios::binary);
+    output2.write(reinterpret_cast<const char*>(words.data()), data1.size());
+  }
+  CorpusView unchecked2("corpus_corrupt.bin");
+  EXPECT_EQ(1, unchecked2.size());
+  try {
+    CorpusView corpus4("corpus_corrupt.bin", true);
+  }
+  catch(expt::ValueError& e) {
+    EXPECT_STREQ("The corpus contains an invalid phone.", e.what());
+    exceptions_thrown++;
+  }
+  std::remove("corpus_corrupt.bin");
+  EXPECT_EQ(3, exceptions_thrown);
+  
+}
+
+TEST(CorpusViewTest, file) {
+  
+  PhoneticSequence sequence1;
+  sequence1.push_back(Syllable("p_hA:n"));
+  sequence1.push_back(Syllable("k_wet_j"));
+  {
+    std::ofstream output1("corpus_test.bin", std::ios::binary);
+    write_corpus(sequence1, output1);
+  }
+  
+  {
+    CorpusView corpus1("corpus_test.bin");
+    EXPECT_EQ(2, corpus1.size());
+    EXPECT_TRUE(sequence1[1] == corpus1[1].syllable());
+  }
+  
+  // A path literal with phone checking on still names a file
+  {
+    CorpusView corpus3("corpus_test.bin", true);
+    EXPECT_EQ(2, corpus3.size());
+    EXPECT_EQ(6, corpus3.phone_count());
+    EXPECT_TRUE(sequence1[0] == corpus3[0].syllable());
+  }
+  std::remove("corpus_test.bin");
+  
+  bool exception_thrown(false);
+  try {
+    CorpusView corpus2("corpus_test.bin");
+  }
+  catch(expt::Exception& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(PhoneCodeTest, hash) {
+  
+  Vowel vowel1(Vowel::close, Vowel::front, Vowel::unrounded);
+  Vowel vowel2(Vowel::close, Vowel::front, Vowel::exolabial);
+  EXPECT_EQ(PhoneCode(vowel1).hash(), PhoneCode(vowel1).hash());
+  EXPECT_NE(PhoneCode(vowel1).hash(), PhoneCode(vowel2).hash());
+  
+}
+
+TEST(PhoneInventoryTest, intern) {
+  
+  PhoneInventory inventory1;
+  EXPECT_EQ(0, inventory1.size());
+  
+  Vowel vowel1(Vowel::open, Vowel::back, Vowel::unrounded);
+  Consonant consonant1;
+  EXPECT_EQ(0, inventory1.intern(vowel1));
+  EXPECT_EQ(1, inventory1.intern(PhoneCode(consonant1)));
+  EXPECT_EQ(0, inventory1.intern(PhoneCode(vowel1)));
+  EXPECT_EQ(2, inventory1.size());
+  EXPECT_EQ(PhoneCode(consonant1), inventory1[1]);
+  EXPECT_EQ(1, inventory1.find(PhoneCode(consonant1)));
+  EXPECT_EQ(-1, inventory1.find(PhoneCode(Vowel())));
+  
+  // Syllables
+  std::vector<int> ids;
+  inventory1.intern(Syllable("p_hA:n"), ids);
+  EXPECT_EQ(3, (int) ids.size());
+  EXPECT_EQ(2, ids[0]);
+  EXPECT_EQ(5, inventory1.size());
+  
+  // Descriptions are kept
+  const std::string& description1 = inventory1.description(0);
+  EXPECT_EQ(vowel1.description(), description1);
+  EXPECT_EQ(&description1, &inventory1.description(0));
+  
+  // IndexError thrown when expected
+  bool exception_thrown(false);
+  try {
+    inventory1[5];
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  exception_thrown = false;
+  try {
+    inventory1.description(-1);
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // The global inventory is shared
+  int id = PhoneInventory::global().intern(vowel1);
+  EXPECT_EQ(id, PhoneInventory::global().find(PhoneCode(vowel1)));
+  
+}
+
+TEST(PhoneInventoryTest, chunks) {
+  
+  // Enough vowels to fill the first chunk and start the second
+  std::vector<PhoneCode> codes;
+  for(int height = 0; height <= 6; height++) {
+    for(int backness = 0; backness <= 4; backness++) {
+      codes.push_back(PhoneCode(Vowel(height, backness, Vowel::unrounded)));
+      codes.push_back(PhoneCode(Vowel(height, backness, Vowel::exolabial)));
+    }
+  }
+  
+  // Readers look phones up by ID while they are being interned
+  PhoneInventory inventory;
+  std::atomic<bool> done(false);
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> readers;
+  for(int i = 0; i < 3; i++) {
+    readers.push_back(std::thread([&]() {
+      while(!done.load()) {
+        int size = inventory.size();
+        for(int id = 0; id < size; id++) {
+          if(inventory[id] != codes[id] || 
+             inventory.description(id) != codes[id].description()) {
+            mismatches++;
+          }
+        }
+      }
+    }));
+  }
+  
+  for(int i = 0; i < (int) codes.size(); i++) {
+    EXPECT_EQ(i, inventory.intern(codes[i]));
+  }
+  done.store(true);
+  for(int i = 0; i < (int) readers.size(); i++) {
+    readers[i].join();
+  }
+  
+  EXPECT_EQ(0, mismatches.load());
+  EXPECT_EQ((int) codes.size(), inventory.size());
+  EXPECT_EQ(codes[64], inventory[64]);
+  EXPECT_EQ(64, inventory.find(codes[64]));
+  EXPECT_EQ(codes[69].description(), inventory.description(69));
+  
+}
+
+TEST(ConsonantTest, description) {
+  
+  Consonant consonant1(Consonant::stop, 
+                       Consonant::bilabial, 
+                       Phone::voiceless, 
+                       Consonant::moderately_aspirated);
+  EXPECT_EQ("voiceless aspirated bilabial stop", consonant1.description());
+  
+  Consonant consonant2(Consonant::nasal, 
+                       Consonant::velar, 
+                       Phone::modal, 
+                       Consonant::completely_voiced, 
+                       Phone::nasal);
+  EXPECT_EQ("voiced velar nasal", consonant2.description());
+  
+  Consonant consonant3(Consonant::stop, 
+                       Consonant::velar, 
+                       Phone::voiceless, 
+                       Consonant::not_aspirated, 
+                       Phone::oral, 
+                       Consonant::ejective, 
+                       2.0);
+  EXPECT_EQ("long voiceless velar ejective stop", consonant3.description());
+  
+  Consonant consonant4(Consonant::stop, 
+                       Consonant::apical_dental, 
+                       Phone::voiceless, 
+                       Consonant::not_aspirated, 
+                       Phone::oral, 
+                       Consonant::click);
+  EXPECT_EQ("voiceless apical-dental click", consonant4.description());
+  
+}
+
+TEST(PhoneCodeTest, description) {
+  
+  Vowel vowel1(Vowel::close, Vowel::front, Vowel::unrounded);
+  PhoneCode code1(vowel1);
+  EXPECT_EQ(vowel1.description(), code1.description());
+  EXPECT_EQ(code1.description(), PhoneCode(vowel1).description());
+  
+  // Describing other phones does not disturb earlier descriptions
+  for(int height = 0; height <= 6; height++) {
+    for(int backness = 0; backness <= 4; backness++) {
+      PhoneCode(Vowel(height, backness, Vowel::endolabial)).description();
+    }
+  }
+  EXPECT_EQ("close front unrounded vowel", code1.description());
+  
+  // Descriptions of different phones compared in one expression stay apart, 
+  // wherever the cache keeps them
+  for(int height = 0; height <= 6; height++) {
+    for(int backness = 0; backness <= 4; backness++) {
+      PhoneCode rounded(Vowel(height, backness, Vowel::exolabial));
+      PhoneCode unrounded(Vowel(height, backness, Vowel::unrounded));
+      EXPECT_FALSE(rounded.description() == unrounded.description());
+    }
+  }
+  
+  // Positions between the named steps
+  Vowel vowel2(5.5, 0.0, Vowel::unrounded);
+  EXPECT_EQ("near-close-close front unrounded vowel", 
+            PhoneCode(vowel2).description());
+  
+  // Decoded phones
+  Syllable syllable1("k_wa~");
+  EXPECT_EQ("voiceless labialized velar stop", 
+            PhoneCode(syllable1[0]).description());
+  EXPECT_EQ("nasal open front unrounded vowel", 
+            PhoneCode(syllable1[1]).description());
+  
+}
+
+TEST(ConsonantTest, check) {
+  
+  // Articulable consonants
+  EXPECT_EQ(Phone::no_violation, 
+            Consonant::check(Consonant::stop, Consonant::glottal, 
+                             Phone::voiceless, Consonant::not_aspirated));
+  EXPECT_EQ(Phone::no_violation, 
+            Consonant::check(Consonant::nasal, Consonant::velar, Phone::modal,
+                             Consonant::completely_voiced, Phone::nasal));
+  
+  // Each rule
+  EXPECT_EQ(Phone::nonpositive_length, 
+            Consonant::check(Consonant::stop, Consonant::bilabial, 
+                             Phone::modal, Consonant::moderately_voiced, 
+                             Phone::oral, Consonant::pul_eg, 0.0));
+  EXPECT_EQ(Phone::voiceless_voiced_vot, 
+            Consonant::check(Consonant::trill, Consonant::apical_dental, 
+                             Phone::voiceless, Consonant::completely_voiced));
+  EXPECT_EQ(Phone::voiced_glottal_stop, 
+            Consonant::check(Consonant::stop, Consonant::glottal, 
+                             Phone::modal, Consonant::completely_voiced));
+  EXPECT_EQ(Phone::impossible_place, 
+            Consonant::check(Consonant::stop, Consonant::pharyngeal, 
+                             Phone::modal, Consonant::strongly_aspirated, 
+                             Phone::strongly_nasal));
+  EXPECT_EQ(Phone::impossible_place, 
+            Consonant::check(Consonant::lateral_approximant, 
+                             Consonant::bilabial, Phone::modal, 
+                             Consonant::completely_voiced));
+  EXPECT_EQ(Phone::voiced_ejective, 
+            Consonant::check(Consonant::stop, Consonant::bilabial, 
+                             Phone::modal, Consonant::completely_voiced, 
+                             Phone::oral, Consonant::ejective));
+  EXPECT_EQ(Phone::oral_nasal, 
+            Consonant::check(Consonant::nasal, Consonant::laminal_dental, 
+                             Phone::modal, Consonant::weakly_voiced));
+  
+}
+
+TEST(ConsonantTest, try_make) {
+  
+  Consonant consonant1;
+  EXPECT_EQ(Phone::no_violation, 
+            Consonant::try_make(consonant1, Consonant::nsib_fricative, 
+                                Consonant::labiodental, Phone::voiceless, 
+                                Consonant::not_aspirated, Phone::oral, 
+                                Consonant::pul_eg, 2.0));
+  EXPECT_TRUE(Consonant(Consonant::nsib_fricative, Consonant::labiodental, 
+                        Phone::voiceless, Consonant::not_aspirated, 
+                        Phone::oral, Consonant::pul_eg, 2.0) == consonant1);
+  
+  // A rejected consonant leaves the result unchanged
+  Consonant consonant2(consonant1);
+  EXPECT_EQ(Phone::voiced_ejective, 
+            Consonant::try_make(consonant1, Consonant::stop, 
+                                Consonant::bilabial, Phone::modal, 
+                                Consonant::completely_voiced, Phone::oral, 
+                                Consonant::ejective));
+  EXPECT_TRUE(consonant2 == consonant1);
+  
+  // The throwing constructor uses the same check
+  bool exception_thrown(false);
+  try {
+    Consonant consonant3(Consonant::stop, Consonant::bilabial, Phone::modal, 
+                         Consonant::completely_voiced, Phone::oral, 
+                         Consonant::ejective);
+  }
+  catch(ImpossibleArticulation e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(ConsonantTest, try_set) {
+  
+  Consonant consonant1;
+  
+  // Rejected changes leave the consonant unchanged
+  EXPECT_EQ(Phone::voiceless_voiced_vot, 
+            consonant1.try_set_vot(Consonant::completely_voiced));
+  EXPECT_EQ(Consonant::moderately_aspirated, consonant1.vot());
+  EXPECT_EQ(Phone::impossible_place, 
+            consonant1.try_set_place(Consonant::pharyngeal));
+  EXPECT_EQ(Consonant::apical_alveolar, consonant1.place());
+  EXPECT_EQ(Phone::nonpositive_length, consonant1.try_shorten(1.0));
+  EXPECT_EQ(1.0, consonant1.length());
+  
+  // Accepted changes are applied
+  EXPECT_EQ(Phone::no_violation, consonant1.try_set_place(Consonant::glottal));
+  EXPECT_EQ(Consonant::glottal, consonant1.place());
+  EXPECT_FALSE(consonant1.has_secondary_articulation());
+  EXPECT_EQ(Phone::voiced_glottal_stop, 
+            consonant1.try_set_phonation(Phone::modal));
+  EXPECT_EQ(Phone::voiceless, consonant1.phonation());
+  EXPECT_EQ(Phone::no_violation, 
+            consonant1.try_set_mechanism(Consonant::ejective));
+  EXPECT_EQ(Phone::no_violation, consonant1.violation());
+  
+  // The throwing setters use the same check
+  bool exception_thrown(false);
+  try {
+    consonant1.set_phonation(Phone::modal);
+  }
+  catch(ImpossibleArticulation e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  EXPECT_EQ(Phone::voiceless, consonant1.phonation());
+  
+}
+
+TEST(VowelTest, try_set) {
+  
+  Vowel vowel1;
+  EXPECT_EQ(Phone::no_violation, vowel1.try_raise(3.0));
+  EXPECT_EQ(6.0, vowel1.height());
+  EXPECT_EQ(Phone::height_out_of_range, vowel1.try_raise(0.5));
+  EXPECT_EQ(6.0, vowel1.height());
+  EXPECT_EQ(Phone::backness_out_of_range, vowel1.try_move_forward(2.5));
+  EXPECT_EQ(Vowel::central, vowel1.backness());
+  EXPECT_EQ(Phone::closed_glottis_vowel, 
+            vowel1.try_set_phonation(Phone::glottal_closure));
+  EXPECT_EQ(Phone::modal, vowel1.phonation());
+  
+  Vowel vowel2;
+  EXPECT_EQ(Phone::backness_out_of_range, 
+            Vowel::try_make(vowel2, Vowel::open, 4.5, Vowel::unrounded));
+  EXPECT_TRUE(Vowel() == vowel2);
+  EXPECT_EQ(Phone::no_violation, 
+            Vowel::try_make(vowel2, Vowel::open, Vowel::back, 
+                            Vowel::exolabial, Phone::nasal));
+  EXPECT_TRUE(Vowel(Vowel::open, Vowel::back, Vowel::exolabial, Phone::nasal,
+                    false) == vowel2);
+  
+}
+
+TEST(PhoneCodeTest, violation) {
+  
+  EXPECT_EQ(Phone::no_violation, PhoneCode(Vowel()).violation());
+  EXPECT_EQ(Phone::no_violation, PhoneCode(Consonant()).violation());
+  
+  // Codes that no Phone could produce are still checked
+  PhoneCode code1(Consonant(Consonant::nasal, Consonant::bilabial, 
+                            Phone::modal, Consonant::completely_voiced, 
+                            Phone::nasal));
+  code1.set_code(code1.code() & ~((uint64_t) 3 << 5));
+  EXPECT_EQ(Phone::oral_nasal, code1.violation());
+  
+  bool exception_thrown(false);
+  try {
+    code1.consonant();
+  }
+  catch(ImpossibleArticulation e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(ConsonantTest, articulable) {
+  
+  // The table can be queried at compile time
+  static_assert(Consonant::articulable(Consonant::stop, Consonant::velar, 
+                                       Phone::voiceless, 
+                                       Consonant::not_aspirated), 
+                "A voiceless velar stop is articulable.");
+  static_assert(!Consonant::articulable(Consonant::stop, 
+                                        Consonant::pharyngeal, 
+                                        Phone::voiceless, 
+                                        Consonant::not_aspirated), 
+                "A pharyngeal stop is not articulable.");
+  static_assert(Consonant::check(Consonant::stop, Consonant::bilabial, 
+                                 Phone::modal, Consonant::completely_voiced, 
+                                 Phone::oral, Consonant::ejective) 
+                == Phone::voiced_ejective, 
+                "A voiced ejective is not articulable.");
+  static_assert(!Vowel::articulable(Phone::glottal_closure), 
+                "A vowel cannot have glottal closure.");
+  
+  // Every manner is possible at the alveolar ridge, so only the other rules 
+  // apply there
+  for(int manner = 0; manner <= Consonant::nasal; manner++) {
+    for(int phonation = 0; phonation <= Phone::strident; phonation++) {
+      for(int vot = 0; vot <= Consonant::strongly_aspirated; vot++) {
+        for(int mechanism = 0; mechanism <= Consonant::implosive; 
+            mechanism++) {
+          for(int nasalization = 0; nasalization <= Phone::strongly_nasal; 
+              nasalization++) {
+            bool expected = 
+              !(phonation == Phone::voiceless 
+                && vot < Consonant::not_aspirated) 
+              && !(mechanism == Consonant::ejective 
+                   && phonation != Phone::voiceless) 
+              && !(manner == Consonant::nasal 
+                   && nasalization == Phone::oral);
+            EXPECT_EQ(expected, Consonant::articulable(
+              (Consonant::Manner) manner, Consonant::apical_alveolar, 
+              (Phone::Phonation) phonation, (Consonant::VOT) vot, 
+              (Phone::Nasalization) nasalization, 
+              (Consonant::Mechanism) mechanism));
+          }
+        }
+      }
+    }
+  }
+  
+}
+
+TEST(SyllableTest, move_constructor) {
+  
+  // Inline phones
+  Syllable syllable1("\"strENkT");
+  Syllable syllable2(syllable1);
+  Syllable syllable3(std::move(syllable1));
+  EXPECT_TRUE(syllable2 == syllable3);
+  EXPECT_EQ(0, syllable1.size());
+  
+  // Phones on the heap are taken over rather than copied
+  Syllable syllable4("a");
+  for(int i = 0; i < 2 * Syllable::inline_capacity; i++) {
+    syllable4.insert_coda(Consonant(), 0);
+  }
+  const Phone* first = &syllable4[0];
+  Syllable syllable5(syllable4);
+  Syllable syllable6(std::move(syllable4));
+  EXPECT_TRUE(syllable5 == syllable6);
+  EXPECT_EQ(first, &syllable6[0]);
+  EXPECT_EQ(0, syllable4.size());
+  
+  // A moved-from syllable can be assigned to again
+  syllable4 = syllable5;
+  EXPECT_TRUE(syllable5 == syllable4);
+  
+}
+
+TEST(SyllableTest, move_assignment) {
+  
+  Syllable syllable1("a");
+  for(int i = 0; i < 2 * Syllable::inline_capacity; i++) {
+    syllable1.insert_onset(Consonant(), 0);
+  }
+  const Phone* first = &syllable1[0];
+  Syllable syllable2(syllable1);
+  
+  // Heap storage is taken over
+  Syllable syllable3("kIt");
+  syllable3 = std::move(syllable1);
+  EXPECT_TRUE(syllable2 == syllable3);
+  EXPECT_EQ(first, &syllable3[0]);
+  EXPECT_EQ(0, syllable1.size());
+  
+  // Inline phones are copied into existing heap storage
+  Syllable syllable4("kIt");
+  Syllable syllable5(syllable4);
+  syllable3 = std::move(syllable4);
+  EXPECT_TRUE(syllable5 == syllable3);
+  EXPECT_EQ(0, syllable4.size());
+  
+  // Growing a sequence moves its syllables
+  PhoneticSequence sequence;
+  for(int i = 0; i < 100; i++) {
+    sequence.push_back(syllable2);
+  }
+  for(int i = 0; i < 100; i++) {
+    EXPECT_TRUE(syllable2 == sequence[i]);
+  }
+  
+}
+
+TEST(ArenaTest, allocate) {
+  
+  EXPECT_THROW(Arena(0), expt::ValueError);
+  
+  Arena arena(1024);
+  EXPECT_EQ(0, arena.allocated());
+  EXPECT_EQ(0, arena.reserved());
+  
+  // Allocations are aligned and do not overlap
+  char* a = static_cast<char*>(arena.allocate(3, 1));
+  char* b = static_cast<char*>(arena.allocate(8, 8));
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(b) % 8);
+  EXPECT_TRUE(b >= a + 3);
+  EXPECT_EQ(11, arena.allocated());
+  EXPECT_EQ(1024, arena.reserved());
+  
+  // Large allocations get their own block without wasting the current one
+  arena.allocate(2000);
+  EXPECT_EQ(3024, arena.reserved());
+  char* c = static_cast<char*>(arena.allocate(1, 1));
+  EXPECT_EQ(b + 8, c);
+  
+  // Resetting keeps the regular blocks for reuse
+  arena.reset();
+  EXPECT_EQ(0, arena.allocated());
+  EXPECT_EQ(1024, arena.reserved());
+  EXPECT_EQ(a, arena.allocate(3, 1));
+  
+  // Over-aligned allocations are padded, within a block or on their own
+  void* d = arena.allocate(8, 256);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(d) % 256);
+  void* e = arena.allocate(600, 4096);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(e) % 4096);
+  EXPECT_THROW(arena.allocate(8, 24), expt::ValueError);
+  EXPECT_THROW(arena.allocate(8, 0), expt::ValueError);
+  
+  arena.release();
+  EXPECT_EQ(0, arena.allocated());
+  EXPECT_EQ(0, arena.reserved());
+  
+}
+
+TEST(SyllableTest, arena) {
+  
+  Arena arena;
+  
+  // Short syllables never touch the arena
+  Syllable syllable1(&arena);
+  EXPECT_EQ(&arena, syllable1.arena());
+  syllable1.insert_onset(Consonant(), 0);
+  EXPECT_EQ(0, arena.allocated());
+  
+  // Long ones store their phones in it
+  for(int i = 0; i < 2 * Syllable::inline_capacity; i++) {
+    syllable1.insert_coda(Consonant(), 0);
+  }
+  EXPECT_LT(0, arena.allocated());
+  
+  // Copies go to the heap unless given an arena
+  Syllable syllable2(syllable1);
+  EXPECT_TRUE(syllable1 == syllable2);
+  EXPECT_EQ((Arena*) 0, syllable2.arena());
+  Syllable syllable3(syllable2, &arena);
+  EXPECT_TRUE(syllable1 == syllable3);
+  EXPECT_EQ(&arena, syllable3.arena());
+  
+  // Storage is only taken over from a syllable in the same arena
+  const Phone* first = &syllable3[0];
+  Syllable syllable4(&arena);
+  syllable4 = std::move(syllable3);
+  EXPECT_EQ(first, &syllable4[0]);
+  syllable2 = std::move(syllable4);
+  EXPECT_TRUE(syllable1 == syllable2);
+  EXPECT_EQ((Arena*) 0, syllable2.arena());
+  
+  // Sequences can keep their buffers in the arena too
+  ArenaSequence sequence{ArenaAllocator<Syllable>(arena)};
+  for(int i = 0; i < 100; i++) {
+    sequence.push_back(Syllable(syllable1, &arena));
+  }
+  for(int i = 0; i < 100; i++) {
+    EXPECT_TRUE(syllable1 == sequence[i]);
+    EXPECT_EQ(&arena, sequence[i].arena());
+  }
+  EXPECT_TRUE(sequence.get_allocator() == ArenaAllocator<int>(arena));
+  
+  // And can be read without copying them into a PhoneticSequence
+  ArenaSequence sequence2{ArenaAllocator<Syllable>(arena)};
+  sequence2.push_back(Syllable("\"strENkT"));
+  sequence2.push_back(Syllable("ma_H_L"));
+  PhoneticSequence copy2(sequence2.begin(), sequence2.end());
+  std::string output1;
+  std::string output2;
+  encode(sequence2, output1, lang::x_sampa, '.');
+  encode(copy2, output2, lang::x_sampa, '.');
+  EXPECT_EQ(output2, output1);
+  long long counts1[ToneCode::count] = {0};
+  long long counts2[ToneCode::count] = {0};
+  tone_histogram(sequence2, counts1);
+  tone_histogram(copy2, counts2);
+  EXPECT_TRUE(std::equal(counts1, counts1 + ToneCode::count, counts2));
+  std::ostringstream corpus1;
+  std::ostringstream corpus2;
+  write_corpus(sequence2, corpus1);
+  write_corpus(copy2, corpus2);
+  EXPECT_EQ(corpus2.str(), corpus1.str());
+  EXPECT_EQ(ColumnarSequence(copy2).phone_count(), 
+            ColumnarSequence(sequence2).phone_count());
+  ArenaSequence sequence3(sequence2.rbegin(), sequence2.rend(), 
+                          ArenaAllocator<Syllable>(arena));
+  PhoneticSequence copy3(copy2.rbegin(), copy2.rend());
+  Aligner aligner;
+  std::vector<Aligner::Step> steps;
+  EXPECT_EQ(aligner.distance(copy2, copy3), 
+            aligner.distance(sequence2, sequence3));
+  EXPECT_EQ(aligner.align(copy2, copy3, steps), 
+            aligner.align(sequence2, sequence3, steps));
+  EXPECT_EQ(Aligner::edit_distance(copy2, copy3), 
+            Aligner::edit_distance(sequence2, sequence3));
+  
+}
+
+TEST(ColumnarSequenceTest, conversion) {
+  
+  ColumnarSequence empty;
+  EXPECT_EQ(0, empty.size());
+  EXPECT_EQ(0, empty.phone_count());
+  EXPECT_EQ(0, empty.mean_height());
+  
+  PhoneticSequence sequence;
+  sequence.push_back(Syllable("\"strENkT"));
+  sequence.push_back(Syllable("ma_H_L"));
+  sequence.push_back(Syllable("n="));
+  
+  ColumnarSequence columns(sequence);
+  EXPECT_EQ(3, columns.size());
+  EXPECT_EQ(10, columns.phone_count());
+  EXPECT_EQ(0, columns.offsets()[0]);
+  EXPECT_EQ(7, columns.offsets()[1]);
+  EXPECT_EQ(10, columns.offsets()[3]);
+  EXPECT_TRUE(sequence[1].tone() == columns.tone(1));
+  EXPECT_TRUE(sequence[1].tone() == columns.tone(-2));
+  EXPECT_FALSE(sequence[0].tone() == columns.tone(1));
+  EXPECT_THROW(columns.tone(3), expt::IndexError);
+  
+  PhoneticSequence copy = columns.sequence();
+  ASSERT_EQ(sequence.size(), copy.size());
+  for(int i = 0; i < (int) sequence.size(); i++) {
+    EXPECT_TRUE(sequence[i] == copy[i]);
+    EXPECT_TRUE(sequence[i] == columns.syllable(i));
+  }
+  EXPECT_THROW(columns.syllable(-4), expt::IndexError);
+  
+  columns.clear();
+  EXPECT_EQ(0, columns.size());
+  columns.append(sequence[2]);
+  EXPECT_TRUE(sequence[2] == columns.syllable(0));
+  
+}
+
+TEST(ColumnarSequenceTest, scans) {
+  
+  // Long enough to use every path through the vectorized scans
+  const char* const transcriptions[] = {"kIt", "\"strENkT", "g{p", "bju:", 
+                                        "k_hA:", "i"};
+  PhoneticSequence sequence;
+  for(int i = 0; i < 9001; i++) {
+    sequence.push_back(Syllable(transcriptions[i % 6]));
+  }
+  ColumnarSequence columns(sequence);
+  
+  // Count and sum the slow way for comparison
+  long long vowels = 0;
+  long long voiceless = 0;
+  long long velar_stops = 0;
+  long long voiceless_velar_stops = 0;
+  double height = 0;
+  double length = 0;
+  for(int i = 0; i < (int) sequence.size(); i++) {
+    for(int j = 0; j < sequence[i].size(); j++) {
+      PhoneCode code(sequence[i][j]);
+      voiceless += code.phonation() == Phone::voiceless;
+      length += code.length();
+      if(code.is_vowel()) {
+        vowels++;
+        height += code.height();
+      }
+      else if(code.manner() == Consonant::stop && 
+              code.place() == Consonant::velar) {
+        velar_stops++;
+        voiceless_velar_stops += code.phonation() == Phone::voiceless;
+      }
+    }
+  }
+  
+  EXPECT_EQ(vowels, columns.count_vowels());
+  EXPECT_EQ(voiceless, columns.count(Phone::voiceless));
+  EXPECT_EQ(velar_stops, columns.count(Consonant::stop, Consonant::velar));
+  EXPECT_EQ(voiceless_velar_stops, 
+            columns.count(Consonant::stop, Consonant::velar, 
+                          Phone::voiceless));
+  EXPECT_LT(voiceless_velar_stops, velar_stops);
+  EXPECT_DOUBLE_EQ(height / vowels, columns.mean_height());
+  EXPECT_DOUBLE_EQ(length, columns.total_length());
+  EXPECT_EQ(ColumnarSequence::not_applicable, columns.manners()[1]);
+  
+}
+
+TEST(PhoneFeaturesTest, distance) {
+  
+  PhoneCode i(Vowel(Vowel::close, Vowel::front, Vowel::unrounded));
+  PhoneCode a(Vowel(Vowel::open, Vowel::front, Vowel::unrounded));
+  PhoneCode u(Vowel(Vowel::close, Vowel::back, Vowel::exolabial));
+  PhoneCode k(Consonant(Consonant::stop, Consonant::velar, Phone::voiceless, 
+                        Consonant::not_aspirated));
+  PhoneCode g(Consonant(Consonant::stop, Consonant::velar, Phone::modal, 
+                        Consonant::completely_voiced));
+  
+  EXPECT_EQ(0, PhoneFeatures::distance(i, i));
+  EXPECT_FLOAT_EQ(1, PhoneFeatures::distance(i, a));
+  EXPECT_FLOAT_EQ(std::sqrt(2.0f), PhoneFeatures::distance(i, u));
+  EXPECT_FLOAT_EQ(PhoneFeatures::distance(u, i), 
+                  PhoneFeatures::distance(i, u));
+  EXPECT_LT(PhoneFeatures::distance(k, g), PhoneFeatures::distance(k, i));
+  EXPECT_LE(PhoneFeatures::distance(k, u), 
+            std::sqrt((float) PhoneFeatures::feature_count));
+  
+  float features[PhoneFeatures::feature_count];
+  PhoneFeatures::features(k, features);
+  EXPECT_EQ(1, features[0]);
+  EXPECT_EQ(0, features[1]);
+  EXPECT_FLOAT_EQ(20.0 / 24, features[4]);
+  
+}
+
+TEST(PhoneFeaturesTest, batch) {
+  
+  // Enough phones to use every path through the kernels
+  std::vector<PhoneCode> phones;
+  for(int height = Vowel::open; height <= Vowel::close; height++) {
+    for(int backness = Vowel::front; backness <= Vowel::back; backness++) {
+      phones.push_back(Vowel(height, backness, Vowel::unrounded));
+    }
+  }
+  for(int place = Consonant::bilabial; place <= Consonant::glottal; place++) {
+    for(int manner = Consonant::lateral_flap; manner <= Consonant::nasal; 
+        manner++) {
+      if(!Consonant::check((Consonant::Manner) manner, 
+                           (Consonant::Place) place, Phone::voiceless, 
+                           Consonant::not_aspirated)) {
+        phones.push_back(Consonant((Consonant::Manner) manner, 
+                                   (Consonant::Place) place, 
+                                   Phone::voiceless, 
+                                   Consonant::not_aspirated));
+      }
+    }
+  }
+  
+  PhoneFeatures batch(phones);
+  int size = batch.size();
+  ASSERT_EQ((int) phones.size(), size);
+  EXPECT_TRUE(phones[3] == batch[3]);
+  EXPECT_TRUE(phones.back() == batch[-1]);
+  EXPECT_THROW(batch[size], expt::IndexError);
+  
+  std::vector<float> row(size);
+  batch.distances(5, row.data());
+  for(int j = 0; j < size; j++) {
+    EXPECT_FLOAT_EQ(PhoneFeatures::distance(phones[5], phones[j]), row[j]);
+  }
+  
+  std::vector<float> matrix(size * size);
+  batch.distance_matrix(matrix.data());
+  std::vector<float> parallel(size * size);
+  ThreadPool pool(3);
+  batch.distance_matrix(parallel.data(), pool);
+  for(int i = 0; i < size; i++) {
+    EXPECT_EQ(0, matrix[i * size + i]);
+    for(int j = 0; j < size; j++) {
+      EXPECT_FLOAT_EQ(batch.distance(i, j), matrix[i * size + j]);
+      EXPECT_EQ(matrix[i * size + j], parallel[i * size + j]);
+    }
+  }
+  
+}
+
+TEST(AlignerTest, constructor) {
+  
+  Aligner aligner;
+  EXPECT_EQ(1, aligner.gap_cost());
+  EXPECT_EQ(1, aligner.substitution_weight());
+  EXPECT_THROW(Aligner(0), expt::ValueError);
+  EXPECT_THROW(Aligner(1, -1), expt::ValueError);
+  
+  PhoneCode k(Consonant(Consonant::stop, Consonant::velar, Phone::voiceless, 
+                        Consonant::not_aspirated));
+  PhoneCode g(Consonant(Consonant::stop, Consonant::velar, Phone::modal, 
+                        Consonant::completely_voiced));
+  EXPECT_EQ(0, aligner.substitution_cost(k, k));
+  EXPECT_FLOAT_EQ(PhoneFeatures::distance(k, g), 
+                  aligner.substitution_cost(k, g));
+  EXPECT_FLOAT_EQ(2 * PhoneFeatures::distance(k, g), 
+                  Aligner(1, 2).substitution_cost(k, g));
+  
+}
+
+TEST(AlignerTest, align) {
+  
+  Aligner aligner;
+  PhoneticSequence first = {Syllable("kIt")};
+  PhoneticSequence second = {Syllable("\"strENkT")};
+  
+  // Deleting everything and inserting everything is always possible
+  EXPECT_EQ(0, aligner.distance(first, first));
+  EXPECT_LE(aligner.distance(first, second), 10);
+  EXPECT_EQ(3, aligner.distance(first, PhoneticSequence()));
+  
+  std::vector<Aligner::Step> steps;
+  float cost = aligner.align(first, second, steps);
+  EXPECT_FLOAT_EQ(aligner.distance(first, second), cost);
+  
+  // The steps cover both strings in order and add up to the cost
+  std::vector<PhoneCode> phones1;
+  std::vector<PhoneCode> phones2;
+  for(int i = 0; i < first[0].size(); i++) {
+    phones1.push_back(PhoneCode(first[0][i]));
+  }
+  for(int i = 0; i < second[0].size(); i++) {
+    phones2.push_back(PhoneCode(second[0][i]));
+  }
+  int next1 = 0;
+  int next2 = 0;
+  float total = 0;
+  for(int i = 0; i < (int) steps.size(); i++) {
+    if(steps[i].first >= 0) {
+      EXPECT_EQ(next1++, steps[i].first);
+    }
+    if(steps[i].second >= 0) {
+      EXPECT_EQ(next2++, steps[i].second);
+    }
+    if(steps[i].first >= 0 && steps[i].second >= 0) {
+      total += aligner.substitution_cost(phones1[steps[i].first], 
+                                         phones2[steps[i].second]);
+    }
+    else {
+      total += aligner.gap_cost();
+    }
+  }
+  EXPECT_EQ(3, next1);
+  EXPECT_EQ(7, next2);
+  EXPECT_FLOAT_EQ(cost, total);
+  
+}
+
+TEST(AlignerTest, band) {
+  
+  Aligner aligner(0.75);
+  PhoneticSequence first = {Syllable("\"strENkT"), Syllable("kIt")};
+  PhoneticSequence second = {Syllable("strENT"), Syllable("k_hIt")};
+  
+  // A wide enough band finds the same alignment, a narrow one cannot do 
+  // better, and one narrower than the difference in length finds nothing
+  EXPECT_FLOAT_EQ(aligner.distance(first, second), 
+                  aligner.distance(first, second, 10));
+  EXPECT_LE(aligner.distance(first, second), 
+            aligner.distance(first, second, 1));
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), 
+            aligner.distance(first, PhoneticSequence({Syllable("a")}), 2));
+  
+}
+
+TEST(AlignerTest, edit_distance) {
+  
+  // Compare with a plain dynamic program on strings built from a few phones
+  auto levenshtein = [](const std::vector<PhoneCode>& first, 
+                        const std::vector<PhoneCode>& second) {
+    std::vector<int> previous(second.size() + 1);
+    for(int j = 0; j <= (int) second.size(); j++) {
+      previous[j] = j;
+    }
+    for(int i = 1; i <= (int) first.size(); i++) {
+      std::vector<int> current(second.size() + 1, i);
+      for(int j = 1; j <= (int) second.size(); j++) {
+        current[j] = std::min(previous[j - 1] + (first[i - 1] != second[j - 1]),
+                              std::min(previous[j], current[j - 1]) + 1);
+      }
+      previous = current;
+    }
+    return previous.back();
+  };
+  
+  std::vector<PhoneCode> alphabet;
+  alphabet.push_back(PhoneCode(Vowel()));
+  alphabet.push_back(PhoneCode(Vowel(Vowel::close, Vowel::front, 
+                                     Vowel::unrounded)));
+  alphabet.push_back(PhoneCode(Consonant()));
+  
+  // Strings of up to 64 phones and longer ones use different algorithms
+  unsigned state = 1;
+  for(int trial = 0; trial < 50; trial++) {
+    std::vector<PhoneCode> first;
+    std::vector<PhoneCode> second;
+    int first_size = trial % 2 ? 63 + trial : trial;
+    for(int i = 0; i < first_size; i++) {
+      state = state * 1103515245 + 12345;
+      first.push_back(alphabet[(state >> 16) % 3]);
+    }
+    for(int i = 0; i < 100; i++) {
+      state = state * 1103515245 + 12345;
+      second.push_back(alphabet[(state >> 16) % 3]);
+    }
+    
+    int expected = levenshtein(first, second);
+    EXPECT_EQ(expected, Aligner::edit_distance(first.data(), first.size(), 
+                                               second.data(), second.size()));
+    EXPECT_EQ(expected, Aligner::edit_distance(second.data(), second.size(), 
+                                               first.data(), first.size()));
+  }
+  
+  EXPECT_EQ(3, Aligner::edit_distance(PhoneticSequence({Syllable("kIt")}), 
+                                      PhoneticSequence()));
+  
+}
+
+TEST(AlignerTest, distances) {
+  
+  Aligner aligner;
+  std::vector<PhoneticSequence> first;
+  std::vector<PhoneticSequence> second;
+  for(int i = 0; i < 100; i++) {
+    first.push_back(PhoneticSequence({Syllable(i % 2 ? "kIt" : "g{p")}));
+    second.push_back(PhoneticSequence({Syllable(i % 3 ? "k_hIt" : "bju:")}));
+  }
+  
+  std::vector<float> output(first.size());
+  ThreadPool pool(3);
+  aligner.distances(first, second, output.data(), pool);
+  for(int i = 0; i < (int) first.size(); i++) {
+    EXPECT_EQ(aligner.distance(first[i], second[i]), output[i]);
+  }
+  
+  second.pop_back();
+  EXPECT_THROW(aligner.distances(first, second, output.data(), pool), 
+               expt::ValueError);
+  
+}
+
+TEST(SyllableTest, hash) {
+  
+  // Equal values have equal hashes, whatever their storage
+  Syllable syllable1("\"strENkT");
+  Syllable syllable2(syllable1);
+  EXPECT_EQ(syllable1.hash(), syllable2.hash());
+  EXPECT_EQ(syllable1.hash(), std::hash<Syllable>()(syllable1));
+  Syllable syllable3("a");
+  for(int i = 0; i < 2 * Syllable::inline_capacity; i++) {
+    syllable3.insert_coda(Consonant(), 0);
+  }
+  Syllable syllable4 = syllable3;
+  EXPECT_EQ(syllable3.hash(), syllable4.hash());
+  
+  // Different ones almost never collide
+  EXPECT_NE(Syllable("kIt").hash(), Syllable("tIk").hash());
+  EXPECT_NE(Syllable("kIt").hash(), Syllable("kI").hash());
+  EXPECT_NE(Tone(1, 0, 0).hash(), Tone(0, 1, 0).hash());
+  EXPECT_EQ(Tone(1, 0, -1).hash(), std::hash<Tone>()(Tone(1, 0, -1)));
+  
+  // Phones hash the same as their codes
+  Vowel vowel(Vowel::close, Vowel::back, Vowel::exolabial);
+  Consonant consonant(Consonant::stop, Consonant::velar, Phone::voiceless, 
+                      Consonant::not_aspirated);
+  EXPECT_EQ(PhoneCode(vowel).hash(), vowel.hash());
+  EXPECT_EQ(PhoneCode(consonant).hash(), std::hash<Consonant>()(consonant));
+  const Phone& phone = vowel;
+  EXPECT_EQ(std::hash<Vowel>()(vowel), phone.hash());
+  EXPECT_EQ(vowel.hash(), std::hash<PhoneCode>()(PhoneCode(vowel)));
+  
+  std::unordered_set<Syllable> set;
+  set.insert(syllable1);
+  set.insert(syllable2);
+  set.insert(syllable3);
+  EXPECT_EQ(2, set.size());
+  
+}
+
+TEST(SyllableIndexTest, add) {
+  
+  SyllableIndex index;
+  EXPECT_EQ(0, index.size());
+  EXPECT_EQ(-1, index.find(Syllable()));
+  
+  PhoneticSequence sequence = {Syllable("kIt"), Syllable("m@"), 
+                               Syllable("kIt")};
+  index.add(sequence);
+  EXPECT_EQ(2, index.size());
+  EXPECT_EQ(3, index.tokens());
+  EXPECT_EQ(0, index.find(Syllable("kIt")));
+  EXPECT_EQ(1, index.find(Syllable("m@")));
+  EXPECT_EQ(2, index.count(0));
+  EXPECT_EQ(1, index.count(1));
+  EXPECT_TRUE(Syllable("m@") == index[1]);
+  EXPECT_THROW(index[2], expt::IndexError);
+  EXPECT_THROW(index.count(-1), expt::IndexError);
+  EXPECT_THROW(index.add(Syllable(), -1), expt::ValueError);
+  
+  EXPECT_EQ(1, index.add(Syllable("m@"), 10));
+  EXPECT_EQ(11, index.count(1));
+  EXPECT_EQ(13, index.tokens());
+  
+  // Growing the table keeps every ID
+  Vowel vowel;
+  Consonant consonant;
+  std::vector<Syllable> types;
+  for(int i = 0; i < 1000; i++) {
+    std::vector<const Phone*> onset(i % 10, &consonant);
+    types.push_back(Syllable(onset, {&vowel}, {}, 
+                             Tone(i / 10 % 5 - 2, i / 50 % 5 - 2, 
+                                  i / 250 - 2)));
+  }
+  for(int i = 0; i < (int) types.size(); i++) {
+    index.add(types[i]);
+  }
+  EXPECT_EQ(1002, index.size());
+  for(int i = 0; i < (int) types.size(); i++) {
+    EXPECT_EQ(i + 2, index.find(types[i]));
+  }
+  
+  index.clear();
+  EXPECT_EQ(0, index.size());
+  EXPECT_EQ(0, index.tokens());
+  EXPECT_EQ(-1, index.find(types[0]));
+  
+}
+
+TEST(SyllableTest, stamp) {
+  
+  // Copies share a stamp, and anything else gets a new one
+  Syllable syllable1("kIt");
+  Syllable syllable2(syllable1);
+  Syllable syllable3("kIt");
+  EXPECT_NE(0, syllable1.stamp());
+  EXPECT_EQ(syllable1.stamp(), syllable2.stamp());
+  EXPECT_NE(syllable1.stamp(), syllable3.stamp());
+  syllable3 = syllable1;
+  EXPECT_EQ(syllable1.stamp(), syllable3.stamp());
+  Syllable syllable4(std::move(syllable3));
+  EXPECT_EQ(syllable1.stamp(), syllable4.stamp());
+  EXPECT_NE(syllable1.stamp(), syllable3.stamp());
+  
+  // Every way of changing a syllable changes its stamp
+  uint64_t stamp = syllable2.stamp();
+  syllable2.insert_coda(Consonant(), 0);
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  syllable2.remove_coda(0);
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  syllable2[0];
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  syllable2.vowels();
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  syllable2.begin();
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  syllable2.visit([](Phone&, Syllable::Part) {});
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  Decoder(x_sampa).decode("kIt", 3, syllable2);
+  EXPECT_NE(stamp, syllable2.stamp());
+  stamp = syllable2.stamp();
+  syllable2.touch();
+  EXPECT_NE(stamp, syllable2.stamp());
+  
+  // Reading does not
+  stamp = syllable2.stamp();
+  const Syllable& syllable5 = syllable2;
+  syllable5[0];
+  syllable5.vowels();
+  syllable5.begin();
+  syllable5.x_sampa();
+  EXPECT_EQ(stamp, syllable2.stamp());
+  
+  // Stamps are unique across threads
+  std::vector<uint64_t> stamps(4);
+  std::vector<std::thread> threads;
+  for(int i = 0; i < 4; i++) {
+    threads.emplace_back([&stamps, i]() {
+      stamps[i] = Syllable("a").stamp();
+    });
+  }
+  for(int i = 0; i < 4; i++) {
+    threads[i].join();
+  }
+  std::sort(stamps.begin(), stamps.end());
+  EXPECT_TRUE(std::unique(stamps.begin(), stamps.end()) == stamps.end());
+  
+}
+
+TEST(SyllableTest, materialize) {
+  
+  // Phones are stored as PhoneCodes, with vowel heights and backnesses 
+  // kept exactly beside them
+  EXPECT_TRUE(std::is_trivially_copyable<Syllable::Slot>::value);
+  EXPECT_EQ(sizeof(PhoneCode) + 2 * sizeof(float), sizeof(Syllable::Slot));
+  Vowel vowel0(2.3, 1.1, Vowel::unrounded);
+  Syllable syllable0;
+  syllable0.insert_nucleus(vowel0, 0);
+  syllable0.remove_nucleus(1);
+  const Syllable& view0 = syllable0;
+  EXPECT_TRUE(vowel0 == static_cast<const Vowel&>(view0[0]));
+  EXPECT_TRUE(vowel0 == syllable0.span()[0].vowel());
+  EXPECT_FALSE(vowel0 == PhoneCode(vowel0).vowel());
+  
+  // Including after a change in place is packed back into the Slots
+  static_cast<Vowel&>(syllable0[0]).raise(0.001);
+  vowel0.raise(0.001);
+  syllable0.insert_coda(Consonant(), 0);
+  EXPECT_TRUE(vowel0 == static_cast<const Vowel&>(view0[0]));
+  EXPECT_TRUE(vowel0 == syllable0.span()[0].vowel());
+  EXPECT_EQ(vowel0.height(), syllable0.nucleus_span()[0].vowel().height());
+  
+  // A change made through a reference is seen by everything that reads the 
+  // phones, and the reference stays valid until phones are added or removed
+  Syllable syllable1("pat");
+  Phone& phone1 = syllable1[1];
+  phone1.set_length(2);
+  EXPECT_EQ("[pa:t]", syllable1.x_sampa());
+  EXPECT_TRUE(syllable1 == Syllable("pa:t"));
+  EXPECT_EQ(Syllable("pa:t").hash(), syllable1.hash());
+  PhoneCode code1 = PhoneCode(Syllable("pa:t")[1]);
+  EXPECT_EQ(code1, syllable1.span()[1].code());
+  EXPECT_EQ(code1, syllable1.nucleus_span()[0].code());
+  phone1.set_length(1);
+  EXPECT_EQ("[pat]", syllable1.x_sampa());
+  EXPECT_EQ(&phone1, &syllable1[1]);
+  
+  // Copies take the changed phones with them
+  static_cast<Consonant&>(syllable1[0]).set_place(Consonant::velar);
+  Syllable syllable2(syllable1);
+  EXPECT_EQ("[kat]", syllable2.x_sampa());
+  Syllable syllable3;
+  syllable3 = syllable1;
+  EXPECT_EQ("[kat]", syllable3.x_sampa());
+  
+  // Adding or removing phones keeps the changes
+  syllable1.insert_coda(Consonant(), 0);
+  syllable1.remove_coda(0);
+  EXPECT_EQ("[kat]", syllable1.x_sampa());
+  for(Phone* phone : syllable1.phones()) {
+    phone->set_length(2);
+  }
+  EXPECT_EQ("[k:a:t:]", syllable1.x_sampa());
+  
+  // Const syllables hand out const phones, and iterators and views read 
+  // the Slots until a phone is reached through them
+  const Syllable& view1 = syllable1;
+  EXPECT_TRUE((std::is_same<std::vector<const Phone*>, 
+    decltype(view1.phones())>::value));
+  EXPECT_EQ(3u, view1.phones().size());
+  
+  // Const iterators and views yield values read from the Slots, which see 
+  // changes made through references
+  EXPECT_TRUE((std::is_same<Syllable::Slot, 
+    decltype(*view1.begin())>::value));
+  EXPECT_TRUE((std::is_same<Syllable::Slot, 
+    decltype(view1.onset()[0])>::value));
+  EXPECT_TRUE((std::is_same<Vowel, decltype(view1.vowels()[0])>::value));
+  static_cast<Vowel&>(syllable1[1]).raise(0.25);
+  EXPECT_TRUE(static_cast<Vowel&>(syllable1[1]) == view1.vowels()[0]);
+  EXPECT_EQ(PhoneCode(syllable1[1]), view1.begin()[1].code());
+  EXPECT_EQ(PhoneCode(syllable1[1]), view1.nucleus().begin()->code());
+  int lengths1 = 0;
+  for(Syllable::Slot slot : view1) {
+    lengths1 += slot.code().length();
+  }
+  EXPECT_EQ(6, lengths1);
+  Syllable syllable5("pat");
+  Syllable::iterator position5 = syllable5.begin() + 1;
+  EXPECT_EQ(syllable5.begin() + 1, position5);
+  position5->set_length(2);
+  EXPECT_EQ("[pa:t]", syllable5.x_sampa());
+  for(Phone& phone : syllable5.consonants()) {
+    phone.set_length(2);
+  }
+  EXPECT_EQ("[p:a:t:]", syllable5.x_sampa());
+  EXPECT_EQ(1, syllable5.vowels().size());
+  
+  // Const syllables can be materialized from several threads at once
+  const Syllable syllable4("\"strENkT");
+  std::vector<std::thread> threads;
+  std::vector<const Phone*> phones(4);
+  for(int t = 0; t < 4; t++) {
+    threads.push_back(std::thread([&syllable4, &phones, t]() {
+      phones[t] = &syllable4[0];
+    }));
+  }
+  for(int t = 0; t < 4; t++) {
+    threads[t].join();
+  }
+  for(int t = 1; t < 4; t++) {
+    EXPECT_EQ(phones[0], phones[t]);
+  }
+  
+}
+
+TEST(SyllableTest, span) {
+  
+  // Spans see the same phones as the reference accessors
+  Syllable syllable("\"strENkT");
+  const Syllable& view = syllable;
+  Syllable::Span span = syllable.span();
+  ASSERT_EQ(syllable.size(), span.size());
+  for(int i = 0; i < span.size(); i++) {
+    EXPECT_EQ(PhoneCode(view[i]), span[i].code());
+    EXPECT_EQ(PhoneCode(view[i]).is_vowel(), span[i].is_vowel());
+  }
+  EXPECT_TRUE(span[-1] == span[span.size() - 1]);
+  EXPECT_EQ(syllable.onset_size(), syllable.onset_span().size());
+  EXPECT_EQ(syllable.nucleus_size(), syllable.nucleus_span().size());
+  EXPECT_EQ(syllable.coda_size(), syllable.coda_span().size());
+  EXPECT_EQ(view.nucleus()[0].code(), syllable.nucleus_span()[0].code());
+  EXPECT_EQ(view.coda()[0].code(), syllable.coda_span()[0].code());
+  EXPECT_TRUE(span.end() == syllable.coda_span().end());
+  int vowels = 0;
+  for(Syllable::Slot slot : syllable.nucleus_span()) {
+    vowels += slot.is_vowel();
+  }
+  EXPECT_EQ(syllable.nucleus_size(), vowels);
+  EXPECT_FALSE(Syllable().span().empty());
+  EXPECT_TRUE(Syllable().coda_span().empty());
+  
+  // IndexError thrown when expected
+  bool exception_thrown(false);
+  try {
+    syllable.onset_span()[syllable.onset_size()];
+  }
+  catch(expt::IndexError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, views) {
+  
+  // The views refer to the phones in place and skip the other kind, and 
+  // const views yield them by value
+  Syllable syllable("\"strENkT");
+  const Syllable& constant = syllable;
+  EXPECT_EQ(syllable.onset_size(), constant.onset().size());
+  EXPECT_EQ(syllable.nucleus_size(), constant.nucleus().size());
+  EXPECT_EQ(syllable.coda_size(), constant.coda().size());
+  EXPECT_TRUE(Syllable::Slot(syllable[0]) == constant.onset()[0]);
+  EXPECT_EQ(&syllable[-1], &syllable.coda()[-1]);
+  EXPECT_EQ(syllable.size(), 
+            syllable.vowels().size() + syllable.consonants().size());
+  EXPECT_EQ(&syllable[-1], &syllable.consonants()[-1]);
+  int consonants = 0;
+  for(const Consonant& consonant : constant.consonants()) {
+    EXPECT_EQ(consonant, constant.consonants()[consonants]);
+    consonants++;
+  }
+  EXPECT_EQ(syllable.consonants().size(), consonants);
+  EXPECT_FALSE(syllable.vowels().empty());
+  EXPECT_TRUE(Syllable().consonants().empty());
+  
+  // Changes through a view change the syllable
+  Vowel vowel(syllable.vowels()[0]);
+  for(Vowel& each : syllable.vowels()) {
+    each.raise(1);
+  }
+  vowel.raise(1);
+  EXPECT_EQ(vowel, syllable.vowels()[0]);
+  
+  // IndexError thrown when expected
+  bool exception_thrown(false);
+  try {
+    constant.vowels()[constant.vowels().size()];
+  }
+  catch(expt::IndexError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+namespace {
+  
+  struct PartCounter {
+    
+    int vowels[3];
+    int consonants[3];
+    
+    PartCounter() {
+      
+      for(int i = 0; i < 3; i++) {
+        vowels[i] = consonants[i] = 0;
+      }
+      
+    }
+    
+    void operator()(const Vowel&, Syllable::Part part) {
+      
+      vowels[part]++;
+      
+    }
+    
+    void operator()(const Consonant&, Syllable::Part part) {
+      
+      consonants[part]++;
+      
+    }
+    
+  };
+  
+};
+
+TEST(SyllableTest, visit) {
+  
+  // Each phone is visited once, as its own kind, with its part
+  Syllable syllable("\"strENkT");
+  PartCounter counter;
+  syllable.visit(counter);
+  EXPECT_EQ(syllable.onset_size(), counter.consonants[Syllable::onset_part]);
+  EXPECT_EQ(syllable.nucleus_size(), counter.vowels[Syllable::nucleus_part]);
+  EXPECT_EQ(syllable.coda_size(), counter.consonants[Syllable::coda_part]);
+  EXPECT_EQ(0, counter.vowels[Syllable::onset_part] + 
+               counter.vowels[Syllable::coda_part] + 
+               counter.consonants[Syllable::nucleus_part]);
+  
+  // Temporaries work too
+  Syllable().visit(PartCounter());
+  PartCounter schwa;
+  Syllable().visit(schwa);
+  EXPECT_EQ(1, schwa.vowels[Syllable::nucleus_part]);
+  
+}
+TEST(SyllableTest, iterator) {
+  
+  // The iterators meet the standard random-access requirements
+  typedef std::iterator_traits<Syllable::iterator> traits;
+  EXPECT_TRUE((std::is_same<std::random_access_iterator_tag, 
+                            traits::iterator_category>::value));
+  EXPECT_TRUE((std::is_same<Phone&, traits::reference>::value));
+  EXPECT_TRUE((std::is_same<Syllable::Slot, std::iterator_traits<
+                 Syllable::const_iterator>::reference>::value));
+  
+  // "strENkT: onset s t r, nucleus E, coda N k T
+  Syllable syllable("\"strENkT");
+  EXPECT_EQ(7, syllable.end() - syllable.begin());
+  EXPECT_EQ(3, std::distance(syllable.onset_begin(), syllable.onset_end()));
+  EXPECT_EQ(1, std::distance(syllable.nucleus_begin(), 
+                             syllable.nucleus_end()));
+  EXPECT_EQ(3, std::distance(syllable.coda_begin(), syllable.coda_end()));
+  EXPECT_TRUE(syllable.nucleus_begin() == syllable.onset_end());
+  EXPECT_EQ(4, std::count_if(syllable.begin(), syllable.end(), 
+                             [](const Phone& phone) {
+                               return phone.phonation() == Phone::voiceless;
+                             }));
+  
+  Syllable::iterator vowel = 
+    std::find_if(syllable.begin(), syllable.end(), [](const Phone& phone) {
+      return dynamic_cast<const Vowel*>(&phone) != 0;
+    });
+  EXPECT_EQ(3, vowel.position());
+  EXPECT_EQ(-4, vowel.inverse_position());
+  EXPECT_TRUE(vowel == syllable.nucleus_begin());
+  EXPECT_TRUE(&*vowel == &syllable[3]);
+  EXPECT_TRUE(&vowel[1] == &syllable[4]);
+  EXPECT_TRUE(&*(2 + vowel) == &syllable[5]);
+  EXPECT_TRUE(&*(vowel - 3) == &syllable[0]);
+  EXPECT_TRUE(vowel > syllable.begin() && vowel < 4 && vowel >= 3);
+  
+  // Phones can be changed in place through an iterator
+  for(Syllable::iterator i = syllable.coda_begin(); i != syllable.coda_end(); 
+      i++) {
+    i->set_length(2);
+  }
+  EXPECT_EQ(2, syllable[-1].length());
+  EXPECT_EQ(1, syllable[0].length());
+  
+  // Construction and set_position are the only bounds checks
+  const Syllable& view = syllable;
+  Syllable::const_iterator last(view, -1);
+  EXPECT_EQ(7, last.position());
+  EXPECT_TRUE(last == view.end());
+  last.set_position(-2);
+  EXPECT_TRUE(*last == Syllable::Slot(syllable[6]));
+  Syllable::const_iterator first = syllable.begin();
+  EXPECT_TRUE(first == view.begin());
+  std::reverse_iterator<Syllable::const_iterator> reverse(view.end());
+  EXPECT_TRUE(*reverse == Syllable::Slot(syllable[6]));
+  
+  bool exception_thrown = false;
+  try {
+    Syllable::iterator(syllable, 8);
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  exception_thrown = false;
+  try {
+    last.set_position(-9);
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(SyllableTest, unchecked) {
+  
+  // The unchecked accessors agree with the checked ones
+  Syllable syllable("\"strENkT");
+  const Syllable& view = syllable;
+  for(int i = 0; i < syllable.size(); i++) {
+    EXPECT_TRUE(&syllable.unchecked(i) == &syllable[i]);
+    EXPECT_TRUE(&view.unchecked(i) == &view[i]);
+  }
+  Syllable::Span coda = syllable.coda_span();
+  EXPECT_TRUE(coda.unchecked(2) == coda[-1]);
+  
+  Tone tone(1, 0, -1);
+  const Tone& levels = tone;
+  for(int i = 0; i < 3; i++) {
+    EXPECT_EQ(tone[i], tone.unchecked(i));
+    EXPECT_EQ(&levels[i], &levels.unchecked(i));
+  }
+  tone.unchecked(1) = 2;
+  EXPECT_EQ(2, tone[-2]);
+  
+  bool exception_thrown = false;
+  try {
+    tone[3];
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+    EXPECT_EQ(3, e.index());
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  // Fields wider than their enumerations are rejected before any table 
+  // lookup: manner 15, place 31, and phonation 15
+  PhoneCode code2 = PhoneCode(Consonant());
+  code2.set_code(code2.code() | (uint64_t) 15 << 1 | (uint64_t) 15 << 7 
+                              | (uint64_t) 31 << 11);
+  EXPECT_EQ(Phone::undefined_value, code2.violation());
+  
+  // Secondary articulation 31
+  PhoneCode code3 = PhoneCode(Consonant());
+  code3.set_code(code3.code() | (uint64_t) 31 << 16);
+  EXPECT_EQ(Phone::undefined_value, code3.violation());
+  
+  // Roundedness 3 and nasalization 3
+  PhoneCode code4 = PhoneCode(Vowel());
+  code4.set_code(code4.code() | (uint64_t) 3 << 7);
+  EXPECT_EQ(Phone::undefined_value, code4.violation());
+  PhoneCode code5 = PhoneCode(Vowel());
+  code5.set_code(code5.code() | (uint64_t) 3 << 5);
+  EXPECT_EQ(Phone::undefined_value, code5.violation());
+  
+  EXPECT_EQ(Phone::undefined_value, 
+            Consonant::check(Consonant::stop, (Consonant::Place) 25, 
+                             Phone::voiceless, Consonant::not_aspirated));
+  EXPECT_FALSE(Consonant::articulable((Consonant::Manner) -1, 
+                                      Consonant::bilabial, Phone::voiceless, 
+                                      Consonant::not_aspirated));
+  EXPECT_EQ(Phone::undefined_value, 
+            Vowel::check(Vowel::open, Vowel::front, Vowel::unrounded, 
+                         Phone::oral, false, (Phone::Phonation) 10));
+  
+}
+
+TEST(ToneCodeTest, constructor) {
+  
+  // Every tone round-trips, and codes order tones level by level
+  EXPECT_EQ(ToneCode(Tone()), ToneCode());
+  int previous = -1;
+  for(int i = -2; i <= 2; i++) {
+    for(int j = -2; j <= 2; j++) {
+      for(int k = -2; k <= 2; k++) {
+        ToneCode code(Tone(i, j, k));
+        EXPECT_EQ(previous + 1, code.code());
+        EXPECT_TRUE(Tone(i, j, k) == code.tone());
+        EXPECT_EQ(j, code.level(1));
+        EXPECT_EQ(3, code.end() - code.begin());
+        EXPECT_EQ(k, code.begin()[2]);
+        previous = code.code();
+      }
+    }
+  }
+  EXPECT_EQ(ToneCode::count - 1, previous);
+  EXPECT_TRUE(ToneCode(-1, 2, 2) < ToneCode(0, -2, -2));
+  EXPECT_EQ(ToneCode(1, 0, -1).hash(), 
+            std::hash<ToneCode>()(ToneCode(1, 0, -1)));
+  
+  // ImpossibleArticulation thrown when expected
+  bool exception_thrown(false);
+  try {
+    ToneCode(0, 3, 0);
+  }
+  catch(ImpossibleArticulation e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(ToneCodeTest, order) {
+  
+  // Contours
+  EXPECT_EQ(ToneCode::level_tone, ToneCode(1, 1, 1).contour());
+  EXPECT_EQ(ToneCode::rising_tone, ToneCode(-2, -2, 1).contour());
+  EXPECT_EQ(ToneCode::falling_tone, ToneCode(2, 0, -1).contour());
+  EXPECT_EQ(ToneCode::peaking_tone, ToneCode(-1, 2, 0).contour());
+  EXPECT_EQ(ToneCode::dipping_tone, ToneCode(1, -2, 1).contour());
+  
+  // ++ visits every tone once, by contour, and -- undoes it
+  ToneCode code(-2, -2, -2);
+  EXPECT_EQ(0, code.rank());
+  std::vector<bool> seen(ToneCode::count, false);
+  for(int i = 0; i < ToneCode::count; i++) {
+    EXPECT_EQ(i, code.rank());
+    EXPECT_FALSE(seen[code.code()]);
+    seen[code.code()] = true;
+    ToneCode next = code;
+    ++next;
+    if(i + 1 < ToneCode::count) {
+      EXPECT_LE(code.contour(), next.contour());
+    }
+    EXPECT_EQ(code, --ToneCode(next));
+    code = next;
+  }
+  EXPECT_EQ(ToneCode(-2, -2, -2), code);
+  EXPECT_EQ(ToneCode(-2, -2, -2), code--);
+  EXPECT_EQ(ToneCode::count - 1, code.rank());
+  
+  // Tone steps through the same order
+  Tone tone(1, 1, 1);
+  ++tone;
+  EXPECT_TRUE(tone == (++ToneCode(1, 1, 1)).tone());
+  --tone;
+  EXPECT_TRUE(tone == Tone(1, 1, 1));
+  
+  // Postfix steps return the tone as it was before
+  EXPECT_TRUE(tone++ == Tone(1, 1, 1));
+  EXPECT_TRUE(tone == (++ToneCode(1, 1, 1)).tone());
+  EXPECT_TRUE(tone-- == (++ToneCode(1, 1, 1)).tone());
+  EXPECT_TRUE(tone == Tone(1, 1, 1));
+  
+}
+
+TEST(ToneCodeTest, histogram) {
+  
+  // Syllables keep their tones as codes
+  PhoneticSequence sequence;
+  Consonant consonant;
+  Vowel vowel;
+  for(int i = 0; i < 1000; i++) {
+    Tone tone(i % 5 - 2, i % 3 - 1, 0);
+    sequence.push_back(Syllable({&consonant}, {&vowel}, {}, tone));
+    EXPECT_EQ(ToneCode(tone), sequence.back().tone_code());
+  }
+  
+  // Counts are added to, and both kinds of sequence agree
+  long long counts[ToneCode::count] = {};
+  counts[0] = 7;
+  tone_histogram(sequence, counts);
+  EXPECT_EQ(7, counts[0]);
+  EXPECT_EQ(67, counts[ToneCode(0, 0, 0).code()]);
+  EXPECT_EQ(66, counts[ToneCode(2, 1, 0).code()]);
+  long long columnar[ToneCode::count] = {};
+  ColumnarSequence columns(sequence);
+  columns.tone_histogram(columnar);
+  for(int i = 1; i < ToneCode::count; i++) {
+    EXPECT_EQ(counts[i], columnar[i]);
+  }
+  EXPECT_EQ(ToneCode(-2, -1, 0), columns.tones()[0]);
+  EXPECT_TRUE(Tone(2, -1, 0) == columns.tone(-1));
+  
+}
+TEST(EncodingCacheTest, encode) {
+  
+  // Same text as encode, with each syllable transcribed once per encoding
+  PhoneticSequence sequence;
+  const char* transcriptions[] = {"\"strENkT", "ma_H_L", "kIt", "ma_H_L"};
+  for(int i = 0; i < 4; i++) {
+    sequence.push_back(Syllable(transcriptions[i]));
+  }
+  EncodingCache cache;
+  for(int i = 0; i < 3; i++) {
+    PhoneticEncoding encoding = (PhoneticEncoding) i;
+    std::string expected;
+    encode(sequence, expected, encoding, '.');
+    std::string output = "[";
+    cache.encode(sequence, output, encoding, '.');
+    EXPECT_EQ("[" + expected, output);
+  }
+  EXPECT_EQ(4, cache.size());
+  EXPECT_EQ(12, cache.misses());
+  
+  // Only changed syllables are transcribed again, however they changed
+  std::string output;
+  cache.encode(sequence, output);
+  EXPECT_EQ(12, cache.misses());
+  sequence[2].vowels()[0].raise(1);
+  sequence[0].insert_onset(Consonant(), 0);
+  sequence[3] = sequence[1];
+  output.clear();
+  cache.encode(sequence, output);
+  EXPECT_EQ(15, cache.misses());
+  std::string expected;
+  encode(sequence, expected);
+  EXPECT_EQ(expected, output);
+  sequence[2].vowels()[0].lower(1);
+  EXPECT_EQ(Syllable("kIt").x_sampa(), "[" + cache.encode(2, sequence[2]) + 
+                                       "]");
+  EXPECT_EQ(16, cache.misses());
+  
+  // A change through a reference taken earlier needs a touch to be seen
+  Phone& phone = sequence[1][0];
+  cache.encode(1, sequence[1]);
+  phone.set_length(2);
+  EXPECT_EQ(17, cache.misses());
+  EXPECT_EQ("ma_H_L", cache.encode(1, sequence[1]));
+  sequence[1].touch();
+  std::string lengthened;
+  sequence[1].encode(lengthened);
+  EXPECT_NE("ma_H_L", lengthened);
+  EXPECT_EQ(lengthened, cache.encode(1, sequence[1]));
+  EXPECT_EQ(18, cache.misses());
+  
+  // Entries past the end of a shorter sequence are dropped
+  sequence.pop_back();
+  for(int i = 0; i < 3; i++) {
+    output.clear();
+    cache.encode(sequence, output, (PhoneticEncoding) i);
+  }
+  EXPECT_EQ(3, cache.size());
+  
+  cache.clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(0, cache.misses());
+  std::string transcription;
+  sequence[1].encode(transcription, unicode);
+  EXPECT_EQ(transcription, cache.encode(0, sequence[1], unicode));
+  
+  bool exception_thrown = false;
+  try {
+    cache.encode(-1, sequence[1]);
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(LexiconTest, add) {
+  
+  // Pronunciations come back exactly, by ID and by word
+  Lexicon lexicon;
+  PhoneticSequence strengths;
+  strengths.push_back(Syllable("\"strENkTs"));
+  PhoneticSequence mama;
+  mama.push_back(Syllable("ma_H_L"));
+  mama.push_back(Syllable("ma"));
+  EXPECT_EQ(0, lexicon.add("strengths", strengths));
+  EXPECT_EQ(1, lexicon.add("mama", mama));
+  EXPECT_EQ(2, lexicon.add("", PhoneticSequence()));
+  EXPECT_EQ(3, lexicon.size());
+  EXPECT_EQ(strengths[0].size() + mama[0].size() + mama[1].size(), 
+            lexicon.phone_count());
+  EXPECT_EQ(1, lexicon.find("mama"));
+  EXPECT_EQ(2, lexicon.find(""));
+  EXPECT_EQ(-1, lexicon.find("mam"));
+  EXPECT_EQ("strengths", lexicon.word(0));
+  Lexicon::Pronunciation pronunciation = lexicon[lexicon.find("mama")];
+  ASSERT_EQ(2, pronunciation.size());
+  EXPECT_TRUE(mama[1] == pronunciation[-1].syllable());
+  EXPECT_TRUE(mama[0].tone() == pronunciation[0].tone());
+  EXPECT_TRUE(strengths == lexicon[0].sequence());
+  EXPECT_EQ(0, lexicon[2].size());
+  
+  // Many words, so that the table grows
+  for(int i = 0; i < 1000; i++) {
+    lexicon.add("word" + std::to_string(i), mama);
+  }
+  EXPECT_FALSE(lexicon.frozen());
+  pronunciation = lexicon[lexicon.size() - 1];
+  const PhoneCode* phones = pronunciation[0].phones();
+  lexicon.freeze();
+  EXPECT_TRUE(lexicon.frozen());
+  
+  // Freezing leaves earlier pronunciations valid
+  EXPECT_EQ(phones, lexicon[lexicon.size() - 1][0].phones());
+  EXPECT_EQ(phones, pronunciation[0].phones());
+  EXPECT_TRUE(mama == pronunciation.sequence());
+  EXPECT_EQ(1003, lexicon.size());
+  for(int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i + 3, lexicon.find("word" + std::to_string(i)));
+  }
+  EXPECT_EQ(0, lexicon.find("strengths"));
+  
+  // Exceptions thrown when expected
+  bool exception_thrown(false);
+  try {
+    lexicon.add("new", mama);
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  Lexicon unfrozen;
+  unfrozen.add("mama", mama);
+  exception_thrown = false;
+  try {
+    unfrozen.add("mama", strengths);
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  EXPECT_EQ(1, unfrozen.size());
+  exception_thrown = false;
+  try {
+    unfrozen[1];
+  }
+  catch(expt::IndexError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(LexiconTest, concurrent) {
+  
+  // Threads reading the same frozen lexicon all see the same pronunciations
+  Lexicon lexicon;
+  for(int i = 0; i < 500; i++) {
+    PhoneticSequence pronunciation(1 + i % 3, Syllable(i % 2 ? "kIt" : "ma"));
+    lexicon.add("word" + std::to_string(i), pronunciation);
+  }
+  lexicon.freeze();
+  std::vector<int> phones(4, 0);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 4; t++) {
+    threads.push_back(std::thread([&lexicon, &phones, t]() {
+      for(int i = 0; i < 500; i++) {
+        Lexicon::Pronunciation pronunciation = 
+          lexicon[lexicon.find("word" + std::to_string(i))];
+        for(int j = 0; j < pronunciation.size(); j++) {
+          phones[t] += pronunciation[j].size();
+        }
+      }
+    }));
+  }
+  for(int t = 0; t < 4; t++) {
+    threads[t].join();
+  }
+  for(int t = 0; t < 4; t++) {
+    EXPECT_EQ(lexicon.phone_count(), phones[t]);
+  }
+  
+}
+TEST(NgramCounterTest, add) {
+  
+  // "strENkT: onset s t r, nucleus E, coda N k T
+  PhoneInventory inventory;
+  NgramCounter counter(3, inventory);
+  Syllable syllable("\"strENkT");
+  counter.add(syllable);
+  std::vector<int> ids;
+  inventory.intern(syllable, ids);
+  int s = ids[0], t = ids[1], r = ids[2], e = ids[3], k = ids[5];
+  const int boundary = NgramCounter::boundary;
+  EXPECT_EQ(1, counter.syllables());
+  EXPECT_EQ(1, counter.count(Syllable::onset_part, {s}));
+  EXPECT_EQ(1, counter.count(Syllable::onset_part, {boundary, s, t}));
+  EXPECT_EQ(1, counter.count(Syllable::onset_part, {t, r, boundary}));
+  EXPECT_EQ(0, counter.count(Syllable::onset_part, {e}));
+  EXPECT_EQ(1, counter.count(Syllable::nucleus_part, {boundary, e, boundary}));
+  EXPECT_EQ(1, counter.count(Syllable::coda_part, {k}));
+  EXPECT_EQ(0, counter.count(Syllable::coda_part, {12345}));
+  EXPECT_EQ(5, counter.total(Syllable::onset_part, 1));
+  EXPECT_EQ(4, counter.total(Syllable::onset_part, 2));
+  EXPECT_EQ(3, counter.total(Syllable::onset_part, 3));
+  EXPECT_EQ(1, counter.tone_count(syllable.tone_code()));
+  
+  // Empty parts are a pair of boundaries
+  counter.add(Syllable("a"));
+  EXPECT_EQ(1, counter.count(Syllable::onset_part, {boundary, boundary}));
+  EXPECT_EQ(1, counter.count(Syllable::coda_part, {boundary, boundary}));
+  
+  // Probabilities condition on the phones before the last
+  EXPECT_DOUBLE_EQ(0.5, counter.probability(Syllable::onset_part, 
+                                            {boundary, s}));
+  EXPECT_DOUBLE_EQ(1.0, counter.probability(Syllable::onset_part, 
+                                            {s, t, r}));
+  EXPECT_DOUBLE_EQ(0.5, counter.probability(Syllable::coda_part, 
+                                            {boundary, boundary}));
+  EXPECT_DOUBLE_EQ(0.0, counter.probability(Syllable::coda_part, 
+                                            {k, boundary, boundary}));
+  EXPECT_DOUBLE_EQ(1 / 7.0, counter.probability(Syllable::onset_part, {s}));
+  
+  // ValueError thrown when expected
+  bool exception_thrown(false);
+  try {
+    counter.count(Syllable::onset_part, {s, t, r, boundary});
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  exception_thrown = false;
+  try {
+    NgramCounter(5, inventory);
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  exception_thrown = false;
+  try {
+    counter.merge(NgramCounter(2, inventory));
+  }
+  catch(expt::ValueError e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+}
+
+TEST(NgramCounterTest, sources) {
+  
+  // Sequences, binary corpora, and threads all give the same counts
+  PhoneticSequence sequence;
+  const char* transcriptions[] = {"\"strENkT", "ma_H_L", "kIt", "a", "tak"};
+  for(int i = 0; i < 500; i++) {
+    sequence.push_back(Syllable(transcriptions[i % 5]));
+  }
+  std::ostringstream stream;
+  write_corpus(sequence, stream);
+  std::string data = stream.str();
+  std::vector<uint64_t> words((data.size() + 7) / 8);
+  std::memcpy(words.data(), data.data(), data.size());
+  CorpusView corpus(words.data(), data.size());
+  
+  PhoneInventory inventory;
+  NgramCounter serial(2, inventory);
+  serial.add(sequence);
+  NgramCounter viewed(2, inventory);
+  viewed.add(corpus);
+  NgramCounter sharded(2, inventory);
+  ThreadPool pool(3);
+  sharded.add(sequence, pool);
+  sharded.add(corpus, pool);
+  
+  EXPECT_EQ(500, viewed.syllables());
+  EXPECT_EQ(1000, sharded.syllables());
+  int a = inventory.find(PhoneCode(Syllable("a")[0]));
+  int t = inventory.find(PhoneCode(Syllable("tak")[0]));
+  for(int part = 0; part < 3; part++) {
+    Syllable::Part p = (Syllable::Part) part;
+    for(int length = 1; length <= 2; length++) {
+      EXPECT_EQ(serial.total(p, length), viewed.total(p, length));
+      EXPECT_EQ(2 * serial.total(p, length), sharded.total(p, length));
+    }
+    for(int i = -1; i < inventory.size(); i++) {
+      EXPECT_EQ(serial.count(p, {i}), viewed.count(p, {i}));
+      EXPECT_EQ(2 * serial.count(p, {i, NgramCounter::boundary}), 
+                sharded.count(p, {i, NgramCounter::boundary}));
+    }
+  }
+  EXPECT_EQ(100, serial.count(Syllable::onset_part, {NgramCounter::boundary, 
+                                                      t}));
+  EXPECT_EQ(300, serial.count(Syllable::nucleus_part, {a}));
+  EXPECT_EQ(800, sharded.tone_count(ToneCode()));
+  EXPECT_EQ(200, sharded.tone_count(Syllable("ma_H_L").tone_code()));
+  
+  sharded.clear();
+  EXPECT_EQ(0, sharded.syllables());
+  EXPECT_EQ(0, sharded.count(Syllable::nucleus_part, {a}));
+  
+}
+TEST(FeatureIndexTest, bitmap) {
+  
+  FeatureIndex::Bitmap bitmap1(130);
+  FeatureIndex::Bitmap bitmap2(130);
+  bitmap1.set(0);
+  bitmap1.set(64);
+  bitmap1.set(-1);
+  bitmap2.set(64);
+  bitmap2.set(100);
+  EXPECT_EQ(3, bitmap1.count());
+  EXPECT_TRUE(bitmap1[129]);
+  EXPECT_FALSE(bitmap1[1]);
+  EXPECT_EQ(1, (bitmap1 & bitmap2).count());
+  EXPECT_EQ(4, (bitmap1 | bitmap2).count());
+  EXPECT_EQ(127, (~bitmap1).count());
+  EXPECT_TRUE(~~bitmap1 == bitmap1);
+  EXPECT_TRUE(bitmap1 != bitmap2);
+  std::vector<int> indices;
+  (bitmap1 | bitmap2).indices(indices);
+  EXPECT_EQ((std::vector<int> {0, 64, 100, 129}), indices);
+  EXPECT_EQ(0, FeatureIndex::Bitmap().count());
+  
+  // Exceptions thrown when expected
+  int exceptions_thrown(0);
+  try {
+    bitmap1 &= FeatureIndex::Bitmap(129);
+  }
+  catch(expt::ValueError e) {
+    exceptions_thrown++;
+  }
+  try {
+    bitmap1.set(130);
+  }
+  catch(expt::IndexError e) {
+    exceptions_thrown++;
+  }
+  EXPECT_EQ(2, exceptions_thrown);
+  
+}
+
+TEST(FeatureIndexTest, queries) {
+  
+  // Every query agrees with checking the phones one at a time
+  PhoneticSequence sequence;
+  const char* transcriptions[] = {"\"strENkTs", "k_hwa", "q_hOG", "ba~", 
+                                  "ts_hy", "gIt", "m=", "x_>e", "Ru"};
+  for(int i = 0; i < 9; i++) {
+    sequence.push_back(Syllable(transcriptions[i]));
+  }
+  sequence[0].insert_nucleus(Vowel(2.5, 1.25, Vowel::unrounded), 0);
+  ColumnarSequence columns(sequence);
+  FeatureIndex index(columns);
+  ASSERT_EQ(columns.phone_count(), index.size());
+  FeatureIndex::Bitmap query = index.consonants() & 
+    (index.place(Consonant::velar) | index.place(Consonant::uvular)) & 
+    index.vot(Consonant::weakly_aspirated, Consonant::strongly_aspirated);
+  FeatureIndex::Bitmap voiceless = index.phonation(Phone::voiceless);
+  FeatureIndex::Bitmap front = index.place(Consonant::bilabial, 
+                                           Consonant::apical_alveolar);
+  FeatureIndex::Bitmap mid = index.height(2.5, 4);
+  FeatureIndex::Bitmap central = index.backness(1, 2);
+  int matches = 0;
+  for(int i = 0; i < index.size(); i++) {
+    PhoneCode phone = index[i];
+    bool consonant = phone.is_consonant();
+    bool expected = consonant && (phone.place() == Consonant::velar || 
+                                  phone.place() == Consonant::uvular) && 
+                    phone.vot() >= Consonant::weakly_aspirated;
+    EXPECT_EQ(expected, query[i]);
+    matches += expected;
+    EXPECT_EQ(phone.phonation() == Phone::voiceless, voiceless[i]);
+    EXPECT_EQ(consonant && phone.place() <= Consonant::apical_alveolar, 
+              front[i]);
+    EXPECT_EQ(!consonant && phone.height() >= 2.5 && phone.height() <= 4, 
+              mid[i]);
+    EXPECT_EQ(!consonant && phone.backness() >= 1 && phone.backness() <= 2, 
+              central[i]);
+    EXPECT_EQ(consonant && phone.manner() == Consonant::stop, 
+              index.manner(Consonant::stop)[i]);
+    EXPECT_EQ(consonant && phone.mechanism() == Consonant::ejective, 
+              index.mechanism(Consonant::ejective)[i]);
+    EXPECT_EQ(!consonant && phone.roundedness() == Vowel::unrounded, 
+              index.roundedness(Vowel::unrounded)[i]);
+  }
+  EXPECT_EQ(2, matches);
+  EXPECT_EQ(index.size(), (index.vowels() | index.consonants()).count());
+  EXPECT_EQ(0, (index.vowels() & index.consonants()).count());
+  EXPECT_EQ(index.vowels().count(), index.height(0, 6).count());
+  EXPECT_EQ(0, index.vot(Consonant::strongly_aspirated, 
+                         Consonant::completely_voiced).count());
+  
+  // Inventories are indexed by ID
+  PhoneInventory inventory;
+  inventory.intern(Consonant(Consonant::stop, Consonant::velar, 
+                             Phone::voiceless, Consonant::weakly_aspirated));
+  inventory.intern(Vowel());
+  FeatureIndex ids(inventory);
+  EXPECT_EQ(2, ids.size());
+  EXPECT_TRUE(ids.vot(Consonant::weakly_aspirated)[0]);
+  EXPECT_TRUE(ids.vowels()[1]);
+  EXPECT_TRUE(inventory[1] == ids[-1]);
+  
+}
+
+TEST(FeatureIndexTest, invalid) {
+  
+  PhoneCode phones[2] = {PhoneCode(Vowel()), PhoneCode(Consonant())};
+  FeatureIndex index(phones, 2);
+  
+  // Feature values outside their enumerations are rejected
+  int exceptions_thrown(0);
+  try {
+    index.manner((Consonant::Manner) (Consonant::nasal + 1));
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  try {
+    index.place(Consonant::bilabial, (Consonant::Place) 25);
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  try {
+    index.vot((Consonant::VOT) -1, Consonant::not_aspirated);
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  try {
+    index.phonation((Phone::Phonation) 10);
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  
+  // So are phones whose features could not be looked up
+  phones[1].set_code(phones[1].code() | (uint64_t) 15 << 7);
+  try {
+    FeatureIndex index2(phones, 2);
+  }
+  catch(expt::ValueError& e) {
+    exceptions_thrown++;
+  }
+  EXPECT_EQ(5, exceptions_thrown);
+  EXPECT_EQ(1, index.place(Consonant::bilabial, Consonant::glottal).count());
+  
+}
+namespace {
+  
+  void count_trace(Instrumentation::Event event, long long nanoseconds, 
+                   void* data) {
+    
+    if(event == Instrumentation::value_error && nanoseconds == 7) {
+      (*static_cast<int*>(data))++;
+    }
+    
+  }
+  
+};
+
+TEST(InstrumentationTest, record) {
+  
+  // Events recorded by hand are counted on every thread, and reset starts 
+  // the counts over
+  Instrumentation::reset();
+  Instrumentation::Snapshot snapshot = Instrumentation::snapshot();
+  for(int i = 0; i < Instrumentation::event_count; i++) {
+    EXPECT_EQ(0, snapshot.counts[i]);
+    EXPECT_EQ(0, snapshot.nanoseconds[i]);
+  }
+  
+  int traced = 0;
+  Instrumentation::set_trace_hook(count_trace, &traced);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 4; t++) {
+    threads.push_back(std::thread([]() {
+      for(int i = 0; i < 100; i++) {
+        Instrumentation::record(Instrumentation::value_error, 7);
+      }
+    }));
+  }
+  for(int t = 0; t < 4; t++) {
+    threads[t].join();
+  }
+  Instrumentation::record(Instrumentation::value_error, 7);
+  Instrumentation::set_trace_hook(0);
+  Instrumentation::record(Instrumentation::value_error, 7);
+  
+  snapshot = Instrumentation::snapshot();
+  EXPECT_EQ(402, snapshot.counts[Instrumentation::value_error]);
+  EXPECT_EQ(2814, snapshot.nanoseconds[Instrumentation::value_error]);
+  EXPECT_EQ(401, traced);
+  
+  {
+    Instrumentation::Timer timer(Instrumentation::unicode_encode);
+  }
+  snapshot = Instrumentation::snapshot();
+  EXPECT_EQ(1, snapshot.counts[Instrumentation::unicode_encode]);
+  EXPECT_TRUE(snapshot.nanoseconds[Instrumentation::unicode_encode] >= 0);
+  
+  Instrumentation::reset();
+  snapshot = Instrumentation::snapshot();
+  EXPECT_EQ(0, snapshot.counts[Instrumentation::value_error]);
+  EXPECT_EQ(0, snapshot.counts[Instrumentation::unicode_encode]);
+  EXPECT_EQ(Instrumentation::kirschenbaum_decode, 
+            Instrumentation::decode_event(kirschenbaum));
+  EXPECT_EQ(Instrumentation::x_sampa_encode, 
+            Instrumentation::encode_event(x_sampa));
+  
+}
+
+TEST(InstrumentationTest, hooks) {
+  
+  // The library's own operations are only counted when it is built with 
+  // LANG_INSTRUMENTATION
+  Instrumentation::reset();
+  Syllable syllable("ka_H", x_sampa);
+  Syllable copy(syllable);
+  std::string transcription = syllable.unicode();
+  bool exception_thrown = false;
+  try {
+    Syllable("k", x_sampa);
+  }
+  catch(DecodingFailed& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  exception_thrown = false;
+  try {
+    syllable[5];
+  }
+  catch(expt::IndexError& e) {
+    exception_thrown = true;
+  }
+  EXPECT_TRUE(exception_thrown);
+  
+  Instrumentation::Snapshot snapshot = Instrumentation::snapshot();
+  int expected = Instrumentation::enabled() ? 1 : 0;
+  EXPECT_EQ(2 * expected, snapshot.counts[Instrumentation::x_sampa_decode]);
+  EXPECT_EQ(0, snapshot.counts[Instrumentation::unicode_decode]);
+  EXPECT_EQ(expected, snapshot.counts[Instrumentation::unicode_encode]);
+  EXPECT_EQ(expected, snapshot.counts[Instrumentation::syllable_copy]);
+  EXPECT_EQ(expected, snapshot.counts[Instrumentation::decoding_failed]);
+  EXPECT_EQ(expected, snapshot.counts[Instrumentation::index_error]);
+  EXPECT_EQ(0, snapshot.counts[Instrumentation::value_error]);
+  
+}
+
+TEST(SoundChangeTest, rule) {
+  
+  PhoneCode mid(Vowel(Vowel::close_mid, Vowel::front, Vowel::unrounded));
+  PhoneCode back(Vowel(Vowel::close_mid, Vowel::back, Vowel::exolabial));
+  PhoneCode stop(Consonant(Consonant::stop, Consonant::velar, 
+                           Phone::voiceless, Consonant::not_aspirated));
+  
+  // An empty rule matches everything and changes nothing
+  SoundChange::Rule rule1;
+  EXPECT_TRUE(rule1.matches(mid, Syllable::nucleus_part));
+  EXPECT_TRUE(rule1.matches(stop, Syllable::coda_part));
+  PhoneCode code(stop);
+  EXPECT_EQ(Phone::no_violation, rule1.apply(code));
+  EXPECT_TRUE(code == stop);
+  
+  // Raise front vowels until they cannot be raised any more
+  SoundChange::Rule rule2;
+  rule2.match_backness(0, 1);
+  rule2.raise(1.0);
+  EXPECT_TRUE(rule2.matches(mid, Syllable::nucleus_part));
+  EXPECT_FALSE(rule2.matches(back, Syllable::nucleus_part));
+  EXPECT_FALSE(rule2.matches(stop, Syllable::onset_part));
+  code = mid;
+  EXPECT_EQ(Phone::no_violation, rule2.apply(code));
+  EXPECT_EQ(Vowel::near_close, code.height());
+  EXPECT_EQ(Phone::no_violation, rule2.apply(code));
+  EXPECT_EQ(Phone::height_out_of_range, rule2.apply(code));
+  EXPECT_EQ(Vowel::close, code.height());
+  EXPECT_EQ(Vowel::front, code.backness());
+  
+  // Aspirate voiceless stops in onsets
+  SoundChange::Rule rule3;
+  rule3.match_manner(Consonant::stop);
+  rule3.match_phonation(Phone::voiceless);
+  rule3.match_part(Syllable::onset_part);
+  rule3.later_vot(2);
+  EXPECT_TRUE(rule3.matches(stop, Syllable::onset_part));
+  EXPECT_FALSE(rule3.matches(stop, Syllable::coda_part));
+  EXPECT_FALSE(rule3.matches(mid, Syllable::onset_part));
+  code = stop;
+  EXPECT_EQ(Phone::no_violation, rule3.apply(code));
+  EXPECT_EQ(Consonant::moderately_aspirated, code.vot());
+  EXPECT_EQ(Phone::no_violation, rule3.apply(code));
+  EXPECT_EQ(Consonant::strongly_aspirated, code.vot());
+  EXPECT_TRUE(code == PhoneCode(Consonant(Consonant::stop, Consonant::velar, 
+                                          Phone::voiceless, 
+                                          Consonant::strongly_aspirated)));
+  
+  // Values of one feature are alternatives
+  SoundChange::Rule rule4;
+  rule4.match_place(Consonant::velar);
+  rule4.match_place(Consonant::uvular);
+  EXPECT_TRUE(rule4.matches(stop, Syllable::onset_part));
+  EXPECT_FALSE(rule4.matches(back, Syllable::nucleus_part));
+  rule4.match_vowels();
+  EXPECT_FALSE(rule4.matches(stop, Syllable::onset_part));
+  SoundChange::Rule rule5;
+  rule5.match_vot(Consonant::strongly_aspirated, 
+                  Consonant::completely_voiced);
+  EXPECT_FALSE(rule5.matches(stop, Syllable::onset_part));
+  
+  // Impossible changes are rejected
+  SoundChange::Rule rule6;
+  rule6.set_place(Consonant::pharyngeal);
+  rule6.set_phonation(Phone::glottal_closure);
+  code = stop;
+  EXPECT_EQ(Phone::impossible_place, rule6.apply(code));
+  EXPECT_TRUE(code == stop);
+  code = mid;
+  EXPECT_EQ(Phone::closed_glottis_vowel, rule6.apply(code));
+  EXPECT_TRUE(code == mid);
+  
+}
+
+TEST(SoundChangeTest, apply) {
+  
+  SoundChange::Rule raising;
+  raising.match_backness(0, 1);
+  raising.raise(1.0);
+  SoundChange::Rule aspiration;
+  aspiration.match_manner(Consonant::stop);
+  aspiration.match_phonation(Phone::voiceless);
+  aspiration.match_part(Syllable::onset_part);
+  aspiration.set_vot(Consonant::moderately_aspirated);
+  SoundChange::Rule glottalization;
+  glottalization.match_manner(Consonant::stop);
+  glottalization.match_part(Syllable::coda_part);
+  glottalization.set_place(Consonant::glottal);
+  SoundChange changes = {raising, aspiration, glottalization};
+  ASSERT_EQ(3, changes.size());
+  
+  PhoneticSequence sequence = {Syllable("pet"), Syllable("bEd"), 
+                               Syllable("tip"), Syllable("ku")};
+  ColumnarSequence columns(sequence);
+  std::vector<SoundChange::Rejection> rejections;
+  EXPECT_EQ(7, changes.apply(sequence, &rejections));
+  ASSERT_EQ(2, (int) rejections.size());
+  EXPECT_EQ(1, rejections[0].syllable);
+  EXPECT_EQ(2, rejections[0].position);
+  EXPECT_EQ(2, rejections[0].rule);
+  EXPECT_EQ(Phone::voiced_glottal_stop, rejections[0].violation);
+  EXPECT_TRUE(rejections[0].phone == PhoneCode(Syllable("bEd")[2]));
+  EXPECT_EQ(2, rejections[1].syllable);
+  EXPECT_EQ(1, rejections[1].position);
+  EXPECT_EQ(0, rejections[1].rule);
+  EXPECT_EQ(Phone::height_out_of_range, rejections[1].violation);
+  
+  const Consonant& onset = static_cast<const Consonant&>(sequence[0][0]);
+  const Consonant& coda = static_cast<const Consonant&>(sequence[0][2]);
+  EXPECT_EQ(Consonant::moderately_aspirated, onset.vot());
+  EXPECT_EQ(Consonant::glottal, coda.place());
+  EXPECT_EQ(Vowel::near_close, 
+            static_cast<const Vowel&>(sequence[0][1]).height());
+  EXPECT_TRUE(PhoneCode(sequence[1][2]) == rejections[0].phone);
+  EXPECT_EQ(Consonant::moderately_aspirated, 
+            static_cast<const Consonant&>(sequence[3][0]).vot());
+  
+  // Columns give the same results
+  std::vector<SoundChange::Rejection> column_rejections;
+  EXPECT_EQ(7, changes.apply(columns, &column_rejections));
+  ASSERT_EQ(rejections.size(), column_rejections.size());
+  for(int i = 0; i < (int) rejections.size(); i++) {
+    EXPECT_EQ(rejections[i].syllable, column_rejections[i].syllable);
+    EXPECT_EQ(rejections[i].position, column_rejections[i].position);
+    EXPECT_TRUE(rejections[i].phone == column_rejections[i].phone);
+  }
+  EXPECT_TRUE(columns.sequence() == sequence);
+  EXPECT_EQ(2, columns.count(Consonant::stop, Consonant::glottal));
+  EXPECT_DOUBLE_EQ(ColumnarSequence(sequence).mean_height(), 
+                   columns.mean_height());
+  
+  // A single syllable, and no rules
+  Syllable syllable("pe");
+  EXPECT_EQ(2, changes.apply(syllable));
+  EXPECT_EQ(0, SoundChange().apply(syllable));
+  
+  // Syllables that no rule changes keep their stamps, so the encodings 
+  // cached for them are still used
+  PhoneticSequence sequence3 = {Syllable("bOn"), Syllable("mo")};
+  EncodingCache cache;
+  std::string output1;
+  cache.encode(sequence3, output1);
+  uint64_t stamp = sequence3[0].stamp();
+  long long misses = cache.misses();
+  EXPECT_EQ(0, changes.apply(sequence3));
+  EXPECT_EQ(stamp, sequence3[0].stamp());
+  std::string output2;
+  cache.encode(sequence3, output2);
+  EXPECT_EQ(output1, output2);
+  EXPECT_EQ(misses, cache.misses());
+  Syllable syllable3("pe");
+  stamp = syllable3.stamp();
+  EXPECT_EQ(2, changes.apply(syllable3));
+  EXPECT_NE(stamp, syllable3.stamp());
+  EXPECT_TRUE(changes[-1].matches(PhoneCode(Syllable("pet")[2]), 
+                                  Syllable::coda_part));
+  
+  // Syllables keep changed heights exactly, and columns quantize them
+  SoundChange::Rule nudge;
+  nudge.raise(0.001);
+  SoundChange nudging = {nudge};
+  PhoneticSequence sequence2 = {Syllable("e")};
+  ColumnarSequence columns2(sequence2);
+  Vowel vowel = sequence2[0].span()[0].vowel();
+  EXPECT_EQ(1, nudging.apply(sequence2));
+  EXPECT_EQ(1, nudging.apply(sequence2));
+  vowel.raise(0.001);
+  vowel.raise(0.001);
+  EXPECT_TRUE(vowel == sequence2[0].span()[0].vowel());
+  EXPECT_EQ(0, nudging.apply(columns2));
+  EXPECT_TRUE(columns2.sequence()[0] == Syllable("e"));
+  
+  // Exceptions thrown when expected
+  int exceptions_thrown(0);
+  try {
+    changes[3];
+  }
+  catch(expt::IndexError e) {
+    exceptions_thrown++;
+  }
+  try {
+    columns.set(columns.phone_count(), PhoneCode());
+  }
+  catch(expt::IndexError e) {
+    exceptions_thrown++;
+  }
+  EXPECT_EQ(2, exceptions_thrown);
+  
+}
+TEST(PhoneTest, names) {
+  
+  // Names are constants spelled like the enumerators
+  static_assert(name(Consonant::velar)[0] == 'v', 
+                "Names must be usable in constant expressions.");
+  EXPECT_STREQ("glottal_closure", name(Phone::glottal_closure));
+  EXPECT_STREQ("strongly_nasal", name(Phone::strongly_nasal));
+  EXPECT_STREQ("near_close", name(Vowel::near_close));
+  EXPECT_STREQ("near_back", name(Vowel::near_back));
+  EXPECT_STREQ("endolabial", name(Vowel::endolabial));
+  EXPECT_STREQ("sib_fricative", name(Consonant::sib_fricative));
+  EXPECT_STREQ("alveolo_palatal", name(Consonant::alveolo_palatal));
+  EXPECT_STREQ("not_aspirated", name(Consonant::not_aspirated));
+  EXPECT_STREQ("pul_eg", name(Consonant::pul_eg));
+  Consonant::Place place = Consonant::uvular;
+  EXPECT_EQ("uvular", lang::string(place));
+  EXPECT_EQ("ejective", lang::string(Consonant::ejective));
+  
+  // Every name parses back to its value
+  for(int i = 0; i <= Consonant::glottal; i++) {
+    Consonant::Place result = Consonant::bilabial;
+    const char* spelling = name((Consonant::Place) i);
+    EXPECT_TRUE(parse(spelling, std::strlen(spelling), result));
+    EXPECT_EQ(i, result);
+  }
+  for(int i = 0; i <= Phone::strident; i++) {
+    Phone::Phonation result = Phone::modal;
+    EXPECT_TRUE(parse(lang::string((Phone::Phonation) i), result));
+    EXPECT_EQ(i, result);
+  }
+  Vowel::Height height = Vowel::mid;
+  EXPECT_TRUE(parse(std::string("close"), height));
+  EXPECT_EQ(Vowel::close, height);
+  Vowel::Backness backness = Vowel::front;
+  EXPECT_TRUE(parse("central", 7, backness));
+  EXPECT_EQ(Vowel::central, backness);
+  Vowel::Roundedness roundedness = Vowel::unrounded;
+  EXPECT_TRUE(parse("exolabial", 9, roundedness));
+  EXPECT_EQ(Vowel::exolabial, roundedness);
+  Phone::Nasalization nasalization = Phone::oral;
+  EXPECT_TRUE(parse("nasal", 5, nasalization));
+  EXPECT_EQ(Phone::nasal, nasalization);
+  Consonant::Manner manner = Consonant::stop;
+  EXPECT_TRUE(parse("nasal", 5, manner));
+  EXPECT_EQ(Consonant::nasal, manner);
+  Consonant::VOT vot = Consonant::not_aspirated;
+  EXPECT_TRUE(parse("weakly_voiced", 13, vot));
+  EXPECT_EQ(Consonant::weakly_voiced, vot);
+  Consonant::Mechanism mechanism = Consonant::pul_eg;
+  EXPECT_TRUE(parse("implosive", 9, mechanism));
+  EXPECT_EQ(Consonant::implosive, mechanism);
+  
+  // Anything else is rejected and leaves the result alone
+  EXPECT_FALSE(parse("velars", 6, place));
+  EXPECT_FALSE(parse("vela", 4, place));
+  EXPECT_FALSE(parse(std::string("nasal"), place));
+  EXPECT_FALSE(parse("", 0, place));
+  EXPECT_FALSE(parse("Velar", 5, place));
+  EXPECT_EQ(Consonant::uvular, place);
+  EXPECT_FALSE(parse("strongly nasal", 14, nasalization));
+  EXPECT_EQ(Phone::nasal, nasalization);
+  
+}
+
+TEST(PhoneTest, enumeration_stepping) {
+  
+  Phone::Phonation phonation = Phone::harsh;
+  EXPECT_EQ(Phone::strident, ++phonation);
+  EXPECT_EQ(Phone::voiceless, ++phonation);
+  EXPECT_EQ(Phone::strident, --phonation);
+  EXPECT_EQ(Phone::strident, phonation++);
+  EXPECT_EQ(Phone::voiceless, phonation);
+  EXPECT_EQ(Phone::voiceless, phonation--);
+  EXPECT_EQ(Phone::strident, phonation);
+  
+  Consonant::Place place = Consonant::velar;
+  EXPECT_EQ(Consonant::bilabial, place += 5);
+  EXPECT_EQ(Consonant::pharyngeal, place -= 3);
+  EXPECT_EQ(Consonant::pharyngeal, place += 25 * 40);
+  EXPECT_EQ(Consonant::velar, place -= -23);
+  place += std::numeric_limits<int>::max();
+  EXPECT_EQ((std::numeric_limits<int>::max() % 25 + Consonant::velar) % 25, 
+            place);
+  place = Consonant::bilabial;
+  place -= std::numeric_limits<int>::min();
+  EXPECT_EQ((25 - std::numeric_limits<int>::min() % 25) % 25, place);
+  
+  Vowel::Height height = Vowel::close;
+  EXPECT_EQ(Vowel::open, ++height);
+  Vowel::Backness backness = Vowel::front;
+  EXPECT_EQ(Vowel::back, --backness);
+  Vowel::Roundedness roundedness = Vowel::unrounded;
+  EXPECT_EQ(Vowel::unrounded, roundedness += 3);
+  Phone::Nasalization nasalization = Phone::oral;
+  EXPECT_EQ(Phone::strongly_nasal, nasalization -= 4);
+  Consonant::Manner manner = Consonant::stop;
+  EXPECT_EQ(Consonant::lateral_flap, manner += 2);
+  Consonant::VOT vot = Consonant::completely_voiced;
+  EXPECT_EQ(Consonant::completely_voiced, vot--);
+  EXPECT_EQ(Consonant::strongly_aspirated, vot);
+  Consonant::Mechanism mechanism = Consonant::implosive;
+  EXPECT_EQ(Consonant::implosive, mechanism++);
+  EXPECT_EQ(Consonant::pul_eg, mechanism);
+  
+}
+int main(int argc, char** argv) {
   
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -5,11 +5,21 @@ Implementation of the expt library of general-purpose exceptions.
 */
 
 #include <string>
+#include <utility>
+#include <exception>
 
 #include "expt.h"
 
 using namespace expt;
 
+namespace {
+  
+  // what() of an IndexError with a known index and size, whose message() 
+  // formats the full text
+  const char index_out_of_range[] = "index out of range";
+  
+}
+
 // Classes
 
 // Exception
@@ -19,21 +29,48 @@ using namespace expt;
   Exception::Exception() {
     
     // Initialize essential fields
-    _message = "";
+    _literal = 0;
+    
+  }
+  
+  Exception::Exception(std::string message) 
+    : _message(std::move(message)) {
+    
+    // Initialize essential fields
+    _literal = 0;
+    
+  }
+  
+  Exception::Exception(const char* message) : _message(message) {
+    
+    // Initialize essential fields
+    _literal = 0;
     
   }
   
-  Exception::Exception(std::string message) {
+  Exception::Exception(Literal, const char* message) {
     
     // Initialize essential fields
-    _message = message;
+    _literal = message;
     
   }
   
-  Exception::Exception(const Exception& original) {
+  Exception::Exception(const Exception& original) : std::exception(original) {
     
     // Initialize essential fields
     _message = original._message;
+    _literal = original._literal;
+    
+  }
+  
+  Exception::Exception(Exception&& original) noexcept 
+    : _message(std::move(original._message)) {
+    
+    // Initialize essential fields
+    _literal = original._literal;
+    
+    original._message.clear();
+    original._literal = 0;
     
   }
   
@@ -41,6 +78,19 @@ using namespace expt;
     
     // Field assignment
     _message = other._message;
+    _literal = other._literal;
+    
+    return *this;
+    
+  }
+  
+  Exception& Exception::operator=(Exception&& other) noexcept {
+    
+    // Field assignment
+    _message = std::move(other._message);
+    _literal = other._literal;
+    other._message.clear();
+    other._literal = 0;
     
     return *this;
     
@@ -48,13 +98,28 @@ using namespace expt;
   
   std::string Exception::message() const {
     
+    if(_literal) {
+      return _literal;
+    }
+    
     return _message;
     
   }
   
   void Exception::set_message(std::string new_message) {
     
-    _message = new_message;
+    _message = std::move(new_message);
+    _literal = 0;
+    
+  }
+  
+  const char* Exception::what() const noexcept {
+    
+    if(_literal) {
+      return _literal;
+    }
+    
+    return _message.c_str();
     
   }
 
@@ -62,31 +127,34 @@ using namespace expt;
   
   ValueError::~ValueError() {}
   
-  ValueError::ValueError() {
-    
-    // Initialize essential fields
-    _message = "";
-    
-  }
+  ValueError::ValueError() {}
   
-  ValueError::ValueError(std::string message) {
-    
-    // Initialize essential fields
-    _message = message;
-    
-  }
+  ValueError::ValueError(std::string message) 
+    : Exception(std::move(message)) {}
+  
+  ValueError::ValueError(const char* message) : Exception(message) {}
+  
+  ValueError::ValueError(Literal, const char* message) 
+    : Exception(literal, message) {}
+  
+  ValueError::ValueError(const ValueError& original) : Exception(original) {}
+  
+  ValueError::ValueError(ValueError&& original) noexcept 
+    : Exception(std::move(original)) {}
   
-  ValueError::ValueError(const ValueError& original) {
+  ValueError& ValueError::operator=(const ValueError& other) {
     
-    // Initialize essential fields
-    _message = original._message;
+    // Transfer fields
+    Exception::operator=(other);
+    
+    return *this;
     
   }
   
-  ValueError& ValueError::operator=(const ValueError& other) {
+  ValueError& ValueError::operator=(ValueError&& other) noexcept {
     
     // Transfer fields
-    _message = other._message;
+    Exception::operator=(std::move(other));
     
     return *this;
     
@@ -94,7 +162,8 @@ using namespace expt;
   
   ValueError::operator Exception() {
     
-    return Exception(_message);
+    // A literal message is copied as a pointer, not as a string
+    return Exception(*this);
     
   }
 
@@ -105,16 +174,63 @@ using namespace expt;
   IndexError::IndexError() {
     
     // Initialize essential fields
-    _message = "";
+    _index = 0;
+    _size = -1;
+    
+  }
+  
+  IndexError::IndexError(long long index, long long size) 
+    : ValueError(literal, index_out_of_range) {
+    
+    // Initialize essential fields
+    _index = index;
+    _size = size;
+    
+  }
+  
+  IndexError::IndexError(const IndexError& original) : ValueError(original) {
+    
+    // Initialize essential fields
+    _index = original._index;
+    _size = original._size;
     
   }
   
   IndexError& IndexError::operator=(const IndexError& other) {
     
+    // Transfer fields
+    ValueError::operator=(other);
+    _index = other._index;
+    _size = other._size;
+    
     return *this;
     
   }
   
+  std::string IndexError::message() const {
+    
+    // set_message replaces the literal, and its message is kept as it is
+    if(_literal != index_out_of_range) {
+      return ValueError::message();
+    }
+    
+    return "Index " + std::to_string(_index) + " is out of range for size " + 
+           std::to_string(_size) + ".";
+    
+  }
+  
+  long long IndexError::index() const {
+    
+    return _index;
+    
+  }
+  
+  long long IndexError::size() const {
+    
+    return _size;
+    
+  }
+  
   IndexError::operator ValueError() {
     
     return ValueError();
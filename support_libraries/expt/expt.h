@@ -5,6 +5,7 @@ This file contains the definitions for the expt library.
 */
 
 #include <string>
+#include <exception>
 
 #ifndef EXPT_HEADER
 #define EXPT_HEADER
@@ -13,7 +14,25 @@ namespace expt {
 
   // Classes
 
-  class Exception {
+  class Literal {
+    
+    /*
+    A tag type that selects the literal constructors of the exceptions in this 
+    project.  Passing literal before a message says that the message has 
+    static storage duration, such as a string literal, so it is only pointed 
+    to and never copied.  A message passed without the tag is always copied.
+    */
+    
+  };
+  
+  const Literal literal = Literal();
+    
+    /*
+    The only value of Literal, to be passed as the first argument of a literal 
+    constructor
+    */
+  
+  class Exception : public std::exception {
     
     /*
     This class is a basic, all-purpose exception.  It should be used as a base 
@@ -21,6 +40,16 @@ namespace expt {
     where no other exception seems to fit.  It includes an optional error 
     message with which to provide information about why the exception was 
     thrown.
+    
+    Exceptions are meant to be cheap to throw.  A message that is passed with 
+    the literal tag is only pointed to, never copied.  Subclasses that carry 
+    details such as an index keep only the details, and format the full 
+    message from them when message() is called.
+    
+    Since Exception derives from std::exception, every exception in this 
+    project can also be caught as a std::exception.  what() gives the same 
+    text as message(), except for subclasses that format their message, 
+    whose what() is a short fixed description of the error.
     */
     
     protected:
@@ -31,6 +60,15 @@ namespace expt {
         An error message to provide more information about what went wrong and 
         caused this exception to be thrown.
         */
+      
+      const char* _literal;
+        
+        /*
+        A message with static storage duration, such as a string literal, 
+        which is used instead of _message if it is not null.  It is not owned 
+        by the Exception.
+        */
+      
     
     public:
       
@@ -55,7 +93,29 @@ namespace expt {
         
         Parameters:
           message: An error message with which to provide more information 
-                    about why the exception was thrown.
+                    about why the exception was thrown.  It is moved into the 
+                    Exception, so an rvalue is never copied.
+        */
+      
+      Exception(const char* message);
+        
+        /*
+        C string constructor
+        
+        Parameters:
+          message: An error message, which is copied into the Exception
+        */
+      
+      Exception(Literal, const char* message);
+        
+        /*
+        Literal constructor
+        
+        Nothing is allocated or copied, so the message must outlive the 
+        Exception and every copy of it.  This is meant for string literals.
+        
+        Parameters:
+          message: A static error message
         */
       
       Exception(const Exception& original);
@@ -67,6 +127,18 @@ namespace expt {
           original: Exception to be copied
         */
       
+      Exception(Exception&& original) noexcept;
+        
+        /*
+        Move constructor
+        
+        Takes over original's message without copying it.  original is left 
+        with an empty message.
+        
+        Parameters:
+          original: Exception to be moved from
+        */
+      
       virtual Exception& operator=(const Exception& other);
        
         /*
@@ -75,6 +147,15 @@ namespace expt {
         Parameters:
           other: Other Exception to be copied
         */
+      
+      virtual Exception& operator=(Exception&& other) noexcept;
+        
+        /*
+        Move assignment.  other is left with an empty message.
+        
+        Parameters:
+          other: Other Exception to be moved from
+        */
     
       virtual std::string message() const;
         
@@ -85,11 +166,21 @@ namespace expt {
       virtual void set_message(std::string new_message);
        
         /*
-        Replaces the Exception's error message with the one given.
+        Replaces the Exception's error message with the one given.  Pass an 
+        rvalue to hand over the string without copying it.
         
         Parameters:
           new_message: The new error message
         */
+      
+      const char* what() const noexcept;
+        
+        /*
+        Returns the stored message, as required by std::exception.  Nothing 
+        is built or allocated, so it is safe to call on the same Exception 
+        from several threads at once.  Subclasses that format their message 
+        return a fixed description instead.
+        */
     
   };
   
@@ -131,6 +222,27 @@ namespace expt {
                     the exception was thrown
         */
       
+      ValueError(const char* message);
+        
+        /*
+        C string constructor
+        
+        Parameters:
+          message: An error message, which is copied into the ValueError
+        */
+      
+      ValueError(Literal, const char* message);
+        
+        /*
+        Literal constructor
+        
+        The message is not copied, so it must outlive the ValueError and every 
+        copy of it.
+        
+        Parameters:
+          message: A static error message
+        */
+      
       ValueError(const ValueError& original);
         
         /*
@@ -140,6 +252,16 @@ namespace expt {
           original: Other ValueError to be copied
         */
       
+      ValueError(ValueError&& original) noexcept;
+        
+        /*
+        Move constructor
+        
+        Parameters:
+          original: Other ValueError to be moved from.  It is left with an 
+                    empty message.
+        */
+      
       ValueError& operator=(const ValueError& other);
         
         /*
@@ -149,6 +271,16 @@ namespace expt {
           other: Other ValueError to be copied
         */
       
+      ValueError& operator=(ValueError&& other) noexcept;
+        
+        /*
+        Move assignment
+        
+        Parameters:
+          other: Other ValueError to be moved from.  It is left with an empty 
+                 message.
+        */
+      
       operator Exception();
         
         /*
@@ -160,9 +292,26 @@ namespace expt {
   class IndexError : public ValueError {
     
     /*
-    An exception to be used when a bounds check on an index fails.
+    An exception to be used when a bounds check on an index fails.  It can 
+    record the index and the size that it was checked against, in which case 
+    message() formats its message from them and what() is "index out of 
+    range".
     */
     
+    protected:
+      
+      long long _index;
+        
+        /*
+        The index that was out of bounds
+        */
+      
+      long long _size;
+        
+        /*
+        The size of the container that was indexed, or -1 if it is unknown
+        */
+    
     public:
       
       ~IndexError();
@@ -175,16 +324,57 @@ namespace expt {
         
         /*
         Empty constructor
+        
+        The index and the size are unknown, and the message is empty.
+        */
+      
+      IndexError(long long index, long long size);
+        
+        /*
+        Bounds constructor
+        
+        Nothing is allocated.  The message is formatted from the index and 
+        the size when message() is called.
+        
+        Parameters:
+          index: The index that was out of bounds
+          size:  The size of the container that was indexed
+        */
+      
+      IndexError(const IndexError& original);
+        
+        /*
+        Copy constructor
+        
+        Parameters:
+          original: Other IndexError to be copied
         */
       
       IndexError& operator=(const IndexError& other);
         
         /*
-        No actual assignment is needed because no data is stored in an 
-        IndexError.  This operator is here just to allow the following line of 
-        code:
+        Standard field-wise assignment
+        */
+      
+      std::string message() const;
         
-          IndexError exception = IndexError();
+        /*
+        Returns the error message.  If the bounds constructor was used and no 
+        message has been set since, it is formatted from the index and the 
+        size.
+        */
+      
+      long long index() const;
+        
+        /*
+        Returns the index that was out of bounds, or 0 if it is unknown.
+        */
+      
+      long long size() const;
+        
+        /*
+        Returns the size of the container that was indexed, or -1 if it is 
+        unknown.
         */
       
       operator ValueError();
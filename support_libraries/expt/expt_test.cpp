@@ -3,13 +3,16 @@ Filename: expt_test.cpp
 
 Test code for the expt library
 
-18 tests
+27 tests
 
-Exception:  7 tests
-ValueError: 6 tests
-IndexError: 5 tests
+Exception:  12 tests
+ValueError: 9 tests
+IndexError: 6 tests
 */
 
+#include <utility>
+#include <exception>
+
 #include <gtest/gtest.h>
 
 #include "expt.h"
@@ -38,6 +41,44 @@ TEST(ExceptionTest, standard_constructor) {
   
 }
 
+TEST(ExceptionTest, literal_constructor) {
+  
+  // The message is pointed to rather than copied, and survives copies
+  static const char message[] = "Stop iteration";
+  Exception exception1(literal, message);
+  EXPECT_EQ("Stop iteration", exception1.message());
+  EXPECT_EQ(message, exception1.what());
+  
+  Exception exception2(exception1);
+  EXPECT_EQ(message, exception2.what());
+  
+  Exception exception3(std::move(exception2));
+  EXPECT_EQ(message, exception3.what());
+  EXPECT_EQ("", exception2.message());
+  
+  // Setting a message replaces the literal
+  exception1.set_message("Dog");
+  EXPECT_EQ("Dog", exception1.message());
+  EXPECT_STREQ("Dog", exception1.what());
+  
+}
+
+TEST(ExceptionTest, c_string_constructor) {
+  
+  // Without the literal tag the message is copied, so the buffer can change
+  char buffer[] = "Stop iteration";
+  Exception exception1(buffer);
+  buffer[0] = 'X';
+  EXPECT_EQ("Stop iteration", exception1.message());
+  EXPECT_STREQ("Stop iteration", exception1.what());
+  
+  std::string message("Dog");
+  Exception exception2(message.c_str());
+  message.clear();
+  EXPECT_STREQ("Dog", exception2.what());
+  
+}
+
 TEST(ExceptionTest, copy_constructor) {
   
   // Fields initialize as expected
@@ -65,6 +106,30 @@ TEST(ExceptionTest, assignment_operator) {
   
 }
 
+TEST(ExceptionTest, move_constructor) {
+  
+  // The message is taken over and the original is left empty
+  Exception exception1("Stop iteration");
+  Exception exception2(std::move(exception1));
+  EXPECT_EQ("Stop iteration", exception2.message());
+  EXPECT_EQ("", exception1.message());
+  
+}
+
+TEST(ExceptionTest, move_assignment) {
+  
+  Exception exception1("Keyboard interrupt");
+  Exception exception2("Dog");
+  exception2 = std::move(exception1);
+  EXPECT_EQ("Keyboard interrupt", exception2.message());
+  EXPECT_EQ("", exception1.message());
+  
+  // A moved-from exception can be assigned to again
+  exception1 = Exception("Cat");
+  EXPECT_EQ("Cat", exception1.message());
+  
+}
+
 TEST(ExceptionTest, get_message) {
   
   Exception exception1;
@@ -134,6 +199,31 @@ TEST(ExceptionTest, overall) {
   
 }
 
+TEST(ExceptionTest, standard_exception) {
+  
+  // Every exception can be caught as a std::exception with the same message
+  bool exception_caught(false);
+  try {
+    throw Exception("Unknown Exception");
+  }
+  catch(std::exception& exception) {
+    exception_caught = true;
+    EXPECT_STREQ("Unknown Exception", exception.what());
+  }
+  EXPECT_TRUE(exception_caught);
+  
+  exception_caught = false;
+  try {
+    throw ValueError(std::string("Value too large."));
+  }
+  catch(std::exception& exception) {
+    exception_caught = true;
+    EXPECT_STREQ("Value too large.", exception.what());
+  }
+  EXPECT_TRUE(exception_caught);
+  
+}
+
 TEST(ValueErrorTest, empty_constructor) {
   
   // Fields initialize as expected
@@ -153,6 +243,21 @@ TEST(ValueErrorTest, standard_constructor) {
   
 }
 
+TEST(ValueErrorTest, literal_constructor) {
+  
+  static const char message[] = "Negative value passed.";
+  ValueError value_error1(literal, message);
+  EXPECT_EQ("Negative value passed.", value_error1.message());
+  EXPECT_EQ(message, value_error1.what());
+  
+  // The literal is kept through assignment and conversion
+  ValueError value_error2;
+  value_error2 = value_error1;
+  EXPECT_EQ(message, value_error2.what());
+  EXPECT_EQ(message, ((Exception) value_error2).what());
+  
+}
+
 TEST(ValueErrorTest, copy_constructor) {
   
   // Fields initialize as expected
@@ -181,6 +286,25 @@ TEST(ValueErrorTest, assignment_operator) {
   
 }
 
+TEST(ValueErrorTest, move_constructor) {
+  
+  ValueError value_error1("Negative length");
+  ValueError value_error2(std::move(value_error1));
+  EXPECT_EQ("Negative length", value_error2.message());
+  EXPECT_EQ("", value_error1.message());
+  
+}
+
+TEST(ValueErrorTest, move_assignment) {
+  
+  ValueError value_error1("Index out of range");
+  ValueError value_error2;
+  value_error2 = std::move(value_error1);
+  EXPECT_EQ("Index out of range", value_error2.message());
+  EXPECT_EQ("", value_error1.message());
+  
+}
+
 TEST(ValueErrorTest, exception_cast) {
   
   // Message transfers as expected
@@ -218,6 +342,36 @@ TEST(IndexErrorTest, empty_constructor) {
   
 }
 
+TEST(IndexErrorTest, bounds_constructor) {
+  
+  // The message is formatted from the index and the size
+  IndexError index_error1(7, 3);
+  EXPECT_EQ(7, index_error1.index());
+  EXPECT_EQ(3, index_error1.size());
+  EXPECT_EQ("Index 7 is out of range for size 3.", index_error1.message());
+  EXPECT_STREQ("index out of range", index_error1.what());
+  
+  IndexError index_error2(index_error1);
+  EXPECT_EQ(7, index_error2.index());
+  EXPECT_EQ(3, index_error2.size());
+  
+  IndexError index_error3;
+  EXPECT_EQ(-1, index_error3.size());
+  index_error3 = index_error1;
+  EXPECT_EQ("Index 7 is out of range for size 3.", index_error3.message());
+  
+  // A message that is set takes precedence
+  index_error3.set_message("Past the end");
+  EXPECT_EQ("Past the end", index_error3.message());
+  EXPECT_STREQ("Past the end", index_error3.what());
+  
+  // what() is the same fixed text for every index
+  IndexError index_error4(-1, 0);
+  EXPECT_EQ(index_error1.what(), index_error4.what());
+  EXPECT_EQ("Index -1 is out of range for size 0.", index_error4.message());
+  
+}
+
 TEST(IndexErrorTest, assignment_operator) {
   
   IndexError index_error1 = IndexError();